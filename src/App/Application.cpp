@@ -297,6 +297,7 @@ void Application::renameDocument(const char *OldName, const char *NewName)
         temp = pos->second;
         DocMap.erase(pos);
         DocMap[NewName] = temp;
+        ObjectIdentifier::touchResolveRevision();
         signalRenameDocument(*temp);
     }
     else {
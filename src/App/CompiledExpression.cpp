@@ -0,0 +1,347 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <cassert>
+# include <cmath>
+# include <memory>
+#endif
+
+#include <Base/Exception.h>
+#include <App/Application.h>
+#include <App/DocumentObject.h>
+#include "CompiledExpression.h"
+#include "Expression.h"
+
+using namespace Base;
+using namespace App;
+
+//
+// CompiledExpression::Value class
+//
+
+/**
+  * Convert the value of a property path the same way VariableExpression::eval() does:
+  * quantities and numbers become numbers, strings become strings.
+  *
+  * @param value Value returned by Property::getPathValue().
+  */
+
+CompiledExpression::Value::Value(const boost::any & value)
+    : type(Number)
+{
+    if (value.type() == typeid(Quantity))
+        quantity = boost::any_cast<Quantity>(value);
+    else if (value.type() == typeid(double))
+        quantity = Quantity(boost::any_cast<double>(value));
+    else if (value.type() == typeid(float))
+        quantity = Quantity(boost::any_cast<float>(value));
+    else if (value.type() == typeid(int))
+        quantity = Quantity(boost::any_cast<int>(value));
+    else if (value.type() == typeid(long))
+        quantity = Quantity(boost::any_cast<long>(value));
+    else if (value.type() == typeid(bool))
+        quantity = Quantity(boost::any_cast<bool>(value) ? 1.0 : 0.0);
+    else {
+        type = String;
+        if (value.type() == typeid(std::string))
+            text = boost::any_cast<std::string>(value);
+        else if (value.type() == typeid(char*))
+            text = boost::any_cast<char*>(value);
+        else if (value.type() == typeid(const char*))
+            text = boost::any_cast<const char*>(value);
+        else
+            throw ExpressionError("Property is of invalid type.");
+    }
+}
+
+/**
+  * Return the value like Expression::getValueAsAny() of the evaluated expression does.
+  */
+
+boost::any CompiledExpression::Value::getValueAsAny() const
+{
+    if (type != Number)
+        return boost::any();
+    return quantity.getUnit().isEmpty() ? boost::any(quantity.getValue()) : boost::any(quantity);
+}
+
+Expression * CompiledExpression::Value::toExpression(const DocumentObject *owner) const
+{
+    if (type == Number)
+        return new NumberExpression(owner, quantity);
+    else
+        return new StringExpression(owner, text);
+}
+
+//
+// CompiledExpression class
+//
+
+/**
+  * Compile \a expr. The expression is not referenced afterwards.
+  */
+
+CompiledExpression::CompiledExpression(const Expression *expr)
+    : revision(Expression::getRevision())
+{
+    compile(expr);
+}
+
+CompiledExpression::~CompiledExpression()
+{
+    for (std::vector<Expression*>::iterator it = trees.begin(); it != trees.end(); ++it)
+        delete *it;
+}
+
+/**
+  * Return false if an expression was changed in place since this one was compiled.
+  */
+
+bool CompiledExpression::isUpToDate() const
+{
+    return revision == Expression::getRevision();
+}
+
+/**
+  * Compiled expressions are used unless the "CompileExpressions" parameter
+  * is switched off, e.g. to compare the results or the speed.
+  */
+
+bool CompiledExpression::isEnabled()
+{
+    return App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Expression")->GetBool("CompileExpressions", true);
+}
+
+/**
+  * Append the instructions that leave the value of \a expr on the stack.
+  */
+
+void CompiledExpression::compile(const Expression *expr)
+{
+    Base::Type type = expr->getTypeId();
+
+    if (type == NumberExpression::getClassTypeId() ||
+            type == ConstantExpression::getClassTypeId() ||
+            type == BooleanExpression::getClassTypeId() ||
+            type == UnitExpression::getClassTypeId()) {
+        constants.push_back(Value(static_cast<const UnitExpression*>(expr)->getQuantity()));
+        code.push_back(Instruction(PushConstant, constants.size() - 1));
+    }
+    else if (type == StringExpression::getClassTypeId()) {
+        constants.push_back(Value(static_cast<const StringExpression*>(expr)->getText()));
+        code.push_back(Instruction(PushConstant, constants.size() - 1));
+    }
+    else if (type == VariableExpression::getClassTypeId()) {
+        variables.push_back(Variable(static_cast<const VariableExpression*>(expr)->getPath()));
+        code.push_back(Instruction(PushVariable, variables.size() - 1));
+    }
+    else if (type == OperatorExpression::getClassTypeId()) {
+        const OperatorExpression * op = static_cast<const OperatorExpression*>(expr);
+        std::size_t begin = code.size();
+
+        compile(op->getLeft());
+        compile(op->getRight());
+        code.push_back(Instruction(ApplyOperator, op->getOperator()));
+        foldConstants(begin, 2);
+    }
+    else if (type == FunctionExpression::getClassTypeId() &&
+             static_cast<const FunctionExpression*>(expr)->getFunction() < FunctionExpression::AGGREGATES &&
+             !static_cast<const FunctionExpression*>(expr)->getArgs().empty()) {
+        const FunctionExpression * f = static_cast<const FunctionExpression*>(expr);
+        const std::vector<Expression*> & args = f->getArgs();
+        int count = args.size() > 1 ? 2 : 1;
+        std::size_t begin = code.size();
+
+        // Like FunctionExpression::eval(), further arguments are ignored
+        for (int i = 0; i < count; ++i)
+            compile(args[i]);
+        code.push_back(Instruction(ApplyFunction, f->getFunction(), count));
+        foldConstants(begin, count);
+    }
+    else if (type == ConditionalExpression::getClassTypeId()) {
+        const ConditionalExpression * cond = static_cast<const ConditionalExpression*>(expr);
+
+        compile(cond->getCondition());
+        std::size_t jumpToFalse = code.size();
+        code.push_back(Instruction(JumpIfFalse, 0));
+        compile(cond->getTrueExpression());
+        std::size_t jumpToEnd = code.size();
+        code.push_back(Instruction(Jump, 0));
+        code[jumpToFalse].arg = code.size();
+        compile(cond->getFalseExpression());
+        code[jumpToEnd].arg = code.size();
+    }
+    else {
+        // Aggregates, ranges and anything else are left to the tree walker
+        trees.push_back(expr->copy());
+        code.push_back(Instruction(EvalTree, trees.size() - 1));
+    }
+}
+
+/**
+  * If the last instruction is applied to \a count constants only, replace the
+  * instructions starting at \a begin with their result. Nothing is done if the
+  * result cannot be computed, so that eval() throws the error.
+  */
+
+void CompiledExpression::foldConstants(std::size_t begin, int count)
+{
+    // Each operand must compile to a single instruction, otherwise it might be
+    // the end of a conditional and the target of a jump.
+    if (code.size() != begin + count + 1)
+        return;
+    for (int i = 0; i < count; ++i) {
+        if (code[begin + i].code != PushConstant ||
+            constants[code[begin + i].arg].getType() != Value::Number)
+            return;
+    }
+
+    const Instruction & last = code.back();
+    const Quantity & v1 = constants[code[begin].arg].getQuantity();
+    const Quantity * v2 = count > 1 ? &constants[code[begin + 1].arg].getQuantity() : 0;
+    Quantity result;
+
+    try {
+        if (last.code == ApplyOperator)
+            result = OperatorExpression::evalOperator(OperatorExpression::Operator(last.arg), v1, *v2);
+        else
+            result = FunctionExpression::evalFunction(FunctionExpression::Function(last.arg), &v1, v2);
+    }
+    catch (Base::Exception &) {
+        return;
+    }
+
+    code.erase(code.begin() + begin, code.end());
+    constants.push_back(Value(result));
+    code.push_back(Instruction(PushConstant, constants.size() - 1));
+}
+
+/**
+  * Return the property \a var refers to. It is looked up again only if the
+  * resolve revision changed since the last call.
+  */
+
+const Property * CompiledExpression::resolve(const Variable &var) const
+{
+    int current = ObjectIdentifier::getResolveRevision();
+
+    if (var.property && var.revision == current)
+        return var.property;
+
+    var.property = 0;
+
+    const Property * prop = var.path.getProperty();
+
+    if (!prop)
+        throw Expression::Exception(var.path.resolveErrorString().c_str());
+
+    if (!prop->getContainer()->isDerivedFrom(App::DocumentObject::getClassTypeId()))
+        throw ExpressionError("Property must belong to a document object.");
+
+    var.property = prop;
+    var.revision = current;
+    return prop;
+}
+
+/**
+  * Evaluate the expression. Throws an exception if the expression cannot be evaluated.
+  *
+  * @returns The value of the expression.
+  */
+
+CompiledExpression::Value CompiledExpression::eval() const
+{
+    std::size_t pc = 0;
+
+    stack.clear();
+    while (pc < code.size()) {
+        const Instruction & i = code[pc++];
+
+        switch (i.code) {
+        case PushConstant:
+            stack.push_back(constants[i.arg]);
+            break;
+        case PushVariable: {
+            const Variable & var = variables[i.arg];
+
+            stack.push_back(Value(resolve(var)->getPathValue(var.path)));
+            break;
+        }
+        case ApplyOperator: {
+            Value & v1 = stack[stack.size() - 2];
+            const Value & v2 = stack.back();
+
+            if (v1.getType() != Value::Number || v2.getType() != Value::Number)
+                throw ExpressionError("Invalid expression");
+
+            v1 = Value(OperatorExpression::evalOperator(OperatorExpression::Operator(i.arg),
+                                                        v1.getQuantity(), v2.getQuantity()));
+            stack.pop_back();
+            break;
+        }
+        case ApplyFunction: {
+            Value & v1 = stack[stack.size() - i.arg2];
+            const Value & v2 = stack.back();
+
+            v1 = Value(FunctionExpression::evalFunction(FunctionExpression::Function(i.arg),
+                                                        v1.getType() == Value::Number ? &v1.getQuantity() : 0,
+                                                        i.arg2 > 1 && v2.getType() == Value::Number ? &v2.getQuantity() : 0));
+            stack.resize(stack.size() - i.arg2 + 1);
+            break;
+        }
+        case JumpIfFalse: {
+            const Value & v = stack.back();
+
+            if (v.getType() != Value::Number)
+                throw ExpressionError("Invalid expression");
+
+            if (!(fabs(v.getQuantity().getValue()) > 0.5))
+                pc = i.arg;
+            stack.pop_back();
+            break;
+        }
+        case Jump:
+            pc = i.arg;
+            break;
+        case EvalTree: {
+            std::unique_ptr<Expression> e(trees[i.arg]->eval());
+
+            if (freecad_dynamic_cast<NumberExpression>(e.get()))
+                stack.push_back(Value(static_cast<NumberExpression*>(e.get())->getQuantity()));
+            else if (freecad_dynamic_cast<StringExpression>(e.get()))
+                stack.push_back(Value(static_cast<StringExpression*>(e.get())->getText()));
+            else
+                stack.push_back(Value());
+            break;
+        }
+        default:
+            assert(0);
+        }
+    }
+
+    assert(stack.size() == 1);
+    return stack.back();
+}
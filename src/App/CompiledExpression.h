@@ -0,0 +1,152 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef COMPILEDEXPRESSION_H
+#define COMPILEDEXPRESSION_H
+
+#include <string>
+#include <vector>
+#include <boost/any.hpp>
+#include <Base/Quantity.h>
+#include <App/ObjectIdentifier.h>
+
+namespace App  {
+
+class DocumentObject;
+class Expression;
+class Property;
+
+/**
+  * Flat form of an expression tree used to evaluate it repeatedly.
+  *
+  * Evaluating an Expression tree allocates a new expression for each node. The
+  * compiled form is a sequence of instructions working on a stack of values
+  * instead, and constant sub-expressions are computed once when compiling. The
+  * property each variable refers to is looked up once and kept until
+  * ObjectIdentifier::getResolveRevision() changes.
+  *
+  * Aggregates, ranges and unknown expression types are evaluated with the
+  * tree walker. The results and error messages are the same as those of
+  * Expression::eval().
+  *
+  * The compiled form keeps copies of the data it needs, so it stays valid
+  * when the expression is deleted. If the expression is changed in place,
+  * isUpToDate() returns false and the expression must be compiled again.
+  */
+
+class AppExport CompiledExpression {
+public:
+
+    /**
+      * Result of an evaluation: a number with an optional unit or a string.
+      */
+
+    class AppExport Value {
+    public:
+        enum Type {
+            None,
+            Number,
+            String
+        };
+
+        Value() : type(None) { }
+
+        explicit Value(const Base::Quantity & _quantity) : type(Number), quantity(_quantity) { }
+
+        explicit Value(const std::string & _text) : type(String), text(_text) { }
+
+        /** Converts a property value, throws if it cannot be used in expressions */
+        explicit Value(const boost::any & value);
+
+        Type getType() const { return type; }
+
+        const Base::Quantity & getQuantity() const { return quantity; }
+
+        const std::string & getText() const { return text; }
+
+        boost::any getValueAsAny() const;
+
+        /** Returns a new Number- or StringExpression like Expression::eval() does */
+        Expression * toExpression(const App::DocumentObject * owner) const;
+
+    private:
+        Type type;
+        Base::Quantity quantity;
+        std::string text;
+    };
+
+    CompiledExpression(const Expression * expr);
+
+    ~CompiledExpression();
+
+    bool isUpToDate() const;
+
+    Value eval() const;
+
+    /** Returns false if expressions should be evaluated with the tree walker */
+    static bool isEnabled();
+
+private:
+    CompiledExpression(const CompiledExpression &);
+    CompiledExpression & operator=(const CompiledExpression &);
+
+    enum OpCode {
+        PushConstant,  /**< Push constants[arg] */
+        PushVariable,  /**< Push the value of variables[arg] */
+        ApplyOperator, /**< Replace the two top values by the result of operator arg */
+        ApplyFunction, /**< Replace the top arg2 values by the result of function arg */
+        JumpIfFalse,   /**< Pop the condition, continue at arg if it is false */
+        Jump,          /**< Continue at arg */
+        EvalTree       /**< Push the result of trees[arg]->eval() */
+    };
+
+    struct Instruction {
+        Instruction(OpCode _code, int _arg, int _arg2 = 0) : code(_code), arg(_arg), arg2(_arg2) { }
+
+        OpCode code;
+        int arg;
+        int arg2;
+    };
+
+    struct Variable {
+        Variable(const ObjectIdentifier & _path) : path(_path), property(0), revision(0) { }
+
+        ObjectIdentifier path;
+        mutable const Property * property; /**< Resolved property, or 0 */
+        mutable int revision;              /**< Resolve revision when property was looked up */
+    };
+
+    void compile(const Expression * expr);
+    void foldConstants(std::size_t begin, int count);
+    const Property * resolve(const Variable & var) const;
+
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+    std::vector<Variable> variables;
+    std::vector<Expression*> trees;
+    int revision;                  /**< Expression revision when compiled */
+    mutable std::vector<Value> stack;
+};
+
+}
+
+#endif // COMPILEDEXPRESSION_H
@@ -73,9 +73,15 @@ recompute path. Also enables more complicated dependencies beyond trees.
 #include <boost/regex.hpp>
 #include <unordered_set>
 #include <unordered_map>
+#include <deque>
+#include <exception>
 
 #include <QCoreApplication>
 #include <QCryptographicHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrentMap>
 
 
 #include "Document.h"
@@ -153,8 +159,28 @@ struct DocumentP
 #ifdef USE_OLD_DAG
     DependencyList DepList;
     std::map<DocumentObject*,Vertex> VertexObjectList;
-    std::map<Vertex,DocumentObject*> vertexMap;
 #endif //USE_OLD_DAG
+    // objects of a running recompute in topological order, removed objects are set to 0
+    std::vector<DocumentObject*> recomputeOrder;
+
+    // Dependency index: the cached out-list of every object of the document and the
+    // in-lists derived from it. Like DocumentObject::getOutList() both keep one entry per link.
+    std::unordered_map<const DocumentObject*, std::vector<DocumentObject*> > outLinks;
+    std::unordered_map<const DocumentObject*, std::vector<DocumentObject*> > inLinks;
+    bool depIndexValid; ///< if false the index is rebuilt on next access
+    bool exprDepsDirty; ///< expressions may resolve to different objects than cached
+    // objects changed or touched since the last recompute, in the order of the changes
+    std::vector<DocumentObject*> dirtyList;
+    std::unordered_set<const DocumentObject*> dirtySet;
+
+    // state of a parallel recompute: changes of objects recomputed in worker threads are
+    // signaled by the recompute thread once the workers have finished
+    bool parallelRecompute;
+    QThread* recomputeThread;
+    QMutex recomputeMutex;
+    std::vector<std::pair<const DocumentObject*, const Property*> > changedInThread;
+    // project file with embedded files that are read in on demand
+    Base::Reference<Base::LazyArchive> lazyArchive;
 
     DocumentP() {
         activeObject = 0;
@@ -167,6 +193,149 @@ struct DocumentP
         iUndoMode = 0;
         UndoMemSize = 0;
         UndoMaxStackSize = 20;
+        depIndexValid = true;
+        exprDepsDirty = false;
+        parallelRecompute = false;
+        recomputeThread = 0;
+    }
+
+    void addToDepIndex(DocumentObject* obj) {
+        // an object re-added by undo/redo may already be linked by others
+        if (undoing || rollback) {
+            depIndexValid = false;
+            return;
+        }
+        outLinks[obj];
+        exprDepsDirty = true;
+        updateDepIndex(obj);
+    }
+    void removeFromDepIndex(const DocumentObject* obj) {
+        dirtySet.erase(obj);
+        dirtyList.erase(std::remove(dirtyList.begin(), dirtyList.end(), obj), dirtyList.end());
+        auto it = outLinks.find(obj);
+        if (it == outLinks.end())
+            return;
+        for (auto link : it->second)
+            removeInLink(link, obj);
+        outLinks.erase(it);
+        exprDepsDirty = true;
+    }
+    void updateDepIndex(const DocumentObject* obj) {
+        if (!depIndexValid)
+            return;
+        auto it = outLinks.find(obj);
+        if (it == outLinks.end())
+            return;
+        std::vector<DocumentObject*> outList = obj->getOutList();
+        for (auto link : it->second)
+            removeInLink(link, obj);
+        for (auto link : outList)
+            inLinks[link].push_back(const_cast<DocumentObject*>(obj));
+        it->second.swap(outList);
+    }
+    void removeInLink(const DocumentObject* link, const DocumentObject* obj) {
+        auto it = inLinks.find(link);
+        if (it == inLinks.end())
+            return;
+        auto jt = std::find(it->second.begin(), it->second.end(), obj);
+        if (jt != it->second.end())
+            it->second.erase(jt);
+        if (it->second.empty())
+            inLinks.erase(it);
+    }
+    void rebuildDepIndex() {
+        outLinks.clear();
+        inLinks.clear();
+        for (auto obj : objectArray) {
+            std::vector<DocumentObject*>& outList = outLinks[obj];
+            outList = obj->getOutList();
+            for (auto link : outList)
+                inLinks[link].push_back(obj);
+        }
+        depIndexValid = true;
+        exprDepsDirty = false;
+    }
+    void markDirty(DocumentObject* obj) {
+        if (dirtySet.insert(obj).second)
+            dirtyList.push_back(obj);
+    }
+    void clearDirty(const std::vector<DocumentObject*>& objs) {
+        for (auto obj : objs)
+            dirtySet.erase(obj);
+        dirtyList.erase(std::remove_if(dirtyList.begin(), dirtyList.end(), [this](DocumentObject* obj) {
+            return dirtySet.find(obj) == dirtySet.end();
+        }), dirtyList.end());
+    }
+    /**
+     * Collects the dirty objects and all objects depending on them and sorts them like
+     * Document::topologicalSort(). The dirty list is moved into \a cone. Returns false
+     * if the sorted objects contain a cyclic dependency.
+     */
+    bool sortDirtyCone(std::vector<DocumentObject*>& cone, std::vector<DocumentObject*>& sorted) {
+        checkDepIndex();
+
+        std::unordered_map<const DocumentObject*, size_t> countMap;
+        cone.clear();
+        for (auto obj : dirtyList) {
+            // skip removed objects
+            if (outLinks.find(obj) != outLinks.end() && countMap.insert(std::make_pair(obj, 0)).second)
+                cone.push_back(obj);
+        }
+        dirtyList.clear();
+        dirtySet.clear();
+
+        // the downstream objects, i.e. all objects linking to the collected ones
+        for (size_t i = 0; i < cone.size(); ++i) {
+            auto it = inLinks.find(cone[i]);
+            if (it == inLinks.end())
+                continue;
+            for (auto parent : it->second) {
+                if (countMap.insert(std::make_pair(parent, 0)).second)
+                    cone.push_back(parent);
+            }
+        }
+
+        // all objects linking to an object of the cone are part of it, so the
+        // in-lists can be used as they are
+        std::deque<DocumentObject*> rootObjects;
+        for (auto obj : cone) {
+            auto it = inLinks.find(obj);
+            size_t count = it != inLinks.end() ? it->second.size() : 0;
+            countMap[obj] = count;
+            if (count == 0)
+                rootObjects.push_back(obj);
+        }
+
+        sorted.clear();
+        sorted.reserve(cone.size());
+        while (!rootObjects.empty()) {
+            DocumentObject* obj = rootObjects.front();
+            rootObjects.pop_front();
+            sorted.push_back(obj);
+            for (auto link : outLinks[obj]) {
+                auto it = countMap.find(link);
+                if (it != countMap.end() && --it->second == 0)
+                    rootObjects.push_back(link);
+            }
+        }
+
+        return sorted.size() == cone.size();
+    }
+    void checkDepIndex() {
+        // a rebuild must not interfere with the index updates of worker threads
+        QMutexLocker locker(parallelRecompute ? &recomputeMutex : 0);
+        if (!depIndexValid) {
+            rebuildDepIndex();
+        }
+        else if (exprDepsDirty) {
+            // expressions reference objects by name, so adding, removing or
+            // relabeling objects may change the dependencies they resolve to
+            exprDepsDirty = false;
+            for (auto obj : objectArray) {
+                if (obj->ExpressionEngine.numExpressions() > 0)
+                    updateDepIndex(obj);
+            }
+        }
     }
 };
 
@@ -809,6 +978,20 @@ void Document::commitTransaction()
             delete mUndoTransactions.front();
             mUndoTransactions.pop_front();
         }
+        // drop the oldest transactions until the memory limit is kept, but
+        // keep the last one even if it exceeds the limit on its own
+        if (d->UndoMemSize > 0) {
+            unsigned int size = getUndoMemSize();
+            while (size > d->UndoMemSize && mUndoTransactions.size() > 1) {
+                Transaction* oldest = mUndoTransactions.front();
+                unsigned int oldestSize = oldest->getMemSize();
+                Console().Log("Undo memory limit exceeded, dropping transaction '%s' (%u bytes)\n",
+                    oldest->Name.c_str(), oldestSize);
+                size -= oldestSize;
+                delete oldest;
+                mUndoTransactions.pop_front();
+            }
+        }
     }
 }
 
@@ -885,7 +1068,15 @@ int Document::getUndoMode(void) const
 
 unsigned int Document::getUndoMemSize (void) const
 {
-    return d->UndoMemSize;
+    unsigned int size = 0;
+    std::list<Transaction*>::const_iterator It;
+    for (It = mUndoTransactions.begin(); It != mUndoTransactions.end(); ++It)
+        size += (*It)->getMemSize();
+    for (It = mRedoTransactions.begin(); It != mRedoTransactions.end(); ++It)
+        size += (*It)->getMemSize();
+    if (d->activeUndoTransaction)
+        size += d->activeUndoTransaction->getMemSize();
+    return size;
 }
 
 void Document::setUndoLimit(unsigned int UndoMemSize)
@@ -893,6 +1084,11 @@ void Document::setUndoLimit(unsigned int UndoMemSize)
     d->UndoMemSize = UndoMemSize;
 }
 
+unsigned int Document::getUndoLimit(void) const
+{
+    return d->UndoMemSize;
+}
+
 void Document::setMaxUndoStackSize(unsigned int UndoMaxStackSize)
 {
      d->UndoMaxStackSize = UndoMaxStackSize;
@@ -907,6 +1103,7 @@ void Document::onChanged(const Property* prop)
 {
     // the Name property is a label for display purposes
     if (prop == &Label) {
+        ObjectIdentifier::touchResolveRevision();
         App::GetApplication().signalRelabelDocument(*this);
     }
     else if (prop == &Uid) {
@@ -945,12 +1142,41 @@ void Document::onChanged(const Property* prop)
 
 void Document::onBeforeChangeProperty(const TransactionalObject *Who, const Property *What)
 {
+    QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
     if (d->activeUndoTransaction && !d->rollback)
         d->activeUndoTransaction->addObjectChange(Who,What);
 }
 
+void Document::_markDirty(DocumentObject* obj)
+{
+    QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
+    d->markDirty(obj);
+}
+
 void Document::onChangedProperty(const DocumentObject *Who, const Property *What)
 {
+    QMutexLocker locker(d->parallelRecompute ? &d->recomputeMutex : 0);
+
+    // keep the dependency index up to date
+    if (What->isDerivedFrom(PropertyLink::getClassTypeId()) ||
+        What->isDerivedFrom(PropertyLinkSub::getClassTypeId()) ||
+        What->isDerivedFrom(PropertyLinkList::getClassTypeId()) ||
+        What->isDerivedFrom(PropertyLinkSubList::getClassTypeId()) ||
+        What == &Who->ExpressionEngine) {
+        d->updateDepIndex(Who);
+    }
+    else if (What == &Who->Label) {
+        d->exprDepsDirty = true;
+    }
+    d->markDirty(const_cast<DocumentObject*>(Who));
+
+    // worker threads must not emit signals, defer it to the recompute thread
+    if (d->parallelRecompute && QThread::currentThread() != d->recomputeThread) {
+        d->changedInThread.push_back(std::make_pair(Who, What));
+        return;
+    }
+
+    locker.unlock();
     signalChangedObject(*Who, *What);
 }
 
@@ -981,6 +1207,9 @@ Document::Document(void)
         ("User parameter:BaseApp/Preferences/Document")->GetASCII("prefAuthor","");
     std::string AuthorComp = App::GetApplication().GetParameterGroupByPath
         ("User parameter:BaseApp/Preferences/Document")->GetASCII("prefCompany","");
+    bool parallel = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetBool("ParallelRecompute",false);
+    setStatus(Document::ParallelRecompute, parallel);
     ADD_PROPERTY_TYPE(Label,("Unnamed"),0,Prop_None,"The name of the document");
     ADD_PROPERTY_TYPE(FileName,(""),0,PropertyType(Prop_Transient|Prop_ReadOnly),"The path to the file where the document is saved to");
     ADD_PROPERTY_TYPE(CreatedBy,(Author.c_str()),0,Prop_None,"The creator of the document");
@@ -1220,6 +1449,9 @@ void Document::exportObjects(const std::vector<App::DocumentObject*>& obj,
                              std::ostream& out)
 {
     Base::ZipWriter writer(out);
+    if (App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetBool("SaveBinaryBrep", true))
+        writer.setMode("BinaryBrep");
     writer.putNextEntry("Document.xml");
     writer.Stream() << "<?xml version='1.0' encoding='utf-8'?>" << endl;
     writer.Stream() << "<Document SchemaVersion=\"4\" ProgramVersion=\""
@@ -1332,6 +1564,9 @@ Document::readObjects(Base::XMLReader& reader)
     }
     reader.readEndElement("ObjectData");
 
+    // links may have been restored before their targets, so rebuild the index on next access
+    d->depIndexValid = false;
+
     return objs;
 }
 
@@ -1363,6 +1598,7 @@ Document::importObjects(Base::XMLReader& reader)
         (*it)->ExpressionEngine.onDocumentRestored();
         (*it)->purgeTouched();
     }
+    d->clearDirty(objs);
     return objs;
 }
 
@@ -1417,9 +1653,16 @@ bool Document::saveCopy(const char* file)
 // Save the document under the name it has been opened
 bool Document::save (void)
 {
-    int compression = App::GetApplication().GetParameterGroupByPath
-        ("User parameter:BaseApp/Preferences/Document")->GetInt("CompressionLevel",3);
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document");
+    int compression = hGrp->GetInt("CompressionLevel",3);
     compression = Base::clamp<int>(compression, Z_NO_COMPRESSION, Z_BEST_COMPRESSION);
+    // number of threads to compress the files, 0 means one per core
+    int threads = hGrp->GetInt("SaveThreads",0);
+    // shapes are saved in the much faster binary format unless ASCII is requested
+    bool binary = hGrp->GetBool("SaveBinaryBrep",true);
+    // optionally keep the tessellation of shapes so that reopening doesn't re-mesh them
+    bool tessellation = hGrp->GetBool("SaveTessellation",false);
 
     if (*(FileName.getValue()) != '\0') {
         // Save the name of the tip object in order to handle in Restore()
@@ -1452,6 +1695,11 @@ bool Document::save (void)
 
             writer.setComment("FreeCAD Document");
             writer.setLevel(compression);
+            writer.setThreadCount(threads);
+            if (binary)
+                writer.setMode("BinaryBrep");
+            if (tessellation)
+                writer.setMode("Tessellation");
             writer.putNextEntry("Document.xml");
 
             Document::Save(writer);
@@ -1469,6 +1717,12 @@ bool Document::save (void)
             GetApplication().signalSaveDocument(*this);
         }
 
+        // files that are not yet read in would get lost when replacing the project file
+        if (d->lazyArchive.isValid() && d->lazyArchive->getFileName() == FileName.getValue()) {
+            d->lazyArchive->restoreAll();
+            d->lazyArchive = 0;
+        }
+
         // if saving the project data succeeded rename to the actual file name
         Base::FileInfo fi(FileName.getValue());
         if (fi.exists()) {
@@ -1552,6 +1806,7 @@ void Document::restore (void)
     d->objectArray.clear();
     d->objectMap.clear();
     d->activeObject = 0;
+    d->lazyArchive = 0;
 
     Base::FileInfo fi(FileName.getValue());
     Base::ifstream file(fi, std::ios::in | std::ios::binary);
@@ -1581,7 +1836,17 @@ void Document::restore (void)
     // Note: This file doesn't need to be available if the document has been created
     // without GUI. But if available then follow after all data files of the App document.
     signalRestoreDocument(reader);
+
+    // With lazy loading large files like shapes or meshes are read in on first access
+    bool lazy = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetBool("LazyLoading",false);
+    if (lazy) {
+        d->lazyArchive = new Base::LazyArchive(FileName.getValue());
+        reader.setLazyArchive(d->lazyArchive);
+    }
     reader.readFiles(zipstream);
+    if (d->lazyArchive.isValid() && !d->lazyArchive->hasPendingFiles())
+        d->lazyArchive = 0;
 
     // reset all touched
     for (std::map<std::string,DocumentObject*>::iterator It= d->objectMap.begin();It!=d->objectMap.end();++It) {
@@ -1590,6 +1855,8 @@ void Document::restore (void)
         It->second->ExpressionEngine.onDocumentRestored();
         It->second->purgeTouched();
     }
+    d->dirtyList.clear();
+    d->dirtySet.clear();
 
     GetApplication().signalFinishRestoreDocument(*this);
 }
@@ -1623,6 +1890,8 @@ void Document::purgeTouched()
 {
     for (std::vector<DocumentObject*>::iterator It = d->objectArray.begin();It != d->objectArray.end();++It)
         (*It)->purgeTouched();
+    d->dirtyList.clear();
+    d->dirtySet.clear();
 }
 
 bool Document::isTouched() const
@@ -1661,18 +1930,11 @@ int Document::countObjects(void) const
 
 std::vector<App::DocumentObject*> Document::getInList(const DocumentObject* me) const
 {
-    // result list
-    std::vector<App::DocumentObject*> result;
-    // go through all objects
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        // get the outList and search if me is in that list
-        std::vector<DocumentObject*> OutList = It->second->getOutList();
-        for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2)
-            if (*It2 && *It2 == me)
-                // add the parent object
-                result.push_back(It->second);
-    }
-    return result;
+    d->checkDepIndex();
+    auto it = d->inLinks.find(me);
+    if (it == d->inLinks.end())
+        return std::vector<App::DocumentObject*>();
+    return it->second;
 }
 
 #ifdef USE_OLD_DAG
@@ -1859,35 +2121,27 @@ int Document::recompute()
         delete *it;
     _RecomputeLog.clear();
 
-    // updates the dependency graph
-    _rebuildDependencyList();
-
-    std::list<Vertex> make_order;
-    DependencyList::out_edge_iterator j, jend;
-
-
-    try {
-        // this sort gives the execute
-        boost::topological_sort(d->DepList, std::front_inserter(make_order));
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Document::recompute: " << e.what() << std::endl;
+    // Only the objects changed since the last recompute and the objects depending on
+    // them are visited. This sort gives the execute order, dependencies come after the
+    // objects linking to them.
+    std::vector<DocumentObject*> cone;
+    if (!d->sortDirtyCone(cone, d->recomputeOrder)) {
+        std::cerr << "Document::recompute: cyclic dependency detected" << std::endl;
+        for (auto obj : cone)
+            d->markDirty(obj);
+        d->recomputeOrder.clear();
         return -1;
     }
 
-    // caching vertex to DocObject
-    for (std::map<DocumentObject*,Vertex>::const_iterator It1= d->VertexObjectList.begin();It1 != d->VertexObjectList.end(); ++It1)
-        d->vertexMap[It1->second] = It1->first;
-
 #ifdef FC_LOGFEATUREUPDATE
     std::clog << "make ordering: " << std::endl;
 #endif
 
-    std::set<DocumentObject*> recomputeList;
+    std::unordered_set<DocumentObject*> recomputeList;
 
-    for (std::list<Vertex>::reverse_iterator i = make_order.rbegin();i != make_order.rend(); ++i) {
-        DocumentObject* Cur = d->vertexMap[*i];
-        if (!Cur || !isIn(Cur)) continue;
+    for (std::vector<DocumentObject*>::reverse_iterator i = d->recomputeOrder.rbegin();i != d->recomputeOrder.rend(); ++i) {
+        DocumentObject* Cur = *i;
+        if (!Cur) continue;
 #ifdef FC_LOGFEATUREUPDATE
         std::clog << Cur->getNameInDocument() << " dep on:" ;
 #endif
@@ -1902,10 +2156,7 @@ int Document::recompute()
         }
         else {// if (Cur->mustExecute() == -1)
             // update if one of the dependencies is touched
-            for (boost::tie(j, jend) = out_edges(*i, d->DepList); j != jend; ++j) {
-                DocumentObject* Test = d->vertexMap[target(*j, d->DepList)];
-
-                if (!Test) continue;
+            for (auto Test : d->outLinks[Cur]) {
 #ifdef FC_LOGFEATUREUPDATE
                 std::clog << " " << Test->getNameInDocument();
 #endif
@@ -1932,33 +2183,71 @@ int Document::recompute()
 
 #ifdef FC_LOGFEATUREUPDATE
     std::clog << "Have to recompute the following document objects" << std::endl;
-    for (std::set<DocumentObject*>::const_iterator it = recomputeList.begin(); it != recomputeList.end(); ++it) {
+    for (std::unordered_set<DocumentObject*>::const_iterator it = recomputeList.begin(); it != recomputeList.end(); ++it) {
         std::clog << "  " << (*it)->getNameInDocument() << std::endl;
     }
 #endif
 
-    for (std::list<Vertex>::reverse_iterator i = make_order.rbegin();i != make_order.rend(); ++i) {
-        DocumentObject* Cur = d->vertexMap[*i];
+    if (testStatus(Document::ParallelRecompute)) {
+        std::vector<DocumentObject*> objs;
+        for (std::vector<DocumentObject*>::reverse_iterator i = d->recomputeOrder.rbegin();i != d->recomputeOrder.rend(); ++i) {
+            DocumentObject* Cur = *i;
+            if (!Cur) continue;
 
-        if (recomputeList.find(Cur) != recomputeList.end() ||
-                Cur->ExpressionEngine.depsAreTouched()) {
-            if ( _recomputeFeature(Cur)) {
-                // if somthing happen break execution of recompute
-                d->vertexMap.clear();
-                return -1;
+            if (recomputeList.find(Cur) != recomputeList.end() ||
+                    Cur->ExpressionEngine.depsAreTouched())
+                objs.push_back(Cur);
+        }
+
+        if (_recomputeFeatures(objs, objectCount)) {
+            // if somthing happen break execution of recompute
+            for (auto obj : d->recomputeOrder) {
+                if (obj) d->markDirty(obj);
+            }
+            d->recomputeOrder.clear();
+            return -1;
+        }
+    }
+    else {
+        for (std::vector<DocumentObject*>::reverse_iterator i = d->recomputeOrder.rbegin();i != d->recomputeOrder.rend(); ++i) {
+            DocumentObject* Cur = *i;
+            if (!Cur) continue;
+
+            if (recomputeList.find(Cur) != recomputeList.end() ||
+                    Cur->ExpressionEngine.depsAreTouched()) {
+                if ( _recomputeFeature(Cur)) {
+                    // if somthing happen break execution of recompute
+                    for (auto obj : d->recomputeOrder) {
+                        if (obj) d->markDirty(obj);
+                    }
+                    d->recomputeOrder.clear();
+                    return -1;
+                }
+                ++objectCount;
             }
-            ++objectCount;
         }
     }
 
-    // reset all touched
-    for (std::map<Vertex,DocumentObject*>::iterator it = d->vertexMap.begin(); it != d->vertexMap.end(); ++it) {
-        if ((it->second) && isIn(it->second))
-            it->second->purgeTouched();
+    // reset all touched, objects outside the visited ones changed meanwhile stay dirty
+    std::unordered_set<const DocumentObject*> visited;
+    for (std::vector<DocumentObject*>::iterator it = d->recomputeOrder.begin(); it != d->recomputeOrder.end(); ++it) {
+        if (*it) {
+            (*it)->purgeTouched();
+            visited.insert(*it);
+        }
     }
-    d->vertexMap.clear();
+    std::vector<DocumentObject*> dirtyList;
+    dirtyList.swap(d->dirtyList);
+    d->dirtySet.clear();
+    for (auto obj : dirtyList) {
+        if (visited.find(obj) == visited.end())
+            d->markDirty(obj);
+    }
+
+    int visitedCount = static_cast<int>(visited.size());
+    d->recomputeOrder.clear();
 
-    signalRecomputed(*this);
+    signalRecomputed(*this, visitedCount, objectCount);
     
     return objectCount;
 }
@@ -2013,35 +2302,40 @@ int Document::recompute()
 
 std::vector<App::DocumentObject*> Document::topologicalSort() const
 {
-    // topological sort algorithm described here:
-    // https://de.wikipedia.org/wiki/Topologische_Sortierung#Algorithmus_f.C3.BCr_das_Topologische_Sortieren
+    // Kahn's algorithm on the dependency index, see
+    // https://en.wikipedia.org/wiki/Topological_sorting#Kahn.27s_algorithm
+    // An object is emitted once all objects linking to it have been emitted.
+    d->checkDepIndex();
+
     vector < App::DocumentObject* > ret;
     ret.reserve(d->objectArray.size());
-    map < App::DocumentObject*,int > countMap;
-
-    for (auto objectIt : d->objectArray)
-        countMap[objectIt] = objectIt->getInList().size();
+    std::unordered_map < const App::DocumentObject*, size_t > countMap;
+    countMap.reserve(d->objectArray.size());
+    std::deque < App::DocumentObject* > rootObjects;
 
-    auto rootObjeIt = find_if(countMap.begin(), countMap.end(), [](pair < App::DocumentObject*, int > count)->bool {
-        return count.second == 0;
-    });
+    for (auto objectIt : d->objectArray) {
+        auto inListIt = d->inLinks.find(objectIt);
+        size_t count = inListIt != d->inLinks.end() ? inListIt->second.size() : 0;
+        countMap[objectIt] = count;
+        if (count == 0)
+            rootObjects.push_back(objectIt);
+    }
 
-    if (rootObjeIt == countMap.end()){
+    if (rootObjects.empty() && !d->objectArray.empty()) {
         cerr << "Document::topologicalSort: cyclic dependency detected (no root object)" << endl;
         return ret;
     }
 
-    while (rootObjeIt != countMap.end()){
-        rootObjeIt->second = rootObjeIt->second - 1;
-        for (auto outListIt : rootObjeIt->first->getOutList()){
+    while (!rootObjects.empty()) {
+        App::DocumentObject* rootObj = rootObjects.front();
+        rootObjects.pop_front();
+        ret.push_back(rootObj);
+
+        for (auto outListIt : d->outLinks[rootObj]) {
             auto outListMapIt = countMap.find(outListIt);
-            outListMapIt->second = outListMapIt->second - 1;
+            if (outListMapIt != countMap.end() && --outListMapIt->second == 0)
+                rootObjects.push_back(outListIt);
         }
-        ret.push_back(rootObjeIt->first);
-
-        rootObjeIt = find_if(countMap.begin(), countMap.end(), [](pair < App::DocumentObject*, int > count)->bool {
-            return count.second == 0;
-        });
     }
 
     return ret;
@@ -2055,8 +2349,15 @@ const char * Document::getErrorDescription(const App::DocumentObject*Obj) const
     return 0;
 }
 
+struct Document::RecomputeJob {
+    DocumentObject* object;
+    DocumentObjectExecReturn* returnCode;
+    std::exception_ptr error; ///< exception thrown by the recompute, if any
+};
+
 // call the recompute of the Feature and handle the exceptions and errors.
-bool Document::_recomputeFeature(DocumentObject* Feat)
+// If the feature was recomputed in a worker thread, only its result is handled.
+bool Document::_recomputeFeature(DocumentObject* Feat, RecomputeJob* job)
 {
 #ifdef FC_LOGFEATUREUPDATE
     std::clog << "Solv: Executing Feature: " << Feat->getNameInDocument() << std::endl;;
@@ -2064,18 +2365,25 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
 
     DocumentObjectExecReturn  *returnCode = 0;
     try {
-        returnCode = Feat->ExpressionEngine.execute();
-        if (returnCode != DocumentObject::StdReturn) {
-            returnCode->Which = Feat;
-            _RecomputeLog.push_back(returnCode);
+        if (job) {
+            if (job->error)
+                std::rethrow_exception(job->error);
+            returnCode = job->returnCode;
+        }
+        else {
+            returnCode = Feat->ExpressionEngine.execute();
+            if (returnCode != DocumentObject::StdReturn) {
+                returnCode->Which = Feat;
+                _RecomputeLog.push_back(returnCode);
     #ifdef FC_DEBUG
-            Base::Console().Error("%s\n",returnCode->Why.c_str());
+                Base::Console().Error("%s\n",returnCode->Why.c_str());
     #endif
-            Feat->setError();
-            return true;
-        }
+                Feat->setError();
+                return true;
+            }
 
-        returnCode = Feat->recompute();
+            returnCode = Feat->recompute();
+        }
     }
     catch(Base::AbortException &e){
         e.ReportException();
@@ -2125,6 +2433,97 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
     return false;
 }
 
+bool Document::_recomputeFeatures(const std::vector<App::DocumentObject*>& objs, int& objectCount)
+{
+    // Group the objects into levels: an object is on the level after the highest level
+    // of the objects it depends on, so that all objects of a level are independent.
+    std::unordered_map<const DocumentObject*, size_t> levelMap;
+    std::vector< std::vector<DocumentObject*> > levels;
+    for (auto obj : objs) {
+        size_t level = 0;
+        for (auto link : d->outLinks[obj]) {
+            auto it = levelMap.find(link);
+            if (it != levelMap.end())
+                level = std::max(level, it->second + 1);
+        }
+        levelMap[obj] = level;
+        if (levels.size() <= level)
+            levels.resize(level + 1);
+        levels[level].push_back(obj);
+    }
+
+    for (auto& level : levels) {
+        std::vector<DocumentObject*> serial;
+        std::vector<RecomputeJob> jobs;
+        for (auto obj : level) {
+            // the object has been removed by an object recomputed before
+            if (d->outLinks.find(obj) == d->outLinks.end())
+                continue;
+            // expressions are evaluated by the Python interpreter and must stay in this thread
+            if (obj->canRecomputeInParallel() && obj->ExpressionEngine.numExpressions() == 0) {
+                RecomputeJob job = {obj, DocumentObject::StdReturn, std::exception_ptr()};
+                jobs.push_back(job);
+            }
+            else {
+                serial.push_back(obj);
+            }
+        }
+
+        if (!jobs.empty()) {
+            d->parallelRecompute = true;
+            d->recomputeThread = QThread::currentThread();
+            QtConcurrent::blockingMap(jobs, [](RecomputeJob& job) {
+                try {
+                    job.returnCode = job.object->recompute();
+                }
+                catch (...) {
+                    job.error = std::current_exception();
+                }
+            });
+            d->parallelRecompute = false;
+        }
+
+        // emit the deferred signals in the order of the recomputed objects
+        std::unordered_map<const DocumentObject*, size_t> jobIndex;
+        for (size_t i = 0; i < jobs.size(); ++i)
+            jobIndex[jobs[i].object] = i;
+        std::vector<std::pair<const DocumentObject*, const Property*> > changed;
+        changed.swap(d->changedInThread);
+        std::stable_sort(changed.begin(), changed.end(),
+            [&jobIndex](const std::pair<const DocumentObject*, const Property*>& a,
+                        const std::pair<const DocumentObject*, const Property*>& b) {
+                auto it = jobIndex.find(a.first);
+                auto jt = jobIndex.find(b.first);
+                size_t ia = it != jobIndex.end() ? it->second : jobIndex.size();
+                size_t ib = jt != jobIndex.end() ? jt->second : jobIndex.size();
+                return ia < ib;
+            });
+        for (auto it : changed)
+            signalChangedObject(*it.first, *it.second);
+
+        // handle the results in the same order and the same way as a serial recompute
+        bool abort = false;
+        for (auto& job : jobs) {
+            if (_recomputeFeature(job.object, &job))
+                abort = true;
+            ++objectCount;
+        }
+        if (abort)
+            return true;
+
+        // the objects which must stay in this thread run once the workers have finished
+        for (auto obj : serial) {
+            if (d->outLinks.find(obj) == d->outLinks.end())
+                continue;
+            if (_recomputeFeature(obj))
+                return true;
+            ++objectCount;
+        }
+    }
+
+    return false;
+}
+
 void Document::recomputeFeature(DocumentObject* Feat)
 {
      // delete recompute log
@@ -2176,6 +2575,8 @@ DocumentObject * Document::addObject(const char* sType, const char* pObjectName,
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
     // insert in the vector
     d->objectArray.push_back(pcObject);
+    d->addToDepIndex(pcObject);
+    ObjectIdentifier::touchResolveRevision();
     // insert in the adjacence list and referenc through the ConectionMap
     //_DepConMap[pcObject] = add_vertex(_DepList);
 
@@ -2231,6 +2632,8 @@ void Document::addObject(DocumentObject* pcObject, const char* pObjectName)
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
     // insert in the vector
     d->objectArray.push_back(pcObject);
+    d->addToDepIndex(pcObject);
+    ObjectIdentifier::touchResolveRevision();
 
     pcObject->Label.setValue( ObjectName );
 
@@ -2251,6 +2654,8 @@ void Document::_addObject(DocumentObject* pcObject, const char* pObjectName)
     std::string ObjectName = getUniqueObjectName(pObjectName);
     d->objectMap[ObjectName] = pcObject;
     d->objectArray.push_back(pcObject);
+    d->addToDepIndex(pcObject);
+    ObjectIdentifier::touchResolveRevision();
     // cache the pointer to the name string in the Object (for performance of DocumentObject::getNameInDocument())
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
 
@@ -2306,18 +2711,12 @@ void Document::remObject(const char* sName)
         signalTransactionRemove(*pos->second, 0);
     }
 
-#ifdef USE_OLD_DAG
-    if (!d->vertexMap.empty()) {
-        // recompute of document is running
-        for (std::map<Vertex,DocumentObject*>::iterator it = d->vertexMap.begin(); it != d->vertexMap.end(); ++it) {
-            if (it->second == pos->second) {
-                it->second = 0; // just nullify the pointer
-                break;
-            }
-        }
+    if (!d->recomputeOrder.empty()) {
+        // recompute of document is running, just nullify the pointer
+        std::replace(d->recomputeOrder.begin(), d->recomputeOrder.end(),
+                     pos->second, static_cast<DocumentObject*>(0));
     }
-#endif //USE_OLD_DAG
-    
+
     // Before deleting we must nullify all dependant objects
     breakDependency(pos->second, true);
 
@@ -2346,6 +2745,8 @@ void Document::remObject(const char* sName)
             break;
         }
     }
+    d->removeFromDepIndex(pos->second);
+    ObjectIdentifier::touchResolveRevision();
     // remove from adjancy list
     //remove_vertex(_DepConMap[pos->second],_DepList);
     //_DepConMap.erase(pos->second);
@@ -2400,6 +2801,8 @@ void Document::_remObject(DocumentObject* pcObject)
             break;
         }
     }
+    d->removeFromDepIndex(pcObject);
+    ObjectIdentifier::touchResolveRevision();
 
     // for a rollback delete the object
     if (d->rollback) {
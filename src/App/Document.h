@@ -66,6 +66,7 @@ public:
         SkipRecompute = 0,
         KeepTrailingDigits = 1,
         Closable = 2,
+        ParallelRecompute = 3,
     };
 
     /** @name Properties */
@@ -143,7 +144,8 @@ public:
                         Base::XMLReader&)> signalImportObjects;
     boost::signal<void (const std::vector<App::DocumentObject*>&, Base::Reader&,
                         const std::map<std::string, std::string>&)> signalImportViewObjects;
-    boost::signal<void (const App::Document&)> signalRecomputed;
+    /// signal after a recompute with the number of visited and executed objects
+    boost::signal<void (const App::Document&, int, int)> signalRecomputed;
     //@}
 
     /** @name File handling of the document */
@@ -275,8 +277,10 @@ public:
     void abortTransaction();
     /// Check if a transaction is open
     bool hasPendingTransaction() const;
-    /// Set the Undo limit in Byte!
+    /// Set the Undo limit in Byte! The oldest transactions are dropped when it is exceeded, 0 means no limit
     void setUndoLimit(unsigned int UndoMemSize=0);
+    /// Returns the Undo limit in Byte
+    unsigned int getUndoLimit(void) const;
     /// Returns the actual memory consumption of the Undo redo stuff.
     unsigned int getUndoMemSize (void) const;
     /// Set the Undo limit as stack size
@@ -352,8 +356,14 @@ protected:
     void onBeforeChangeProperty(const TransactionalObject *Who, const Property *What);
     /// callback from the Document objects after property was changed
     void onChangedProperty(const DocumentObject *Who, const Property *What);
-    /// helper which Recompute only this feature
-    bool _recomputeFeature(DocumentObject* Feat);
+    /// callback from the Document objects when touched, remembers it for the next recompute
+    void _markDirty(DocumentObject* obj);
+    /// result of an object recomputed in a worker thread
+    struct RecomputeJob;
+    /// helper which Recompute only this feature, or handles the result of \a job if given
+    bool _recomputeFeature(DocumentObject* Feat, RecomputeJob* job=0);
+    /// helper which recomputes the given objects, sorted dependencies first, using worker threads
+    bool _recomputeFeatures(const std::vector<App::DocumentObject*>& objs, int& objectCount);
     void _clearRedos();
 
     /// refresh the internal dependency graph
@@ -37,6 +37,8 @@
 #include <App/DocumentObjectPy.h>
 #include <boost/signals/connection.hpp>
 #include <boost/bind.hpp>
+#include <unordered_set>
+#include <deque>
 
 using namespace App;
 
@@ -201,35 +203,31 @@ std::vector<App::DocumentObject*> DocumentObject::getInList(void) const
 #endif // if USE_OLD_DAG
 
 
-void _getInListRecursive(std::vector<DocumentObject*>& objSet, const DocumentObject* obj, const DocumentObject* checkObj, int depth)
-{
-    for (const auto objIt : obj->getInList()){
-        // if the check object is in the recursive inList we have a cycle!
-        if (objIt == checkObj || depth <= 0){
-            std::cerr << "DocumentObject::getInListRecursive(): cyclic dependency detected!"<<std::endl;
-            throw Base::Exception("DocumentObject::getInListRecursive(): cyclic dependency detected!");
-        }
-
-        objSet.push_back(objIt);
-        _getInListRecursive(objSet, objIt, checkObj,depth-1);
-    }
-}
-
 std::vector<App::DocumentObject*> DocumentObject::getInListRecursive(void) const
 {
-    // number of objects in document is a good estimate in result size
-    int maxDepth = getDocument()->countObjects() +2;
+    // breadth-first walk over the in-lists, every object is visited only once
     std::vector<App::DocumentObject*> result;
-    result.reserve(maxDepth);
+    std::unordered_set<const DocumentObject*> visited;
+    std::deque<const DocumentObject*> pending(1, this);
+
+    while (!pending.empty()) {
+        const DocumentObject* obj = pending.front();
+        pending.pop_front();
+        for (const auto objIt : obj->getInList()) {
+            // if the check object is in the recursive inList we have a cycle!
+            if (objIt == this) {
+                std::cerr << "DocumentObject::getInListRecursive(): cyclic dependency detected!"<<std::endl;
+                throw Base::Exception("DocumentObject::getInListRecursive(): cyclic dependency detected!");
+            }
 
-    // using a rcursie helper to collect all InLists
-    _getInListRecursive(result, this, this, maxDepth);
+            if (visited.insert(objIt).second) {
+                result.push_back(objIt);
+                pending.push_back(objIt);
+            }
+        }
+    }
 
-    // remove duplicate entries and resize the vector
     std::sort(result.begin(), result.end());
-    auto newEnd = std::unique(result.begin(), result.end());
-    result.resize(std::distance(result.begin(), newEnd));
-
     return result;
 }
 
@@ -416,8 +414,10 @@ void DocumentObject::onChanged(const Property* prop)
     if (_pDoc)
         _pDoc->onChangedProperty(this,prop);
 
-    if (prop == &Label && _pDoc && oldLabel != Label.getStrValue())
+    if (prop == &Label && _pDoc && oldLabel != Label.getStrValue()) {
+        ObjectIdentifier::touchResolveRevision();
         _pDoc->signalRelabelObject(*this);
+    }
 
     if (prop->getType() & Prop_Output)
         return;
@@ -443,6 +443,8 @@ std::vector<PyObject *> DocumentObject::getPySubObjects(const std::vector<std::s
 void DocumentObject::touch(void)
 {
     StatusBits.set(0);
+    if (_pDoc)
+        _pDoc->_markDirty(this);
 }
 
 /**
@@ -186,6 +186,14 @@ public:
     /// Recompute only this feature
     bool recomputeFeature();
 
+    /** Returns true if execute() of this object can run in a worker thread while
+     * other, independent objects of the document are recomputed. This is only
+     * used if parallel recompute is enabled for the document.
+     */
+    virtual bool canRecomputeInParallel(void) const {
+        return false;
+    }
+
     /// get the status Message
     const char *getStatusString(void) const;
 
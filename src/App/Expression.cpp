@@ -33,6 +33,7 @@
 #include <App/DocumentObject.h>
 #include <App/PropertyUnits.h>
 #include <Base/QuantityPy.h>
+#include <QAtomicInt>
 #include <QStringList>
 #include <string>
 #include <sstream>
@@ -42,6 +43,7 @@
 #include <deque>
 #include <algorithm>
 #include "Expression.h"
+#include "CompiledExpression.h"
 #include <Base/Unit.h>
 #include <App/PropertyUnits.h>
 #include <App/ObjectIdentifier.h>
@@ -123,6 +125,8 @@ std::string unquote(const std::string & input)
 
 TYPESYSTEM_SOURCE_ABSTRACT(App::Expression, Base::BaseClass);
 
+static QAtomicInt expressionRevision;
+
 Expression::Expression(const DocumentObject *_owner)
     : owner(_owner)
 {
@@ -133,11 +137,58 @@ Expression::~Expression()
 {
 }
 
+/**
+ * @brief Get the current expression revision.
+ *
+ * The revision changes whenever an expression tree is modified in place, so that
+ * compiled forms of it are compiled again.
+ *
+ * @return Revision number.
+ */
+
+int Expression::getRevision()
+{
+    return expressionRevision.fetchAndAddOrdered(0);
+}
+
+/**
+ * @brief Increment the expression revision.
+ */
+
+void Expression::touchRevision()
+{
+    expressionRevision.fetchAndAddOrdered(1);
+}
+
 Expression * Expression::parse(const DocumentObject *owner, const std::string &buffer)
 {
     return ExpressionParser::parse(owner, buffer.c_str());
 }
 
+/**
+  * Visitor that sets the owner of each node. The revision is not touched, the
+  * nodes are only changed while copying them.
+  */
+
+class Expression::OwnerSetter : public ExpressionVisitor {
+public:
+    OwnerSetter(const DocumentObject * _owner) : owner(_owner) { }
+
+    void visit(Expression * e) { e->setOwner(owner); }
+
+private:
+    const DocumentObject * owner;
+};
+
+Expression * Expression::copyWithOwner(const DocumentObject *newOwner) const
+{
+    Expression * expr = copy();
+    OwnerSetter v(newOwner);
+
+    expr->visit(v);
+    return expr;
+}
+
 //
 // UnitExpression class
 //
@@ -162,6 +213,7 @@ UnitExpression::UnitExpression(const DocumentObject *_owner, const Base::Quantit
 void UnitExpression::setUnit(const Quantity &_quantity)
 {
     quantity = _quantity;
+    touchRevision();
 }
 
 /**
@@ -263,6 +315,7 @@ int NumberExpression::priority() const
 void NumberExpression::negate()
 {
     quantity.setValue(-quantity.getValue());
+    touchRevision();
 }
 
 std::string NumberExpression::toString() const
@@ -344,8 +397,6 @@ Expression * OperatorExpression::eval() const
     NumberExpression * v1;
     std::unique_ptr<Expression> e2(right->eval());
     NumberExpression * v2;
-    Expression * output;
-    const double epsilon = std::numeric_limits<double>::epsilon();
 
     v1 = freecad_dynamic_cast<NumberExpression>(e1.get());
     v2 = freecad_dynamic_cast<NumberExpression>(e2.get());
@@ -353,67 +404,86 @@ Expression * OperatorExpression::eval() const
     if (v1 == 0 || v2 == 0)
         throw ExpressionError("Invalid expression");
 
+    Quantity output = evalOperator(op, v1->getQuantity(), v2->getQuantity());
+
+    if (isComparison(op))
+        return new BooleanExpression(owner, output.getValue() != 0.0);
+    else
+        return new NumberExpression(owner, output);
+}
+
+/**
+  * Apply the operator \a op to the values \a v1 and \a v2. Comparisons return
+  * 1 or 0. Throws an ExpressionError exception if the units do not match.
+  *
+  * This is used by eval() and by CompiledExpression.
+  */
+
+Quantity OperatorExpression::evalOperator(Operator op, const Quantity & v1, const Quantity & v2)
+{
+    Quantity output;
+    const double epsilon = std::numeric_limits<double>::epsilon();
+
     switch (op) {
     case ADD:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for + operator");
-        output = new NumberExpression(owner, v1->getQuantity() + v2->getQuantity());
+        output = v1 + v2;
         break;
     case SUB:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for - operator");
-        output = new NumberExpression(owner, v1->getQuantity()- v2->getQuantity());
+        output = v1 - v2;
         break;
     case MUL:
     case UNIT:
-        output = new NumberExpression(owner, v1->getQuantity() * v2->getQuantity());
+        output = v1 * v2;
         break;
     case DIV:
-        output = new NumberExpression(owner, v1->getQuantity() / v2->getQuantity());
+        output = v1 / v2;
         break;
     case POW:
-        output = new NumberExpression(owner, v1->getQuantity().pow(v2->getQuantity()) );
+        output = v1.pow(v2);
         break;
     case EQ:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for the = operator");
-        output = new BooleanExpression(owner, essentiallyEqual(v1->getValue(), v2->getValue(), epsilon) );
+        output = Quantity(essentiallyEqual(v1.getValue(), v2.getValue(), epsilon));
         break;
     case NEQ:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for the != operator");
-        output = new BooleanExpression(owner, !essentiallyEqual(v1->getValue(), v2->getValue(), epsilon) );
+        output = Quantity(!essentiallyEqual(v1.getValue(), v2.getValue(), epsilon));
         break;
     case LT:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for the < operator");
-        output = new BooleanExpression(owner, definitelyLessThan(v1->getValue(), v2->getValue(), epsilon) );
+        output = Quantity(definitelyLessThan(v1.getValue(), v2.getValue(), epsilon));
         break;
     case GT:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for the > operator");
-        output = new BooleanExpression(owner, definitelyGreaterThan(v1->getValue(), v2->getValue(), epsilon) );
+        output = Quantity(definitelyGreaterThan(v1.getValue(), v2.getValue(), epsilon));
         break;
     case LTE:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for the <= operator");
-        output = new BooleanExpression(owner, definitelyLessThan(v1->getValue(), v2->getValue(), epsilon) ||
-                                       essentiallyEqual(v1->getValue(), v2->getValue(), epsilon));
+        output = Quantity(definitelyLessThan(v1.getValue(), v2.getValue(), epsilon) ||
+                          essentiallyEqual(v1.getValue(), v2.getValue(), epsilon));
         break;
     case GTE:
-        if (v1->getUnit() != v2->getUnit())
+        if (v1.getUnit() != v2.getUnit())
             throw ExpressionError("Incompatible units for the >= operator");
-        output = new BooleanExpression(owner, essentiallyEqual(v1->getValue(), v2->getValue(), epsilon) ||
-                                       definitelyGreaterThan(v1->getValue(), v2->getValue(), epsilon));
+        output = Quantity(essentiallyEqual(v1.getValue(), v2.getValue(), epsilon) ||
+                          definitelyGreaterThan(v1.getValue(), v2.getValue(), epsilon));
         break;
     case NEG:
-        output = new NumberExpression(owner, -v1->getQuantity() );
+        output = -v1;
         break;
     case POS:
-        output = new NumberExpression(owner, v1->getQuantity() );
+        output = v1;
         break;
     default:
-        output = 0;
         assert(0);
     }
 
@@ -924,6 +994,20 @@ Expression * FunctionExpression::eval() const
     std::unique_ptr<Expression> e2(args.size() > 1 ? args[1]->eval() : 0);
     NumberExpression * v1 = freecad_dynamic_cast<NumberExpression>(e1.get());
     NumberExpression * v2 = freecad_dynamic_cast<NumberExpression>(e2.get());
+
+    return new NumberExpression(owner, evalFunction(f, v1 ? &v1->getQuantity() : 0, v2 ? &v2->getQuantity() : 0));
+}
+
+/**
+  * Compute the function \a f of \a v1 and, for functions taking two arguments, \a v2.
+  * A null pointer stands for an argument that did not evaluate to a number.
+  * Throws an ExpressionError exception if an argument or its unit is invalid.
+  *
+  * This is used by eval() and by CompiledExpression.
+  */
+
+Quantity FunctionExpression::evalFunction(Function f, const Quantity * v1, const Quantity * v2)
+{
     double output;
     Unit unit;
     double scaler = 1;
@@ -1105,7 +1189,7 @@ Expression * FunctionExpression::eval() const
         assert(0);
     }
 
-    return new NumberExpression(owner, Quantity(scaler * output, unit));
+    return Quantity(scaler * output, unit);
 }
 
 /**
@@ -1339,55 +1423,9 @@ Expression * VariableExpression::eval() const
     if (!parent->isDerivedFrom(App::DocumentObject::getClassTypeId()))
         throw ExpressionError("Property must belong to a document object.");
 
-    boost::any value = prop->getPathValue(var);
+    CompiledExpression::Value value(prop->getPathValue(var));
 
-    if (value.type() == typeid(Quantity)) {
-        Quantity qvalue = boost::any_cast<Quantity>(value);
-
-        return new NumberExpression(owner, qvalue);
-    }
-    else if (value.type() == typeid(double)) {
-        double dvalue = boost::any_cast<double>(value);
-
-        return new NumberExpression(owner, Quantity(dvalue));
-    }
-    else if (value.type() == typeid(float)) {
-        double fvalue = boost::any_cast<float>(value);
-
-        return new NumberExpression(owner, Quantity(fvalue));
-    }
-    else if (value.type() == typeid(int)) {
-        int ivalue = boost::any_cast<int>(value);
-
-        return new NumberExpression(owner, Quantity(ivalue));
-    }
-    else if (value.type() == typeid(long)) {
-        long lvalue = boost::any_cast<long>(value);
-
-        return new NumberExpression(owner, Quantity(lvalue));
-    }
-    else if (value.type() == typeid(bool)) {
-        double bvalue = boost::any_cast<bool>(value) ? 1.0 : 0.0;
-
-        return new NumberExpression(owner, Quantity(bvalue));
-    }
-    else if (value.type() == typeid(std::string)) {
-        std::string svalue = boost::any_cast<std::string>(value);
-
-        return new StringExpression(owner, svalue);
-    }
-    else if (value.type() == typeid(char*)) {
-        char* svalue = boost::any_cast<char*>(value);
-
-        return new StringExpression(owner, svalue);
-    }
-    else if (value.type() == typeid(const char*)) {
-        const char* svalue = boost::any_cast<const char*>(value);
-
-        return new StringExpression(owner, svalue);
-    }
-
-    throw ExpressionError("Property is of invalid type.");
+    return value.toExpression(owner);
 }
 
 /**
@@ -1411,6 +1449,12 @@ Expression *VariableExpression::copy() const
     return new VariableExpression(owner, var);
 }
 
+void VariableExpression::setOwner(const DocumentObject *_owner)
+{
+    Expression::setOwner(_owner);
+    var.setOwner(_owner);
+}
+
 int VariableExpression::priority() const
 {
     return 20;
@@ -1433,6 +1477,7 @@ void VariableExpression::getDeps(std::set<ObjectIdentifier> &props) const
 void VariableExpression::setPath(const ObjectIdentifier &path)
 {
      var = path;
+     touchRevision();
 }
 
 bool VariableExpression::validDocumentObjectRename(const std::string &oldName, const std::string &newName)
@@ -1442,6 +1487,7 @@ bool VariableExpression::validDocumentObjectRename(const std::string &oldName, c
 
 bool VariableExpression::renameDocumentObject(const std::string &oldName, const std::string &newName)
 {
+    touchRevision();
     return var.renameDocumentObject(oldName, newName);
 }
 
@@ -1452,6 +1498,7 @@ bool VariableExpression::validDocumentRename(const std::string &oldName, const s
 
 bool VariableExpression::renameDocument(const std::string &oldName, const std::string &newName)
 {
+    touchRevision();
     return var.renameDocument(oldName, newName);
 }
 
@@ -1582,6 +1629,7 @@ void ConditionalExpression::visit(ExpressionVisitor &v)
     condition->visit(v);
     trueExpr->visit(v);
     falseExpr->visit(v);
+    v.visit(this);
 }
 
 TYPESYSTEM_SOURCE(App::ConstantExpression, App::NumberExpression);
@@ -1678,6 +1726,7 @@ Expression *RangeExpression::simplify() const
 void RangeExpression::setRange(const Range &r)
 {
     range = r;
+    touchRevision();
 }
 
 namespace App {
@@ -1830,6 +1879,17 @@ std::vector<boost::tuple<int, int, std::string> > tokenize(const std::string &st
 
 }
 
+namespace {
+
+// The cache is emptied when it grows beyond this number of expressions
+const std::size_t MaxCacheSize = 10000;
+
+std::map<std::string, boost::shared_ptr<Expression> > ParsedExpressions; /**< Parsed expressions without owner, by text */
+unsigned long ParseCount = 0;
+unsigned long HitCount = 0;
+
+}
+
 /**
   * Parse the expression given by \a buffer, and use \a owner as the owner of the
   * returned expression. If the parser fails for some reason, and exception is thrown.
@@ -1847,6 +1907,7 @@ Expression * App::ExpressionParser::parse(const App::DocumentObject *owner, cons
     ExpressionParser::YY_BUFFER_STATE my_string_buffer = ExpressionParser::ExpressionParser_scan_string (buffer);
 
     initParser(owner);
+    ++ParseCount;
 
     // run the parser
     int result = ExpressionParser::ExpressionParser_yyparse ();
@@ -1869,6 +1930,56 @@ Expression * App::ExpressionParser::parse(const App::DocumentObject *owner, cons
     }
 }
 
+/**
+  * Same as parse(), but the string is parsed only once. Documents with many
+  * cells or bindings often repeat the same formulas, e.g. when they are
+  * restored or imported. The cache keeps an expression without owner for each
+  * string; the returned expression is a copy of it owned by \a owner, so the
+  * caller may modify or delete it. Strings that fail to parse are not cached.
+  *
+  * @param owner  The DocumentObject that will own the expression.
+  * @param buffer The sting buffer to parse.
+  *
+  * @returns A pointer to an expression.
+  *
+  */
+
+Expression * App::ExpressionParser::parseCached(const App::DocumentObject *owner, const char* buffer)
+{
+    std::map<std::string, boost::shared_ptr<Expression> >::const_iterator it = ParsedExpressions.find(buffer);
+
+    if (it != ParsedExpressions.end()) {
+        ++HitCount;
+        return it->second->copyWithOwner(owner);
+    }
+
+    boost::shared_ptr<Expression> expr(parse(0, buffer));
+
+    if (ParsedExpressions.size() >= MaxCacheSize)
+        clearCache();
+    ParsedExpressions[buffer] = expr;
+    return expr->copyWithOwner(owner);
+}
+
+ExpressionParser::CacheStatistics ExpressionParser::getCacheStatistics()
+{
+    CacheStatistics stats;
+
+    stats.parses = ParseCount;
+    stats.hits = HitCount;
+    stats.size = ParsedExpressions.size();
+    return stats;
+}
+
+/**
+  * Delete the expressions kept by parseCached().
+  */
+
+void ExpressionParser::clearCache()
+{
+    ParsedExpressions.clear();
+}
+
 UnitExpression * ExpressionParser::parseUnit(const App::DocumentObject *owner, const char* buffer)
 {
     // parse from buffer
@@ -90,6 +90,9 @@ public:
 
     virtual Expression * copy() const = 0;
 
+    /// Returns a copy of the expression in which all nodes are owned by \a newOwner
+    Expression * copyWithOwner(const App::DocumentObject * newOwner) const;
+
     virtual int priority() const { return 0; }
 
     virtual void getDeps(std::set<ObjectIdentifier> &/*props*/) const { }
@@ -107,8 +110,18 @@ public:
 
     virtual boost::any getValueAsAny() const { static boost::any empty; return empty; }
 
+    /// Returns a number that changes whenever an expression tree is modified in place
+    static int getRevision();
+
 protected:
+    static void touchRevision();
+
+    virtual void setOwner(const App::DocumentObject * _owner) { owner = _owner; }
+
     const App::DocumentObject * owner; /**< The document object used to access unqualified variables (i.e local scope) */
+
+private:
+    class OwnerSetter;
 };
 
 /**
@@ -252,6 +265,10 @@ public:
 
     Expression * getRight() const { return right; }
 
+    static Base::Quantity evalOperator(Operator op, const Base::Quantity & v1, const Base::Quantity & v2);
+
+    static bool isComparison(Operator op) { return op >= EQ && op <= GTE; }
+
 protected:
 
     virtual bool isCommutative() const;
@@ -288,6 +305,12 @@ public:
 
     virtual void visit(ExpressionVisitor & v);
 
+    Expression * getCondition() const { return condition; }
+
+    Expression * getTrueExpression() const { return trueExpr; }
+
+    Expression * getFalseExpression() const { return falseExpr; }
+
 protected:
 
     Expression * condition;  /**< Condition */
@@ -363,6 +386,12 @@ public:
 
     virtual void visit(ExpressionVisitor & v);
 
+    Function getFunction() const { return f; }
+
+    const std::vector<Expression*> & getArgs() const { return args; }
+
+    static Base::Quantity evalFunction(Function f, const Base::Quantity * v1, const Base::Quantity * v2);
+
 protected:
     Expression *evalAggregate() const;
 
@@ -417,6 +446,8 @@ public:
 
 protected:
 
+    virtual void setOwner(const App::DocumentObject * _owner);
+
     ObjectIdentifier var; /**< Variable name  */
 };
 
@@ -480,6 +511,20 @@ namespace ExpressionParser {
 AppExport Expression * parse(const App::DocumentObject *owner, const char *buffer);
 AppExport UnitExpression * parseUnit(const App::DocumentObject *owner, const char *buffer);
 AppExport ObjectIdentifier parsePath(const App::DocumentObject *owner, const char* buffer);
+AppExport Expression * parseCached(const App::DocumentObject *owner, const char *buffer);
+
+/**
+ * @brief The CacheStatistics struct counts the work done by parse() and parseCached().
+ */
+
+struct CacheStatistics {
+    unsigned long parses; /**< Number of strings run through the parser */
+    unsigned long hits;   /**< Number of parseCached() calls answered from the cache */
+    std::size_t size;     /**< Number of expressions in the cache */
+};
+
+AppExport CacheStatistics getCacheStatistics();
+AppExport void clearCache();
 AppExport bool isTokenAnIndentifier(const std::string & str);
 AppExport std::vector<boost::tuple<int, int, std::string> > tokenize(const std::string & str);
 
@@ -95,6 +95,10 @@ public:
         }
         return DocumentObject::StdReturn;
     }
+    /// Python features are always recomputed in the main thread
+    virtual bool canRecomputeInParallel(void) const {
+        return false;
+    }
     /// returns the type name of the ViewProvider
     virtual const char* getViewProviderName(void) const {
         return FeatureT::getViewProviderName();
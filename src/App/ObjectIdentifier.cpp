@@ -39,10 +39,13 @@
 #include <Base/Tools.h>
 #include <Base/Interpreter.h>
 #include <Base/QuantityPy.h>
+#include <QAtomicInt>
 
 using namespace App;
 using namespace Base;
 
+static QAtomicInt resolveRevision;
+
 /**
  * @brief Compute a hash value for the object identifier given by \a path.
  * @param path Inputn path
@@ -1133,3 +1136,27 @@ std::string ObjectIdentifier::ResolveResults::resolveErrorString() const
 
     return "";
 }
+
+/**
+ * @brief Get the current resolve revision.
+ *
+ * Code that keeps the property an object identifier resolved to must resolve it again
+ * when the revision changed, because the property might have been destroyed or the
+ * identifier might refer to another object now.
+ *
+ * @return Revision number.
+ */
+
+int ObjectIdentifier::getResolveRevision()
+{
+    return resolveRevision.fetchAndAddOrdered(0);
+}
+
+/**
+ * @brief Increment the resolve revision.
+ */
+
+void ObjectIdentifier::touchResolveRevision()
+{
+    resolveRevision.fetchAndAddOrdered(1);
+}
@@ -162,6 +162,8 @@ public:
 
     virtual ~ObjectIdentifier() {}
 
+    void setOwner(const App::PropertyContainer * _owner) { owner = _owner; }
+
     // Components
     void addComponent(const Component &c) { components.push_back(c); }
 
@@ -237,6 +239,12 @@ public:
 
     std::string resolveErrorString() const;
 
+    /// Returns a number that changes whenever object identifiers may resolve to other properties
+    static int getResolveRevision();
+
+    /// Is called when properties are added or destroyed, or objects and documents are added, removed or relabeled
+    static void touchResolveRevision();
+
 protected:
 
     struct ResolveResults {
@@ -56,7 +56,9 @@ Property::Property()
 
 Property::~Property()
 {
-
+    // compiled expressions must look up their properties again
+    if (father)
+        ObjectIdentifier::touchResolveRevision();
 }
 
 const char* Property::getName(void) const
@@ -82,6 +84,7 @@ const char* Property::getDocumentation(void) const
 void Property::setContainer(PropertyContainer *Father)
 {
     father = Father;
+    ObjectIdentifier::touchResolveRevision();
 }
 
 void Property::setPathValue(const ObjectIdentifier &path, const boost::any &value)
@@ -198,7 +198,7 @@ void PropertyExpressionEngine::Restore(Base::XMLReader &reader)
 
         reader.readElement("Expression");
         ObjectIdentifier path = ObjectIdentifier::parse(docObj, reader.getAttribute("path"));
-        boost::shared_ptr<Expression> expression(ExpressionParser::parse(docObj, reader.getAttribute("expression")));
+        boost::shared_ptr<Expression> expression(ExpressionParser::parseCached(docObj, reader.getAttribute("expression")));
         const char * comment = reader.hasAttribute("comment") ? reader.getAttribute("comment") : 0;
 
         restoredExpressions[path] = ExpressionInfo(expression, comment);
@@ -559,6 +559,7 @@ DocumentObjectExecReturn *App::PropertyExpressionEngine::execute()
     // Compute evaluation order
     std::vector<App::ObjectIdentifier> evaluationOrder = computeEvaluationOrder();
     std::vector<ObjectIdentifier>::const_iterator it = evaluationOrder.begin();
+    bool useCompiled = CompiledExpression::isEnabled();
 
 #ifdef FC_PROPERTYEXPRESSIONENGINE_LOG
     std::clog << "Computing expressions for " << getName() << std::endl;
@@ -580,12 +581,22 @@ DocumentObjectExecReturn *App::PropertyExpressionEngine::execute()
             throw Base::Exception("Invalid property owner.");
 
         // Evaluate expression
-        std::unique_ptr<Expression> e(expressions[*it].expression->eval());
+        ExpressionInfo & info = expressions[*it];
+        boost::any value;
+
+        if (useCompiled) {
+            if (!info.compiled || !info.compiled->isUpToDate())
+                info.compiled.reset(new CompiledExpression(info.expression.get()));
+            value = info.compiled->eval().getValueAsAny();
+        }
+        else {
+            std::unique_ptr<Expression> e(info.expression->eval());
+            value = e->getValueAsAny();
+        }
 
 #ifdef FC_PROPERTYEXPRESSIONENGINE_LOG
         {
             Base::Quantity q;
-            boost::any value = e->getValueAsAny();
 
             if (value.type() == typeid(Base::Quantity))
                 q = boost::any_cast<Base::Quantity>(value);
@@ -601,7 +612,7 @@ DocumentObjectExecReturn *App::PropertyExpressionEngine::execute()
 #endif
 
         /* Set value of property */
-        prop->setPathValue(*it, e->getValueAsAny());
+        prop->setPathValue(*it, value);
 
         ++it;
     }
@@ -30,6 +30,7 @@
 #include <boost/graph/topological_sort.hpp>
 #include <App/Property.h>
 #include <App/Expression.h>
+#include <App/CompiledExpression.h>
 #include <set>
 
 namespace Base {
@@ -59,6 +60,7 @@ public:
     struct ExpressionInfo {
         boost::shared_ptr<App::Expression> expression; /**< The actual expression tree */
         std::string comment; /**< Optional comment for this expression */
+        boost::shared_ptr<App::CompiledExpression> compiled; /**< Compiled form of expression, created on first evaluation */
 
         ExpressionInfo(boost::shared_ptr<App::Expression> expression = boost::shared_ptr<App::Expression>(), const char * comment = 0) {
             this->expression = expression;
@@ -69,11 +71,13 @@ public:
         ExpressionInfo(const ExpressionInfo & other) {
             expression = other.expression;
             comment = other.comment;
+            compiled = other.compiled;
         }
 
         ExpressionInfo & operator=(const ExpressionInfo & other) {
             expression = other.expression;
             comment = other.comment;
+            compiled = other.compiled;
             return *this;
         }
     };
@@ -85,7 +85,11 @@ Transaction::~Transaction()
 
 unsigned int Transaction::getMemSize (void) const
 {
-    return 0;
+    unsigned int size = 0;
+    TransactionList::const_iterator It;
+    for (It = _Objects.begin(); It != _Objects.end(); ++It)
+        size += It->second->getMemSize();
+    return size;
 }
 
 void Transaction::Save (Base::Writer &/*writer*/) const
@@ -279,7 +283,12 @@ void TransactionObject::setProperty(const Property* pcProp)
 
 unsigned int TransactionObject::getMemSize (void) const
 {
-    return 0;
+    // the saved copies of the changed properties
+    unsigned int size = 0;
+    std::map<const Property*,Property*>::const_iterator It;
+    for (It = _PropChangeMap.begin(); It != _PropChangeMap.end(); ++It)
+        size += It->second->getMemSize();
+    return size;
 }
 
 void TransactionObject::Save (Base::Writer &/*writer*/) const
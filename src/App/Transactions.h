@@ -57,6 +57,7 @@ public:
     // the utf-8 name of the transaction
     std::string Name;
 
+    /// the memory used by the saved property values
     virtual unsigned int getMemSize (void) const;
     virtual void Save (Base::Writer &writer) const;
     /// This method is used to restore properties from an XML document.
@@ -68,3 +68,17 @@ void Persistence::SaveDocFile (Writer &/*writer*/) const
 void Persistence::RestoreDocFile(Reader &/*reader*/)
 {
 }
+
+bool Persistence::RestoreDocFileLazy(LazyFile* /*file*/)
+{
+    return false;
+}
+
+void Persistence::restoreLazyFile() const
+{
+}
+
+bool Persistence::hasLazyFile() const
+{
+    return false;
+}
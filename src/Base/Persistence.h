@@ -33,6 +33,7 @@
 
 namespace Base
 {
+class LazyFile;
 class Reader;
 class Writer;
 class XMLReader;
@@ -146,6 +147,23 @@ public:
      * @see Base::Reader,Base::XMLReader
      */
     virtual void RestoreDocFile(Reader &/*reader*/);
+    /** This method is used to defer the restoring of large amounts of data
+     * If a document is opened with lazy loading, Base::XMLReader::readFiles() calls this
+     * method instead of RestoreDocFile(). If the method returns true the object takes
+     * ownership of \a file and reads it in with restoreLazyFile() as soon as its data
+     * is accessed for the first time. The default implementation returns false, so
+     * that RestoreDocFile() is called at once.
+     * @see Base::LazyFile
+     */
+    virtual bool RestoreDocFileLazy(LazyFile* /*file*/);
+    /** Reads in the file passed to RestoreDocFileLazy() if this hasn't happened yet.
+     * The default implementation does nothing.
+     */
+    virtual void restoreLazyFile() const;
+    /** Returns true if the file passed to RestoreDocFileLazy() hasn't been read in yet.
+     * The default implementation returns false.
+     */
+    virtual bool hasLazyFile() const;
 };
 
 } //namespace Base
@@ -31,6 +31,10 @@
 #endif
 
 #include <locale>
+#include <memory>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
 
 /// Here the FreeCAD includes sorted by Base,App,Gui......
 #include "Reader.h"
@@ -320,8 +324,16 @@ void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
         // no file name for the current entry in the zip was registered.
         if (jt != FileList.end()) {
             try {
-                Base::Reader reader(zipstream, jt->FileName, DocumentSchema);
-                jt->Object->RestoreDocFile(reader);
+                // with lazy loading the object may keep a handle to the file
+                // and read it in later
+                LazyFile* file = 0;
+                if (lazyArchive.isValid())
+                    file = new LazyFile(lazyArchive, jt->FileName, DocumentSchema, jt->Object);
+                if (!file || !jt->Object->RestoreDocFileLazy(file)) {
+                    delete file;
+                    Base::Reader reader(zipstream, jt->FileName, DocumentSchema);
+                    jt->Object->RestoreDocFile(reader);
+                }
             }
             catch(...) {
                 // For any exception we just continue with the next file.
@@ -391,6 +403,11 @@ bool Base::XMLReader::doNameMapping() const
     return false;
 }
 
+void Base::XMLReader::setLazyArchive(LazyArchive* archive)
+{
+    lazyArchive = archive;
+}
+
 // ---------------------------------------------------------------------------
 //  Base::XMLReader: Implementation of the SAX DocumentHandler interface
 // ---------------------------------------------------------------------------
@@ -527,3 +544,116 @@ std::istream& Base::Reader::getStream()
     return this->_str;
 }
 
+// ----------------------------------------------------------
+
+namespace {
+// guards the pending files of all lazy archives
+QMutex lazyMutex(QMutex::Recursive);
+// number of lazy files that haven't been read yet, to skip the lock if there are none
+QAtomicInt lazyFileCount;
+}
+
+Base::LazyArchive::LazyArchive(const std::string& FileName)
+  : FileName(FileName), zipFile(0)
+{
+}
+
+Base::LazyArchive::~LazyArchive()
+{
+    delete zipFile;
+}
+
+const std::string& Base::LazyArchive::getFileName() const
+{
+    return FileName;
+}
+
+bool Base::LazyArchive::hasPendingFiles() const
+{
+    QMutexLocker locker(&lazyMutex);
+    return !files.empty();
+}
+
+void Base::LazyArchive::restoreAll()
+{
+    QMutexLocker locker(&lazyMutex);
+    // restoring a file removes it from the list
+    std::vector<LazyFile*> pending(files.begin(), files.end());
+    for (std::vector<LazyFile*>::iterator it = pending.begin(); it != pending.end(); ++it) {
+        if (files.find(*it) != files.end())
+            (*it)->object->restoreLazyFile();
+    }
+
+    delete zipFile;
+    zipFile = 0;
+}
+
+std::istream* Base::LazyArchive::open(const std::string& name)
+{
+    QMutexLocker locker(&lazyMutex);
+    // the central directory is read only once
+    if (!zipFile) {
+        try {
+            zipFile = new zipios::ZipFile(FileName);
+        }
+        catch (const std::exception&) {
+            throw Base::FileException("Cannot open project file", FileName.c_str());
+        }
+    }
+
+    std::istream* str = zipFile->getInputStream(name);
+    if (!str)
+        throw Base::FileException("Embedded file not found in project file", FileName.c_str());
+    return str;
+}
+
+// ----------------------------------------------------------
+
+Base::LazyFile::LazyFile(LazyArchive* archive, const std::string& name, int version, Persistence* object)
+  : archive(archive), name(name), version(version), object(object)
+{
+    QMutexLocker locker(&lazyMutex);
+    archive->files.insert(this);
+    lazyFileCount.fetchAndAddOrdered(1);
+}
+
+Base::LazyFile::~LazyFile()
+{
+    QMutexLocker locker(&lazyMutex);
+    archive->files.erase(this);
+    lazyFileCount.fetchAndAddOrdered(-1);
+}
+
+const std::string& Base::LazyFile::getFileName() const
+{
+    return name;
+}
+
+void Base::LazyFile::restore(const std::function<void (Reader&)>& func) const
+{
+    try {
+        std::unique_ptr<std::istream> str(archive->open(name));
+        Base::Reader reader(*str, name, version);
+        func(reader);
+    }
+    catch (...) {
+        Base::Console().Error("Reading failed from embedded file: %s\n", name.c_str());
+    }
+}
+
+void Base::LazyFile::restoreOnce(LazyFile*& file, const std::function<void (Reader&)>& func)
+{
+    if (lazyFileCount.fetchAndAddOrdered(0) == 0)
+        return;
+
+    QMutexLocker locker(&lazyMutex);
+    if (!file)
+        return;
+
+    // reset it first, so that accessing the data while reading doesn't start over
+    LazyFile* pending = file;
+    file = 0;
+    pending->restore(func);
+    delete pending;
+}
+
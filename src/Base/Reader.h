@@ -24,18 +24,22 @@
 #define BASE_READER_H
 
 
+#include <functional>
 #include <string>
 #include <map>
+#include <set>
 
 #include <xercesc/framework/XMLPScanToken.hpp>
 #include <xercesc/sax2/Attributes.hpp>
 #include <xercesc/sax2/DefaultHandler.hpp>
 
 #include "FileInfo.h"
+#include "Handle.h"
 #include "Writer.h"
 
 namespace zipios {
 class ZipInputStream;
+class ZipFile;
 }
 
 XERCES_CPP_NAMESPACE_BEGIN
@@ -45,6 +49,10 @@ XERCES_CPP_NAMESPACE_END
 
 namespace Base
 {
+class LazyArchive;
+class LazyFile;
+class Persistence;
+class Reader;
 
 
 /** The XML reader class 
@@ -164,6 +172,8 @@ public:
     virtual void addName(const char*, const char*);
     virtual const char* getName(const char*) const;
     virtual bool doNameMapping() const;
+    /// defer reading of the files to objects that support it, see Persistence::RestoreDocFileLazy()
+    void setLazyArchive(LazyArchive*);
     //@}
 
     /// Schema Version of the document
@@ -252,6 +262,7 @@ protected:
     };
     std::vector<FileEntry> FileList;
     std::vector<std::string> FileNames;
+    Reference<LazyArchive> lazyArchive;
 };
 
 class BaseExport Reader : public std::istream
@@ -268,6 +279,65 @@ private:
     int fileVersion;
 };
 
+/** The LazyArchive class
+ * A project file whose embedded files are read in on demand. It keeps track of
+ * all files that haven't been read yet.
+ * \see Base::LazyFile
+ */
+class BaseExport LazyArchive : public Handled
+{
+public:
+    LazyArchive(const std::string& FileName);
+    ~LazyArchive();
+
+    const std::string& getFileName() const;
+    /// check if there are still files that haven't been read in
+    bool hasPendingFiles() const;
+    /** Reads in all pending files. This must be done before the project file
+     * gets overwritten.
+     */
+    void restoreAll();
+    /// open an embedded file, the caller must delete the returned stream
+    std::istream* open(const std::string& name);
+
+private:
+    friend class LazyFile;
+    std::string FileName;
+    zipios::ZipFile* zipFile;
+    std::set<LazyFile*> files;
+};
+
+/** The LazyFile class
+ * Refers to a file inside a LazyArchive that is read in by its object as soon
+ * as its data is needed.
+ * \see Base::Persistence::RestoreDocFileLazy()
+ */
+class BaseExport LazyFile
+{
+public:
+    LazyFile(LazyArchive* archive, const std::string& name, int version, Persistence* object);
+    ~LazyFile();
+
+    const std::string& getFileName() const;
+    /** Opens the file and passes it to \a func. Errors are reported to the console
+     * like in XMLReader::readFiles().
+     */
+    void restore(const std::function<void (Reader&)>& func) const;
+    /** Restores \a file with \a func, deletes it and sets \a file to 0. Nothing is
+     * done if \a file is 0. Objects may be read in from several threads at once,
+     * e.g. during a parallel recompute, so \a file is checked and reset under a
+     * lock that also guards the list of pending files of the archives.
+     */
+    static void restoreOnce(LazyFile*& file, const std::function<void (Reader&)>& func);
+
+private:
+    friend class LazyArchive;
+    Reference<LazyArchive> archive;
+    std::string name;
+    int version;
+    Persistence* object;
+};
+
 }
 
 
@@ -0,0 +1,249 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <cfloat>
+# include <vector>
+#endif
+
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define BASE_VECTORARRAY_SSE2
+# include <emmintrin.h>
+#endif
+
+#include "VectorArray.h"
+
+using namespace Base;
+
+namespace {
+
+// the smallest number of points worth a thread of its own
+const std::size_t MinBlockSize = 100000;
+
+struct Block
+{
+    char* data;
+    std::size_t count;
+    BoundBox3f boxf;
+    BoundBox3d boxd;
+};
+
+inline float* pointAt(char* data, std::size_t index, std::size_t stride)
+{
+    return &(reinterpret_cast<Vector3f*>(data + index * stride)->x);
+}
+
+#if defined(BASE_VECTORARRAY_SSE2)
+// The columns of the upper three rows of a matrix: the x and y rows are in the
+// two lanes of one register, the z row in the lower lane of another one.
+struct Columns
+{
+    __m128d xy[4];
+    __m128d z[4];
+
+    Columns(const Matrix4D& mat)
+    {
+        for (int i = 0; i < 4; i++) {
+            xy[i] = _mm_set_pd(mat[1][i], mat[0][i]);
+            z[i] = _mm_set_sd(mat[2][i]);
+        }
+    }
+};
+
+// Computes the transformed point in the same order as Matrix4D::operator*()
+inline void transformPoint(const Columns& col, const float* p, __m128d& xy, __m128d& z)
+{
+    __m128d x = _mm_set1_pd(p[0]);
+    __m128d y = _mm_set1_pd(p[1]);
+    __m128d w = _mm_set1_pd(p[2]);
+    xy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(col.xy[0], x),
+                                          _mm_mul_pd(col.xy[1], y)),
+                               _mm_mul_pd(col.xy[2], w)), col.xy[3]);
+    z  = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(col.z[0], x),
+                                          _mm_mul_pd(col.z[1], y)),
+                               _mm_mul_pd(col.z[2], w)), col.z[3]);
+}
+
+// The minimum and maximum are taken such that NaN coordinates are ignored like
+// BoundBox3::Add() does.
+inline void setBoundBox(BoundBox3f& box, __m128 minv, __m128 maxv)
+{
+    float lo[4], hi[4];
+    _mm_storeu_ps(lo, minv);
+    _mm_storeu_ps(hi, maxv);
+    box = BoundBox3f(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2]);
+}
+#endif
+
+void transformBlock(const Matrix4D* mat, Block* block, std::size_t stride)
+{
+#if defined(BASE_VECTORARRAY_SSE2)
+    Columns col(*mat);
+    __m128 minv = _mm_set1_ps(FLT_MAX);
+    __m128 maxv = _mm_set1_ps(-FLT_MAX);
+    for (std::size_t i = 0; i < block->count; i++) {
+        float* p = pointAt(block->data, i, stride);
+        __m128d xy, z;
+        transformPoint(col, p, xy, z);
+        __m128 r = _mm_movelh_ps(_mm_cvtpd_ps(xy), _mm_cvtpd_ps(z));
+        _mm_storel_pi(reinterpret_cast<__m64*>(p), r);
+        _mm_store_ss(p + 2, _mm_movehl_ps(r, r));
+        minv = _mm_min_ps(r, minv);
+        maxv = _mm_max_ps(r, maxv);
+    }
+    setBoundBox(block->boxf, minv, maxv);
+#else
+    const Matrix4D& m = *mat;
+    for (std::size_t i = 0; i < block->count; i++) {
+        float* p = pointAt(block->data, i, stride);
+        double x = p[0], y = p[1], z = p[2];
+        p[0] = (float)(m[0][0]*x + m[0][1]*y + m[0][2]*z + m[0][3]);
+        p[1] = (float)(m[1][0]*x + m[1][1]*y + m[1][2]*z + m[1][3]);
+        p[2] = (float)(m[2][0]*x + m[2][1]*y + m[2][2]*z + m[2][3]);
+        block->boxf.Add(Vector3f(p[0], p[1], p[2]));
+    }
+#endif
+}
+
+void boundBlock(const Matrix4D*, Block* block, std::size_t stride)
+{
+#if defined(BASE_VECTORARRAY_SSE2)
+    __m128 minv = _mm_set1_ps(FLT_MAX);
+    __m128 maxv = _mm_set1_ps(-FLT_MAX);
+    for (std::size_t i = 0; i < block->count; i++) {
+        // only load the three coordinates, the next point may be beyond the array
+        const float* p = pointAt(block->data, i, stride);
+        __m128 r = _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)),
+                                 _mm_load_ss(p + 2));
+        minv = _mm_min_ps(r, minv);
+        maxv = _mm_max_ps(r, maxv);
+    }
+    setBoundBox(block->boxf, minv, maxv);
+#else
+    for (std::size_t i = 0; i < block->count; i++) {
+        const float* p = pointAt(block->data, i, stride);
+        block->boxf.Add(Vector3f(p[0], p[1], p[2]));
+    }
+#endif
+}
+
+void transformedBoundBlock(const Matrix4D* mat, Block* block, std::size_t stride)
+{
+#if defined(BASE_VECTORARRAY_SSE2)
+    Columns col(*mat);
+    __m128d minxy = _mm_set1_pd(DBL_MAX), minz = minxy;
+    __m128d maxxy = _mm_set1_pd(-DBL_MAX), maxz = maxxy;
+    for (std::size_t i = 0; i < block->count; i++) {
+        __m128d xy, z;
+        transformPoint(col, pointAt(block->data, i, stride), xy, z);
+        minxy = _mm_min_pd(xy, minxy);
+        maxxy = _mm_max_pd(xy, maxxy);
+        minz = _mm_min_sd(z, minz);
+        maxz = _mm_max_sd(z, maxz);
+    }
+    double lo[2], hi[2];
+    _mm_storeu_pd(lo, minxy);
+    _mm_storeu_pd(hi, maxxy);
+    block->boxd = BoundBox3d(lo[0], lo[1], _mm_cvtsd_f64(minz),
+                             hi[0], hi[1], _mm_cvtsd_f64(maxz));
+#else
+    for (std::size_t i = 0; i < block->count; i++) {
+        const float* p = pointAt(block->data, i, stride);
+        block->boxd.Add((*mat) * Vector3d(p[0], p[1], p[2]));
+    }
+#endif
+}
+
+/*
+ * Splits the array into one block per thread, or a single block if the array is
+ * small, and runs \a func on the blocks. The calling thread handles the first one.
+ */
+void runBlocks(void (*func)(const Matrix4D*, Block*, std::size_t), const Matrix4D* mat,
+               char* data, std::size_t count, std::size_t stride, std::vector<Block>& blocks)
+{
+    std::size_t threads = static_cast<std::size_t>(std::max(QThread::idealThreadCount(), 1));
+    std::size_t numBlocks = std::max<std::size_t>(std::min(threads, count / MinBlockSize), 1);
+    std::size_t blockSize = (count + numBlocks - 1) / numBlocks;
+
+    blocks.resize(numBlocks);
+    for (std::size_t i = 0; i < numBlocks; i++) {
+        std::size_t begin = std::min(i * blockSize, count);
+        blocks[i].data = data + begin * stride;
+        blocks[i].count = std::min(blockSize, count - begin);
+    }
+
+    QList< QFuture<void> > futures;
+    for (std::size_t i = 1; i < numBlocks; i++)
+        futures.append(QtConcurrent::run(func, mat, &blocks[i], stride));
+    func(mat, &blocks[0], stride);
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+        it->waitForFinished();
+}
+
+} // namespace
+
+BoundBox3f VectorArray::Transform(const Matrix4D& rclMat, Vector3f* pts, std::size_t count,
+                                  std::size_t stride)
+{
+    std::vector<Block> blocks;
+    runBlocks(transformBlock, &rclMat, reinterpret_cast<char*>(pts), count, stride, blocks);
+
+    BoundBox3f box;
+    for (std::vector<Block>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+        box.Add(it->boxf);
+    return box;
+}
+
+BoundBox3f VectorArray::GetBoundBox(const Vector3f* pts, std::size_t count, std::size_t stride)
+{
+    // the points are only read
+    std::vector<Block> blocks;
+    runBlocks(boundBlock, 0, reinterpret_cast<char*>(const_cast<Vector3f*>(pts)),
+              count, stride, blocks);
+
+    BoundBox3f box;
+    for (std::vector<Block>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+        box.Add(it->boxf);
+    return box;
+}
+
+BoundBox3d VectorArray::GetBoundBox(const Matrix4D& rclMat, const Vector3f* pts, std::size_t count,
+                                    std::size_t stride)
+{
+    // the points are only read
+    std::vector<Block> blocks;
+    runBlocks(transformedBoundBlock, &rclMat, reinterpret_cast<char*>(const_cast<Vector3f*>(pts)),
+              count, stride, blocks);
+
+    BoundBox3d box;
+    for (std::vector<Block>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+        box.Add(it->boxd);
+    return box;
+}
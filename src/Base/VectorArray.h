@@ -0,0 +1,71 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef BASE_VECTORARRAY_H
+#define BASE_VECTORARRAY_H
+
+#include <cstddef>
+
+#include "BoundBox.h"
+#include "Matrix.h"
+#include "Vector3D.h"
+
+namespace Base
+{
+
+/**
+ * The VectorArray class transforms arrays of points and computes their bounding
+ * boxes in one pass.
+ *
+ * The points need not be contiguous: \a stride is the distance in bytes between
+ * two points, so the points can be members of larger structures such as the mesh
+ * points. The coordinates are computed in double precision in the same order as
+ * Matrix4D::operator*() does, so the results are the same as transforming point
+ * by point. If the compiler targets SSE2 the x and y coordinates are computed in
+ * the two lanes of one register. Large arrays are split into blocks that are
+ * processed by several threads.
+ */
+class BaseExport VectorArray
+{
+public:
+    /**
+     * Transforms the \a count points starting at \a pts with \a rclMat and returns
+     * the bounding box of the transformed points.
+     */
+    static BoundBox3f Transform(const Matrix4D& rclMat, Vector3f* pts, std::size_t count,
+                                std::size_t stride = sizeof(Vector3f));
+    /** Returns the bounding box of the \a count points starting at \a pts. */
+    static BoundBox3f GetBoundBox(const Vector3f* pts, std::size_t count,
+                                  std::size_t stride = sizeof(Vector3f));
+    /**
+     * Returns the bounding box of the \a count points starting at \a pts transformed
+     * with \a rclMat. The points are not modified.
+     */
+    static BoundBox3d GetBoundBox(const Matrix4D& rclMat, const Vector3f* pts, std::size_t count,
+                                  std::size_t stride = sizeof(Vector3f));
+};
+
+} // namespace Base
+
+
+#endif // BASE_VECTORARRAY_H
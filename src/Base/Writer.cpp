@@ -36,7 +36,14 @@
 #include "Tools.h"
 
 #include <algorithm>
+#include <deque>
 #include <locale>
+#include <zlib.h>
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
 
 using namespace Base;
 using namespace std;
@@ -239,34 +246,194 @@ void Writer::decInd(void)
 
 // ----------------------------------------------------------------------------
 
+namespace Base {
+/*!
+ Compresses the serialized data of one additional file. The job runs in a
+ worker thread and only touches its own buffer.
+ */
+class ZipEntryJob : public QRunnable
+{
+public:
+    ZipEntryJob(const std::string& name, std::string& buf, int level)
+      : name(name), level(level), size(0), crc(0), method(zipios::DEFLATED)
+    {
+        data.swap(buf);
+        setAutoDelete(false);
+    }
+    virtual void run()
+    {
+        compress();
+        done.release();
+    }
+    bool isFinished() const
+    {
+        return done.available() > 0;
+    }
+    void waitForFinished()
+    {
+        done.acquire();
+        done.release();
+    }
+
+private:
+    void compress()
+    {
+        size = static_cast<zipios::uint32>(data.size());
+        crc = crc32(0, Z_NULL, 0);
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(data.data()), size);
+        if (level == Z_NO_COMPRESSION) {
+            method = zipios::STORED;
+            return;
+        }
+
+        z_stream zs;
+        zs.zalloc = Z_NULL;
+        zs.zfree  = Z_NULL;
+        zs.opaque = Z_NULL;
+        // raw deflate stream without zlib header as expected by the zip format
+        if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            error = "Failed to initialize compression of ";
+            error += name;
+            return;
+        }
+
+        std::string out;
+        out.resize(deflateBound(&zs, size));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        zs.avail_in = size;
+        zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        zs.avail_out = static_cast<uInt>(out.size());
+        int err = deflate(&zs, Z_FINISH);
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (err != Z_STREAM_END) {
+            error = "Failed to compress ";
+            error += name;
+            return;
+        }
+
+        // incompressible data is stored as is
+        if (out.size() < data.size()) {
+            data.swap(out);
+            method = zipios::DEFLATED;
+        }
+        else {
+            method = zipios::STORED;
+        }
+    }
+
+public:
+    std::string name;
+    std::string data;
+    std::string error;
+    int level;
+    zipios::uint32 size;
+    zipios::uint32 crc;
+    zipios::StorageMethod method;
+
+private:
+    QSemaphore done;
+};
+}
+
 ZipWriter::ZipWriter(const char* FileName) 
-  : ZipStream(FileName)
+  : ZipStream(FileName), buffering(false), level(6), threadCount(0)
 {
-#ifdef _MSC_VER
-    ZipStream.imbue(std::locale::empty());
-#else
-    //FIXME: Check whether this is correct
-    ZipStream.imbue(std::locale::classic());
-#endif
-    ZipStream.precision(12);
-    ZipStream.setf(ios::fixed,ios::floatfield);
+    init();
 }
 
 ZipWriter::ZipWriter(std::ostream& os) 
-  : ZipStream(os)
+  : ZipStream(os), buffering(false), level(6), threadCount(0)
+{
+    init();
+}
+
+void ZipWriter::init()
 {
 #ifdef _MSC_VER
     ZipStream.imbue(std::locale::empty());
+    EntryBuffer.imbue(std::locale::empty());
 #else
     //FIXME: Check whether this is correct
     ZipStream.imbue(std::locale::classic());
+    EntryBuffer.imbue(std::locale::classic());
 #endif
     ZipStream.precision(12);
     ZipStream.setf(ios::fixed,ios::floatfield);
+    EntryBuffer.precision(12);
+    EntryBuffer.setf(ios::fixed,ios::floatfield);
+}
+
+std::ostream& ZipWriter::Stream(void)
+{
+    if (buffering)
+        return EntryBuffer;
+    return ZipStream;
+}
+
+void ZipWriter::setLevel(int level)
+{
+    this->level = level;
+    ZipStream.setLevel(level);
 }
 
 void ZipWriter::writeFiles(void)
 {
+#ifdef ZIPIOS_HAVE_PUT_RAW_ENTRY
+    int threads = threadCount > 0 ? threadCount : QThread::idealThreadCount();
+    if (threads > 1 && level >= Z_NO_COMPRESSION && level <= Z_BEST_COMPRESSION) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        // limit the number of buffered entries waiting for compression
+        const std::size_t maxPending = 2 * static_cast<std::size_t>(threads);
+        std::deque<ZipEntryJob*> pending;
+
+        try {
+            // use a while loop because it is possible that while
+            // processing the files new ones can be added
+            size_t index = 0;
+            while (index < FileList.size()) {
+                FileEntry entry = FileList.begin()[index];
+
+                // the serialization itself must happen in the main thread
+                EntryBuffer.str(std::string());
+                EntryBuffer.clear();
+                buffering = true;
+                entry.Object->SaveDocFile(*this);
+                buffering = false;
+                std::string data = EntryBuffer.str();
+                EntryBuffer.str(std::string());
+
+                ZipEntryJob* job = new ZipEntryJob(entry.FileName, data, level);
+                pending.push_back(job);
+                pool.start(job);
+
+                // append the entries that are done in their original order
+                while (!pending.empty() && (pending.size() >= maxPending || pending.front()->isFinished())) {
+                    ZipEntryJob* front = pending.front();
+                    pending.pop_front();
+                    putEntry(front);
+                }
+                index++;
+            }
+
+            while (!pending.empty()) {
+                ZipEntryJob* front = pending.front();
+                pending.pop_front();
+                putEntry(front);
+            }
+        }
+        catch (...) {
+            buffering = false;
+            pool.waitForDone();
+            for (std::deque<ZipEntryJob*>::iterator it = pending.begin(); it != pending.end(); ++it)
+                delete *it;
+            throw;
+        }
+        return;
+    }
+#endif
+
     // use a while loop because it is possible that while
     // processing the files new ones can be added
     size_t index = 0;
@@ -278,6 +445,21 @@ void ZipWriter::writeFiles(void)
     }
 }
 
+void ZipWriter::putEntry(ZipEntryJob* job)
+{
+#ifdef ZIPIOS_HAVE_PUT_RAW_ENTRY
+    job->waitForFinished();
+    if (job->error.empty()) {
+        ZipStream.putRawEntry(zipios::ZipCDirEntry(job->name), job->method, job->data.data(),
+                              static_cast<zipios::uint32>(job->data.size()), job->size, job->crc);
+    }
+    else {
+        addError(job->error);
+    }
+#endif
+    delete job;
+}
+
 ZipWriter::~ZipWriter()
 {
     ZipStream.close();
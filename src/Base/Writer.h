@@ -46,6 +46,7 @@ namespace Base
 {
 
 class Persistence;
+class ZipEntryJob;
 
 
 /** The Writer class 
@@ -140,6 +141,12 @@ protected:
 /** The ZipWriter class 
  * This is an important helper class implementation for the store and retrieval system
  * of persistent objects in FreeCAD. 
+ *
+ * The additional files are serialized one after another into a memory buffer
+ * and compressed by a pool of worker threads while the next file is being
+ * serialized. The compressed entries are appended to the archive in the order
+ * they were added. With a compression level of 0 the entries are stored
+ * uncompressed.
  * \see Base::Persistence
  * \author Juergen Riegel
  */
@@ -152,14 +159,25 @@ public:
 
     virtual void writeFiles(void);
 
-    virtual std::ostream &Stream(void){return ZipStream;}
+    virtual std::ostream &Stream(void);
 
     void setComment(const char* str){ZipStream.setComment(str);}
-    void setLevel(int level){ZipStream.setLevel( level );}
+    void setLevel(int level);
     void putNextEntry(const char* str){ZipStream.putNextEntry(str);}
+    /// Set the number of threads used to compress the additional files, 0 means one per core
+    void setThreadCount(int count){threadCount = count;}
+    int getThreadCount() const {return threadCount;}
+
+private:
+    void init();
+    void putEntry(ZipEntryJob*);
 
 private:
     zipios::ZipOutputStream ZipStream;
+    std::ostringstream EntryBuffer;
+    bool buffering;
+    int level;
+    int threadCount;
 };
 
 /** The StringWriter class 
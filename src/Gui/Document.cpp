@@ -24,6 +24,7 @@
 #include "PreCompiled.h"
 
 #ifndef _PreComp_
+# include <algorithm>
 # include <QAbstractButton>
 # include <qapplication.h>
 # include <qdir.h>
@@ -167,11 +168,15 @@ Document::Document(App::Document* pcDocument,Application * app)
     // mustn't increment it (Werner Jan-12-2006)
     _pcDocPy = new Gui::DocumentPy(this);
 
-    if (App::GetApplication().GetParameterGroupByPath
-        ("User parameter:BaseApp/Preferences/Document")->GetBool("UsingUndo",true)){
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document");
+    if (hGrp->GetBool("UsingUndo",true)){
         d->_pcDocument->setUndoMode(1);
         // set the maximum stack size
-        d->_pcDocument->setMaxUndoStackSize(App::GetApplication().GetParameterGroupByPath("User parameter:BaseApp/Preferences/Document")->GetInt("MaxUndoSize",20));
+        d->_pcDocument->setMaxUndoStackSize(hGrp->GetInt("MaxUndoSize",20));
+        // set the memory limit of the stack in MB, 0 means no limit
+        unsigned long memSize = std::min<unsigned long>(hGrp->GetUnsigned("MaxUndoMemSize",0), 4095);
+        d->_pcDocument->setUndoLimit(static_cast<unsigned int>(memSize * 1024 * 1024));
     }
 }
 
@@ -865,6 +870,7 @@ void Document::slotFinishRestoreDocument(const App::Document& doc)
     std::map<const App::DocumentObject*,ViewProviderDocumentObject*>::iterator it;
     for (it = d->_ViewProviderMap.begin(); it != d->_ViewProviderMap.end(); ++it) {
         it->second->finishRestoring();
+        it->second->updateLazyData();
     }
 
     // reset modified flag
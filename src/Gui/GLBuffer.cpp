@@ -0,0 +1,149 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <stdint.h>
+# include <Inventor/elements/SoGLCacheContextElement.h>
+# include <Inventor/misc/SoContextHandler.h>
+#endif
+
+#include "GLBuffer.h"
+
+using namespace Gui;
+
+OpenGLBuffer::OpenGLBuffer(GLenum type)
+  : target(type)
+  , currentContext(0)
+  , glue(0)
+{
+    SoContextHandler::addContextDestructionCallback(context_destruction_cb, this);
+}
+
+OpenGLBuffer::~OpenGLBuffer()
+{
+    SoContextHandler::removeContextDestructionCallback(context_destruction_cb, this);
+    destroy();
+}
+
+bool OpenGLBuffer::isVBOSupported(uint32_t ctx)
+{
+    // Software renderers like the generic GDI implementation on Windows
+    // don't offer the extension and fall back to immediate mode
+    const cc_glglue * glue = cc_glglue_instance(ctx);
+    return (glue && cc_glglue_has_vertex_buffer_object(glue));
+}
+
+void OpenGLBuffer::setCurrentContext(uint32_t ctx)
+{
+    currentContext = ctx;
+    glue = cc_glglue_instance(currentContext);
+}
+
+bool OpenGLBuffer::isCreated() const
+{
+    return buffers.find(currentContext) != buffers.end();
+}
+
+bool OpenGLBuffer::allocate(const void *data, std::size_t size)
+{
+    std::map<uint32_t, Buffer>::iterator it = buffers.find(currentContext);
+    if (it == buffers.end()) {
+        Buffer buf;
+        cc_glglue_glGenBuffers(glue, 1, &buf.id);
+        buf.size = 0;
+        it = buffers.insert(std::make_pair(currentContext, buf)).first;
+    }
+
+    // clear old errors to detect a failed allocation
+    while (glGetError() != GL_NO_ERROR) {
+    }
+
+    cc_glglue_glBindBuffer(glue, target, it->second.id);
+    cc_glglue_glBufferData(glue, target, size, data, GL_STATIC_DRAW);
+    cc_glglue_glBindBuffer(glue, target, 0);
+
+    if (glGetError() != GL_NO_ERROR) {
+        cc_glglue_glDeleteBuffers(glue, 1, &it->second.id);
+        buffers.erase(it);
+        return false;
+    }
+
+    it->second.size = size;
+    return true;
+}
+
+void OpenGLBuffer::write(std::size_t offset, const void *data, std::size_t size)
+{
+    std::map<uint32_t, Buffer>::iterator it = buffers.find(currentContext);
+    if (it != buffers.end()) {
+        cc_glglue_glBindBuffer(glue, target, it->second.id);
+        cc_glglue_glBufferSubData(glue, target, offset, size, data);
+        cc_glglue_glBindBuffer(glue, target, 0);
+    }
+}
+
+void OpenGLBuffer::bind()
+{
+    std::map<uint32_t, Buffer>::iterator it = buffers.find(currentContext);
+    if (it != buffers.end())
+        cc_glglue_glBindBuffer(glue, target, it->second.id);
+}
+
+void OpenGLBuffer::release()
+{
+    cc_glglue_glBindBuffer(glue, target, 0);
+}
+
+void OpenGLBuffer::destroy()
+{
+    // schedule delete for all allocated GL resources
+    for (std::map<uint32_t, Buffer>::iterator it = buffers.begin(); it != buffers.end(); ++it) {
+        void * ptr = reinterpret_cast<void*>(static_cast<uintptr_t>(it->second.id));
+        SoGLCacheContextElement::scheduleDeleteCallback(it->first, buffer_delete, ptr);
+    }
+    buffers.clear();
+}
+
+std::size_t OpenGLBuffer::size() const
+{
+    std::map<uint32_t, Buffer>::const_iterator it = buffers.find(currentContext);
+    if (it != buffers.end())
+        return it->second.size;
+    return 0;
+}
+
+void OpenGLBuffer::context_destruction_cb(uint32_t context, void * userdata)
+{
+    // the buffer ids die with the context
+    OpenGLBuffer * self = static_cast<OpenGLBuffer*>(userdata);
+    self->buffers.erase(context);
+}
+
+void OpenGLBuffer::buffer_delete(void * closure, uint32_t contextid)
+{
+    const cc_glglue * glue = cc_glglue_instance(static_cast<int>(contextid));
+    GLuint id = static_cast<GLuint>(reinterpret_cast<uintptr_t>(closure));
+    cc_glglue_glDeleteBuffers(glue, 1, &id);
+}
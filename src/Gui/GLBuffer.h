@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef GUI_GLBUFFER_H
+#define GUI_GLBUFFER_H
+
+#include <cstddef>
+#include <map>
+#include <Inventor/C/glue/gl.h>
+
+#ifndef GL_ARRAY_BUFFER
+# define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+# define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_STATIC_DRAW
+# define GL_STATIC_DRAW 0x88E4
+#endif
+
+namespace Gui {
+
+/**
+ * The OpenGLBuffer class manages an OpenGL buffer object (VBO) that keeps
+ * vertex or index data on the graphics card.
+ *
+ * As a scene graph can be rendered in several GL contexts a separate buffer
+ * is created for each context the data is uploaded to. Before any other
+ * method is called the context must be set with setCurrentContext(). The
+ * buffers are released with Coin's scheduled delete mechanism, so destroy()
+ * can also be called when no context is current.
+ */
+class GuiExport OpenGLBuffer
+{
+public:
+    /// Construction, \a type is GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+    OpenGLBuffer(GLenum type);
+    ~OpenGLBuffer();
+
+    /// Checks whether the GL context \a ctx supports buffer objects
+    static bool isVBOSupported(uint32_t ctx);
+
+    void setCurrentContext(uint32_t ctx);
+    /// Returns true if a buffer exists in the current context
+    bool isCreated() const;
+    /**
+     * Creates the buffer in the current context if needed and uploads \a size
+     * bytes of \a data. If \a data is null the content is left undefined and can be
+     * filled with write(). If the graphics card has not enough memory the buffer is
+     * destroyed and false is returned.
+     */
+    bool allocate(const void *data, std::size_t size);
+    /// Replaces \a size bytes of the buffer at \a offset with \a data
+    void write(std::size_t offset, const void *data, std::size_t size);
+    void bind();
+    void release();
+    /// Schedules the deletion of the buffers of all contexts
+    void destroy();
+    /// Returns the size in bytes of the buffer of the current context
+    std::size_t size() const;
+
+private:
+    OpenGLBuffer(const OpenGLBuffer&);
+    OpenGLBuffer& operator=(const OpenGLBuffer&);
+
+    static void context_destruction_cb(uint32_t context, void * userdata);
+    static void buffer_delete(void * closure, uint32_t contextid);
+
+    struct Buffer {
+        GLuint id;
+        std::size_t size;
+    };
+
+    GLenum target;
+    uint32_t currentContext;
+    const cc_glglue* glue;
+    std::map<uint32_t, Buffer> buffers;
+};
+
+} // namespace Gui
+
+#endif  // GUI_GLBUFFER_H
@@ -340,7 +340,8 @@ bool SelectionSingleton::hasSelection(const char* doc) const
 std::vector<SelectionObject> SelectionSingleton::getSelectionEx(const char* pDocName, Base::Type typeId) const
 {
     std::vector<SelectionObject> temp;
-    std::map<App::DocumentObject*,SelectionObject> SortMap;
+    // position of the entry of each object in temp
+    boost::unordered_map<App::DocumentObject*,std::size_t> SortMap;
 
     // check the type
     if (typeId == Base::Type::badType()) 
@@ -359,11 +360,12 @@ std::vector<SelectionObject> SelectionSingleton::getSelectionEx(const char* pDoc
             // right type?
             if (It->pObject->getTypeId().isDerivedFrom(typeId)){
                 // if the object has already an entry
-                if (SortMap.find(It->pObject) != SortMap.end()){
+                boost::unordered_map<App::DocumentObject*,std::size_t>::iterator Jt = SortMap.find(It->pObject);
+                if (Jt != SortMap.end()){
                     // only add sub-element
                     if (!It->SubName.empty()) {
-                        SortMap[It->pObject].SubNames.push_back(It->SubName);
-                        SortMap[It->pObject].SelPoses.push_back(Base::Vector3d(It->x,It->y,It->z));
+                        temp[Jt->second].SubNames.push_back(It->SubName);
+                        temp[Jt->second].SelPoses.push_back(Base::Vector3d(It->x,It->y,It->z));
                     }
                 }
                 else {
@@ -376,21 +378,13 @@ std::vector<SelectionObject> SelectionSingleton::getSelectionEx(const char* pDoc
                         tempSelObj.SubNames.push_back(It->SubName);
                         tempSelObj.SelPoses.push_back(Base::Vector3d(It->x,It->y,It->z));
                     }
-                    SortMap.insert(std::pair<App::DocumentObject*,SelectionObject>(It->pObject,tempSelObj));
+                    SortMap[It->pObject] = temp.size();
+                    temp.push_back(tempSelObj);
                 }
             }
         }
     }
 
-    // The map loses the order thus we have to go again through the list and pick up the SelectionObject from the map
-    for (std::list<_SelObj>::const_iterator It = _SelList.begin();It != _SelList.end();++It) {
-        std::map<App::DocumentObject*,SelectionObject>::iterator Jt = SortMap.find(It->pObject);
-        if (Jt != SortMap.end()) {
-            temp.push_back(Jt->second);
-            SortMap.erase(Jt);
-        }
-    }
-
     return temp;
 }
 
@@ -654,6 +648,67 @@ App::Document* SelectionSingleton::getDocument(const char* pDocName) const
         return App::GetApplication().getActiveDocument();
 }
 
+void SelectionSingleton::notifyNotAllowed()
+{
+    if (getMainWindow()) {
+        QString msg;
+        if (ActiveGate->notAllowedReason.length() > 0) {
+            msg = QObject::tr(ActiveGate->notAllowedReason.c_str());
+        } else {
+            msg = QCoreApplication::translate("SelectionFilter","Selection not allowed by filter");
+        }
+        getMainWindow()->showMessage(msg);
+        Gui::MDIView* mdi = Gui::Application::Instance->activeDocument()->getActiveView();
+        mdi->setOverrideCursor(Qt::ForbiddenCursor);
+    }
+    ActiveGate->notAllowedReason.clear();
+    QApplication::beep();
+}
+
+void SelectionSingleton::indexSelection(std::list<_SelObj>::iterator It)
+{
+    _SelIndex[It->DocName][It->FeatName].insert(std::make_pair(It->SubName, It));
+}
+
+void SelectionSingleton::unindexSelection(std::list<_SelObj>::iterator It)
+{
+    boost::unordered_map<std::string, ObjectIndex>::iterator docIt = _SelIndex.find(It->DocName);
+    if (docIt == _SelIndex.end())
+        return;
+    ObjectIndex::iterator objIt = docIt->second.find(It->FeatName);
+    if (objIt == docIt->second.end())
+        return;
+    SubIndex::iterator subIt = objIt->second.find(It->SubName);
+    if (subIt == objIt->second.end() || subIt->second != It)
+        return;
+
+    // drop empty maps, so that an object or document in the index has a selection
+    objIt->second.erase(subIt);
+    if (objIt->second.empty()) {
+        docIt->second.erase(objIt);
+        if (docIt->second.empty())
+            _SelIndex.erase(docIt);
+    }
+}
+
+void SelectionSingleton::rebuildSelectionIndex()
+{
+    _SelIndex.clear();
+    for (std::list<_SelObj>::iterator It = _SelList.begin(); It != _SelList.end(); ++It)
+        indexSelection(It);
+}
+
+const SelectionSingleton::SubIndex* SelectionSingleton::findSelection(const std::string& DocName, const std::string& FeatName) const
+{
+    boost::unordered_map<std::string, ObjectIndex>::const_iterator docIt = _SelIndex.find(DocName);
+    if (docIt == _SelIndex.end())
+        return 0;
+    ObjectIndex::const_iterator objIt = docIt->second.find(FeatName);
+    if (objIt == docIt->second.end())
+        return 0;
+    return &objIt->second;
+}
+
 bool SelectionSingleton::addSelection(const char* pDocName, const char* pObjectName, const char* pSubName, float x, float y, float z)
 {
     // already in ?
@@ -673,19 +728,7 @@ bool SelectionSingleton::addSelection(const char* pDocName, const char* pObjectN
         // check for a Selection Gate
         if (ActiveGate) {
             if (!ActiveGate->allow(temp.pDoc,temp.pObject,pSubName)) {
-                if (getMainWindow()) {
-                    QString msg;
-                    if (ActiveGate->notAllowedReason.length() > 0) {
-                        msg = QObject::tr(ActiveGate->notAllowedReason.c_str());
-                    } else {
-                        msg = QCoreApplication::translate("SelectionFilter","Selection not allowed by filter");
-                    }
-                    getMainWindow()->showMessage(msg);
-                    Gui::MDIView* mdi = Gui::Application::Instance->activeDocument()->getActiveView();
-                    mdi->setOverrideCursor(Qt::ForbiddenCursor);
-                }
-                ActiveGate->notAllowedReason.clear();
-                QApplication::beep();
+                notifyNotAllowed();
                 return false;
             }
         }
@@ -700,7 +743,7 @@ bool SelectionSingleton::addSelection(const char* pDocName, const char* pObjectN
         if (temp.pObject)
             temp.TypeName = temp.pObject->getTypeId().getName();
 
-        _SelList.push_back(temp);
+        indexSelection(_SelList.insert(_SelList.end(), temp));
 
         SelectionChanges Chng;
 
@@ -750,12 +793,16 @@ bool SelectionSingleton::addSelection(const char* pDocName, const char* pObjectN
         temp.DocName  = pDocName;
         temp.FeatName = pObjectName ? pObjectName : "";
         for (std::vector<std::string>::const_iterator it = pSubNames.begin(); it != pSubNames.end(); ++it) {
+            // already in ?
+            if (isSelected(pDocName, pObjectName, it->c_str()))
+                continue;
+
             temp.SubName  = it->c_str();
             temp.x        = 0;
             temp.y        = 0;
             temp.z        = 0;
 
-            _SelList.push_back(temp);
+            indexSelection(_SelList.insert(_SelList.end(), temp));
         }
 
         SelectionChanges Chng;
@@ -783,11 +830,92 @@ bool SelectionSingleton::addSelection(const char* pDocName, const char* pObjectN
     }
 }
 
+bool SelectionSingleton::addSelections(const char* pDocName, const std::vector<std::pair<std::string, std::string> >& pNames)
+{
+    App::Document* pDoc = getDocument(pDocName);
+    if (!pDoc) {
+        Base::Console().Error("Cannot add to selection: no document '%s' found.\n", pDocName);
+        return false;
+    }
+
+    _SelObj temp;
+    temp.pDoc     = pDoc;
+    temp.pObject  = 0;
+    temp.DocName  = pDoc->getName();
+    temp.x        = 0;
+    temp.y        = 0;
+    temp.z        = 0;
+
+    bool added = false;
+    bool rejected = false;
+    for (std::vector<std::pair<std::string, std::string> >::const_iterator it = pNames.begin(); it != pNames.end(); ++it) {
+        // mostly all sub-elements of an object come one after another
+        if (it == pNames.begin() || it->first != temp.FeatName) {
+            temp.FeatName = it->first;
+            temp.pObject  = pDoc->getObject(it->first.c_str());
+            temp.TypeName = temp.pObject ? temp.pObject->getTypeId().getName() : "";
+        }
+
+        // already in ?
+        if (isSelected(temp.DocName.c_str(), it->first.c_str(), it->second.c_str()))
+            continue;
+
+        // check for a Selection Gate
+        if (ActiveGate && !ActiveGate->allow(pDoc, temp.pObject, it->second.c_str())) {
+            rejected = true;
+            continue;
+        }
+
+        temp.SubName = it->second;
+        indexSelection(_SelList.insert(_SelList.end(), temp));
+        added = true;
+    }
+
+    if (rejected)
+        notifyNotAllowed();
+
+    // observers that handle SetSelection synchronize themselves with the
+    // selection of the document
+    if (added) {
+        SelectionChanges Chng;
+        Chng.Type = SelectionChanges::SetSelection;
+        Chng.pDocName = temp.DocName.c_str();
+        Chng.pObjectName = "";
+        Chng.pSubName = "";
+        Chng.pTypeName = "";
+
+        Notify(Chng);
+        signalSelectionChanged(Chng);
+    }
+
+    return true;
+}
+
 void SelectionSingleton::rmvSelection(const char* pDocName, const char* pObjectName, const char* pSubName)
 {
     std::vector<SelectionChanges> rmvList;
 
-    for (std::list<_SelObj>::iterator It = _SelList.begin();It != _SelList.end();) {
+    // Use the index to restrict the search to the item to remove, or to return
+    // immediately if nothing of the object or document is selected
+    std::list<_SelObj>::iterator It = _SelList.begin();
+    std::list<_SelObj>::iterator End = _SelList.end();
+    if (pObjectName) {
+        const SubIndex* subs = findSelection(pDocName, pObjectName);
+        if (!subs)
+            return;
+        if (pSubName) {
+            SubIndex::const_iterator jt = subs->find(pSubName);
+            if (jt == subs->end())
+                return;
+            It = End = jt->second;
+            ++End;
+        }
+    }
+    else if (_SelIndex.find(pDocName) == _SelIndex.end()) {
+        return;
+    }
+
+    while (It != End) {
         if ((It->DocName == pDocName && !pObjectName) ||
             (It->DocName == pDocName && pObjectName && It->FeatName == pObjectName && !pSubName) ||
             (It->DocName == pDocName && pObjectName && It->FeatName == pObjectName && pSubName && It->SubName == pSubName))
@@ -799,6 +927,7 @@ void SelectionSingleton::rmvSelection(const char* pDocName, const char* pObjectN
             std::string tmpTypName = It->TypeName;
 
             // destroy the _SelObj item
+            unindexSelection(It);
             It = _SelList.erase(It);
 
             SelectionChanges Chng;
@@ -867,6 +996,7 @@ void SelectionSingleton::setSelection(const char* pDocName, const std::vector<Ap
         return;
 
     _SelList = temp;
+    rebuildSelectionIndex();
 
     SelectionChanges Chng;
     Chng.Type = SelectionChanges::SetSelection;
@@ -894,13 +1024,13 @@ void SelectionSingleton::clearSelection(const char* pDocName)
             docName = pDocName;
         else
             docName = pDoc->getName(); // active document
-        std::list<_SelObj> selList;
-        for (std::list<_SelObj>::iterator it = _SelList.begin(); it != _SelList.end(); ++it) {
-            if (it->DocName != docName)
-                selList.push_back(*it);
+        for (std::list<_SelObj>::iterator it = _SelList.begin(); it != _SelList.end();) {
+            if (it->DocName == docName)
+                it = _SelList.erase(it);
+            else
+                ++it;
         }
-
-        _SelList = selList;
+        _SelIndex.erase(docName);
 
         SelectionChanges Chng;
         Chng.Type = SelectionChanges::ClrSelection;
@@ -921,6 +1051,7 @@ void SelectionSingleton::clearSelection(const char* pDocName)
 void SelectionSingleton::clearCompleteSelection()
 {
     _SelList.clear();
+    _SelIndex.clear();
 
     SelectionChanges Chng;
     Chng.Type = SelectionChanges::ClrSelection;
@@ -943,29 +1074,18 @@ bool SelectionSingleton::isSelected(const char* pDocName, const char* pObjectNam
     const char* tmpDocName = pDocName ? pDocName : "";
     const char* tmpFeaName = pObjectName ? pObjectName : "";
     const char* tmpSubName = pSubName ? pSubName : "";
-    for (std::list<_SelObj>::const_iterator It = _SelList.begin();It != _SelList.end();++It)
-        if (It->DocName == tmpDocName && It->FeatName == tmpFeaName && It->SubName == tmpSubName)
-            return true;
-    return false;
+    const SubIndex* subs = findSelection(tmpDocName, tmpFeaName);
+    return subs && subs->find(tmpSubName) != subs->end();
 }
 
 bool SelectionSingleton::isSelected(App::DocumentObject* obj, const char* pSubName) const
 {
-    if (!obj) return false;
-
-    for(list<_SelObj>::const_iterator It = _SelList.begin();It != _SelList.end();++It) {
-        if (It->pObject == obj) {
-            if (pSubName) {
-                if (It->SubName == pSubName)
-                    return true;
-            }
-            else {
-                return true;
-            }
-        }
-    }
+    if (!obj || !obj->getNameInDocument()) return false;
 
-    return false;
+    const SubIndex* subs = findSelection(obj->getDocument()->getName(), obj->getNameInDocument());
+    if (!subs)
+        return false;
+    return !pSubName || subs->find(pSubName) != subs->end();
 }
 
 void SelectionSingleton::slotDeletedObject(const App::DocumentObject& Obj)
@@ -1031,6 +1151,11 @@ PyMethodDef SelectionSingleton::Methods[] = {
     {"addSelection",         (PyCFunction) SelectionSingleton::sAddSelection, 1, 
      "addSelection(object,[string,float,float,float]) -- Add an object to the selection\n"
      "where string is the sub-element name and the three floats represent a 3d point"},
+    {"addSelections",        (PyCFunction) SelectionSingleton::sAddSelections, 1,
+     "addSelections(object,list) -- Add a list of sub-elements of an object to the selection\n"
+     "The observers get a single setSelection notification instead of an addSelection\n"
+     "notification for each sub-element. Observers that only handle addSelection are\n"
+     "therefore not notified."},
     {"removeSelection",      (PyCFunction) SelectionSingleton::sRemoveSelection, 1,
      "removeSelection(object) -- Remove an object from the selection"},
     {"clearSelection"  ,     (PyCFunction) SelectionSingleton::sClearSelection, 1,
@@ -1136,6 +1261,38 @@ PyObject *SelectionSingleton::sAddSelection(PyObject * /*self*/, PyObject *args,
     return 0;
 }
 
+PyObject *SelectionSingleton::sAddSelections(PyObject * /*self*/, PyObject *args, PyObject * /*kwd*/)
+{
+    PyObject *object;
+    PyObject *sequence;
+    if (!PyArg_ParseTuple(args, "O!O", &(App::DocumentObjectPy::Type),&object,&sequence))
+        return NULL;                             // NULL triggers exception 
+
+    App::DocumentObjectPy* docObjPy = static_cast<App::DocumentObjectPy*>(object);
+    App::DocumentObject* docObj = docObjPy->getDocumentObjectPtr();
+    if (!docObj || !docObj->getNameInDocument()) {
+        PyErr_SetString(Base::BaseExceptionFreeCADError, "Cannot check invalid object");
+        return NULL;
+    }
+
+    try {
+        Py::Sequence list(sequence);
+        std::vector<std::pair<std::string, std::string> > names;
+        names.reserve(list.size());
+        for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+            std::string subname = static_cast<std::string>(Py::String(*it));
+            names.push_back(std::make_pair(std::string(docObj->getNameInDocument()), subname));
+        }
+        Selection().addSelections(docObj->getDocument()->getName(), names);
+    }
+    catch (const Py::Exception&) {
+        PyErr_SetString(PyExc_ValueError, "type must be 'DocumentObject, list or tuple of subnames'");
+        return NULL;
+    }
+
+    Py_Return;
+}
+
 PyObject *SelectionSingleton::sRemoveSelection(PyObject * /*self*/, PyObject *args, PyObject * /*kwd*/)
 {
     PyObject *object;
@@ -30,6 +30,8 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <utility>
+#include <boost/unordered_map.hpp>
 #include <CXX/Objects.hxx>
 
 #include <Base/Observer.h>
@@ -221,6 +223,14 @@ public:
     bool addSelection(const char* pDocName, const char* pObjectName=0, const char* pSubName=0, float x=0, float y=0, float z=0);
     /// Add to selection with several sub-elements
     bool addSelection(const char* pDocName, const char* pObjectName, const std::vector<std::string>& pSubNames);
+    /** Add several objects or sub-elements, given as pairs of object and sub-element
+     * name, to the selection of a document. Items that are already selected or that
+     * are rejected by the SelectionGate are skipped. Instead of one notification per
+     * item a single SetSelection notification is sent at the end.
+     * @note Observers that only handle AddSelection, like the sketcher in edit mode,
+     * are not notified, so only use this where all observers handle SetSelection.
+     */
+    bool addSelections(const char* pDocName, const std::vector<std::pair<std::string, std::string> >& pNames);
     /// Remove from selection (for internal use)
     void rmvSelection(const char* pDocName, const char* pObjectName=0, const char* pSubName=0);
     /// Set the selection for a document
@@ -331,6 +341,7 @@ public:
 
 protected:
     static PyObject *sAddSelection        (PyObject *self,PyObject *args,PyObject *kwd);
+    static PyObject *sAddSelections       (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject *sRemoveSelection     (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject *sClearSelection      (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject *sIsSelected          (PyObject *self,PyObject *args,PyObject *kwd);
@@ -355,6 +366,8 @@ protected:
 
     /// helper to retrieve document by name
     App::Document* getDocument(const char* pDocName=0) const;
+    /// tell the user that the SelectionGate rejected a selection
+    void notifyNotAllowed();
 
     SelectionChanges CurrentPreselection;
 
@@ -369,6 +382,18 @@ protected:
     };
     std::list<_SelObj> _SelList;
 
+    /** The entries of _SelList by document, object and sub-element name, so that
+     * looking up a selected item doesn't need to go through the whole list.
+     */
+    typedef boost::unordered_map<std::string, std::list<_SelObj>::iterator> SubIndex;
+    typedef boost::unordered_map<std::string, SubIndex> ObjectIndex;
+    boost::unordered_map<std::string, ObjectIndex> _SelIndex;
+
+    void indexSelection(std::list<_SelObj>::iterator);
+    void unindexSelection(std::list<_SelObj>::iterator);
+    void rebuildSelectionIndex();
+    const SubIndex* findSelection(const std::string& DocName, const std::string& FeatName) const;
+
     static SelectionSingleton* _pcSingleton;
 
     std::string DocName;
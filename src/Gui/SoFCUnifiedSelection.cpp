@@ -296,15 +296,37 @@ void SoFCUnifiedSelection::doAction(SoAction *action)
             for (std::vector<ViewProvider*>::iterator it = vps.begin(); it != vps.end(); ++it) {
                 ViewProviderDocumentObject* vpd = static_cast<ViewProviderDocumentObject*>(*it);
                 if (vpd->useNewSelectionModel()) {
-                    if (Selection().isSelected(vpd->getObject()) && vpd->isSelectable()) {
+                    SoSelectionElementAction action(SoSelectionElementAction::None);
+                    action.setColor(this->colorSelection.getValue());
+                    action.apply(vpd->getRoot());
+                }
+            }
+
+            // the selection may have been replaced by several items at once (e.g. by
+            // addSelections()), so highlight the selected sub-elements of each object
+            if (this->pcDocument) {
+                std::vector<SelectionObject> sel = Selection().getSelectionEx(this->pcDocument->getDocument()->getName());
+                for (std::vector<SelectionObject>::iterator it = sel.begin(); it != sel.end(); ++it) {
+                    ViewProvider* vp = this->pcDocument->getViewProvider(it->getObject());
+                    if (!vp || !vp->useNewSelectionModel() || !vp->isSelectable())
+                        continue;
+
+                    const std::vector<std::string>& subNames = it->getSubNames();
+                    if (subNames.empty()) {
                         SoSelectionElementAction action(SoSelectionElementAction::All);
                         action.setColor(this->colorSelection.getValue());
-                        action.apply(vpd->getRoot());
+                        action.apply(vp->getRoot());
+                        continue;
                     }
-                    else {
-                        SoSelectionElementAction action(SoSelectionElementAction::None);
+
+                    for (std::vector<std::string>::const_iterator jt = subNames.begin(); jt != subNames.end(); ++jt) {
+                        SoDetail* detail = vp->getDetail(jt->c_str());
+                        SoSelectionElementAction action(detail ? SoSelectionElementAction::Append
+                                                               : SoSelectionElementAction::All);
                         action.setColor(this->colorSelection.getValue());
-                        action.apply(vpd->getRoot());
+                        action.setElement(detail);
+                        action.apply(vp->getRoot());
+                        delete detail;
                     }
                 }
             }
@@ -34,6 +34,7 @@
 
 /// Here the FreeCAD includes sorted by Base,App,Gui......
 #include <Base/Console.h>
+#include <Base/Exception.h>
 #include <App/Material.h>
 #include <App/DocumentObject.h>
 #include "Application.h"
@@ -81,6 +82,46 @@ void ViewProviderDocumentObject::finishRestoring()
 {
 }
 
+void ViewProviderDocumentObject::updateLazyData()
+{
+    // With lazy loading the data files were not read in when the object was
+    // created, so nothing has been drawn for them yet. Hidden objects read
+    // their files in when they are shown for the first time.
+    pendingData.clear();
+    std::map<std::string, App::Property*> Map;
+    pcObject->getPropertyMap(Map);
+    for (std::map<std::string, App::Property*>::iterator it = Map.begin(); it != Map.end(); ++it) {
+        if (it->second->hasLazyFile())
+            pendingData.push_back(it->first);
+    }
+
+    if (Visibility.getValue())
+        updatePendingData();
+}
+
+void ViewProviderDocumentObject::updatePendingData()
+{
+    std::vector<std::string> names;
+    names.swap(pendingData);
+    for (std::vector<std::string>::iterator it = names.begin(); it != names.end(); ++it) {
+        App::Property* prop = pcObject->getPropertyByName(it->c_str());
+        if (!prop)
+            continue;
+        try {
+            updateData(prop);
+        }
+        catch (const Base::MemoryException& e) {
+            Base::Console().Error("Memory exception in '%s' thrown: %s\n", pcObject->getNameInDocument(), e.what());
+        }
+        catch (Base::Exception& e) {
+            e.ReportException();
+        }
+        catch (const std::exception& e) {
+            Base::Console().Error("C++ exception in '%s' thrown: %s\n", pcObject->getNameInDocument(), e.what());
+        }
+    }
+}
+
 bool ViewProviderDocumentObject::isAttachedToDocument() const
 {
     return (!testStatus(Detach));
@@ -141,6 +182,8 @@ void ViewProviderDocumentObject::show(void)
         Visibility.setValue(true);
         Visibility.setStatus(App::Property::User2, false);
     }
+    if (!pendingData.empty())
+        updatePendingData();
     ViewProvider::show();
 }
 
@@ -86,6 +86,8 @@ public:
     //@{
     virtual void startRestoring();
     virtual void finishRestoring();
+    /// Draws the data of lazily loaded files now if visible, otherwise on the next show()
+    void updateLazyData();
     //@}
 
 protected:
@@ -133,9 +135,14 @@ protected:
 protected:
     App::DocumentObject *pcObject;
 
+private:
+    void updatePendingData();
+
 private:
     std::vector<const char*> aDisplayEnumsArray;
     std::vector<std::string> aDisplayModesArray;
+    /// Names of the properties that still need to be drawn
+    std::vector<std::string> pendingData;
 };
 
 
@@ -27,20 +27,20 @@
 #include <BRepBuilderAPI_MakeVertex.hxx>
 #include <BRepClass3d_SolidClassifier.hxx>
 #include <BRepGProp_Face.hxx>
+#include <Standard.hxx>
 #include <TopoDS.hxx>
 #include <TopoDS_Vertex.hxx>
 
-#include <QEventLoop>
+#include <QAtomicInt>
 #include <QFuture>
-#include <QFutureWatcher>
-#include <QtConcurrentMap>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
 
 #include <boost/signals.hpp>
-#include <boost/bind.hpp>
 
 #include <Base/Console.h>
 #include <Base/Exception.h>
-#include <Base/FutureWatcherProgress.h>
 #include <Base/Parameter.h>
 #include <Base/Sequencer.h>
 #include <Base/Tools.h>
@@ -48,6 +48,7 @@
 #include <Mod/Mesh/App/Mesh.h>
 #include <Mod/Mesh/App/MeshFeature.h>
 #include <Mod/Mesh/App/Core/Algorithm.h>
+#include <Mod/Mesh/App/Core/BVH.h>
 #include <Mod/Mesh/App/Core/Grid.h>
 #include <Mod/Mesh/App/Core/Iterator.h>
 #include <Mod/Mesh/App/Core/MeshKernel.h>
@@ -75,10 +76,12 @@ unsigned long InspectActualMesh::countPoints() const
     return this->_count;
 }
 
-Base::Vector3f InspectActualMesh::getPoint(unsigned long index)
+Base::Vector3f InspectActualMesh::getPoint(unsigned long index) const
 {
-    _iter.Set(index);
-    return *_iter;
+    // work on a copy of the iterator as this may be called from several threads
+    MeshCore::MeshPointIterator iter(_iter);
+    iter.Set(index);
+    return *iter;
 }
 
 // ----------------------------------------------------------------
@@ -92,7 +95,7 @@ unsigned long InspectActualPoints::countPoints() const
     return _rKernel.size();
 }
 
-Base::Vector3f InspectActualPoints::getPoint(unsigned long index)
+Base::Vector3f InspectActualPoints::getPoint(unsigned long index) const
 {
     Base::Vector3d p = _rKernel.getPoint(index);
     return Base::Vector3f((float)p.x,(float)p.y,(float)p.z);
@@ -118,7 +121,7 @@ unsigned long InspectActualShape::countPoints() const
     return points.size();
 }
 
-Base::Vector3f InspectActualShape::getPoint(unsigned long index)
+Base::Vector3f InspectActualShape::getPoint(unsigned long index) const
 {
     return Base::toVector<float>(points[index]);
 }
@@ -198,19 +201,17 @@ namespace Inspection {
                     for (ulY = ulY1; ulY <= ulY2; ulY++) {
                         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++) {
                             if (rclFacet.IntersectBoundingBox(GetBoundBox(ulX, ulY, ulZ)))
-                                _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+                                _aulGrid.Add(CellIndex(ulX, ulY, ulZ), ulFacetIndex);
                         }
                     }
                 }
             }
             else
-                _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+                _aulGrid.Add(CellIndex(ulX1, ulY1, ulZ1), ulFacetIndex);
         }
 
         void InitGrid (void)
         {
-            unsigned long i, j;
-
             Base::BoundBox3f clBBMesh = _pclMesh->GetBoundBox().Transformed(_transform);
 
             float fLengthX = clBBMesh.LengthX(); 
@@ -226,13 +227,7 @@ namespace Inspection {
             _fGridLenZ = (1.0f + fLengthZ) / float(_ulCtGridsZ);
             _fMinZ = clBBMesh.MinZ - 0.5f;
 
-            _aulGrid.clear();
-            _aulGrid.resize(_ulCtGridsX);
-            for (i = 0; i < _ulCtGridsX; i++) {
-                _aulGrid[i].resize(_ulCtGridsY);
-                for (j = 0; j < _ulCtGridsY; j++)
-                    _aulGrid[i][j].resize(_ulCtGridsZ);
-            }
+            _aulGrid.Init(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ);
         }
 
         void RebuildGrid (void)
@@ -246,6 +241,7 @@ namespace Inspection {
             for (clFIter.Init(); clFIter.More(); clFIter.Next()) {
                 AddFacet(*clFIter, i++);
             }
+            _aulGrid.Finish();
         }
 
     private:
@@ -258,29 +254,22 @@ InspectNominalMesh::InspectNominalMesh(const Mesh::MeshObject& rMesh, float offs
     const MeshCore::MeshKernel& kernel = rMesh.getKernel();
     _iter.Transform(rMesh.getTransform());
 
-    // Max. limit of grid elements
-    float fMaxGridElements=8000000.0f;
     Base::BoundBox3f box = kernel.GetBoundBox().Transformed(rMesh.getTransform());
 
-    // estimate the minimum allowed grid length
-    float fMinGridLen = (float)pow((box.LengthX()*box.LengthY()*box.LengthZ()/fMaxGridElements), 0.3333f);
-    float fGridLen = 5.0f * MeshCore::MeshAlgorithm(kernel).GetAverageEdgeLength();
-
-    // We want to avoid to get too small grid elements otherwise building up the grid structure would take
-    // too much time and memory. 
-    // Having quite a dense grid speeds up more the following algorithms extremely. Due to the issue above it's
-    // always a compromise between speed and memory usage.
-    fGridLen = std::max<float>(fMinGridLen, fGridLen);
-
-    // build up grid structure to speed up algorithms
-    _pGrid = new MeshInspectGrid(kernel, fGridLen, rMesh.getTransform());
+    // Unlike a grid the bounding volume hierarchy doesn't degrade if the facets are
+    // distributed very unevenly, e.g. fine scans of small features inside big parts.
+    _pBVH.reset(new MeshCore::MeshFacetBVH(kernel, rMesh.getTransform()));
     _box = box;
     _box.Enlarge(offset);
 }
 
 InspectNominalMesh::~InspectNominalMesh()
 {
-    delete this->_pGrid;
+}
+
+InspectNominalGeometry* InspectNominalMesh::clone() const
+{
+    return new InspectNominalMesh(*this);
 }
 
 float InspectNominalMesh::getDistance(const Base::Vector3f& point)
@@ -288,25 +277,14 @@ float InspectNominalMesh::getDistance(const Base::Vector3f& point)
     if (!_box.IsInBox(point))
         return FLT_MAX; // must be inside bbox
 
-    std::vector<unsigned long> indices;
-    //_pGrid->GetElements(point, indices);
-    if (indices.empty()) {
-        std::set<unsigned long> inds;
-        _pGrid->MeshGrid::SearchNearestFromPoint(point, inds);
-        indices.insert(indices.begin(), inds.begin(), inds.end());
-    }
-
-    float fMinDist=FLT_MAX;
-    bool positive = true;
-    for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
-        _iter.Set(*it);
-        float fDist = _iter->DistanceToPoint(point);
-        if (fabs(fDist) < fabs(fMinDist)) {
-            fMinDist = fDist;
-            positive = point.DistanceToPlane(_iter->_aclPoints[0], _iter->GetNormal()) > 0;
-        }
-    }
+    unsigned long index;
+    float fMinDist;
+    Base::Vector3f res;
+    if (!_pBVH->NearestFacetToPoint(point, index, fMinDist, res))
+        return FLT_MAX;
 
+    _iter.Set(index);
+    bool positive = point.DistanceToPlane(_iter->_aclPoints[0], _iter->GetNormal()) > 0;
     if (!positive)
         fMinDist = -fMinDist;
     return fMinDist;
@@ -334,7 +312,7 @@ InspectNominalFastMesh::InspectNominalFastMesh(const Mesh::MeshObject& rMesh, fl
     fGridLen = std::max<float>(fMinGridLen, fGridLen);
 
     // build up grid structure to speed up algorithms
-    _pGrid = new MeshInspectGrid(kernel, fGridLen, rMesh.getTransform());
+    _pGrid.reset(new MeshInspectGrid(kernel, fGridLen, rMesh.getTransform()));
     _box = box;
     _box.Enlarge(offset);
     max_level = (unsigned long)(offset/fGridLen);
@@ -342,7 +320,11 @@ InspectNominalFastMesh::InspectNominalFastMesh(const Mesh::MeshObject& rMesh, fl
 
 InspectNominalFastMesh::~InspectNominalFastMesh()
 {
-    delete this->_pGrid;
+}
+
+InspectNominalGeometry* InspectNominalFastMesh::clone() const
+{
+    return new InspectNominalFastMesh(*this);
 }
 
 /**
@@ -354,11 +336,9 @@ float InspectNominalFastMesh::getDistance(const Base::Vector3f& point)
     if (!_box.IsInBox(point))
         return FLT_MAX; // must be inside bbox
 
-    std::set<unsigned long> indices;
+    std::vector<unsigned long> indices;
 #if 0 // a point in a neighbour grid can be nearer
-    std::vector<unsigned long> elements;
-    _pGrid->GetElements(point, elements);
-    indices.insert(elements.begin(), elements.end());
+    _pGrid->GetElements(point, indices);
 #else
     unsigned long ulX, ulY, ulZ;
     _pGrid->Position(point, ulX, ulY, ulZ);
@@ -367,11 +347,14 @@ float InspectNominalFastMesh::getDistance(const Base::Vector3f& point)
         _pGrid->GetHull(ulX, ulY, ulZ, ulLevel++, indices);
     if (indices.size() == 0 || ulLevel==1)
         _pGrid->GetHull(ulX, ulY, ulZ, ulLevel, indices);
+    // facets lying in several grids are listed several times
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
 #endif
 
     float fMinDist=FLT_MAX;
     bool positive = true;
-    for (std::set<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
+    for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
         _iter.Set(*it);
         float fDist = _iter->DistanceToPoint(point);
         if (fabs(fDist) < fabs(fMinDist)) {
@@ -391,12 +374,16 @@ InspectNominalPoints::InspectNominalPoints(const Points::PointKernel& Kernel, fl
   : _rKernel(Kernel)
 {
     int uGridPerAxis = 50; // totally 125.000 grid elements 
-    this->_pGrid = new Points::PointsGrid (Kernel, uGridPerAxis);
+    this->_pGrid.reset(new Points::PointsGrid (Kernel, uGridPerAxis));
 }
 
 InspectNominalPoints::~InspectNominalPoints()
 {
-    delete this->_pGrid;
+}
+
+InspectNominalGeometry* InspectNominalPoints::clone() const
+{
+    return new InspectNominalPoints(*this);
 }
 
 float InspectNominalPoints::getDistance(const Base::Vector3f& point)
@@ -448,6 +435,12 @@ InspectNominalShape::~InspectNominalShape()
     delete distss;
 }
 
+InspectNominalGeometry* InspectNominalShape::clone() const
+{
+    // BRepExtrema_DistShapeShape keeps the state of the last query, so the copy needs its own one
+    return new InspectNominalShape(_rShape, 0.0f);
+}
+
 float InspectNominalShape::getDistance(const Base::Vector3f& point)
 {
     gp_Pnt pnt3d(point.x,point.y,point.z);
@@ -639,21 +632,26 @@ unsigned int PropertyDistanceList::getMemSize (void) const
 
 // ----------------------------------------------------------------
 
-// helper class to use Qt's concurrent framework
-struct DistanceInspection
+namespace Inspection {
+// Helper class to compute the distances in chunks of points. The chunks can be
+// processed by several threads where each thread works with its own copies of
+// the nominal geometries. Every point is computed the same way, so the result
+// doesn't depend on the number of threads.
+class DistanceInspection
 {
-
+public:
     DistanceInspection(float radius, InspectActualGeometry*  a,
-                       std::vector<InspectNominalGeometry*> n)
-                    : radius(radius), actual(a), nominal(n)
+                       const std::vector<InspectNominalGeometry*>& n, std::vector<float>& vals)
+                    : radius(radius), actual(a), nominal(n), values(vals)
+                    , nextIndex(0), countDone(0), countReported(0)
     {
     }
-    float mapped(unsigned long index)
+    float mapped(unsigned long index, const std::vector<InspectNominalGeometry*>& nominal) const
     {
         Base::Vector3f pnt = actual->getPoint(index);
 
         float fMinDist=FLT_MAX;
-        for (std::vector<InspectNominalGeometry*>::iterator it = nominal.begin(); it != nominal.end(); ++it) {
+        for (std::vector<InspectNominalGeometry*>::const_iterator it = nominal.begin(); it != nominal.end(); ++it) {
             float fDist = (*it)->getDistance(pnt);
             if (fabs(fDist) < fabs(fMinDist))
                 fMinDist = fDist;
@@ -666,11 +664,94 @@ struct DistanceInspection
 
         return fMinDist;
     }
+    void run(int threads, Base::SequencerLauncher& seq)
+    {
+        unsigned long count = values.size();
+        if (threads < 2 || count <= ChunkSize || count > INT_MAX / 2) {
+            processChunks(&nominal, &seq);
+            return;
+        }
+
+        Standard::SetReentrant(Standard_True);
+
+        std::vector< std::vector<InspectNominalGeometry*> > copies(threads - 1);
+        for (std::size_t i = 0; i < copies.size(); i++) {
+            for (std::vector<InspectNominalGeometry*>::iterator it = nominal.begin(); it != nominal.end(); ++it)
+                copies[i].push_back((*it)->clone());
+        }
+
+        QList< QFuture<void> > futures;
+        for (std::size_t i = 0; i < copies.size(); i++) {
+            std::vector<InspectNominalGeometry*>* nominals = &copies[i];
+            Base::SequencerLauncher* progress = 0;
+            futures << QtConcurrent::run(this, &DistanceInspection::processChunks, nominals, progress);
+        }
+
+        try {
+            // the calling thread takes part and reports the progress of all threads
+            processChunks(&nominal, &seq);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+                it->waitForFinished();
+            reportProgress(seq);
+        }
+        catch (...) {
+            // stop the other threads before their nominals are destroyed
+            nextIndex.fetchAndStoreOrdered((int)count);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it) {
+                try {
+                    it->waitForFinished();
+                }
+                catch (...) {
+                }
+            }
+            destroyCopies(copies);
+            throw;
+        }
+
+        destroyCopies(copies);
+    }
+
+private:
+    void processChunks(std::vector<InspectNominalGeometry*>* nominals, Base::SequencerLauncher* seq)
+    {
+        unsigned long count = values.size();
+        for (;;) {
+            unsigned long begin = (unsigned long)nextIndex.fetchAndAddOrdered((int)ChunkSize);
+            if (begin >= count)
+                break;
+            unsigned long end = std::min<unsigned long>(begin + ChunkSize, count);
+            for (unsigned long index = begin; index < end; index++)
+                values[index] = mapped(index, *nominals);
+            countDone.fetchAndAddOrdered((int)(end - begin));
+            if (seq)
+                reportProgress(*seq);
+        }
+    }
+    void reportProgress(Base::SequencerLauncher& seq)
+    {
+        unsigned long done = (unsigned long)countDone.fetchAndAddOrdered(0);
+        for (; countReported < done; countReported++)
+            seq.next();
+    }
+    static void destroyCopies(std::vector< std::vector<InspectNominalGeometry*> >& copies)
+    {
+        for (std::size_t i = 0; i < copies.size(); i++) {
+            for (std::vector<InspectNominalGeometry*>::iterator it = copies[i].begin(); it != copies[i].end(); ++it)
+                delete *it;
+        }
+    }
+
+    static const unsigned long ChunkSize = 1024;
 
     float radius;
     InspectActualGeometry*  actual;
     std::vector<InspectNominalGeometry*> nominal;
+    std::vector<float>& values;
+    QAtomicInt nextIndex;
+    QAtomicInt countDone;
+    unsigned long countReported;
 };
+}
 
 PROPERTY_SOURCE(Inspection::Feature, App::DocumentObject)
 
@@ -745,52 +826,21 @@ App::DocumentObjectExecReturn* Feature::execute(void)
             inspectNominal.push_back(nominal);
     }
 
-#if 0 // test with some huge data sets
-    Standard::SetReentrant(Standard_True);
-    std::vector<unsigned long> index(actual->countPoints());
-    std::generate(index.begin(), index.end(), Base::iotaGen<unsigned long>(0));
-    DistanceInspection check(this->SearchRadius.getValue(), actual, inspectNominal);
-    QFuture<float> future = QtConcurrent::mapped
-        (index, boost::bind(&DistanceInspection::mapped, &check, _1));
-    //future.waitForFinished(); // blocks the GUI
-    Base::FutureWatcherProgress progress("Inspecting...", actual->countPoints());
-    QFutureWatcher<float> watcher;
-    QObject::connect(&watcher, SIGNAL(progressValueChanged(int)),
-                     &progress, SLOT(progressValueChanged(int)));
-    watcher.setFuture(future);
-
-    // keep it responsive during computation
-    QEventLoop loop;
-    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
-    loop.exec();
-
-    std::vector<float> vals;
-    vals.insert(vals.end(), future.begin(), future.end());
-#else
     unsigned long count = actual->countPoints();
     std::stringstream str;
     str << "Inspecting " << this->Label.getValue() << "...";
     Base::SequencerLauncher seq(str.str().c_str(), count);
 
-    std::vector<float> vals(count);
-    for (unsigned long index = 0; index < count; index++) {
-        Base::Vector3f pnt = actual->getPoint(index);
-
-        float fMinDist=FLT_MAX;
-        for (std::vector<InspectNominalGeometry*>::iterator it = inspectNominal.begin(); it != inspectNominal.end(); ++it) {
-            float fDist = (*it)->getDistance(pnt);
-            if (fabs(fDist) < fabs(fMinDist))
-                fMinDist = fDist;
-        }
+    // the distances are computed in parallel unless disabled by the user
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Inspection/Inspection");
+    int threads = 1;
+    if (hGrp->GetBool("Multithreading", true))
+        threads = std::max(1, QThread::idealThreadCount());
 
-        if (fMinDist > this->SearchRadius.getValue())
-            fMinDist = FLT_MAX;
-        else if (-fMinDist > this->SearchRadius.getValue())
-            fMinDist = -FLT_MAX;
-        vals[index] = fMinDist;
-        seq.next();
-    }
-#endif
+    std::vector<float> vals(count);
+    DistanceInspection check(this->SearchRadius.getValue(), actual, inspectNominal, vals);
+    check.run(threads, seq);
 
     Distances.setValues(vals);
 
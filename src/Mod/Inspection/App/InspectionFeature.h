@@ -24,6 +24,8 @@
 #ifndef INSPECTION_FEATURE_H
 #define INSPECTION_FEATURE_H
 
+#include <boost/shared_ptr.hpp>
+
 #include <App/DocumentObject.h>
 #include <App/PropertyLinks.h>
 #include <App/DocumentObjectGroup.h>
@@ -37,6 +39,7 @@ class BRepExtrema_DistShapeShape;
 namespace MeshCore {
 class MeshKernel;
 class MeshGrid;
+class MeshFacetBVH;
 }
 
 namespace Mesh   { class MeshObject; }
@@ -46,7 +49,9 @@ namespace Part   { class TopoShape;  }
 namespace Inspection
 {
 
-/** Delivers the number of points to be checked and returns the appropriate point to an index. */
+/** Delivers the number of points to be checked and returns the appropriate point to an index.
+ * getPoint() is called from several threads at the same time.
+ */
 class InspectionExport InspectActualGeometry
 {
 public:
@@ -54,7 +59,7 @@ public:
     virtual ~InspectActualGeometry() {}
     /// Number of points to be checked
     virtual unsigned long countPoints() const = 0;
-    virtual Base::Vector3f getPoint(unsigned long) = 0;
+    virtual Base::Vector3f getPoint(unsigned long) const = 0;
 };
 
 class InspectionExport InspectActualMesh : public InspectActualGeometry
@@ -63,7 +68,7 @@ public:
     InspectActualMesh(const Mesh::MeshObject& rMesh);
     ~InspectActualMesh();
     virtual unsigned long countPoints() const;
-    virtual Base::Vector3f getPoint(unsigned long);
+    virtual Base::Vector3f getPoint(unsigned long) const;
 
 private:
     MeshCore::MeshPointIterator _iter;
@@ -75,7 +80,7 @@ class InspectionExport InspectActualPoints : public InspectActualGeometry
 public:
     InspectActualPoints(const Points::PointKernel&);
     virtual unsigned long countPoints() const;
-    virtual Base::Vector3f getPoint(unsigned long);
+    virtual Base::Vector3f getPoint(unsigned long) const;
 
 private:
     const Points::PointKernel& _rKernel;
@@ -86,20 +91,25 @@ class InspectionExport InspectActualShape : public InspectActualGeometry
 public:
     InspectActualShape(const Part::TopoShape&);
     virtual unsigned long countPoints() const;
-    virtual Base::Vector3f getPoint(unsigned long);
+    virtual Base::Vector3f getPoint(unsigned long) const;
 
 private:
     const Part::TopoShape& _rShape;
     std::vector<Base::Vector3d> points;
 };
 
-/** Calculates the shortest distance of the underlying geometry to a given point. */
+/** Calculates the shortest distance of the underlying geometry to a given point.
+ * An instance must not be used by several threads at the same time. Instead each
+ * thread works with its own copy created by clone().
+ */
 class InspectionExport InspectNominalGeometry
 {
 public:
     InspectNominalGeometry() {}
     virtual ~InspectNominalGeometry() {}
     virtual float getDistance(const Base::Vector3f&) = 0;
+    /// Creates a copy with its own query state that shares the search structures
+    virtual InspectNominalGeometry* clone() const = 0;
 };
 
 class InspectionExport InspectNominalMesh : public InspectNominalGeometry
@@ -108,10 +118,11 @@ public:
     InspectNominalMesh(const Mesh::MeshObject& rMesh, float offset);
     ~InspectNominalMesh();
     virtual float getDistance(const Base::Vector3f&);
+    virtual InspectNominalGeometry* clone() const;
 
 private:
     MeshCore::MeshFacetIterator _iter;
-    MeshCore::MeshGrid* _pGrid;
+    boost::shared_ptr<MeshCore::MeshFacetBVH> _pBVH;
     Base::BoundBox3f _box;
 };
 
@@ -121,10 +132,11 @@ public:
     InspectNominalFastMesh(const Mesh::MeshObject& rMesh, float offset);
     ~InspectNominalFastMesh();
     virtual float getDistance(const Base::Vector3f&);
+    virtual InspectNominalGeometry* clone() const;
 
 protected:
     MeshCore::MeshFacetIterator _iter;
-    MeshCore::MeshGrid* _pGrid;
+    boost::shared_ptr<MeshCore::MeshGrid> _pGrid;
     Base::BoundBox3f _box;
     unsigned long max_level;
 };
@@ -135,10 +147,11 @@ public:
     InspectNominalPoints(const Points::PointKernel&, float offset);
     ~InspectNominalPoints();
     virtual float getDistance(const Base::Vector3f&);
+    virtual InspectNominalGeometry* clone() const;
 
 private:
     const Points::PointKernel& _rKernel;
-    Points::PointsGrid* _pGrid;
+    boost::shared_ptr<Points::PointsGrid> _pGrid;
 };
 
 class InspectionExport InspectNominalShape : public InspectNominalGeometry
@@ -147,6 +160,11 @@ public:
     InspectNominalShape(const TopoDS_Shape&, float offset);
     ~InspectNominalShape();
     virtual float getDistance(const Base::Vector3f&);
+    virtual InspectNominalGeometry* clone() const;
+
+private:
+    InspectNominalShape(const InspectNominalShape&);
+    InspectNominalShape& operator=(const InspectNominalShape&);
 
 private:
     BRepExtrema_DistShapeShape* distss;
@@ -0,0 +1,94 @@
+#***************************************************************************
+#*                                                                         *
+#*   This file is part of the FreeCAD CAx development system.              *
+#*                                                                         *
+#*   This program is free software; you can redistribute it and/or modify  *
+#*   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#*   as published by the Free Software Foundation; either version 2 of     *
+#*   the License, or (at your option) any later version.                   *
+#*   for detail see the LICENCE text file.                                 *
+#*                                                                         *
+#*   FreeCAD is distributed in the hope that it will be useful,            *
+#*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#*   GNU Library General Public License for more details.                  *
+#*                                                                         *
+#*   You should have received a copy of the GNU Library General Public     *
+#*   License along with FreeCAD; if not, write to the Free Software        *
+#*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#*   USA                                                                   *
+#*                                                                         *
+#***************************************************************************
+
+import FreeCAD, unittest, random
+import Mesh, Points, Part, Inspection
+
+
+#---------------------------------------------------------------------------
+# define the functions to test the FreeCAD inspection module
+#---------------------------------------------------------------------------
+
+class InspectionFeatureCases(unittest.TestCase):
+    def setUp(self):
+        self.param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Mod/Inspection/Inspection")
+        self.multithreading = self.param.GetBool("Multithreading", True)
+        self.doc = FreeCAD.newDocument("InspectionTest")
+
+        # more points than fit into one chunk, so that several threads get work
+        random.seed(42)
+        pts = []
+        for i in range(3000):
+            v = FreeCAD.Vector(random.uniform(-1, 1), random.uniform(-1, 1), random.uniform(-1, 1))
+            if v.Length < 1e-3:
+                continue
+            v.normalize()
+            pts.append(v * random.uniform(9.0, 11.0))
+        self.actual = self.doc.addObject("Points::Feature", "Actual")
+        self.actual.Points = Points.Points(pts)
+
+    def inspect(self, nominal, multithreading):
+        self.param.SetBool("Multithreading", multithreading)
+        feature = self.doc.addObject("Inspection::Feature", "Inspection")
+        feature.Actual = self.actual
+        feature.Nominals = [nominal]
+        feature.SearchRadius = 2.0
+        self.doc.recompute()
+        distances = feature.Distances
+        self.doc.removeObject(feature.Name)
+        return distances
+
+    def compareDistances(self, nominal):
+        # each point is computed the same way, so the distances must be equal
+        serial = self.inspect(nominal, False)
+        parallel = self.inspect(nominal, True)
+        self.failUnless(len(serial) == self.actual.Points.CountPoints)
+        self.failUnless(len(serial) > 1024)
+        self.failUnless(serial == parallel)
+        self.failUnless(len([d for d in serial if abs(d) < 1.0]) > 0)
+
+    def testMeshNominal(self):
+        nominal = self.doc.addObject("Mesh::Feature", "Mesh")
+        nominal.Mesh = Mesh.createSphere(10.0, 100)
+        self.compareDistances(nominal)
+
+    def testShapeNominal(self):
+        nominal = self.doc.addObject("Part::Feature", "Shape")
+        nominal.Shape = Part.makeSphere(10.0)
+        self.compareDistances(nominal)
+
+    def testPointsNominal(self):
+        # enough points that the grid of the nominal is built in several blocks
+        rand = random.Random(4711)
+        pts = [FreeCAD.Vector(rand.uniform(-10, 10), rand.uniform(-10, 10), rand.uniform(-10, 10))
+               for i in range(300000)]
+        nominal = self.doc.addObject("Points::Feature", "Nominal")
+        nominal.Points = Points.Points(pts)
+        # each actual point is a nominal point, so it must be found in its grid element
+        self.actual.Points = Points.Points(pts[::100])
+        distances = self.inspect(nominal, True)
+        self.failUnless(len(distances) == len(pts[::100]))
+        self.failUnless(max(distances) == 0.0)
+
+    def tearDown(self):
+        self.param.SetBool("Multithreading", self.multithreading)
+        FreeCAD.closeDocument("InspectionTest")
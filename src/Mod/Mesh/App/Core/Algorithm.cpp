@@ -29,6 +29,7 @@
 
 #include "Algorithm.h"
 #include "Approximation.h"
+#include "BVH.h"
 #include "Elements.h"
 #include "Iterator.h"
 #include "Grid.h"
@@ -140,6 +141,12 @@ bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::
     return false;
 }
 
+bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const MeshFacetBVH &rclBVH,
+                                       Base::Vector3f &rclRes, unsigned long &rulFacet) const
+{
+    return rclBVH.NearestFacetOnRay(rclPt, rclDir, rclRes, rulFacet, true);
+}
+
 bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const std::vector<unsigned long> &raulFacets,
                                        Base::Vector3f &rclRes, unsigned long &rulFacet) const
 {
@@ -239,6 +246,39 @@ bool MeshAlgorithm::FirstFacetToVertex(const Base::Vector3f &rPt, float fMaxDist
     return found;
 }
 
+bool MeshAlgorithm::FirstFacetToVertex(const Base::Vector3f &rPt, float fMaxDistance, const MeshFacetBVH &rBVH, unsigned long &uIndex) const
+{
+    const float fEps = 0.001f;
+
+    std::vector<unsigned long> facets;
+
+    // get the facets around the point, sorted by their index
+    rBVH.FacetsAroundPoint(rPt, std::max<float>(fMaxDistance, fEps), facets);
+
+    // Check all facets if the point is part of it
+    for (std::vector<unsigned long>::iterator it = facets.begin(); it != facets.end(); ++it) {
+        MeshGeomFacet cFacet = this->_rclMesh.GetFacet(*it);
+        if (cFacet.IsPointOfFace(rPt, fMaxDistance)) {
+            uIndex = *it;
+            return true;
+        }
+        else {
+            // if not then check the distance to the border of the triangle
+            Base::Vector3f res;
+            float fDist;
+            unsigned short uSide;
+            cFacet.ProjectPointToPlane(rPt, res);
+            cFacet.NearestEdgeToPoint(res, fDist, uSide);
+            if (fDist < fEps) {
+                uIndex = *it;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 float MeshAlgorithm::GetAverageEdgeLength() const
 {
     float fLen = 0.0f;
@@ -1400,6 +1440,13 @@ bool MeshAlgorithm::NearestPointFromPoint (const Base::Vector3f &rclPt, const Me
   return true;
 }
 
+bool MeshAlgorithm::NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclBVH,
+                                           unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const
+{
+  float fDist;
+  return rclBVH.NearestFacetToPoint(rclPt, rclResFacetIndex, fDist, rclResPoint);
+}
+
 bool MeshAlgorithm::CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetGrid &rclGrid,
                                   std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps, bool bConnectPolygons) const
 {
@@ -45,6 +45,7 @@ class MeshGeomFacet;
 class MeshGeomEdge;
 class MeshKernel;
 class MeshFacetGrid;
+class MeshFacetBVH;
 class MeshFacetArray;
 class MeshRefPointToFacets;
 class AbstractPolygonTriangulator;
@@ -100,12 +101,28 @@ public:
    */
   bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, float fMaxSearchArea,
                           const MeshFacetGrid &rclGrid, Base::Vector3f &rclRes, unsigned long &rulFacet) const;
+  /**
+   * Searches for the nearest facet to the ray defined by
+   * (\a rclPt, \a rclDir).
+   * The point \a rclRes holds the intersection point with the ray and the
+   * nearest facet with index \a rulFacet.
+   * Like the grid version only facets in direction of \a rclDir are found.
+   * \note This method is optimized by using a bounding volume hierarchy which
+   * unlike a grid doesn't depend on an even distribution of the facets.
+   */
+  bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const MeshFacetBVH &rclBVH,
+                          Base::Vector3f &rclRes, unsigned long &rulFacet) const;
   /**
    * Searches for the first facet of the grid element (\a rclGrid) in that the point \a rclPt lies into which is a distance not
    * higher than \a fMaxDistance. Of no such facet is found \a rulFacet is undefined and false is returned, otherwise true.
    * \note If the point \a rclPt is outside of the grid \a rclGrid nothing is done.
    */
   bool FirstFacetToVertex(const Base::Vector3f &rclPt, float fMaxDistance, const MeshFacetGrid &rclGrid, unsigned long &rulFacet) const;
+  /**
+   * Searches for the facet with the lowest index around the point \a rclPt which is a distance not higher than \a fMaxDistance.
+   * If no such facet is found \a rulFacet is undefined and false is returned, otherwise true.
+   */
+  bool FirstFacetToVertex(const Base::Vector3f &rclPt, float fMaxDistance, const MeshFacetBVH &rclBVH, unsigned long &rulFacet) const;
   /**
    * Checks from the viewpoint \a rcView if the vertex \a rcVertex is visible or it is hidden by a facet. 
    * If the vertex is visible true is returned, false otherwise.
@@ -276,6 +293,8 @@ public:
                               unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
   bool NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetGrid& rclGrid, float fMaxSearchArea,
                               unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
+  bool NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclBVH,
+                              unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
   /** Cuts the mesh with a plane. The result is a list of polylines. */
   bool CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetGrid &rclGrid,
                      std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
@@ -0,0 +1,520 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <climits>
+#endif
+
+#include "BVH.h"
+#include "Elements.h"
+#include "MeshKernel.h"
+
+using namespace MeshCore;
+
+namespace MeshCore {
+// Number of bins per axis used to evaluate the surface area heuristic
+const unsigned long BVH_BIN_COUNT = 16;
+// Nodes with up to this number of facets always become a leaf
+const unsigned long BVH_MIN_LEAF_SIZE = 4;
+// Nodes with up to this number of facets become a leaf if a split doesn't pay off
+const unsigned long BVH_MAX_LEAF_SIZE = 16;
+// The stacks of the queries have a fixed size, so the depth of the tree is limited
+const unsigned long BVH_MAX_DEPTH = 60;
+}
+
+struct MeshFacetBVH::FacetBox
+{
+  float         fMin[3];
+  float         fMax[3];
+  float         fCenter[3];
+  unsigned long ulIndex;
+};
+
+namespace MeshCore {
+struct BVHBin
+{
+  float         fMin[3];
+  float         fMax[3];
+  unsigned long ulCount;
+
+  BVHBin() : ulCount(0)
+  {
+    for (int i = 0; i < 3; i++) {
+      fMin[i] =  FLOAT_MAX;
+      fMax[i] = -FLOAT_MAX;
+    }
+  }
+  void Add (const float fBoxMin[3], const float fBoxMax[3])
+  {
+    for (int i = 0; i < 3; i++) {
+      fMin[i] = std::min<float>(fMin[i], fBoxMin[i]);
+      fMax[i] = std::max<float>(fMax[i], fBoxMax[i]);
+    }
+  }
+  float HalfArea () const
+  {
+    float dx = fMax[0] - fMin[0];
+    float dy = fMax[1] - fMin[1];
+    float dz = fMax[2] - fMin[2];
+    return dx * dy + dy * dz + dz * dx;
+  }
+};
+
+struct BVHBinOfBox
+{
+  int   iAxis;
+  float fMin;
+  float fScale;
+
+  BVHBinOfBox (int axis, float min, float scale) : iAxis(axis), fMin(min), fScale(scale) {}
+  unsigned long operator() (const float fCenter[3]) const
+  {
+    unsigned long ulBin = (unsigned long)((fCenter[iAxis] - fMin) * fScale);
+    return std::min<unsigned long>(ulBin, BVH_BIN_COUNT - 1);
+  }
+};
+}
+
+MeshFacetBVH::MeshFacetBVH (const MeshKernel &rclM)
+{
+  Rebuild(rclM);
+}
+
+MeshFacetBVH::MeshFacetBVH (const MeshKernel &rclM, const Base::Matrix4D &rclMat)
+{
+  Rebuild(rclM, rclMat);
+}
+
+MeshFacetBVH::~MeshFacetBVH (void)
+{
+}
+
+void MeshFacetBVH::Rebuild (const MeshKernel &rclM)
+{
+  const MeshPointArray& rPoints = rclM.GetPoints();
+  const MeshFacetArray& rFacets = rclM.GetFacets();
+
+  std::vector<Base::Vector3f> aclPoints;
+  aclPoints.reserve(3 * rFacets.size());
+  for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+    aclPoints.push_back(rPoints[it->_aulPoints[0]]);
+    aclPoints.push_back(rPoints[it->_aulPoints[1]]);
+    aclPoints.push_back(rPoints[it->_aulPoints[2]]);
+  }
+
+  Build(aclPoints);
+}
+
+void MeshFacetBVH::Rebuild (const MeshKernel &rclM, const Base::Matrix4D &rclMat)
+{
+  const MeshPointArray& rPoints = rclM.GetPoints();
+  const MeshFacetArray& rFacets = rclM.GetFacets();
+
+  // transform the points the same way as MeshFacetIterator does
+  std::vector<Base::Vector3f> aclPoints;
+  aclPoints.reserve(3 * rFacets.size());
+  for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+    aclPoints.push_back(rclMat * rPoints[it->_aulPoints[0]]);
+    aclPoints.push_back(rclMat * rPoints[it->_aulPoints[1]]);
+    aclPoints.push_back(rclMat * rPoints[it->_aulPoints[2]]);
+  }
+
+  Build(aclPoints);
+}
+
+void MeshFacetBVH::Build (const std::vector<Base::Vector3f> &aclPoints)
+{
+  unsigned long ulCtFacets = aclPoints.size() / 3;
+
+  _aclNodes.clear();
+  _aclPoints.clear();
+  _aulFacets.clear();
+  if (ulCtFacets == 0)
+    return;
+
+  std::vector<FacetBox> aclBoxes(ulCtFacets);
+  float fMaxCoord = 0.0f;
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    FacetBox& box = aclBoxes[i];
+    const Base::Vector3f* p = &aclPoints[3 * i];
+    for (int j = 0; j < 3; j++) {
+      box.fMin[j] = std::min<float>(p[0][j], std::min<float>(p[1][j], p[2][j]));
+      box.fMax[j] = std::max<float>(p[0][j], std::max<float>(p[1][j], p[2][j]));
+      box.fCenter[j] = 0.5f * (box.fMin[j] + box.fMax[j]);
+      fMaxCoord = std::max<float>(fMaxCoord, std::max<float>(fabs(box.fMin[j]), fabs(box.fMax[j])));
+    }
+    box.ulIndex = i;
+  }
+
+  // a balanced tree has about twice as many nodes as leaves
+  _aclNodes.reserve(4 * ulCtFacets / BVH_MIN_LEAF_SIZE + 1);
+  BuildNode(aclBoxes, 0, ulCtFacets, 0);
+
+  // Enlarge the boxes a bit so that intersection points and nearest points that are computed
+  // with the usual rounding errors still lie inside the boxes of their facets
+  float fEps = 1.0e-5f * fMaxCoord;
+  for (std::vector<Node>::iterator it = _aclNodes.begin(); it != _aclNodes.end(); ++it) {
+    for (int j = 0; j < 3; j++) {
+      it->fMin[j] -= fEps;
+      it->fMax[j] += fEps;
+    }
+  }
+
+  // store the facets in the order of the leaves
+  _aulFacets.resize(ulCtFacets);
+  _aclPoints.resize(3 * ulCtFacets);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    unsigned long ulIndex = aclBoxes[i].ulIndex;
+    _aulFacets[i] = ulIndex;
+    _aclPoints[3 * i    ] = aclPoints[3 * ulIndex    ];
+    _aclPoints[3 * i + 1] = aclPoints[3 * ulIndex + 1];
+    _aclPoints[3 * i + 2] = aclPoints[3 * ulIndex + 2];
+  }
+}
+
+unsigned long MeshFacetBVH::BuildNode (std::vector<FacetBox> &aclBoxes, unsigned long ulFirst, unsigned long ulLast,
+                                       unsigned long ulDepth)
+{
+  // _aclNodes may be reallocated by the recursive calls, so only work with indices
+  unsigned long ulNode = _aclNodes.size();
+  _aclNodes.push_back(Node());
+
+  BVHBin clBounds, clCenters;
+  for (unsigned long i = ulFirst; i < ulLast; i++) {
+    clBounds.Add(aclBoxes[i].fMin, aclBoxes[i].fMax);
+    clCenters.Add(aclBoxes[i].fCenter, aclBoxes[i].fCenter);
+  }
+
+  for (int j = 0; j < 3; j++) {
+    _aclNodes[ulNode].fMin[j] = clBounds.fMin[j];
+    _aclNodes[ulNode].fMax[j] = clBounds.fMax[j];
+  }
+  _aclNodes[ulNode].uiOffset = static_cast<unsigned int>(ulFirst);
+  _aclNodes[ulNode].uiCount  = static_cast<unsigned int>(ulLast - ulFirst);
+
+  unsigned long ulCount = ulLast - ulFirst;
+  if (ulCount <= BVH_MIN_LEAF_SIZE || ulDepth >= BVH_MAX_DEPTH)
+    return ulNode;
+
+  // search for the split with the lowest cost
+  int iBestAxis = -1;
+  unsigned long ulBestBin = 0;
+  float fBestCost = FLOAT_MAX;
+  for (int iAxis = 0; iAxis < 3; iAxis++) {
+    float fExtent = clCenters.fMax[iAxis] - clCenters.fMin[iAxis];
+    if (fExtent <= 0.0f)
+      continue;
+
+    BVHBinOfBox clBinOf(iAxis, clCenters.fMin[iAxis], float(BVH_BIN_COUNT) / fExtent);
+    BVHBin aclBins[BVH_BIN_COUNT];
+    for (unsigned long i = ulFirst; i < ulLast; i++) {
+      BVHBin& bin = aclBins[clBinOf(aclBoxes[i].fCenter)];
+      bin.Add(aclBoxes[i].fMin, aclBoxes[i].fMax);
+      bin.ulCount++;
+    }
+
+    // areas and counts of the right side for each split position
+    float afRightArea[BVH_BIN_COUNT];
+    unsigned long aulRightCount[BVH_BIN_COUNT];
+    BVHBin clRight;
+    unsigned long ulRightCount = 0;
+    for (unsigned long i = BVH_BIN_COUNT - 1; i > 0; i--) {
+      clRight.Add(aclBins[i].fMin, aclBins[i].fMax);
+      ulRightCount += aclBins[i].ulCount;
+      afRightArea[i] = clRight.HalfArea();
+      aulRightCount[i] = ulRightCount;
+    }
+
+    BVHBin clLeft;
+    unsigned long ulLeftCount = 0;
+    for (unsigned long i = 1; i < BVH_BIN_COUNT; i++) {
+      clLeft.Add(aclBins[i - 1].fMin, aclBins[i - 1].fMax);
+      ulLeftCount += aclBins[i - 1].ulCount;
+      if (ulLeftCount == 0 || aulRightCount[i] == 0)
+        continue;
+      float fCost = float(ulLeftCount) * clLeft.HalfArea() + float(aulRightCount[i]) * afRightArea[i];
+      if (fCost < fBestCost) {
+        fBestCost = fCost;
+        iBestAxis = iAxis;
+        ulBestBin = i;
+      }
+    }
+  }
+
+  unsigned long ulMid;
+  if (iBestAxis < 0) {
+    // all centers coincide, split in the middle
+    ulMid = ulFirst + ulCount / 2;
+  }
+  else {
+    // compare with the cost of a leaf, the traversal of an inner node costs as much as one facet test
+    float fArea = clBounds.HalfArea();
+    if (fArea > 0.0f && ulCount <= BVH_MAX_LEAF_SIZE && 1.0f + fBestCost / fArea >= float(ulCount))
+      return ulNode;
+
+    BVHBinOfBox clBinOf(iBestAxis, clCenters.fMin[iBestAxis],
+                        float(BVH_BIN_COUNT) / (clCenters.fMax[iBestAxis] - clCenters.fMin[iBestAxis]));
+    std::vector<FacetBox>::iterator it = aclBoxes.begin();
+    std::vector<FacetBox>::iterator pos = it + ulFirst;
+    for (std::vector<FacetBox>::iterator jt = pos; jt != it + ulLast; ++jt) {
+      if (clBinOf(jt->fCenter) < ulBestBin)
+        std::swap(*pos++, *jt);
+    }
+    ulMid = pos - it;
+  }
+
+  BuildNode(aclBoxes, ulFirst, ulMid, ulDepth + 1);
+  unsigned long ulRight = BuildNode(aclBoxes, ulMid, ulLast, ulDepth + 1);
+  _aclNodes[ulNode].uiOffset = static_cast<unsigned int>(ulRight);
+  _aclNodes[ulNode].uiCount  = 0;
+
+  return ulNode;
+}
+
+inline float MeshFacetBVH::SquaredDistanceToBox (const Node &rclNode, const Base::Vector3f &rclPt) const
+{
+  float fDist = 0.0f;
+  for (unsigned short j = 0; j < 3; j++) {
+    float d = std::max<float>(rclNode.fMin[j] - rclPt[j], std::max<float>(rclPt[j] - rclNode.fMax[j], 0.0f));
+    fDist += d * d;
+  }
+  return fDist;
+}
+
+inline bool MeshFacetBVH::IntersectBox (const Node &rclNode, const Base::Vector3f &rclPt, const Base::Vector3f &rclDir,
+                                        const Base::Vector3f &rclInvDir, bool bForward, float &rfMinParam) const
+{
+  // the parameter range of the line inside the box
+  float fNear = bForward ? 0.0f : -FLOAT_MAX;
+  float fFar  =  FLOAT_MAX;
+  for (unsigned short j = 0; j < 3; j++) {
+    if (rclDir[j] == 0.0f) {
+      if (rclPt[j] < rclNode.fMin[j] || rclPt[j] > rclNode.fMax[j])
+        return false;
+      continue;
+    }
+
+    float t1 = (rclNode.fMin[j] - rclPt[j]) * rclInvDir[j];
+    float t2 = (rclNode.fMax[j] - rclPt[j]) * rclInvDir[j];
+    if (t1 > t2)
+      std::swap(t1, t2);
+    fNear = std::max<float>(fNear, t1);
+    fFar  = std::min<float>(fFar, t2);
+    if (fNear > fFar)
+      return false;
+  }
+
+  if (fNear > 0.0f)
+    rfMinParam = fNear;
+  else if (fFar < 0.0f)
+    rfMinParam = -fFar;
+  else
+    rfMinParam = 0.0f;
+  return true;
+}
+
+bool MeshFacetBVH::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir,
+                                      Base::Vector3f &rclRes, unsigned long &rulFacet, bool bForward) const
+{
+  // MeshGeomFacet::Foraminate never succeeds for a null vector
+  float fDirLen = rclDir.Length();
+  if (_aclNodes.empty() || fDirLen == 0.0f)
+    return false;
+
+  Base::Vector3f clInvDir;
+  for (unsigned short j = 0; j < 3; j++)
+    clInvDir[j] = rclDir[j] != 0.0f ? 1.0f / rclDir[j] : 0.0f;
+
+  bool bSol = false;
+  float fMinDist = FLOAT_MAX;
+  unsigned long ulInd = ULONG_MAX;
+  Base::Vector3f clProj, clRes;
+
+  float fParam;
+  if (!IntersectBox(_aclNodes[0], rclPt, rclDir, clInvDir, bForward, fParam))
+    return false;
+
+  // pending nodes with the lower bound of their distance
+  std::pair<unsigned int, float> aStack[BVH_MAX_DEPTH + 2];
+  int iTop = 0;
+  aStack[iTop++] = std::make_pair(0u, fParam * fDirLen);
+  while (iTop > 0) {
+    --iTop;
+    unsigned int uiNode = aStack[iTop].first;
+    // facets with the same distance are compared by their index
+    if (aStack[iTop].second > fMinDist)
+      continue;
+
+    const Node& rclNode = _aclNodes[uiNode];
+    if (rclNode.uiCount > 0) {
+      for (unsigned int i = rclNode.uiOffset; i < rclNode.uiOffset + rclNode.uiCount; i++) {
+        MeshGeomFacet clFacet(_aclPoints[3 * i], _aclPoints[3 * i + 1], _aclPoints[3 * i + 2]);
+        if (clFacet.Foraminate(rclPt, rclDir, clRes)) {
+          if (bForward && (clRes - rclPt) * rclDir < 0.0f)
+            continue;
+          float fDist = (clRes - rclPt).Length();
+          if (!bSol || fDist < fMinDist || (fDist == fMinDist && _aulFacets[i] < ulInd)) {
+            bSol     = true;
+            fMinDist = fDist;
+            clProj   = clRes;
+            ulInd    = _aulFacets[i];
+          }
+        }
+      }
+    }
+    else {
+      // visit the nearer child first
+      unsigned int uiLeft = uiNode + 1, uiRight = rclNode.uiOffset;
+      float fLeft, fRight;
+      bool bLeft  = IntersectBox(_aclNodes[uiLeft],  rclPt, rclDir, clInvDir, bForward, fLeft);
+      bool bRight = IntersectBox(_aclNodes[uiRight], rclPt, rclDir, clInvDir, bForward, fRight);
+      fLeft *= fDirLen;
+      fRight *= fDirLen;
+      if (bLeft && bRight) {
+        if (fLeft <= fRight) {
+          aStack[iTop++] = std::make_pair(uiRight, fRight);
+          aStack[iTop++] = std::make_pair(uiLeft, fLeft);
+        }
+        else {
+          aStack[iTop++] = std::make_pair(uiLeft, fLeft);
+          aStack[iTop++] = std::make_pair(uiRight, fRight);
+        }
+      }
+      else if (bLeft) {
+        aStack[iTop++] = std::make_pair(uiLeft, fLeft);
+      }
+      else if (bRight) {
+        aStack[iTop++] = std::make_pair(uiRight, fRight);
+      }
+    }
+  }
+
+  if (bSol) {
+    rclRes   = clProj;
+    rulFacet = ulInd;
+  }
+
+  return bSol;
+}
+
+bool MeshFacetBVH::NearestFacetToPoint (const Base::Vector3f &rclPt, unsigned long &rulFacet, float &rfDist,
+                                        Base::Vector3f &rclRes) const
+{
+  if (_aclNodes.empty())
+    return false;
+
+  float fMinDist = FLOAT_MAX;
+  unsigned long ulInd = ULONG_MAX;
+  unsigned long ulPos = ULONG_MAX;
+
+  // pending nodes with the lower bound of their squared distance
+  std::pair<unsigned int, float> aStack[BVH_MAX_DEPTH + 2];
+  int iTop = 0;
+  aStack[iTop++] = std::make_pair(0u, SquaredDistanceToBox(_aclNodes[0], rclPt));
+  while (iTop > 0) {
+    --iTop;
+    unsigned int uiNode = aStack[iTop].first;
+    // facets with the same distance are compared by their index
+    if (ulInd != ULONG_MAX && aStack[iTop].second > fMinDist * fMinDist)
+      continue;
+
+    const Node& rclNode = _aclNodes[uiNode];
+    if (rclNode.uiCount > 0) {
+      for (unsigned int i = rclNode.uiOffset; i < rclNode.uiOffset + rclNode.uiCount; i++) {
+        MeshGeomFacet clFacet(_aclPoints[3 * i], _aclPoints[3 * i + 1], _aclPoints[3 * i + 2]);
+        float fDist = clFacet.DistanceToPoint(rclPt);
+        if (fDist < fMinDist || (fDist == fMinDist && _aulFacets[i] < ulInd)) {
+          fMinDist = fDist;
+          ulInd    = _aulFacets[i];
+          ulPos    = i;
+        }
+      }
+    }
+    else {
+      // visit the nearer child first
+      unsigned int uiLeft = uiNode + 1, uiRight = rclNode.uiOffset;
+      float fLeft  = SquaredDistanceToBox(_aclNodes[uiLeft], rclPt);
+      float fRight = SquaredDistanceToBox(_aclNodes[uiRight], rclPt);
+      if (fLeft <= fRight) {
+        aStack[iTop++] = std::make_pair(uiRight, fRight);
+        aStack[iTop++] = std::make_pair(uiLeft, fLeft);
+      }
+      else {
+        aStack[iTop++] = std::make_pair(uiLeft, fLeft);
+        aStack[iTop++] = std::make_pair(uiRight, fRight);
+      }
+    }
+  }
+
+  // distances of degenerated facets may be invalid
+  if (ulPos == ULONG_MAX)
+    return false;
+
+  MeshGeomFacet clFacet(_aclPoints[3 * ulPos], _aclPoints[3 * ulPos + 1], _aclPoints[3 * ulPos + 2]);
+  rfDist   = clFacet.DistanceToPoint(rclPt, rclRes);
+  rulFacet = ulInd;
+
+  return true;
+}
+
+void MeshFacetBVH::FacetsAroundPoint (const Base::Vector3f &rclPt, float fDistance, std::vector<unsigned long> &raulFacets) const
+{
+  if (_aclNodes.empty())
+    return;
+
+  unsigned long ulSize = raulFacets.size();
+  float fDist2 = fDistance * fDistance;
+
+  unsigned int auiStack[BVH_MAX_DEPTH + 2];
+  int iTop = 0;
+  auiStack[iTop++] = 0;
+  while (iTop > 0) {
+    unsigned int uiNode = auiStack[--iTop];
+    const Node& rclNode = _aclNodes[uiNode];
+    if (SquaredDistanceToBox(rclNode, rclPt) > fDist2)
+      continue;
+
+    if (rclNode.uiCount > 0) {
+      for (unsigned int i = rclNode.uiOffset; i < rclNode.uiOffset + rclNode.uiCount; i++) {
+        float fBoxDist = 0.0f;
+        for (unsigned short j = 0; j < 3; j++) {
+          float fMin = std::min<float>(_aclPoints[3 * i][j], std::min<float>(_aclPoints[3 * i + 1][j], _aclPoints[3 * i + 2][j]));
+          float fMax = std::max<float>(_aclPoints[3 * i][j], std::max<float>(_aclPoints[3 * i + 1][j], _aclPoints[3 * i + 2][j]));
+          float d = std::max<float>(fMin - rclPt[j], std::max<float>(rclPt[j] - fMax, 0.0f));
+          fBoxDist += d * d;
+        }
+        if (fBoxDist <= fDist2)
+          raulFacets.push_back(_aulFacets[i]);
+      }
+    }
+    else {
+      auiStack[iTop++] = rclNode.uiOffset;
+      auiStack[iTop++] = uiNode + 1;
+    }
+  }
+
+  std::sort(raulFacets.begin() + ulSize, raulFacets.end());
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <vector>
+
+#include <Base/Matrix.h>
+#include <Base/Vector3D.h>
+
+namespace MeshCore {
+
+class MeshKernel;
+
+/**
+ * The MeshFacetBVH class is a bounding volume hierarchy over the facets of a mesh.
+ * Unlike the grids it adapts to the distribution of the facets, so the queries stay
+ * fast on meshes with a very uneven facet density. The tree is built with a binned
+ * surface area heuristic.
+ *
+ * The nodes are 32 bytes each and stored depth-first in one array where the first
+ * child of an inner node directly follows its parent. The corner points of the facets
+ * are copied in the order of the leaves, so a leaf is tested without accessing the
+ * mesh kernel.
+ *
+ * After the tree is built all queries are read-only and can be used by several
+ * threads at the same time.
+ */
+class MeshExport MeshFacetBVH
+{
+public:
+  /** @name Construction */
+  //@{
+  /// Construction
+  MeshFacetBVH (const MeshKernel &rclM);
+  /// Construction, the facets are transformed by \a rclMat
+  MeshFacetBVH (const MeshKernel &rclM, const Base::Matrix4D &rclMat);
+  /// Destruction
+  ~MeshFacetBVH (void);
+  //@}
+
+  /** Rebuilds the tree for the given mesh. */
+  void Rebuild (const MeshKernel &rclM);
+  /** Rebuilds the tree for the given mesh whose facets are transformed by \a rclMat. */
+  void Rebuild (const MeshKernel &rclM, const Base::Matrix4D &rclMat);
+  /** Returns the number of facets in the tree. */
+  unsigned long CountFacets (void) const
+  { return _aulFacets.size(); }
+  /** Returns the number of nodes of the tree. */
+  unsigned long CountNodes (void) const
+  { return _aclNodes.size(); }
+
+  /** @name Search */
+  //@{
+  /**
+   * Searches for the nearest facet to the point \a rclPt that is hit by the line through
+   * \a rclPt with direction \a rclDir. The intersection point is \a rclRes and the index
+   * of the facet \a rulFacet. The line extends in both directions like in
+   * MeshAlgorithm::NearestFacetOnRay() that tests all facets. If \a bForward is true only
+   * intersection points in direction of \a rclDir are accepted.
+   */
+  bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir,
+                          Base::Vector3f &rclRes, unsigned long &rulFacet, bool bForward = false) const;
+  /**
+   * Searches for the facet with the smallest distance to the point \a rclPt. The distance is
+   * \a rfDist and the nearest point on the facet \a rclRes. If the tree is empty false is
+   * returned.
+   */
+  bool NearestFacetToPoint (const Base::Vector3f &rclPt, unsigned long &rulFacet, float &rfDist,
+                            Base::Vector3f &rclRes) const;
+  /**
+   * Gets the indices of all facets whose bounding box has a distance not higher than
+   * \a fDistance to the point \a rclPt. The indices are sorted.
+   */
+  void FacetsAroundPoint (const Base::Vector3f &rclPt, float fDistance, std::vector<unsigned long> &raulFacets) const;
+  //@}
+
+private:
+  struct Node
+  {
+    float         fMin[3];
+    float         fMax[3];
+    unsigned int  uiOffset; /**< First facet of a leaf or index of the second child of an inner node. */
+    unsigned int  uiCount;  /**< Number of facets of a leaf, 0 for inner nodes. */
+  };
+  struct FacetBox;
+
+  void Build (const std::vector<Base::Vector3f> &aclPoints);
+  unsigned long BuildNode (std::vector<FacetBox> &aclBoxes, unsigned long ulFirst, unsigned long ulLast,
+                           unsigned long ulDepth);
+  inline float SquaredDistanceToBox (const Node &rclNode, const Base::Vector3f &rclPt) const;
+  inline bool IntersectBox (const Node &rclNode, const Base::Vector3f &rclPt, const Base::Vector3f &rclDir,
+                            const Base::Vector3f &rclInvDir, bool bForward, float &rfMinParam) const;
+
+private:
+  std::vector<Node>           _aclNodes;  /**< Nodes of the tree, the root is the first one. */
+  std::vector<Base::Vector3f> _aclPoints; /**< Corner points of the facets in the order of the leaves. */
+  std::vector<unsigned long>  _aulFacets; /**< Facet indices in the order of the leaves. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_BVH_H
@@ -25,8 +25,17 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <cfloat>
+# include <climits>
+# include <cmath>
+# include <cstring>
 #endif
 
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
 #include <Base/Sequencer.h>
 #include <Base/Exception.h>
 
@@ -253,3 +262,444 @@ void MeshBuilder::Finish (bool freeMemory)
 
     _meshKernel.RecalcBoundBox();
 }
+
+// ----------------------------------------------------------------------------
+
+namespace {
+template <class T>
+void sortRange(T* first, T* last)
+{
+    std::sort(first, last);
+}
+
+template <class T>
+void mergeRange(T* first, T* middle, T* last)
+{
+    std::inplace_merge(first, middle, last);
+}
+
+// Sorts the items in chunks with several threads and merges the chunks pairwise
+template <class T>
+void sortParallel(std::vector<T>& items)
+{
+    std::size_t count = items.size();
+    if (count == 0)
+        return;
+
+    T* data = &items[0];
+    int threads = std::max(1, QThread::idealThreadCount());
+    if (threads > 1 && count > 100000) {
+        std::vector<T*> bounds;
+        for (int i = 0; i <= threads; i++)
+            bounds.push_back(data + (count * i) / threads);
+
+        QList< QFuture<void> > futures;
+        for (std::size_t i = 0; i + 1 < bounds.size(); i++)
+            futures << QtConcurrent::run(&sortRange<T>, bounds[i], bounds[i+1]);
+        for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+            it->waitForFinished();
+
+        while (bounds.size() > 2) {
+            std::vector<T*> merged;
+            std::size_t chunks = bounds.size() - 1;
+            futures.clear();
+            for (std::size_t i = 0; i + 1 < chunks; i += 2) {
+                futures << QtConcurrent::run(&mergeRange<T>, bounds[i], bounds[i+1], bounds[i+2]);
+                merged.push_back(bounds[i]);
+            }
+            if (chunks % 2)
+                merged.push_back(bounds[chunks-1]);
+            merged.push_back(bounds[chunks]);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+                it->waitForFinished();
+            bounds.swap(merged);
+        }
+    }
+    else {
+        sortRange(data, data + count);
+    }
+}
+
+// A point with the index of the cell it lies in
+struct CellPoint
+{
+    int64_t cell[3];
+    Base::Vector3f point;
+    unsigned long index;
+
+    bool operator < (const CellPoint& p) const
+    {
+        for (int i = 0; i < 3; i++) {
+            if (cell[i] != p.cell[i])
+                return cell[i] < p.cell[i];
+        }
+        return index < p.index;
+    }
+};
+
+// Compares only the cell of a point, for the search of all points of a cell
+struct CellLess
+{
+    bool operator () (const CellPoint& p, const int64_t* cell) const
+    {
+        for (int i = 0; i < 3; i++) {
+            if (p.cell[i] != cell[i])
+                return p.cell[i] < cell[i];
+        }
+        return false;
+    }
+    bool operator () (const int64_t* cell, const CellPoint& p) const
+    {
+        for (int i = 0; i < 3; i++) {
+            if (cell[i] != p.cell[i])
+                return cell[i] < p.cell[i];
+        }
+        return false;
+    }
+};
+
+// The same comparison as MeshPoint::operator< uses
+inline bool isSamePoint(const Base::Vector3f& p, const Base::Vector3f& q, float tolerance)
+{
+    return std::fabs(p.x - q.x) < tolerance &&
+           std::fabs(p.y - q.y) < tolerance &&
+           std::fabs(p.z - q.z) < tolerance;
+}
+
+// Searches for a point the first earlier point within the tolerance
+class NearPointSearch
+{
+public:
+    NearPointSearch(const std::vector<CellPoint>& points, float tolerance, double cellSize)
+        : points(points), tolerance(tolerance), cellSize(cellSize)
+    {
+    }
+    // Sets for the points [begin, end) the first earlier point within the tolerance
+    void find(std::size_t begin, std::size_t end, std::vector<unsigned long>* firstNear) const
+    {
+        for (std::size_t i = begin; i < end; i++) {
+            unsigned long index = firstNearPoint(i, 0);
+            if (index != points[i].index)
+                (*firstNear)[points[i].index] = index;
+        }
+    }
+    // Returns the first earlier point within the tolerance that is not merged into
+    // another point, or the index of the point itself
+    unsigned long firstNearPoint(std::size_t i, const std::vector<unsigned long>* mapping) const
+    {
+        const CellPoint& p = points[i];
+        unsigned long first = p.index;
+
+        // the points of the same cell are stored next to each other
+        for (std::size_t j = i; j > 0 && isSameCell(points[j-1].cell, p.cell); j--)
+            checkPoint(p, points[j-1], mapping, first);
+        for (std::size_t j = i + 1; j < points.size() && isSameCell(points[j].cell, p.cell); j++)
+            checkPoint(p, points[j], mapping, first);
+
+        // a point near the cell border is compared with the points of the neighbouring cells
+        double margin = 2.0 * tolerance;
+        int lower[3], upper[3];
+        for (int k = 0; k < 3; k++) {
+            double offset = p.point[k] - p.cell[k] * cellSize;
+            lower[k] = offset < margin ? -1 : 0;
+            upper[k] = offset > cellSize - margin ? 1 : 0;
+        }
+
+        int64_t cell[3];
+        for (int dx = lower[0]; dx <= upper[0]; dx++) {
+            cell[0] = p.cell[0] + dx;
+            for (int dy = lower[1]; dy <= upper[1]; dy++) {
+                cell[1] = p.cell[1] + dy;
+                for (int dz = lower[2]; dz <= upper[2]; dz++) {
+                    if (dx == 0 && dy == 0 && dz == 0)
+                        continue;
+                    cell[2] = p.cell[2] + dz;
+                    std::vector<CellPoint>::const_iterator it = std::lower_bound(points.begin(), points.end(),
+                        static_cast<const int64_t*>(cell), CellLess());
+                    for (; it != points.end() && isSameCell(it->cell, cell); ++it)
+                        checkPoint(p, *it, mapping, first);
+                }
+            }
+        }
+
+        return first;
+    }
+
+private:
+    static bool isSameCell(const int64_t* c1, const int64_t* c2)
+    {
+        return c1[0] == c2[0] && c1[1] == c2[1] && c1[2] == c2[2];
+    }
+    void checkPoint(const CellPoint& p, const CellPoint& q, const std::vector<unsigned long>* mapping,
+                    unsigned long& first) const
+    {
+        if (q.index < first && isSamePoint(p.point, q.point, tolerance)) {
+            if (!mapping || (*mapping)[q.index] == q.index)
+                first = q.index;
+        }
+    }
+
+    const std::vector<CellPoint>& points;
+    float tolerance;
+    double cellSize;
+};
+
+// Maps each point onto the first earlier point within the tolerance that isn't mapped
+// itself, like MeshBuilder does. The points are given by their first occurrence, i.e.
+// mapping[index] == index for each of them.
+void mergeNearPoints(std::vector<CellPoint>& points, float tolerance, double cellSize, std::vector<unsigned long>& mapping)
+{
+    sortParallel(points);
+
+    std::size_t count = points.size();
+    int threads = std::max(1, QThread::idealThreadCount());
+    if (count < 100000)
+        threads = 1;
+
+    // the threads write the results of different points
+    NearPointSearch search(points, tolerance, cellSize);
+    std::vector<unsigned long> firstNear(mapping.size(), ULONG_MAX);
+    QList< QFuture<void> > futures;
+    for (int i = 1; i < threads; i++) {
+        std::size_t begin = (count * i) / threads;
+        std::size_t end = (count * (i + 1)) / threads;
+        futures << QtConcurrent::run(&search, &NearPointSearch::find, begin, end, &firstNear);
+    }
+    try {
+        search.find(0, count / threads, &firstNear);
+        for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+            it->waitForFinished();
+    }
+    catch (...) {
+        // the other threads still use the points
+        for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it) {
+            try {
+                it->waitForFinished();
+            }
+            catch (...) {
+            }
+        }
+        throw;
+    }
+
+    // In the order of occurrence, so the earlier points are already mapped. If the first
+    // near point is merged itself, the other near points are searched.
+    std::vector<unsigned long> position;
+    for (unsigned long i = 0; i < firstNear.size(); i++) {
+        unsigned long first = firstNear[i];
+        if (first == ULONG_MAX)
+            continue;
+        if (mapping[first] == first) {
+            mapping[i] = first;
+            continue;
+        }
+        if (position.empty()) {
+            position.resize(mapping.size());
+            for (std::size_t j = 0; j < count; j++)
+                position[points[j].index] = j;
+        }
+        mapping[i] = search.firstNearPoint(position[i], &mapping);
+    }
+}
+}
+
+Base::Vector3f MeshFastBuilder::Vertex::GetPoint() const
+{
+    Base::Vector3f pt;
+    std::memcpy(&pt.x, &key[0], sizeof(float));
+    std::memcpy(&pt.y, &key[1], sizeof(float));
+    std::memcpy(&pt.z, &key[2], sizeof(float));
+    return pt;
+}
+
+bool MeshFastBuilder::Vertex::operator < (const Vertex& v) const
+{
+    if (key[0] != v.key[0])
+        return key[0] < v.key[0];
+    if (key[1] != v.key[1])
+        return key[1] < v.key[1];
+    if (key[2] != v.key[2])
+        return key[2] < v.key[2];
+    // keep equal points in the order of their occurrence
+    return index < v.index;
+}
+
+bool MeshFastBuilder::Vertex::operator == (const Vertex& v) const
+{
+    return key[0] == v.key[0] && key[1] == v.key[1] && key[2] == v.key[2];
+}
+
+MeshFastBuilder::MeshFastBuilder(MeshKernel& rclM) : _meshKernel(rclM)
+{
+}
+
+MeshFastBuilder::~MeshFastBuilder(void)
+{
+}
+
+void MeshFastBuilder::Initialize (unsigned long ctFacets)
+{
+    _meshKernel.Clear();
+    _vertices.resize(3 * ctFacets);
+}
+
+void MeshFastBuilder::SetFacet (unsigned long index, const Base::Vector3f* facetPoints)
+{
+    // adjust circulation direction
+    int order[3] = {0, 1, 2};
+    if ((((facetPoints[1] - facetPoints[0]) % (facetPoints[2] - facetPoints[0])) * facetPoints[3]) < 0.0f)
+        std::swap(order[1], order[2]);
+
+    for (int i = 0; i < 3; i++) {
+        Vertex& v = _vertices[3 * index + i];
+        const Base::Vector3f& pt = facetPoints[order[i]];
+        std::memcpy(&v.key[0], &pt.x, sizeof(float));
+        std::memcpy(&v.key[1], &pt.y, sizeof(float));
+        std::memcpy(&v.key[2], &pt.z, sizeof(float));
+        // -0.0 and 0.0 are the same coordinate
+        for (int j = 0; j < 3; j++) {
+            if (v.key[j] == 0x80000000)
+                v.key[j] = 0;
+        }
+        v.index = 3 * index + i;
+    }
+}
+
+bool MeshFastBuilder::CheckCoordinates (float fTolerance) const
+{
+    // the cell indices must fit into 64 bit integers
+    double limit = FLT_MAX;
+    if (fTolerance > 0.0f)
+        limit = std::min<double>(limit, fTolerance * 1.0e18);
+    for (std::vector<Vertex>::const_iterator it = _vertices.begin(); it != _vertices.end(); ++it) {
+        Base::Vector3f pt = it->GetPoint();
+        for (int i = 0; i < 3; i++) {
+            double coord = pt[i];
+            if (!(std::fabs(coord) <= limit))
+                return false; // also for NaN and infinity
+        }
+    }
+
+    return true;
+}
+
+void MeshFastBuilder::FinishWithBuilder ()
+{
+    unsigned long ctFacets = _vertices.size() / 3;
+    MeshBuilder builder(_meshKernel);
+    builder.Initialize(ctFacets);
+    for (unsigned long i = 0; i < ctFacets; i++) {
+        Base::Vector3f facetPoints[4];
+        for (int j = 0; j < 3; j++)
+            facetPoints[j] = _vertices[3*i+j].GetPoint();
+        // the circulation direction is already adjusted, so pass a normal that keeps it
+        facetPoints[3] = (facetPoints[1] - facetPoints[0]) % (facetPoints[2] - facetPoints[0]);
+        builder.AddFacet(facetPoints);
+    }
+    { std::vector<Vertex>().swap(_vertices); }
+    builder.Finish();
+}
+
+void MeshFastBuilder::Finish (void)
+{
+    unsigned long ctVertices = _vertices.size();
+    unsigned long ctFacets = ctVertices / 3;
+    if (ctVertices == 0)
+        return;
+
+    // the tolerance of MeshBuilder
+    float tolerance = MeshDefinitions::_fMinPointDistanceD1;
+    if (!CheckCoordinates(tolerance)) {
+        FinishWithBuilder();
+        return;
+    }
+
+    sortParallel(_vertices);
+
+    // map each vertex onto the first occurrence of its coordinates
+    std::vector<unsigned long> mapping(ctVertices);
+    std::vector<CellPoint> cellPoints;
+    // the cells are much larger than the tolerance, so that most points are only
+    // compared with the points of their own cell
+    double cellSize = 64.0 * tolerance;
+    std::vector<Vertex>::iterator it, jt;
+    for (it = _vertices.begin(); it != _vertices.end(); it = jt) {
+        for (jt = it; jt != _vertices.end() && *jt == *it; ++jt)
+            mapping[jt->index] = it->index;
+        if (tolerance > 0.0f) {
+            CellPoint cp;
+            cp.point = it->GetPoint();
+            for (int i = 0; i < 3; i++)
+                cp.cell[i] = static_cast<int64_t>(std::floor(cp.point[i] / cellSize));
+            cp.index = it->index;
+            cellPoints.push_back(cp);
+        }
+    }
+
+    // then map the first occurrences onto earlier points within the tolerance
+    if (!cellPoints.empty()) {
+        mergeNearPoints(cellPoints, tolerance, cellSize, mapping);
+        { std::vector<CellPoint>().swap(cellPoints); }
+        for (unsigned long i = 0; i < ctVertices; i++)
+            mapping[i] = mapping[mapping[i]];
+    }
+
+    // number the points in the order of their first occurrence like MeshBuilder does
+    unsigned long ctPoints = 0;
+    std::vector<bool> isPoint(ctVertices, false);
+    for (unsigned long i = 0; i < ctVertices; i++) {
+        unsigned long first = mapping[i];
+        if (first == i) {
+            isPoint[i] = true;
+            mapping[i] = ctPoints++;
+        }
+        else {
+            mapping[i] = mapping[first];
+        }
+    }
+
+    // the points keep the coordinates of their first occurrence
+    MeshPointArray points(ctPoints);
+    for (it = _vertices.begin(); it != _vertices.end(); it = jt) {
+        if (isPoint[it->index])
+            points[mapping[it->index]] = it->GetPoint();
+        for (jt = it; jt != _vertices.end() && *jt == *it; ++jt);
+    }
+    { std::vector<Vertex>().swap(_vertices); }
+
+    // skip degenerated facets
+    MeshFacetArray facets;
+    facets.reserve(ctFacets);
+    std::vector<unsigned long> usage(ctPoints, 0);
+    for (unsigned long i = 0; i < ctFacets; i++) {
+        MeshFacet mf;
+        mf._aulPoints[0] = mapping[3*i];
+        mf._aulPoints[1] = mapping[3*i+1];
+        mf._aulPoints[2] = mapping[3*i+2];
+        if ((mf._aulPoints[0] == mf._aulPoints[1]) || (mf._aulPoints[0] == mf._aulPoints[2]) || (mf._aulPoints[1] == mf._aulPoints[2]))
+            continue;
+        for (int j = 0; j < 3; j++)
+            usage[mf._aulPoints[j]]++;
+        facets.push_back(mf);
+    }
+
+    // remove points that are only used by degenerated facets
+    unsigned long ctValid = ctPoints - std::count(usage.begin(), usage.end(), 0);
+    if (ctValid < ctPoints) {
+        MeshPointArray validPoints(ctValid);
+        unsigned long index = 0;
+        for (unsigned long i = 0; i < ctPoints; i++) {
+            if (usage[i] > 0) {
+                validPoints[index] = points[i];
+                usage[i] = index++;
+            }
+        }
+        for (MeshFacetArray::_TIterator kt = facets.begin(); kt != facets.end(); ++kt) {
+            for (int j = 0; j < 3; j++)
+                kt->_aulPoints[j] = usage[kt->_aulPoints[j]];
+        }
+        points.swap(validPoints);
+    }
+
+    _meshKernel.Adopt(points, facets, true);
+}
@@ -25,6 +25,7 @@
 
 #include <set>
 #include <vector>
+#include <stdint.h>
 
 #include "MeshKernel.h"
 #include <Base/Vector3D.h>
@@ -164,6 +165,66 @@ private:
     float _fSaveTolerance;
 };
 
+/**
+ * Class for creating the mesh structure of a large facet soup, e.g. a binary STL file.
+ * In contrast to MeshBuilder the facets are stored at a given position and thus can be
+ * set from several threads at the same time. Finish() welds the vertices by a parallel
+ * sort of their coordinates. Then the points are sorted into cells, and each point is
+ * compared with the points of its cell and, if it lies near the border, of the
+ * neighbouring cells.
+ * The result is the same as of MeshBuilder: same point and facet order, same circulation
+ * direction, and degenerated facets and unreferenced points are removed. A point is merged
+ * into the first earlier point within the tolerance (see MeshPoint::operator<) that wasn't
+ * merged itself. MeshBuilder searches a std::set with this tolerant comparison, which isn't
+ * a strict ordering, so in rare cases it misses such a point and keeps a duplicate.
+ * \code
+ * MeshFastBuilder builder(someMeshReference);
+ * builder.Initialize(numberOfFacets);
+ * ...
+ * // can be called concurrently for different indices
+ * builder.SetFacet(index, facetPoints);
+ * ...
+ * builder.Finish();
+ * \endcode
+ */
+class MeshExport MeshFastBuilder
+{
+public:
+    MeshFastBuilder(MeshKernel& rclM);
+    ~MeshFastBuilder(void);
+
+    /** Initializes the class and clears the mesh kernel.
+     * @param ctFacets count of facets.
+     */
+    void Initialize (unsigned long ctFacets);
+    /** Sets the facet with the given index.
+     * @param index facet index in the range of [0, ctFacets)
+     * @param facetPoints Array of vectors (size 4) in order of vec1, vec2,
+     *                    vec3, normal
+     */
+    void SetFacet (unsigned long index, const Base::Vector3f* facetPoints);
+    /** Welds the vertices, removes degenerated facets and sets up the mesh kernel. */
+    void Finish (void);
+
+private:
+    struct Vertex
+    {
+        uint32_t key[3];
+        unsigned long index;
+        Base::Vector3f GetPoint() const;
+        bool operator < (const Vertex&) const;
+        bool operator == (const Vertex&) const;
+    };
+
+    /** Returns false if a coordinate is not finite or too large for a cell index. */
+    bool CheckCoordinates (float fTolerance) const;
+    /** Builds the mesh with MeshBuilder, e.g. for coordinates that cannot be sorted into cells. */
+    void FinishWithBuilder ();
+
+    MeshKernel& _meshKernel;
+    std::vector<Vertex> _vertices;
+};
+
 } // namespace MeshCore
 
 #endif 
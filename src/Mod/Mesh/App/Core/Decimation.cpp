@@ -0,0 +1,354 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
+# include <functional>
+# include <iterator>
+# include <queue>
+#endif
+
+#include "Decimation.h"
+#include "MeshKernel.h"
+#include "Elements.h"
+#include "TopoAlgorithm.h"
+
+#include <QAtomicInt>
+
+
+using namespace MeshCore;
+
+/**
+ * The sum of the squared distances to a set of planes, stored as symmetric 4x4 matrix.
+ */
+struct MeshSimplify::Quadric
+{
+    double a[10];
+
+    Quadric()
+    {
+        std::fill(a, a+10, 0.0);
+    }
+    void AddPlane(double x, double y, double z, double d)
+    {
+        a[0] += x*x; a[1] += x*y; a[2] += x*z; a[3] += x*d;
+        a[4] += y*y; a[5] += y*z; a[6] += y*d;
+        a[7] += z*z; a[8] += z*d;
+        a[9] += d*d;
+    }
+    Quadric& operator += (const Quadric& q)
+    {
+        for (int i=0; i<10; i++)
+            a[i] += q.a[i];
+        return *this;
+    }
+    double Evaluate(double x, double y, double z) const
+    {
+        return a[0]*x*x + 2.0*a[1]*x*y + 2.0*a[2]*x*z + 2.0*a[3]*x
+                        +     a[4]*y*y + 2.0*a[5]*y*z + 2.0*a[6]*y
+                                       +     a[7]*z*z + 2.0*a[8]*z
+                                                      +     a[9];
+    }
+    /** Computes the point with the smallest error. Returns false if it is not unique. */
+    bool Minimize(double& x, double& y, double& z) const
+    {
+        double det = a[0]*(a[4]*a[7]-a[5]*a[5])
+                   - a[1]*(a[1]*a[7]-a[5]*a[2])
+                   + a[2]*(a[1]*a[5]-a[4]*a[2]);
+        double trace = a[0] + a[4] + a[7];
+        if (std::fabs(det) <= 1e-6 * trace * trace * trace)
+            return false;
+
+        // Cramer's rule for A*x = -b
+        double b0 = -a[3], b1 = -a[6], b2 = -a[8];
+        x = (b0*(a[4]*a[7]-a[5]*a[5]) - a[1]*(b1*a[7]-a[5]*b2) + a[2]*(b1*a[5]-a[4]*b2)) / det;
+        y = (a[0]*(b1*a[7]-b2*a[5]) - b0*(a[1]*a[7]-a[5]*a[2]) + a[2]*(a[1]*b2-b1*a[2])) / det;
+        z = (a[0]*(a[4]*b2-a[5]*b1) - a[1]*(a[1]*b2-b1*a[2]) + b0*(a[1]*a[5]-a[4]*a[2])) / det;
+        return true;
+    }
+};
+
+namespace {
+
+/** An edge that is collapsed by removing \a ulPoint0 and keeping \a ulPoint1. */
+struct EdgeCollapseCost
+{
+    double fCost;
+    unsigned long ulFacet;
+    unsigned short usSide;
+    unsigned long ulPoint0, ulPoint1;
+    unsigned long ulStamp0, ulStamp1;
+
+    bool operator > (const EdgeCollapseCost& c) const
+    {
+        return fCost > c.fCost;
+    }
+};
+
+typedef std::priority_queue<EdgeCollapseCost, std::vector<EdgeCollapseCost>,
+                            std::greater<EdgeCollapseCost> > CollapseQueue;
+
+template <class Q>
+double CollapseCost(const Q& q, const Base::Vector3f& p0, const Base::Vector3f& p1, Base::Vector3f& pos)
+{
+    double x, y, z;
+    if (q.Minimize(x, y, z)) {
+        // a far away minimum usually is a numerical problem
+        Base::Vector3f v((float)x, (float)y, (float)z);
+        if (Base::DistanceP2(v, (p0+p1)*0.5f) <= Base::DistanceP2(p0, p1)) {
+            pos = v;
+            return q.Evaluate(x, y, z);
+        }
+    }
+
+    // choose the best of the end and the middle point
+    Base::Vector3f cand[3] = {p0, p1, (p0+p1)*0.5f};
+    double fMin = -1.0;
+    for (int i=0; i<3; i++) {
+        double fCost = q.Evaluate(cand[i].x, cand[i].y, cand[i].z);
+        if (fMin < 0.0 || fCost < fMin) {
+            fMin = fCost;
+            pos = cand[i];
+        }
+    }
+    return fMin;
+}
+
+}
+
+MeshSimplify::MeshSimplify(MeshKernel& rclM)
+  : _rclMesh(rclM), _fMaxError(0.0f)
+{
+}
+
+MeshSimplify::~MeshSimplify()
+{
+}
+
+bool MeshSimplify::FacetsAroundPoint(unsigned long ulFacet, unsigned long ulPoint,
+                                     std::vector<unsigned long>& raulFacets) const
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    bool bClosed = true;
+    raulFacets.clear();
+    raulFacets.push_back(ulFacet);
+
+    for (std::size_t i = 0; i < raulFacets.size(); i++) {
+        const MeshFacet& rFace = rFacets[raulFacets[i]];
+        for (int j=0; j<3; j++) {
+            if (rFace._aulPoints[j] == ulPoint) {
+                // the two edges at the point
+                unsigned long ulN[2] = {rFace._aulNeighbours[j], rFace._aulNeighbours[(j+2)%3]};
+                for (int k=0; k<2; k++) {
+                    if (ulN[k] == ULONG_MAX)
+                        bClosed = false;
+                    else if (std::find(raulFacets.begin(), raulFacets.end(), ulN[k]) == raulFacets.end())
+                        raulFacets.push_back(ulN[k]);
+                }
+                break;
+            }
+        }
+    }
+
+    return bClosed;
+}
+
+void MeshSimplify::Simplify(unsigned long ulTargetSize, QAtomicInt* pclCancel)
+{
+    const MeshPointArray& rPoints = _rclMesh.GetPoints();
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    unsigned long ulCtFacets = rFacets.size();
+    if (ulCtFacets <= ulTargetSize)
+        return;
+
+    // the quadric of a point is built of the planes of its adjacent facets
+    std::vector<Quadric> aQuadrics(rPoints.size());
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+        const MeshPoint& p0 = rPoints[it->_aulPoints[0]];
+        const MeshPoint& p1 = rPoints[it->_aulPoints[1]];
+        const MeshPoint& p2 = rPoints[it->_aulPoints[2]];
+        Base::Vector3f n = (p1 - p0) % (p2 - p0);
+        float fLength = n.Length();
+        if (fLength <= 0.0f)
+            continue;
+        n /= fLength;
+
+        Quadric q;
+        q.AddPlane(n.x, n.y, n.z, -(n * p0));
+        for (int i=0; i<3; i++)
+            aQuadrics[it->_aulPoints[i]] += q;
+    }
+
+    // the stamp of a point is increased when it is moved
+    std::vector<unsigned long> aulStamps(rPoints.size(), 0);
+    CollapseQueue clQueue;
+    EdgeCollapseCost clCand;
+    Base::Vector3f clPos;
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+        unsigned long ulFacet = it - rFacets.begin();
+        for (unsigned short i=0; i<3; i++) {
+            if (it->_aulNeighbours[i] != ULONG_MAX && it->_aulNeighbours[i] > ulFacet) {
+                clCand.ulFacet = ulFacet;
+                clCand.usSide = i;
+                clCand.ulPoint0 = it->_aulPoints[i];
+                clCand.ulPoint1 = it->_aulPoints[(i+1)%3];
+                clCand.ulStamp0 = 0;
+                clCand.ulStamp1 = 0;
+                Quadric q = aQuadrics[clCand.ulPoint0];
+                q += aQuadrics[clCand.ulPoint1];
+                clCand.fCost = CollapseCost(q, rPoints[clCand.ulPoint0], rPoints[clCand.ulPoint1], clPos);
+                clQueue.push(clCand);
+            }
+        }
+    }
+
+    MeshTopoAlgorithm clTopAlg(_rclMesh);
+    std::vector<unsigned long> aulRing0, aulRing1, aulOpposite;
+    std::vector<unsigned long> aulPoints0, aulPoints1, aulCommon;
+    while (ulCtFacets > ulTargetSize && !clQueue.empty()) {
+        if (pclCancel && pclCancel->fetchAndAddOrdered(0) != 0)
+            break;
+        EdgeCollapseCost clEdge = clQueue.top();
+        clQueue.pop();
+
+        // skip entries of edges that have changed since
+        const MeshFacet& rFace = rFacets[clEdge.ulFacet];
+        if (!rFace.IsValid())
+            continue;
+        unsigned long ulNeighbour = rFace._aulNeighbours[clEdge.usSide];
+        unsigned long p0 = rFace._aulPoints[clEdge.usSide];
+        unsigned long p1 = rFace._aulPoints[(clEdge.usSide+1)%3];
+        if (ulNeighbour == ULONG_MAX || p0 != clEdge.ulPoint0 || p1 != clEdge.ulPoint1 ||
+            aulStamps[p0] != clEdge.ulStamp0 || aulStamps[p1] != clEdge.ulStamp1)
+            continue;
+
+        // points at the boundary are kept
+        if (!FacetsAroundPoint(clEdge.ulFacet, p0, aulRing0) ||
+            !FacetsAroundPoint(clEdge.ulFacet, p1, aulRing1))
+            continue;
+
+        // the only common neighbours of both points must be the opposite points of the
+        // two facets, otherwise the mesh becomes non-manifold
+        const MeshFacet& rNeighbour = rFacets[ulNeighbour];
+        unsigned long ulOpp0 = rFace._aulPoints[(clEdge.usSide+2)%3];
+        unsigned long ulOpp1 = rNeighbour._aulPoints[(rNeighbour.Side(rFace)+2)%3];
+        if (ulOpp0 == ulOpp1)
+            continue;
+
+        aulPoints0.clear();
+        for (std::vector<unsigned long>::iterator it = aulRing0.begin(); it != aulRing0.end(); ++it)
+            aulPoints0.insert(aulPoints0.end(), rFacets[*it]._aulPoints, rFacets[*it]._aulPoints+3);
+        std::sort(aulPoints0.begin(), aulPoints0.end());
+        aulPoints0.erase(std::unique(aulPoints0.begin(), aulPoints0.end()), aulPoints0.end());
+        aulPoints1.clear();
+        for (std::vector<unsigned long>::iterator it = aulRing1.begin(); it != aulRing1.end(); ++it)
+            aulPoints1.insert(aulPoints1.end(), rFacets[*it]._aulPoints, rFacets[*it]._aulPoints+3);
+        std::sort(aulPoints1.begin(), aulPoints1.end());
+        aulPoints1.erase(std::unique(aulPoints1.begin(), aulPoints1.end()), aulPoints1.end());
+        aulCommon.clear();
+        std::set_intersection(aulPoints0.begin(), aulPoints0.end(), aulPoints1.begin(), aulPoints1.end(),
+                              std::back_inserter(aulCommon));
+        // the common points are p0, p1 and the two opposite points
+        if (aulCommon.size() != 4)
+            continue;
+
+        // an opposite point with three facets would be left with two identical facets
+        if (FacetsAroundPoint(clEdge.ulFacet, ulOpp0, aulOpposite) && aulOpposite.size() <= 3)
+            continue;
+        if (FacetsAroundPoint(ulNeighbour, ulOpp1, aulOpposite) && aulOpposite.size() <= 3)
+            continue;
+
+        Quadric q = aQuadrics[p0];
+        q += aQuadrics[p1];
+        double fCost = CollapseCost(q, rPoints[p0], rPoints[p1], clPos);
+
+        // the facets around the collapsed edge must not flip
+        bool bFlip = false;
+        std::vector<unsigned long>* aulRings[2] = {&aulRing0, &aulRing1};
+        for (int r=0; r<2 && !bFlip; r++) {
+            for (std::vector<unsigned long>::iterator it = aulRings[r]->begin(); it != aulRings[r]->end(); ++it) {
+                if (*it == clEdge.ulFacet || *it == ulNeighbour)
+                    continue;
+                const MeshFacet& rF = rFacets[*it];
+                Base::Vector3f v[3];
+                for (int i=0; i<3; i++)
+                    v[i] = rPoints[rF._aulPoints[i]];
+                Base::Vector3f clOld = (v[1] - v[0]) % (v[2] - v[0]);
+                for (int i=0; i<3; i++) {
+                    if (rF._aulPoints[i] == p0 || rF._aulPoints[i] == p1)
+                        v[i] = clPos;
+                }
+                Base::Vector3f clNew = (v[1] - v[0]) % (v[2] - v[0]);
+                if (clOld * clNew <= 0.2f * clOld.Length() * clNew.Length()) {
+                    bFlip = true;
+                    break;
+                }
+            }
+        }
+        if (bFlip)
+            continue;
+
+        if (!clTopAlg.CollapseEdge(clEdge.ulFacet, ulNeighbour))
+            continue;
+
+        _rclMesh.SetPoint(p1, clPos);
+        aQuadrics[p1] = q;
+        aulStamps[p1]++;
+        ulCtFacets -= 2;
+        _fMaxError = std::max<float>(_fMaxError, (float)std::sqrt(std::max<double>(fCost, 0.0)));
+
+        // the edges at the remaining point have new costs
+        for (int r=0; r<2; r++) {
+            for (std::vector<unsigned long>::iterator it = aulRings[r]->begin(); it != aulRings[r]->end(); ++it) {
+                const MeshFacet& rF = rFacets[*it];
+                if (!rF.IsValid())
+                    continue;
+                for (unsigned short i=0; i<3; i++) {
+                    // both facets of an edge are in the rings, add it only once
+                    if (rF._aulNeighbours[i] == ULONG_MAX || rF._aulNeighbours[i] < *it)
+                        continue;
+                    unsigned long ulP0 = rF._aulPoints[i];
+                    unsigned long ulP1 = rF._aulPoints[(i+1)%3];
+                    if (ulP0 != p1 && ulP1 != p1)
+                        continue;
+                    clCand.ulFacet = *it;
+                    clCand.usSide = i;
+                    clCand.ulPoint0 = ulP0;
+                    clCand.ulPoint1 = ulP1;
+                    clCand.ulStamp0 = aulStamps[ulP0];
+                    clCand.ulStamp1 = aulStamps[ulP1];
+                    Quadric qe = aQuadrics[ulP0];
+                    qe += aQuadrics[ulP1];
+                    clCand.fCost = CollapseCost(qe, rPoints[ulP0], rPoints[ulP1], clPos);
+                    clQueue.push(clCand);
+                }
+            }
+        }
+    }
+
+    clTopAlg.Cleanup();
+    _rclMesh.RecalcBoundBox();
+}
@@ -0,0 +1,76 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_DECIMATION_H
+#define MESH_DECIMATION_H
+
+#include <vector>
+
+class QAtomicInt;
+
+namespace MeshCore
+{
+class MeshKernel;
+
+/**
+ * The MeshSimplify class reduces the number of facets of a mesh by collapsing edges
+ * with MeshTopoAlgorithm::CollapseEdge(). The edges are collapsed in the order of
+ * the quadric error metric of Garland and Heckbert and the remaining point is moved
+ * to the position with the smallest error.
+ *
+ * Edges at the mesh boundary are kept and an edge is not collapsed if this would
+ * make the mesh non-manifold or flip the orientation of a facet.
+ */
+class MeshExport MeshSimplify
+{
+public:
+    MeshSimplify(MeshKernel&);
+    ~MeshSimplify();
+
+    /**
+     * Collapses edges until the mesh has not more than \a ulTargetSize facets or no
+     * further edge can be collapsed. If \a pclCancel is given the decimation stops
+     * as soon as another thread sets it to a non-zero value. The mesh is valid but
+     * only partly decimated then.
+     */
+    void Simplify(unsigned long ulTargetSize, QAtomicInt* pclCancel = 0);
+    /**
+     * Returns the highest error of a collapsed edge. It estimates the largest
+     * distance of the simplified surface to the original surface.
+     */
+    float GetMaxError() const
+    { return _fMaxError; }
+
+private:
+    struct Quadric;
+    bool FacetsAroundPoint(unsigned long ulFacet, unsigned long ulPoint,
+                           std::vector<unsigned long>& raulFacets) const;
+
+private:
+    MeshKernel& _rclMesh;
+    float _fMaxError;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_DECIMATION_H
@@ -43,6 +43,12 @@
 
 #include <Base/Sequencer.h>
 
+#include <QAtomicInt>
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
 using namespace MeshCore;
 
 
@@ -590,44 +596,124 @@ bool MeshFixSingleFacet::Fixup ()
 
 // ----------------------------------------------------------------
 
-bool MeshEvalSelfIntersection::Evaluate ()
+namespace MeshCore {
+/**
+ * The MeshSelfIntersectionTest class tests the facet pairs of all grid cells for
+ * intersections. A pair of facets lying in several common cells is only tested in
+ * the first of them. So, each pair is tested once and the cells can be processed
+ * by several threads.
+ */
+class MeshSelfIntersectionTest
 {
-    // Contains bounding boxes for every facet 
-    std::vector<Base::BoundBox3f> boxes;
+public:
+    typedef std::vector<std::pair<unsigned long, unsigned long> > PairList;
 
-    // Splits the mesh using grid for speeding up the calculation
-    MeshFacetGrid cMeshFacetGrid(_rclMesh);
-    const MeshFacetArray& rFaces = _rclMesh.GetFacets();
-    MeshGridIterator clGridIter(cMeshFacetGrid);
-    unsigned long ulGridX, ulGridY, ulGridZ;
-    cMeshFacetGrid.GetCtGrids(ulGridX, ulGridY, ulGridZ);
+    MeshSelfIntersectionTest(const MeshKernel& rclMesh, bool bStopAtFirst)
+      : _rclMesh(rclMesh), _clGrid(rclMesh), _bStopAtFirst(bStopAtFirst)
+      , _nextChunk(0), _countDone(0), _found(0), _ulCountReported(0)
+    {
+        _aclBoxes.reserve(rclMesh.CountFacets());
+        MeshFacetIterator cMFI(rclMesh);
+        for (cMFI.Begin(); cMFI.More(); cMFI.Next())
+            _aclBoxes.push_back((*cMFI).GetBoundBox());
+
+        unsigned long ulGridX, ulGridY, ulGridZ;
+        _clGrid.GetCtGrids(ulGridX, ulGridY, ulGridZ);
+        _ulCountCells = ulGridX * ulGridY * ulGridZ;
+        _aclResults.resize((_ulCountCells + ChunkSize - 1) / ChunkSize);
+    }
+    unsigned long CountCells() const
+    {
+        return _ulCountCells;
+    }
+    /// Tests all cells with \a threads threads, the progress is reported to \a seq
+    void Run(int threads, Base::SequencerLauncher& seq)
+    {
+        if (threads < 2 || _aclResults.size() < 2) {
+            TestChunks(&seq);
+            return;
+        }
 
-    MeshFacetIterator cMFI(_rclMesh);
-    for (cMFI.Begin(); cMFI.More(); cMFI.Next()) {
-        boxes.push_back((*cMFI).GetBoundBox());
+        QList< QFuture<void> > futures;
+        for (int i = 1; i < threads; i++) {
+            Base::SequencerLauncher* progress = 0;
+            futures << QtConcurrent::run(this, &MeshSelfIntersectionTest::TestChunks, progress);
+        }
+
+        try {
+            // the calling thread takes part and reports the progress of all threads
+            TestChunks(&seq);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+                it->waitForFinished();
+            ReportProgress(seq);
+        }
+        catch (...) {
+            // the user has aborted, stop the other threads before the data is destroyed
+            _nextChunk.fetchAndStoreOrdered((int)_aclResults.size());
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it) {
+                try {
+                    it->waitForFinished();
+                }
+                catch (...) {
+                }
+            }
+            throw;
+        }
+    }
+    bool HasIntersections() const
+    {
+        return _found.fetchAndAddOrdered(0) != 0;
+    }
+    /// Appends the intersecting pairs sorted by their facet indices
+    void GetIntersections(PairList& raclPairs) const
+    {
+        PairList aclPairs;
+        for (std::vector<PairList>::const_iterator it = _aclResults.begin(); it != _aclResults.end(); ++it)
+            aclPairs.insert(aclPairs.end(), it->begin(), it->end());
+        std::sort(aclPairs.begin(), aclPairs.end());
+        raclPairs.insert(raclPairs.end(), aclPairs.begin(), aclPairs.end());
     }
 
-    // Calculates the intersections
-    Base::SequencerLauncher seq("Checking for self-intersections...", ulGridX*ulGridY*ulGridZ);
-    for (clGridIter.Init(); clGridIter.More(); clGridIter.Next()) {
-        //Get the facet indices, belonging to the current grid unit
+private:
+    void TestChunks(Base::SequencerLauncher* seq)
+    {
         std::vector<unsigned long> aulGridElements;
-        clGridIter.GetElements(aulGridElements);
+        for (;;) {
+            unsigned long ulChunk = (unsigned long)_nextChunk.fetchAndAddOrdered(1);
+            if (ulChunk >= _aclResults.size())
+                break;
+            unsigned long ulBegin = ulChunk * ChunkSize;
+            unsigned long ulEnd = std::min<unsigned long>(ulBegin + ChunkSize, _ulCountCells);
+            for (unsigned long ulCell = ulBegin; ulCell < ulEnd; ulCell++) {
+                if (_bStopAtFirst && HasIntersections())
+                    break;
+                TestCell(ulCell, aulGridElements, _aclResults[ulChunk]);
+            }
 
-        seq.next();
-        if (aulGridElements.size()==0)
-            continue;
+            _countDone.fetchAndAddOrdered((int)(ulEnd - ulBegin));
+            if (seq)
+                ReportProgress(*seq);
+        }
+    }
+    void TestCell(unsigned long ulCell, std::vector<unsigned long>& aulGridElements, PairList& raclPairs)
+    {
+        unsigned long ulX, ulY, ulZ;
+        _clGrid.GetPositionToIndex(ulCell, ulX, ulY, ulZ);
+        aulGridElements.clear();
+        _clGrid.GetElements(ulX, ulY, ulZ, aulGridElements);
 
+        const MeshFacetArray& rFaces = _rclMesh.GetFacets();
         MeshGeomFacet facet1, facet2;
         Base::Vector3f pt1, pt2;
         for (std::vector<unsigned long>::iterator it = aulGridElements.begin(); it != aulGridElements.end(); ++it) {
-            const Base::BoundBox3f& box1 = boxes[*it];
-            cMFI.Set(*it);
-            facet1 = *cMFI;
+            const Base::BoundBox3f& box1 = _aclBoxes[*it];
             const MeshFacet& rface1 = rFaces[*it];
-            for (std::vector<unsigned long>::iterator jt = it; jt != aulGridElements.end(); ++jt) {
-                if (jt == it) // the identical facet
+            bool bFacet1 = false;
+            for (std::vector<unsigned long>::iterator jt = it + 1; jt != aulGridElements.end(); ++jt) {
+                const Base::BoundBox3f& box2 = _aclBoxes[*jt];
+                if (!(box1 && box2))
                     continue;
+
                 // If the facets share a common vertex we do not check for self-intersections because they 
                 // could but usually do not intersect each other and the algorithm below would detect false-positives,
                 // otherwise
@@ -645,21 +731,84 @@ bool MeshEvalSelfIntersection::Evaluate ()
                     rface1._aulPoints[2] == rface2._aulPoints[2])
                     continue; // ignore facets sharing a common vertex
 
-                const Base::BoundBox3f& box2 = boxes[*jt];
-                if (box1 && box2) {
-                    cMFI.Set(*jt);
-                    facet2 = *cMFI;
-                    int ret = facet1.IntersectWithFacet(facet2, pt1, pt2);
-                    if (ret == 2) {
-                        // abort after the first detected self-intersection
-                        return false;
+                if (!bFacet1) {
+                    facet1 = _rclMesh.GetFacet(rface1);
+                    bFacet1 = true;
+                }
+                facet2 = _rclMesh.GetFacet(rface2);
+                if (!IsFirstCommonCell(box1, box2, facet1, facet2, ulCell))
+                    continue;
+                int ret = facet1.IntersectWithFacet(facet2, pt1, pt2);
+                if (ret == 2) {
+                    raclPairs.push_back(std::make_pair(std::min<unsigned long>(*it, *jt),
+                                                       std::max<unsigned long>(*it, *jt)));
+                    if (_bStopAtFirst) {
+                        _found.fetchAndStoreOrdered(1);
+                        return;
                     }
                 }
             }
         }
     }
+    /// Checks whether no cell before \a ulCell contains both facets
+    bool IsFirstCommonCell(const Base::BoundBox3f& box1, const Base::BoundBox3f& box2,
+                           const MeshGeomFacet& facet1, const MeshGeomFacet& facet2,
+                           unsigned long ulCell) const
+    {
+        // MeshFacetGrid::AddFacet() adds a facet to the cells of its bounding box it
+        // intersects, so the common cells lie in the intersection of both boxes
+        unsigned long ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
+        _clGrid.Position(Base::Vector3f(std::max<float>(box1.MinX, box2.MinX),
+                                        std::max<float>(box1.MinY, box2.MinY),
+                                        std::max<float>(box1.MinZ, box2.MinZ)), ulX1, ulY1, ulZ1);
+        _clGrid.Position(Base::Vector3f(std::min<float>(box1.MaxX, box2.MaxX),
+                                        std::min<float>(box1.MaxY, box2.MaxY),
+                                        std::min<float>(box1.MaxZ, box2.MaxZ)), ulX2, ulY2, ulZ2);
+        if (ulX1 == ulX2 && ulY1 == ulY2 && ulZ1 == ulZ2)
+            return true;
 
-    return true;
+        for (unsigned long ulX = ulX1; ulX <= ulX2; ulX++) {
+            for (unsigned long ulY = ulY1; ulY <= ulY2; ulY++) {
+                for (unsigned long ulZ = ulZ1; ulZ <= ulZ2; ulZ++) {
+                    if (_clGrid.GetIndexToPosition(ulX, ulY, ulZ) >= ulCell)
+                        continue;
+                    Base::BoundBox3f clCellBox = _clGrid.GetBoundBox(ulX, ulY, ulZ);
+                    if (facet1.IntersectBoundingBox(clCellBox) && facet2.IntersectBoundingBox(clCellBox))
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+    void ReportProgress(Base::SequencerLauncher& seq)
+    {
+        unsigned long ulDone = (unsigned long)_countDone.fetchAndAddOrdered(0);
+        for (; _ulCountReported < ulDone; _ulCountReported++)
+            seq.next(true);
+    }
+
+    static const unsigned long ChunkSize = 64;
+
+    const MeshKernel& _rclMesh;
+    MeshFacetGrid _clGrid;
+    std::vector<Base::BoundBox3f> _aclBoxes;
+    std::vector<PairList> _aclResults;
+    unsigned long _ulCountCells;
+    bool _bStopAtFirst;
+    QAtomicInt _nextChunk;
+    QAtomicInt _countDone;
+    mutable QAtomicInt _found;
+    unsigned long _ulCountReported;
+};
+}
+
+bool MeshEvalSelfIntersection::Evaluate ()
+{
+    MeshSelfIntersectionTest test(_rclMesh, true);
+    Base::SequencerLauncher seq("Checking for self-intersections...", test.CountCells());
+    test.Run(_threads > 0 ? _threads : QThread::idealThreadCount(), seq);
+    return !test.HasIntersections();
 }
 
 void MeshEvalSelfIntersection::GetIntersections(const std::vector<std::pair<unsigned long, unsigned long> >& indices,
@@ -688,72 +837,10 @@ void MeshEvalSelfIntersection::GetIntersections(const std::vector<std::pair<unsi
 
 void MeshEvalSelfIntersection::GetIntersections(std::vector<std::pair<unsigned long, unsigned long> >& intersection) const
 {
-    // Contains bounding boxes for every facet 
-    std::vector<Base::BoundBox3f> boxes;
-    //intersection.clear();
-
-    // Splits the mesh using grid for speeding up the calculation
-    MeshFacetGrid cMeshFacetGrid(_rclMesh);
-    const MeshFacetArray& rFaces = _rclMesh.GetFacets();
-    MeshGridIterator clGridIter(cMeshFacetGrid);
-    unsigned long ulGridX, ulGridY, ulGridZ;
-    cMeshFacetGrid.GetCtGrids(ulGridX, ulGridY, ulGridZ);
-
-    MeshFacetIterator cMFI(_rclMesh);
-    for(cMFI.Begin(); cMFI.More(); cMFI.Next()) {
-        boxes.push_back((*cMFI).GetBoundBox());
-    }
-
-    // Calculates the intersections
-    Base::SequencerLauncher seq("Checking for self-intersections...", ulGridX*ulGridY*ulGridZ);
-    for (clGridIter.Init(); clGridIter.More(); clGridIter.Next()) {
-        //Get the facet indices, belonging to the current grid unit
-        std::vector<unsigned long> aulGridElements;
-        clGridIter.GetElements(aulGridElements);
-
-        seq.next(true);
-        if (aulGridElements.size()==0)
-            continue;
-
-        MeshGeomFacet facet1, facet2;
-        Base::Vector3f pt1, pt2;
-        for (std::vector<unsigned long>::iterator it = aulGridElements.begin(); it != aulGridElements.end(); ++it) {
-            const Base::BoundBox3f& box1 = boxes[*it];
-            cMFI.Set(*it);
-            facet1 = *cMFI;
-            const MeshFacet& rface1 = rFaces[*it];
-            for (std::vector<unsigned long>::iterator jt = it; jt != aulGridElements.end(); ++jt) {
-                if (jt == it) // the identical facet
-                    continue;
-                // If the facets share a common vertex we do not check for self-intersections because they 
-                // could but usually do not intersect each other and the algorithm below would detect false-positives,
-                // otherwise
-                const MeshFacet& rface2 = rFaces[*jt];
-                if (rface1._aulPoints[0] == rface2._aulPoints[0] || 
-                    rface1._aulPoints[0] == rface2._aulPoints[1] ||
-                    rface1._aulPoints[0] == rface2._aulPoints[2])
-                    continue; // ignore facets sharing a common vertex
-                if (rface1._aulPoints[1] == rface2._aulPoints[0] || 
-                    rface1._aulPoints[1] == rface2._aulPoints[1] ||
-                    rface1._aulPoints[1] == rface2._aulPoints[2])
-                    continue; // ignore facets sharing a common vertex
-                if (rface1._aulPoints[2] == rface2._aulPoints[0] || 
-                    rface1._aulPoints[2] == rface2._aulPoints[1] ||
-                    rface1._aulPoints[2] == rface2._aulPoints[2])
-                    continue; // ignore facets sharing a common vertex
-
-                const Base::BoundBox3f& box2 = boxes[*jt];
-                if (box1 && box2) {
-                    cMFI.Set(*jt);
-                    facet2 = *cMFI;
-                    int ret = facet1.IntersectWithFacet(facet2, pt1, pt2);
-                    if (ret == 2) {
-                        intersection.push_back(std::make_pair (*it,*jt));
-                    }
-                }
-            }
-        }
-    }
+    MeshSelfIntersectionTest test(_rclMesh, false);
+    Base::SequencerLauncher seq("Checking for self-intersections...", test.CountCells());
+    test.Run(_threads > 0 ? _threads : QThread::idealThreadCount(), seq);
+    test.GetIntersections(intersection);
 }
 
 std::vector<unsigned long> MeshFixSelfIntersection::GetFacets() const
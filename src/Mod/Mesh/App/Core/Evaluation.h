@@ -288,8 +288,10 @@ protected:
 class MeshExport MeshEvalSelfIntersection : public MeshEvaluation
 {
 public:
-    MeshEvalSelfIntersection (const MeshKernel &rclB) : MeshEvaluation(rclB) {}
+    MeshEvalSelfIntersection (const MeshKernel &rclB) : MeshEvaluation(rclB), _threads(0) {}
     virtual ~MeshEvalSelfIntersection () {}
+    /// Sets the number of threads to use, by default QThread::idealThreadCount() is used
+    void SetThreadCount(int threads) { _threads = threads; }
     /// Evaluate the mesh and return if true if there are self intersections
     bool Evaluate ();
     /// collect all intersection lines
@@ -297,6 +299,9 @@ public:
         std::vector<std::pair<Base::Vector3f, Base::Vector3f> >&) const;
     /// collect the index of all facets with self intersections
     void GetIntersections(std::vector<std::pair<unsigned long, unsigned long> >&) const;
+
+private:
+    int _threads;
 };
 
 /**
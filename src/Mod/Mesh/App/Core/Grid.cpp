@@ -27,6 +27,11 @@
 # include <algorithm>
 #endif
 
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
 #include "Grid.h"
 #include "Iterator.h"
 
@@ -36,6 +41,61 @@
 
 using namespace MeshCore;
 
+void MeshGridCells::Init (unsigned long ulCtCells)
+{
+  Clear();
+  _ulCtCells = ulCtCells;
+  _aulOffsets.resize(ulCtCells + 1, 0);
+}
+
+void MeshGridCells::Clear (void)
+{
+  _ulCtCells = 0;
+  std::vector<unsigned long>().swap(_aulOffsets);
+  std::vector<unsigned long>().swap(_aulIndices);
+  std::vector<Entries>().swap(_aclEntries);
+}
+
+void MeshGridCells::Add (Entries &raclEntries)
+{
+  _aclEntries.push_back(Entries());
+  _aclEntries.back().swap(raclEntries);
+}
+
+void MeshGridCells::Finish (void)
+{
+  std::vector<Entries>::const_iterator it;
+  Entries::const_iterator jt;
+
+  // count the elements of each grid element, the offsets are the running sums
+  std::vector<unsigned long> aulOffsets(_ulCtCells + 1, 0);
+  for (it = _aclEntries.begin(); it != _aclEntries.end(); ++it) {
+    for (jt = it->begin(); jt != it->end(); ++jt)
+      aulOffsets[jt->first + 1]++;
+  }
+  for (unsigned long i = 0; i < _ulCtCells; i++)
+    aulOffsets[i + 1] += aulOffsets[i];
+
+  // move the elements to their place
+  std::vector<unsigned long> aulIndices(aulOffsets.back());
+  std::vector<unsigned long> aulNext(aulOffsets.begin(), aulOffsets.end() - 1);
+  for (it = _aclEntries.begin(); it != _aclEntries.end(); ++it) {
+    for (jt = it->begin(); jt != it->end(); ++jt)
+      aulIndices[aulNext[jt->first]++] = jt->second;
+  }
+
+  _aulOffsets.swap(aulOffsets);
+  _aulIndices.swap(aulIndices);
+  std::vector<Entries>().swap(_aclEntries);
+}
+
+unsigned long MeshGridCells::MemoryUsage (void) const
+{
+  return (_aulOffsets.capacity() + _aulIndices.capacity()) * sizeof(unsigned long);
+}
+
+// ----------------------------------------------------------------
+
 MeshGrid::MeshGrid (const MeshKernel &rclM)
 : _pclMesh(&rclM),
   _ulCtElements(0),
@@ -62,7 +122,7 @@ void MeshGrid::Attach (const MeshKernel &rclM)
 
 void MeshGrid::Clear (void)
 {
-  _aulGrid.clear();
+  _aulGrid.Clear();
   _pclMesh = NULL;  
 }
 
@@ -93,8 +153,6 @@ void MeshGrid::InitGrid (void)
 {
   assert(_pclMesh != NULL);
 
-  unsigned long i, j;
-
   // Grid Laengen berechnen wenn nicht initialisiert
   //
   if ((_ulCtGridsX == 0) || (_ulCtGridsY == 0) || (_ulCtGridsZ == 0))
@@ -128,14 +186,7 @@ void MeshGrid::InitGrid (void)
   }
 
   // Daten-Struktur anlegen
-  _aulGrid.clear();
-  _aulGrid.resize(_ulCtGridsX);
-  for (i = 0; i < _ulCtGridsX; i++)
-  {
-    _aulGrid[i].resize(_ulCtGridsY);
-    for (j = 0; j < _ulCtGridsY; j++)
-      _aulGrid[i][j].resize(_ulCtGridsZ);
-  }
+  _aulGrid.Init(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ);
 }
 
 unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsigned long> &raulElements,
@@ -155,7 +206,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -190,7 +241,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
         if (Base::DistanceP2(GetBoundBox(i, j, k).GetCenter(), rclOrg) < fMinDistP2)
-          raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+          GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -221,7 +272,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::set<unsigned
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(_aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -449,9 +500,9 @@ void MeshGrid::CalculateGridLength (int iCtGridPerAxis)
   }
 }
 
-void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<unsigned long> &raclInd) const
+void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::vector<unsigned long> &raulInd) const
 {
-  raclInd.clear();
+  raulInd.clear();
   Base::BoundBox3f  clBB = GetBoundBox();
 
   if (clBB.IsInBox(rclPt) == true)
@@ -461,9 +512,9 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
     //int nX = ulX, nY = ulY, nZ = ulZ;
     unsigned long ulMaxLevel = std::max<unsigned long>(_ulCtGridsX, std::max<unsigned long>(_ulCtGridsY, _ulCtGridsZ));
     unsigned long ulLevel = 0;
-    while (raclInd.empty() && ulLevel <= ulMaxLevel)
-      GetHull(ulX, ulY, ulZ, ulLevel++, raclInd);
-    GetHull(ulX, ulY, ulZ, ulLevel, raclInd);
+    while (raulInd.empty() && ulLevel <= ulMaxLevel)
+      GetHull(ulX, ulY, ulZ, ulLevel++, raulInd);
+    GetHull(ulX, ulY, ulZ, ulLevel, raulInd);
   }
   else
   { // Punkt ausserhalb
@@ -473,12 +524,12 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
       case Base::BoundBox3f::RIGHT:
       {
         unsigned long nX = 0;
-        while (raclInd.empty() && nX < _ulCtGridsX)
+        while (raulInd.empty() && nX < _ulCtGridsX)
         {
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raulInd);
           }
           nX++;
         }
@@ -487,26 +538,26 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
       case Base::BoundBox3f::LEFT:
       {
         int nX = _ulCtGridsX - 1;
-        while (raclInd.empty() && nX >= 0)
+        while (raulInd.empty() && nX >= 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raulInd);
           }
-          nX++;
+          nX--;
         }
         break;
       }
       case Base::BoundBox3f::TOP:
       {
         unsigned long nY = 0;
-        while (raclInd.empty() && nY < _ulCtGridsY)
+        while (raulInd.empty() && nY < _ulCtGridsY)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raulInd);
           }
           nY++;
         }
@@ -515,12 +566,12 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
       case Base::BoundBox3f::BOTTOM:
       {
         int nY = _ulCtGridsY - 1;
-        while (raclInd.empty() && nY >= 0)
+        while (raulInd.empty() && nY >= 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raulInd);
           }
           nY--;
         }
@@ -529,12 +580,12 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
       case Base::BoundBox3f::BACK:
       {
         unsigned long nZ = 0;
-        while (raclInd.empty() && nZ < _ulCtGridsZ)
+        while (raulInd.empty() && nZ < _ulCtGridsZ)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raulInd);
           }
           nZ++;
         }
@@ -543,12 +594,12 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
       case Base::BoundBox3f::FRONT:
       {
         int nZ = _ulCtGridsZ - 1;
-        while (raclInd.empty() && nZ >= 0)
+        while (raulInd.empty() && nZ >= 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raulInd);
           }
           nZ--;
         }
@@ -559,6 +610,18 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
         break;
     }
   }
+
+  // elements lying in several grids are listed several times
+  std::sort(raulInd.begin(), raulInd.end());
+  raulInd.erase(std::unique(raulInd.begin(), raulInd.end()), raulInd.end());
+}
+
+void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<unsigned long> &raclInd) const
+{
+  std::vector<unsigned long> aulInd;
+  SearchNearestFromPoint(rclPt, aulInd);
+  raclInd.clear();
+  raclInd.insert(aulInd.begin(), aulInd.end());
 }
 
 void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
@@ -611,17 +674,70 @@ void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ,
   }
 }
 
-unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
-                                     std::set<unsigned long> &raclInd) const
+void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
+                        unsigned long ulDistance, std::vector<unsigned long> &raulInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  if (rclSet.size() > 0)
+  int nX1 = std::max<int>(0, int(ulX) - int(ulDistance));
+  int nY1 = std::max<int>(0, int(ulY) - int(ulDistance));
+  int nZ1 = std::max<int>(0, int(ulZ) - int(ulDistance));
+  int nX2 = std::min<int>(int(_ulCtGridsX) - 1, int(ulX) + int(ulDistance));
+  int nY2 = std::min<int>(int(_ulCtGridsY) - 1, int(ulY) + int(ulDistance));
+  int nZ2 = std::min<int>(int(_ulCtGridsZ) - 1, int(ulZ) + int(ulDistance));
+
+  int i, j;
+
+  // top plane
+  for (i = nX1; i <= nX2; i++)
   {
-    raclInd.insert(rclSet.begin(), rclSet.end());
-    return rclSet.size();
+    for (j = nY1; j <= nY2; j++)
+      GetElements(i, j, nZ1, raulInd);
+  }
+  // bottom plane
+  for (i = nX1; i <= nX2; i++)
+  {
+    for (j = nY1; j <= nY2; j++)
+      GetElements(i, j, nZ2, raulInd);
+  }
+  // left plane
+  for (i = nY1; i <= nY2; i++)
+  {
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(nX1, i, j, raulInd);
+  }
+  // right plane
+  for (i = nY1; i <= nY2; i++)
+  {
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(nX2, i, j, raulInd);
+  }
+  // front plane
+  for (i = (nX1+1); i <= (nX2-1); i++)
+  {
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(i, nY1, j, raulInd);
+  }
+  // back plane
+  for (i = (nX1+1); i <= (nX2-1); i++)
+  {
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(i, nY2, j, raulInd);
   }
+}
 
-  return 0;
+unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
+                                     std::set<unsigned long> &raclInd) const
+{
+  unsigned long ulCell = CellIndex(ulX, ulY, ulZ);
+  raclInd.insert(_aulGrid.Begin(ulCell), _aulGrid.End(ulCell));
+  return _aulGrid.Size(ulCell);
+}
+
+unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
+                                     std::vector<unsigned long> &raulInd) const
+{
+  unsigned long ulCell = CellIndex(ulX, ulY, ulZ);
+  raulInd.insert(raulInd.end(), _aulGrid.Begin(ulCell), _aulGrid.End(ulCell));
+  return _aulGrid.Size(ulCell);
 }
 
 unsigned long MeshGrid::GetElements(const Base::Vector3f &rclPoint, std::vector<unsigned long>& aulFacets) const
@@ -630,9 +746,8 @@ unsigned long MeshGrid::GetElements(const Base::Vector3f &rclPoint, std::vector<
   if (!CheckPosition(rclPoint, ulX, ulY, ulZ))
     return 0;
 
-  aulFacets.resize(_aulGrid[ulX][ulY][ulZ].size());
-
-  std::copy(_aulGrid[ulX][ulY][ulZ].begin(), _aulGrid[ulX][ulY][ulZ].end(), aulFacets.begin());
+  unsigned long ulCell = CellIndex(ulX, ulY, ulZ);
+  aulFacets.assign(_aulGrid.Begin(ulCell), _aulGrid.End(ulCell));
   return aulFacets.size();
 }
 
@@ -736,16 +851,39 @@ void MeshFacetGrid::RebuildGrid (void)
 
   InitGrid();
  
-  // Daten-Struktur fuellen
-  MeshFacetIterator clFIter(*_pclMesh);
-
-  unsigned long i = 0;
-  for (clFIter.Init(); clFIter.More(); clFIter.Next())
+  // Daten-Struktur fuellen, for large meshes the facets are split into blocks
+  // handled by several threads. The blocks are added in order so that the facets
+  // of a grid element are sorted.
+  unsigned long ulBlocks = std::min<unsigned long>(QThread::idealThreadCount(), _ulCtElements / 100000 + 1);
+  ulBlocks = std::max<unsigned long>(ulBlocks, 1);
+  std::vector<MeshGridCells::Entries> aclEntries(ulBlocks);
+  if (ulBlocks > 1)
+  {
+    QList< QFuture<void> > futures;
+    for (unsigned long i = 0; i < ulBlocks; i++)
+    {
+      futures << QtConcurrent::run(this, &MeshFacetGrid::AddFacets, i * _ulCtElements / ulBlocks,
+                                   (i + 1) * _ulCtElements / ulBlocks, &aclEntries[i]);
+    }
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+      it->waitForFinished();
+  }
+  else
   {
-//    AddFacet(*clFIter, i++, 2.0f);
-    AddFacet(*clFIter, i++);
+    AddFacets(0, _ulCtElements, &aclEntries[0]);
   }
 
+  for (std::vector<MeshGridCells::Entries>::iterator it = aclEntries.begin(); it != aclEntries.end(); ++it)
+    _aulGrid.Add(*it);
+  _aulGrid.Finish();
+}
+
+void MeshFacetGrid::AddFacets (unsigned long ulBegin, unsigned long ulEnd, MeshGridCells::Entries *paclEntries) const
+{
+  // a facet lies in at least one grid element
+  paclEntries->reserve(ulEnd - ulBegin);
+  for (unsigned long i = ulBegin; i < ulEnd; i++)
+    AddFacet(_pclMesh->GetFacet(i), i, *paclEntries);
 }
 
 unsigned long MeshFacetGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt) const
@@ -946,8 +1084,8 @@ void MeshFacetGrid::SearchNearestFacetInGrid(unsigned long ulX, unsigned long ul
                                              const Base::Vector3f &rclPt, float &rfMinDist,
                                              unsigned long &rulFacetInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  for (std::set<unsigned long>::const_iterator pI = rclSet.begin(); pI != rclSet.end(); ++pI)
+  unsigned long ulCell = CellIndex(ulX, ulY, ulZ);
+  for (MeshGridCells::const_iterator pI = _aulGrid.Begin(ulCell); pI != _aulGrid.End(ulCell); ++pI)
   {
     float fDist = _pclMesh->GetFacet(*pI).DistanceToPoint(rclPt);
     if (fDist < rfMinDist)
@@ -998,7 +1136,7 @@ void MeshPointGrid::AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, f
   unsigned long ulX, ulY, ulZ;
   Pos(Base::Vector3f(rclPt.x, rclPt.y, rclPt.z), ulX, ulY, ulZ);
   if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
-    _aulGrid[ulX][ulY][ulZ].insert(ulPtIndex);
+    _aulGrid.Add(CellIndex(ulX, ulY, ulZ), ulPtIndex);
 }
 
 void MeshPointGrid::Validate (const MeshKernel &rclMesh)
@@ -1057,6 +1195,8 @@ void MeshPointGrid::RebuildGrid (void)
   {
     AddPoint(*cPIter, i++);
   }
+
+  _aulGrid.Finish();
 }
 
 void MeshPointGrid::Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const
@@ -1118,7 +1258,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
   if ((_rclGrid.GetBoundBox().IsInBox(rclPt)) == true)
   {  // Voxel bestimmen, indem der Startpunkt liegt
     _rclGrid.Position(rclPt, _ulX, _ulY, _ulZ);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
     _bValidRay = true;
   }
   else
@@ -1131,7 +1271,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
       else
         _rclGrid.Position(cP1, _ulX, _ulY, _ulZ);
 
-      raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+      _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
       _bValidRay = true;
     }
   }
@@ -1182,7 +1322,7 @@ bool MeshGridIterator::NextOnRay (std::vector<unsigned long> &raulElements)
   if ((_bValidRay == true) && (_rclGrid.CheckPos(_ulX, _ulY, _ulZ) == true))
   {
     GridElement pos(_ulX, _ulY, _ulZ); _cSearchPositions.insert(pos);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end()); 
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements); 
   }
   else
     _bValidRay = false;  // Strahl ausgetreten
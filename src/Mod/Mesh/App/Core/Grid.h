@@ -25,6 +25,7 @@
 #define MESH_GRID_H
 
 #include <set>
+#include <vector>
 
 #include "MeshKernel.h"
 #include <Base/Vector3D.h>
@@ -44,6 +45,63 @@ class MeshGrid;
 //#define MESHGRID_BBOX_EXTENSION 1.0e-3f
 #define MESHGRID_BBOX_EXTENSION 10.0f
 
+/**
+ * The MeshGridCells class stores the element indices of all grid elements in one
+ * contiguous array. A second array keeps for each grid element the offset of its
+ * first index. While the grid is built the pairs of grid element and element index
+ * are collected, Finish() then sorts them into place by a counting sort.
+ *
+ * Compared to a set per grid element this needs only a fraction of the memory and
+ * reading the elements of a grid element doesn't need to walk through tree nodes.
+ */
+class MeshExport MeshGridCells
+{
+public:
+  /// Pairs of grid element and element index
+  typedef std::vector<std::pair<unsigned long, unsigned long> > Entries;
+  typedef std::vector<unsigned long>::const_iterator const_iterator;
+
+  /// Construction
+  MeshGridCells (void) : _ulCtCells(0) { }
+
+  /** Removes all elements and sets the number of grid elements. */
+  void Init (unsigned long ulCtCells);
+  /** Removes all elements and grid elements. */
+  void Clear (void);
+  /** Adds the element \a ulElement to the grid element \a ulCell. It's only accessible after
+   * Finish() has been called. */
+  void Add (unsigned long ulCell, unsigned long ulElement)
+  {
+    if (_aclEntries.empty())
+      _aclEntries.push_back(Entries());
+    _aclEntries.back().push_back(std::make_pair(ulCell, ulElement));
+  }
+  /** Adds a whole block of entries e.g. collected by a worker thread. The content of
+   * \a raclEntries is taken over. */
+  void Add (Entries &raclEntries);
+  /** Sorts all added elements into their grid elements. The elements of a grid element
+   * keep the order in which they were added. */
+  void Finish (void);
+
+  /** Returns an iterator to the first element of the grid element \a ulCell. */
+  const_iterator Begin (unsigned long ulCell) const
+  { return _aulIndices.begin() + _aulOffsets[ulCell]; }
+  /** Returns an iterator past the last element of the grid element \a ulCell. */
+  const_iterator End (unsigned long ulCell) const
+  { return _aulIndices.begin() + _aulOffsets[ulCell + 1]; }
+  /** Returns the number of elements in the grid element \a ulCell. */
+  unsigned long Size (unsigned long ulCell) const
+  { return _aulOffsets[ulCell + 1] - _aulOffsets[ulCell]; }
+  /** Returns the number of bytes used to store the grid elements. */
+  unsigned long MemoryUsage (void) const;
+
+private:
+  unsigned long              _ulCtCells;  /**< Number of grid elements. */
+  std::vector<unsigned long> _aulOffsets; /**< Offsets of the grid elements into _aulIndices. */
+  std::vector<unsigned long> _aulIndices; /**< Element indices sorted by grid element. */
+  std::vector<Entries>       _aclEntries; /**< Collected entries until Finish() is called. */
+};
+
 /**
  * The MeshGrid allows to divide a global mesh object into smaller regions
  * of elements (e.g. facets, points or edges) depending on the resolution
@@ -89,12 +147,16 @@ public:
                                 const Base::Vector3f &rclOrg, float fMaxDist, bool bDelDoubles = true) const;
   /** Searches for the nearest grids that contain elements from a point, the result are grid indices. */
   void SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<unsigned long> &rclInd) const;
+  /** Does the same as the method above but fills a sorted vector without duplicates. */
+  void SearchNearestFromPoint (const Base::Vector3f &rclPt, std::vector<unsigned long> &raulInd) const;
   //@}
 
   /** @name Getters */
   //@{
   /** Returns the indices of the elements in the given grid. */
   unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::set<unsigned long> &raclInd) const;
+  /** Appends the indices of the elements in the given grid to \a raulInd. */
+  unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::vector<unsigned long> &raulInd) const;
   unsigned long GetElements (const Base::Vector3f &rclPoint, std::vector<unsigned long>& aulFacets) const;
   //@}
 
@@ -125,7 +187,10 @@ public:
   bool GetPositionToIndex(unsigned long id, unsigned long& ulX, unsigned long& ulY, unsigned long& ulZ) const;
   /** Returns the number of elements in a given grid. */
   unsigned long GetCtElements(unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
-  { return _aulGrid[ulX][ulY][ulZ].size(); }
+  { return _aulGrid.Size(CellIndex(ulX, ulY, ulZ)); }
+  /** Returns the number of bytes used to store the grid elements. */
+  unsigned long GetMemoryUsage() const
+  { return _aulGrid.MemoryUsage(); }
   /** Validates the grid structure and rebuilds it if needed. Must be implemented in sub-classes. */
   virtual void Validate (const MeshKernel &rclM) = 0;
   /** Verifies the grid structure and returns false if inconsistencies are found. */
@@ -141,8 +206,14 @@ public:
   inline bool CheckPos (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const;
   /** Get the indices of all elements lying in the grids around a given grid with distance \a ulDistance. */
   void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::set<unsigned long> &raclInd) const;
+  /** Does the same as the method above but appends the indices to \a raulInd. An element lying in several grids is
+   * appended several times. */
+  void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::vector<unsigned long> &raulInd) const;
 
 protected:
+  /** Returns the index of a grid element in the internal structure, the position is not checked. */
+  unsigned long CellIndex (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+  { return (ulZ * _ulCtGridsY + ulY) * _ulCtGridsX + ulX; }
   /** Initializes the size of the internal structure. */
   virtual void InitGrid (void);
   /** Deletes the grid structure. */
@@ -157,7 +228,7 @@ protected:
   virtual unsigned long HasElements (void) const = 0;
 
 protected:
-  std::vector<std::vector<std::vector<std::set<unsigned long> > > >  _aulGrid;   /**< Grid data structure. */
+  MeshGridCells     _aulGrid;     /**< Grid data structure. */
   const MeshKernel* _pclMesh;     /**< The mesh kernel. */
   unsigned long     _ulCtElements;/**< Number of grid elements for validation issues. */
   unsigned long     _ulCtGridsX;  /**< Number of grid elements in z. */
@@ -226,8 +297,10 @@ protected:
   inline void PosWithCheck (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
   /** Adds a new facet element to the grid structure. \a rclFacet is the geometric facet and \a ulFacetIndex 
    * the corresponding index in the mesh kernel. The facet is added to each grid element that intersects 
-   * the facet. */
-  inline void AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, float fEpsilon = 0.0f);
+   * the facet. The entries are collected in \a raclEntries. */
+  inline void AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, MeshGridCells::Entries &raclEntries) const;
+  /** Collects the entries of the facets in the range [\a ulBegin, \a ulEnd), can be called from several threads. */
+  void AddFacets (unsigned long ulBegin, unsigned long ulEnd, MeshGridCells::Entries *paclEntries) const;
   /** Returns the number of stored elements. */
   unsigned long HasElements (void) const
   { return _pclMesh->CountFacets(); }
@@ -295,7 +368,7 @@ public:
   /** Returns indices of the elements in the current grid. */
   void GetElements (std::vector<unsigned long> &raulElements) const
   {
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
   }
   /** Returns the number of elements in the current grid. */
   unsigned long GetCtElements() const
@@ -434,7 +507,8 @@ inline void MeshFacetGrid::PosWithCheck (const Base::Vector3f &rclPoint, unsigne
   assert((rulX < _ulCtGridsX) && (rulY < _ulCtGridsY) && (rulZ < _ulCtGridsZ));
 }
 
-inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, float /*fEpsilon*/)
+inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex,
+                                     MeshGridCells::Entries &raclEntries) const
 {
 #if 0
   unsigned long  i, ulX, ulY, ulZ, ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
@@ -503,13 +577,13 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
         {
           if ( rclFacet.IntersectBoundingBox( GetBoundBox(ulX, ulY, ulZ) ) )
-            _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+            raclEntries.push_back(std::make_pair(CellIndex(ulX, ulY, ulZ), ulFacetIndex));
         }
       }
     }
   }
   else
-    _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+    raclEntries.push_back(std::make_pair(CellIndex(ulX1, ulY1, ulZ1), ulFacetIndex));
 
 #endif
 }
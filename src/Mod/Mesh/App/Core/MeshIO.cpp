@@ -38,10 +38,17 @@
 #include <Base/FileInfo.h>
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
+#include <Base/Swap.h>
 #include <Base/Placement.h>
 #include <Base/Tools.h>
 #include <zipios++/gzipoutputstream.h>
 
+#include <QFile>
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
 #include <cmath>
 #include <sstream>
 #include <iomanip>
@@ -112,6 +119,27 @@ int numDigits(int number)
     return digits;
 }
 
+/* Checks the 50 or 100 bytes after the binary STL header for keywords of an ASCII STL file */
+bool isAsciiSTL(char* szBuf)
+{
+    upper(szBuf);
+    return (strstr(szBuf, "SOLID") != NULL)  || (strstr(szBuf, "FACET") != NULL)    || (strstr(szBuf, "NORMAL") != NULL) ||
+           (strstr(szBuf, "VERTEX") != NULL) || (strstr(szBuf, "ENDFACET") != NULL) || (strstr(szBuf, "ENDLOOP") != NULL);
+}
+
+/* Reads the binary STL facets [begin, end) from a memory block */
+void readBinarySTLFacets(MeshCore::MeshFastBuilder* builder, const char* data,
+                         unsigned long begin, unsigned long end)
+{
+    Base::Vector3f clVects[4];
+    for (unsigned long i = begin; i < end; i++) {
+        // read normal, points and overread 2 bytes attribute
+        std::memcpy(clVects, data + 50 * i, sizeof(clVects));
+        std::swap(clVects[0], clVects[3]);
+        builder->SetFacet(i, clVects);
+    }
+}
+
 /* Usage by CMeshNastran, CMeshCadmouldFE. Added by Sergey Sukhov (26.04.2002)*/
 struct NODE {float x, y, z;};
 struct TRIA {int iV[3];};
@@ -158,7 +186,37 @@ bool MeshInput::LoadAny(const char* FileName)
         // read file
         bool ok = false;
         if (fi.hasExtension("stl") || fi.hasExtension("ast")) {
-            ok = LoadSTL(str);
+            // read binary STL files directly from the memory-mapped file
+            QFile file(QString::fromUtf8(FileName));
+            uchar* data = 0;
+            qint64 size = 0;
+            if (_fastImport && file.open(QIODevice::ReadOnly)) {
+                size = file.size();
+                if (size > 84)
+                    data = file.map(0, size);
+            }
+
+            char szBuf[101];
+            if (data) {
+                uint32_t ulCt;
+                std::memcpy(&ulCt, data + 80, sizeof(ulCt));
+                std::size_t ulBytes = std::min<std::size_t>(ulCt > 1 ? 100 : 50, size - 84);
+                std::memcpy(szBuf, data + 84, ulBytes);
+                szBuf[ulBytes] = 0;
+            }
+
+            if (data && !isAsciiSTL(szBuf)) {
+                try {
+                    ok = LoadBinarySTL(reinterpret_cast<const char*>(data), static_cast<std::size_t>(size));
+                }
+                catch (const Base::MemoryException&) {
+                    _rclMesh.Clear();
+                    throw;
+                }
+            }
+            else {
+                ok = LoadSTL(str);
+            }
         }
         else if (fi.hasExtension("iv")) {
             ok = LoadInventor( str );
@@ -238,11 +296,9 @@ bool MeshInput::LoadSTL (std::istream &rstrIn)
     if (!rstrIn.read(szBuf, ulBytes))
         return (ulCt==0);
     szBuf[ulBytes] = 0;
-    upper(szBuf);
 
     try {
-        if ((strstr(szBuf, "SOLID") == NULL)  && (strstr(szBuf, "FACET") == NULL)    && (strstr(szBuf, "NORMAL") == NULL) &&
-            (strstr(szBuf, "VERTEX") == NULL) && (strstr(szBuf, "ENDFACET") == NULL) && (strstr(szBuf, "ENDLOOP") == NULL)) {
+        if (!isAsciiSTL(szBuf)) {
             // probably binary STL
             buf->pubseekoff(0, std::ios::beg, std::ios::in);
             return LoadBinarySTL(rstrIn);
@@ -605,6 +661,122 @@ namespace MeshCore {
                 return x.first == y;
             }
         };
+
+        template <typename T>
+        float readValue(const char* data, bool swap)
+        {
+            T v;
+            std::memcpy(&v, data, sizeof(T));
+            if (swap)
+                Base::SwapEndian<T>(v);
+            return static_cast<float>(v);
+        }
+
+        // Decodes the vertices of a binary file. As they only have scalar properties
+        // all vertices have the same size and can be decoded in parallel.
+        class BinaryVertexReader
+        {
+        public:
+            BinaryVertexReader(const std::vector<std::pair<std::string, Number> >& props, bool swap)
+                : swap(swap), stride(0), red(-1), green(-1), blue(-1), data(0), points(0), colors(0)
+            {
+                for (std::vector<std::pair<std::string, Number> >::const_iterator it = props.begin(); it != props.end(); ++it) {
+                    int index = static_cast<int>(types.size());
+                    if (it->first == "x")
+                        coords[0] = index;
+                    else if (it->first == "y")
+                        coords[1] = index;
+                    else if (it->first == "z")
+                        coords[2] = index;
+                    else if (it->first == "red")
+                        red = index;
+                    else if (it->first == "green")
+                        green = index;
+                    else if (it->first == "blue")
+                        blue = index;
+                    types.push_back(it->second);
+                    offsets.push_back(stride);
+                    stride += size(it->second);
+                }
+            }
+            std::size_t vertexSize() const
+            {
+                return stride;
+            }
+            void setData(const char* d, MeshPointArray* p, std::vector<App::Color>* c)
+            {
+                data = d;
+                points = p;
+                colors = c;
+            }
+            void read(std::size_t begin, std::size_t end) const
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    const char* vertex = data + i * stride;
+                    Base::Vector3f& pt = (*points)[i];
+                    pt.x = value(vertex, coords[0]);
+                    pt.y = value(vertex, coords[1]);
+                    pt.z = value(vertex, coords[2]);
+                    if (colors) {
+                        float r = value(vertex, red) / 255.0f;
+                        float g = value(vertex, green) / 255.0f;
+                        float b = value(vertex, blue) / 255.0f;
+                        (*colors)[i] = App::Color(r, g, b);
+                    }
+                }
+            }
+
+        private:
+            static std::size_t size(Number type)
+            {
+                switch (type) {
+                case int8:
+                case uint8:
+                    return 1;
+                case int16:
+                case uint16:
+                    return 2;
+                case int32:
+                case uint32:
+                case float32:
+                    return 4;
+                default:
+                    return 8;
+                }
+            }
+            float value(const char* vertex, int index) const
+            {
+                const char* v = vertex + offsets[index];
+                switch (types[index]) {
+                case int8:
+                    return readValue<int8_t>(v, false);
+                case uint8:
+                    return readValue<uint8_t>(v, false);
+                case int16:
+                    return readValue<int16_t>(v, swap);
+                case uint16:
+                    return readValue<uint16_t>(v, swap);
+                case int32:
+                    return readValue<int32_t>(v, swap);
+                case uint32:
+                    return readValue<uint32_t>(v, swap);
+                case float32:
+                    return readValue<float>(v, swap);
+                default:
+                    return readValue<double>(v, swap);
+                }
+            }
+
+            bool swap;
+            std::vector<Number> types;
+            std::vector<std::size_t> offsets;
+            std::size_t stride;
+            int coords[3];
+            int red, green, blue;
+            const char* data;
+            MeshPointArray* points;
+            std::vector<App::Color>* colors;
+        };
     }
     using namespace Ply;
 }
@@ -935,7 +1107,48 @@ bool MeshInput::LoadPLY (std::istream &inp)
         else
             is.setByteOrder(Base::Stream::BigEndian);
 
-        for (std::size_t i = 0; i < v_count; i++) {
+        // the vertex block is read at once and decoded with several threads
+        if (_fastImport && v_count > 0) {
+            BinaryVertexReader reader(vertex_props, format == binary_big_endian);
+            // check the size of the block before allocating it
+            std::size_t vertexBytes = v_count * reader.vertexSize();
+            if (vertexBytes / reader.vertexSize() != v_count)
+                return false;
+            std::streampos pos = inp.tellg();
+            if (pos != std::streampos(-1)) {
+                inp.seekg(0, std::ios::end);
+                std::streampos end = inp.tellg();
+                inp.seekg(pos);
+                if (end != std::streampos(-1) && static_cast<uint64_t>(end - pos) < vertexBytes)
+                    return false;
+            }
+            std::vector<char> vertexData(vertexBytes);
+            if (!inp.read(&vertexData[0], vertexBytes))
+                return false;
+
+            meshPoints.resize(v_count);
+            std::vector<App::Color>* colors = 0;
+            if (_material && (rgb_value == MeshIO::PER_VERTEX)) {
+                _material->diffuseColor.resize(v_count);
+                colors = &_material->diffuseColor;
+            }
+            reader.setData(&vertexData[0], &meshPoints, colors);
+
+            std::size_t threads = std::max(1, QThread::idealThreadCount());
+            if (v_count < 10000)
+                threads = 1;
+            QList< QFuture<void> > futures;
+            for (std::size_t i = 1; i < threads; i++) {
+                std::size_t begin = (v_count * i) / threads;
+                std::size_t end = (v_count * (i + 1)) / threads;
+                futures << QtConcurrent::run(&reader, &BinaryVertexReader::read, begin, end);
+            }
+            reader.read(0, v_count / threads);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+                it->waitForFinished();
+        }
+
+        for (std::size_t i = meshPoints.size(); i < v_count; i++) {
             // go through the vertex properties
             std::map<std::string, float> prop_values;
             for (std::vector<std::pair<std::string, Number> >::iterator it = vertex_props.begin(); it != vertex_props.end(); ++it) {
@@ -1248,6 +1461,41 @@ bool MeshInput::LoadBinarySTL (std::istream &rstrIn)
     return true;
 }
 
+/** Loads a binary STL file from a memory block. */
+bool MeshInput::LoadBinarySTL (const char* data, std::size_t size)
+{
+    if (size < 84)
+        return false;
+
+    // number of facets
+    uint32_t ulCt = 0;
+    std::memcpy(&ulCt, data + 80, sizeof(ulCt));
+
+    // compare with the number of facets the data can hold
+    if (ulCt > (size - 84) / 50)
+        return false;// not a valid STL file
+
+    MeshFastBuilder builder(this->_rclMesh);
+    builder.Initialize(ulCt);
+
+    // read the facets in parallel chunks
+    unsigned long threads = std::max(1, QThread::idealThreadCount());
+    if (ulCt < 10000)
+        threads = 1;
+    QList< QFuture<void> > futures;
+    for (unsigned long i = 0; i < threads; i++) {
+        unsigned long begin = (static_cast<uint64_t>(ulCt) * i) / threads;
+        unsigned long end = (static_cast<uint64_t>(ulCt) * (i + 1)) / threads;
+        futures << QtConcurrent::run(readBinarySTLFacets, &builder, data + 84, begin, end);
+    }
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+        it->waitForFinished();
+
+    builder.Finish();
+
+    return true;
+}
+
 /** Loads the mesh object from an XML file. */
 void MeshInput::LoadXML (Base::XMLReader &reader)
 {
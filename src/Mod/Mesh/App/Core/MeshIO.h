@@ -84,13 +84,22 @@ class MeshExport MeshInput
 {
 public:
     MeshInput (MeshKernel &rclM)
-        : _rclMesh(rclM), _material(0){}
+        : _rclMesh(rclM), _material(0), _fastImport(true){}
     MeshInput (MeshKernel &rclM, Material* m)
-        : _rclMesh(rclM), _material(m){}
+        : _rclMesh(rclM), _material(m), _fastImport(true){}
     virtual ~MeshInput (void) { }
     const std::vector<std::string>& GetGroupNames() const {
         return _groupNames;
     }
+    /** If enabled LoadAny() memory-maps binary STL files and reads them
+     * with several threads. Like the stream-based reader the vertices are
+     * merged within MeshDefinitions::_fMinPointDistanceD1. The vertices of
+     * binary PLY files are read at once and decoded with several threads.
+     * It is on by default.
+     */
+    void SetFastImport(bool on) {
+        _fastImport = on;
+    }
 
     /// Loads the file, decided by extension
     bool LoadAny(const char* FileName);
@@ -104,6 +113,10 @@ public:
     bool LoadAsciiSTL (std::istream &rstrIn);
     /** Loads a binary STL file. */
     bool LoadBinarySTL (std::istream &rstrIn);
+    /** Loads a binary STL file from a memory block, e.g. a memory-mapped file.
+     * The facets are read in parallel and the vertices are merged with MeshFastBuilder.
+     */
+    bool LoadBinarySTL (const char* data, std::size_t size);
     /** Loads an OBJ Mesh file. */
     bool LoadOBJ (std::istream &rstrIn);
     /** Loads an OFF Mesh file. */
@@ -125,6 +138,7 @@ protected:
     MeshKernel &_rclMesh;   /**< reference to mesh data structure */
     Material* _material;
     std::vector<std::string> _groupNames;
+    bool _fastImport;
 };
 
 /**
@@ -34,6 +34,7 @@
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
 #include <Base/Swap.h>
+#include <Base/VectorArray.h>
 
 #include "Algorithm.h"
 #include "Approximation.h"
@@ -912,14 +913,11 @@ void MeshKernel::operator *= (const Base::Matrix4D &rclMat)
 
 void MeshKernel::Transform (const Base::Matrix4D &rclMat)
 {
-    MeshPointArray::_TIterator  clPIter = _aclPointArray.begin(), clPEIter = _aclPointArray.end();
-    Base::Matrix4D clMatrix(rclMat);
-
+    // transform the points and compute the new bounding box in one pass
     _clBoundBox.SetVoid();
-    while (clPIter < clPEIter) {
-        *clPIter *= clMatrix;
-        _clBoundBox.Add(*clPIter);
-        clPIter++;
+    if (!_aclPointArray.empty()) {
+        _clBoundBox = Base::VectorArray::Transform(rclMat, &_aclPointArray[0],
+                                                   _aclPointArray.size(), sizeof(MeshPoint));
     }
 }
 
@@ -932,8 +930,10 @@ void MeshKernel::Smooth(int iterations, float stepsize)
 void MeshKernel::RecalcBoundBox (void)
 {
     _clBoundBox.SetVoid();
-    for (MeshPointArray::_TConstIterator pI = _aclPointArray.begin(); pI != _aclPointArray.end(); pI++)
-        _clBoundBox.Add(*pI);
+    if (!_aclPointArray.empty()) {
+        _clBoundBox = Base::VectorArray::GetBoundBox(&_aclPointArray[0],
+                                                     _aclPointArray.size(), sizeof(MeshPoint));
+    }
 }
 
 std::vector<Base::Vector3f> MeshKernel::CalcVertexNormals() const
@@ -28,6 +28,7 @@
 #endif
 
 #include <CXX/Objects.hxx>
+#include <App/Application.h>
 #include <Base/Builder3D.h>
 #include <Base/Console.h>
 #include <Base/Exception.h>
@@ -39,6 +40,7 @@
 #include <Base/ViewProj.h>
 
 #include "Core/Builder.h"
+#include "Core/Decimation.h"
 #include "Core/MeshKernel.h"
 #include "Core/Grid.h"
 #include "Core/Iterator.h"
@@ -401,6 +403,8 @@ bool MeshObject::load(const char* file, MeshCore::Material* mat)
 {
     MeshCore::MeshKernel kernel;
     MeshCore::MeshInput aReader(kernel, mat);
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath("User parameter:BaseApp/Preferences/Mod/Mesh");
+    aReader.SetFastImport(hGrp->GetBool("FastImport", true));
     if (!aReader.LoadAny(file))
         return false;
 
@@ -933,6 +937,14 @@ void MeshObject::smooth(int iterations, float d_max)
     _kernel.Smooth(iterations, d_max);
 }
 
+void MeshObject::decimate(unsigned long targetSize)
+{
+    MeshCore::MeshSimplify simplify(_kernel);
+    simplify.Simplify(targetSize);
+    // the facet indices of the segments are not valid any more
+    this->_segments.clear();
+}
+
 Base::Vector3d MeshObject::getPointNormal(unsigned long index) const
 {
     std::vector<Base::Vector3f> temp = _kernel.CalcVertexNormals();
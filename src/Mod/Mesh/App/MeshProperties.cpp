@@ -426,7 +426,7 @@ void PropertyCurvatureList::Paste(const App::Property &from)
 // ----------------------------------------------------------------------------
 
 PropertyMeshKernel::PropertyMeshKernel()
-  : _meshObject(new MeshObject()), meshPyObject(0)
+  : _meshObject(new MeshObject()), meshPyObject(0), lazyFile(0)
 {
     // Note: Normally this property is a member of a document object, i.e. the setValue()
     // method gets called in the constructor of a sublcass of DocumentObject, e.g. Mesh::Feature.
@@ -442,6 +442,8 @@ PropertyMeshKernel::~PropertyMeshKernel()
         meshPyObject->parentProperty = 0;
         Py_DECREF(meshPyObject);
     }
+    leaveSharing();
+    delete lazyFile;
 }
 
 void PropertyMeshKernel::setValuePtr(MeshObject* mesh)
@@ -450,69 +452,194 @@ void PropertyMeshKernel::setValuePtr(MeshObject* mesh)
     // before calling hasSetValue()
     Base::Reference<MeshObject> tmp(_meshObject);
     aboutToSetValue();
-    _meshObject = mesh;
+    // the mesh is replaced, so there is no need to read in the old one
+    delete lazyFile;
+    lazyFile = 0;
+    setMeshObject(mesh);
     hasSetValue();
 }
 
 void PropertyMeshKernel::setValue(const MeshObject& mesh)
 {
     aboutToSetValue();
+    delete lazyFile;
+    lazyFile = 0;
+    detachMesh(false);
     *_meshObject = mesh;
     hasSetValue();
 }
 
 void PropertyMeshKernel::setValue(const MeshCore::MeshKernel& mesh)
 {
+    restoreLazyFile();
     aboutToSetValue();
+    detachMesh(false);
     _meshObject->setKernel(mesh);
     hasSetValue();
 }
 
 void PropertyMeshKernel::swapMesh(MeshObject& mesh)
 {
+    restoreLazyFile();
     aboutToSetValue();
+    detachMesh(true);
     _meshObject->swap(mesh);
     hasSetValue();
 }
 
 void PropertyMeshKernel::swapMesh(MeshCore::MeshKernel& mesh)
 {
+    restoreLazyFile();
     aboutToSetValue();
+    detachMesh(true);
     _meshObject->swap(mesh);
     hasSetValue();
 }
 
+/**
+ * The mesh object may be shared with copies of this property, e.g. in the undo
+ * stack. Before it is modified the property gets an own mesh object, with a copy
+ * of the data if \a keepData is true. Otherwise the caller replaces the data and
+ * only the placement is kept.
+ */
+void PropertyMeshKernel::detachMesh(bool keepData)
+{
+    std::map<unsigned long, Base::Vector3f> points;
+    points.swap(_pointPatch);
+    if (_meshObject.getRefCount() > 1) {
+        if (keepData)
+            setMeshObject(new MeshObject(*_meshObject));
+        else
+            setMeshObject(new MeshObject(MeshCore::MeshKernel(), _meshObject->getTransform()));
+    }
+    else {
+        leaveSharing();
+    }
+
+    // the mesh object is not shared any more, so the points can be applied
+    if (keepData) {
+        MeshCore::MeshKernel& kernel = _meshObject->getKernel();
+        for (std::map<unsigned long, Base::Vector3f>::iterator it = points.begin(); it != points.end(); ++it)
+            kernel.SetPoint(it->first, it->second);
+    }
+}
+
+void PropertyMeshKernel::setMeshObject(MeshObject* mesh)
+{
+    leaveSharing();
+    _meshObject = mesh;
+    // the Python wrapper must refer to the current mesh object
+    if (meshPyObject)
+        meshPyObject->_pcTwinPointer = mesh;
+}
+
+/**
+ * References the mesh object of \a prop. The properties that share a mesh
+ * object are registered with each other so that a modification of some points
+ * can be recorded in the other properties instead of copying the whole mesh.
+ */
+void PropertyMeshKernel::shareMesh(const PropertyMeshKernel& prop)
+{
+    setMeshObject(prop._meshObject);
+    _pointPatch = prop._pointPatch;
+    if (!prop._sharedWith) {
+        prop._sharedWith.reset(new std::set<PropertyMeshKernel*>());
+        prop._sharedWith->insert(const_cast<PropertyMeshKernel*>(&prop));
+    }
+    _sharedWith = prop._sharedWith;
+    _sharedWith->insert(this);
+}
+
+void PropertyMeshKernel::leaveSharing()
+{
+    if (_sharedWith) {
+        _sharedWith->erase(this);
+        _sharedWith.reset();
+    }
+    _pointPatch.clear();
+}
+
+/**
+ * Sets the points of the shared mesh object. The other properties that share
+ * it keep the original points. Returns false if the mesh object is referenced
+ * elsewhere, e.g. by a Python mesh point, and must be detached instead.
+ */
+bool PropertyMeshKernel::setSharedPoints(const std::vector<std::pair<unsigned long, Base::Vector3f> >& inds)
+{
+    if (!_sharedWith || _meshObject.getRefCount() != static_cast<int>(_sharedWith->size()))
+        return false;
+
+    MeshCore::MeshKernel& kernel = _meshObject->getKernel();
+    const MeshCore::MeshPointArray& points = kernel.GetPoints();
+    for (std::vector<std::pair<unsigned long, Base::Vector3f> >::const_iterator it = inds.begin(); it != inds.end(); ++it) {
+        for (std::set<PropertyMeshKernel*>::iterator jt = _sharedWith->begin(); jt != _sharedWith->end(); ++jt) {
+            // a point that was already changed keeps its first original value
+            if (*jt != this)
+                (*jt)->_pointPatch.insert(std::make_pair(it->first, Base::Vector3f(points[it->first])));
+        }
+        kernel.SetPoint(it->first, it->second);
+        _pointPatch.erase(it->first);
+    }
+
+    return true;
+}
+
+/**
+ * A property that shares its mesh object but differs in some points gets an own
+ * copy before the mesh is accessed. This only happens if a saved copy, e.g. of
+ * the undo stack, is read directly and not via Paste().
+ */
+void PropertyMeshKernel::applyPointPatch() const
+{
+    if (!_pointPatch.empty())
+        const_cast<PropertyMeshKernel*>(this)->detachMesh(true);
+}
+
 const MeshObject& PropertyMeshKernel::getValue(void)const 
 {
+    restoreLazyFile();
+    applyPointPatch();
     return *_meshObject;
 }
 
 const MeshObject* PropertyMeshKernel::getValuePtr(void)const 
 {
+    restoreLazyFile();
+    applyPointPatch();
     return (MeshObject*)_meshObject;
 }
 
 const Data::ComplexGeoData* PropertyMeshKernel::getComplexData() const
 {
+    restoreLazyFile();
+    applyPointPatch();
     return (MeshObject*)_meshObject;
 }
 
 Base::BoundBox3d PropertyMeshKernel::getBoundingBox() const
 {
+    restoreLazyFile();
+    applyPointPatch();
     return _meshObject->getBoundBox();
 }
 
 unsigned int PropertyMeshKernel::getMemSize (void) const
 {
+    // A shared mesh object is not counted, e.g. the undo stack shares it with
+    // the document. Only the points in which this property differs count.
     unsigned int size = 0;
-    size += _meshObject->getMemSize();
+    size += static_cast<unsigned int>(_pointPatch.size() * (sizeof(unsigned long) + sizeof(Base::Vector3f)));
+    if (_meshObject.getRefCount() <= 1)
+        size += _meshObject->getMemSize();
     
     return size;
 }
 
 MeshObject* PropertyMeshKernel::startEditing()
 {
+    restoreLazyFile();
     aboutToSetValue();
+    detachMesh(true);
     return (MeshObject*)_meshObject;
 }
 
@@ -523,22 +650,38 @@ void PropertyMeshKernel::finishEditing()
 
 void PropertyMeshKernel::transformGeometry(const Base::Matrix4D &rclMat)
 {
+    restoreLazyFile();
     aboutToSetValue();
+    detachMesh(true);
     _meshObject->transformGeometry(rclMat);
     hasSetValue();
 }
 
 void PropertyMeshKernel::setPointIndices(const std::vector<std::pair<unsigned long, Base::Vector3f> >& inds)
 {
+    restoreLazyFile();
+    unsigned long countPoints = _meshObject->countPoints();
+    for (std::vector<std::pair<unsigned long, Base::Vector3f> >::const_iterator it = inds.begin(); it != inds.end(); ++it) {
+        if (it->first >= countPoints)
+            throw Base::ValueError("Point index out of range");
+    }
+
     aboutToSetValue();
-    MeshCore::MeshKernel& kernel = _meshObject->getKernel();
-    for (std::vector<std::pair<unsigned long, Base::Vector3f> >::const_iterator it = inds.begin(); it != inds.end(); ++it)
-        kernel.SetPoint(it->first, it->second);
+    // if the mesh is shared, e.g. with the undo stack, only the changed points
+    // are kept for the other properties
+    if (!setSharedPoints(inds)) {
+        detachMesh(true);
+        MeshCore::MeshKernel& kernel = _meshObject->getKernel();
+        for (std::vector<std::pair<unsigned long, Base::Vector3f> >::const_iterator it = inds.begin(); it != inds.end(); ++it)
+            kernel.SetPoint(it->first, it->second);
+    }
     hasSetValue();
 }
 
 PyObject *PropertyMeshKernel::getPyObject(void)
 {
+    restoreLazyFile();
+    applyPointPatch();
     if (!meshPyObject) {
         meshPyObject = new MeshPy(&*_meshObject);
         meshPyObject->setConst(); // set immutable
@@ -574,6 +717,8 @@ void PropertyMeshKernel::setPyObject(PyObject *value)
 
 void PropertyMeshKernel::Save (Base::Writer &writer) const
 {
+    restoreLazyFile();
+    applyPointPatch();
     if (writer.isForceXML()) {
         writer.Stream() << writer.ind() << "<Mesh>" << std::endl;
         MeshCore::MeshOutput saver(_meshObject->getKernel());
@@ -602,6 +747,7 @@ void PropertyMeshKernel::Restore(Base::XMLReader &reader)
         kernel.Adopt(points, facets);
 
         aboutToSetValue();
+        detachMesh(false);
         _meshObject->getKernel().Adopt(points, facets);
         hasSetValue();
     } 
@@ -613,29 +759,64 @@ void PropertyMeshKernel::Restore(Base::XMLReader &reader)
 
 void PropertyMeshKernel::SaveDocFile (Base::Writer &writer) const
 {
+    restoreLazyFile();
+    applyPointPatch();
     _meshObject->save(writer.Stream());
 }
 
 void PropertyMeshKernel::RestoreDocFile(Base::Reader &reader)
 {
     aboutToSetValue();
+    detachMesh(false);
     _meshObject->load(reader);
     hasSetValue();
 }
 
+bool PropertyMeshKernel::RestoreDocFileLazy(Base::LazyFile* file)
+{
+    // the mesh will be read into the current mesh object
+    detachMesh(false);
+    delete lazyFile;
+    lazyFile = file;
+    return true;
+}
+
+void PropertyMeshKernel::restoreLazyFile() const
+{
+    // The mesh is read in as if it had been restored together with the
+    // document, so no change is notified
+    MeshObject* mesh = _meshObject;
+    Base::LazyFile::restoreOnce(lazyFile, [mesh](Base::Reader& reader) {
+        mesh->load(reader);
+    });
+}
+
 App::Property *PropertyMeshKernel::Copy(void) const
 {
-    // Note: Copy the content, do NOT reference the same mesh object
+    restoreLazyFile();
+    // Note: Reference the same mesh object, it is copied before either property modifies it
     PropertyMeshKernel *prop = new PropertyMeshKernel();
-    *(prop->_meshObject) = *(this->_meshObject);
+    prop->shareMesh(*this);
     return prop;
 }
 
 void PropertyMeshKernel::Paste(const App::Property &from)
 {
-    // Note: Copy the content, do NOT reference the same mesh object
-    aboutToSetValue();
+    // Note: Reference the same mesh object, it is copied before either property modifies it
     const PropertyMeshKernel& prop = dynamic_cast<const PropertyMeshKernel&>(from);
-    *(this->_meshObject) = *(prop._meshObject);
+    prop.restoreLazyFile();
+    aboutToSetValue();
+    delete lazyFile;
+    lazyFile = 0;
+    // When undoing a change of some points the mesh object is still shared,
+    // so only these points are written back
+    std::vector<std::pair<unsigned long, Base::Vector3f> > points(prop._pointPatch.begin(), prop._pointPatch.end());
+    if (prop._meshObject == _meshObject && prop._sharedWith && prop._sharedWith == _sharedWith
+        && setSharedPoints(points)) {
+        _pointPatch.clear();
+    }
+    else {
+        shareMesh(prop);
+    }
     hasSetValue();
 }
@@ -29,6 +29,7 @@
 #include <set>
 #include <string>
 #include <map>
+#include <boost/shared_ptr.hpp>
 
 #include <Base/Handle.h>
 #include <Base/Matrix.h>
@@ -40,6 +41,9 @@
 #include "Core/MeshKernel.h"
 #include "Mesh.h"
 
+namespace Base {
+class LazyFile;
+}
 
 namespace Mesh
 {
@@ -244,14 +248,36 @@ public:
 
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
-
+    bool RestoreDocFileLazy(Base::LazyFile* file);
+    void restoreLazyFile() const;
+    bool hasLazyFile() const
+    { return lazyFile != 0; }
+
+    /** Copy() and Paste() share the mesh object instead of copying it, e.g. for
+     * the undo stack. The data is copied when a shared mesh gets modified, except
+     * for setPointIndices() where the other properties keep the changed points.
+     */
     App::Property *Copy(void) const;
     void Paste(const App::Property &from);
     //@}
 
+private:
+    void detachMesh(bool keepData);
+    void setMeshObject(MeshObject* mesh);
+    void shareMesh(const PropertyMeshKernel& prop);
+    void leaveSharing();
+    bool setSharedPoints(const std::vector<std::pair<unsigned long, Base::Vector3f> >& inds);
+    void applyPointPatch() const;
+
 private:
     Base::Reference<MeshObject> _meshObject;
+    /// the properties that share the mesh object, including this one
+    mutable boost::shared_ptr<std::set<PropertyMeshKernel*> > _sharedWith;
+    /// the points in which this property differs from the shared mesh object
+    std::map<unsigned long, Base::Vector3f> _pointPatch;
     MeshPy* meshPyObject;
+    /// file with the mesh if it isn't read in yet
+    mutable Base::LazyFile* lazyFile;
 };
 
 } // namespace Mesh
@@ -41,6 +41,7 @@
 #include "Core/Degeneration.h"
 #include "Core/Elements.h"
 #include "Core/Grid.h"
+#include "Core/BVH.h"
 #include "Core/MeshKernel.h"
 #include "Core/Segmentation.h"
 #include "Core/Curvature.h"
@@ -770,7 +771,18 @@ PyObject*  MeshPy::setPoint(PyObject *args)
         return NULL;
 
     PY_TRY {
-        getMeshObjectPtr()->setPoint(index, static_cast<Base::VectorPy*>(pnt)->value());
+        if (this->parentProperty) {
+            // let the property record the point instead of copying the whole mesh
+            Base::Matrix4D mat(getMeshObjectPtr()->getTransform());
+            mat.inverse();
+            Base::Vector3d pt = mat * static_cast<Base::VectorPy*>(pnt)->value();
+            std::vector<std::pair<unsigned long, Base::Vector3f> > inds;
+            inds.push_back(std::make_pair(index, Base::Vector3f((float)pt.x, (float)pt.y, (float)pt.z)));
+            this->parentProperty->setPointIndices(inds);
+        }
+        else {
+            getMeshObjectPtr()->setPoint(index, static_cast<Base::VectorPy*>(pnt)->value());
+        }
     } PY_CATCH;
 
     Py_Return;
@@ -935,12 +947,14 @@ PyObject*  MeshPy::hasSelfIntersections(PyObject *args)
 
 PyObject*  MeshPy::getSelfIntersections(PyObject *args)
 {
-    if (!PyArg_ParseTuple(args, ""))
+    int threads = 0;
+    if (!PyArg_ParseTuple(args, "|i", &threads))
         return NULL;
 
     std::vector<std::pair<unsigned long, unsigned long> > selfIndices;
     std::vector<std::pair<Base::Vector3f, Base::Vector3f> > selfPoints;
     MeshCore::MeshEvalSelfIntersection eval(getMeshObjectPtr()->getKernel());
+    eval.SetThreadCount(threads);
     eval.GetIntersections(selfIndices);
     eval.GetIntersections(selfIndices, selfPoints);
 
@@ -1581,6 +1595,24 @@ PyObject*  MeshPy::smooth(PyObject *args)
     Py_Return; 
 }
 
+PyObject*  MeshPy::decimate(PyObject *args)
+{
+    int targetSize;
+    if (!PyArg_ParseTuple(args, "i", &targetSize))
+        return NULL;
+    if (targetSize < 0) {
+        PyErr_SetString(PyExc_ValueError, "Target size must not be negative");
+        return NULL;
+    }
+
+    PY_TRY {
+        MeshPropertyLock lock(this->parentProperty);
+        getMeshObjectPtr()->decimate(static_cast<unsigned long>(targetSize));
+    } PY_CATCH;
+
+    Py_Return; 
+}
+
 PyObject* MeshPy::nearestFacetOnRay(PyObject *args)
 {
     PyObject* pnt_p;
@@ -1644,6 +1676,148 @@ PyObject* MeshPy::nearestFacetOnRay(PyObject *args)
     }
 }
 
+namespace {
+enum SearchStructure { SearchAll, SearchGrid, SearchBVH };
+
+bool getSearchStructure(const char* name, SearchStructure& search)
+{
+    if (strcmp(name, "BVH") == 0)
+        search = SearchBVH;
+    else if (strcmp(name, "Grid") == 0)
+        search = SearchGrid;
+    else if (strcmp(name, "None") == 0)
+        search = SearchAll;
+    else
+        return false;
+    return true;
+}
+}
+
+PyObject* MeshPy::nearestFacetsOnRays(PyObject *args)
+{
+    PyObject* rays;
+    const char* name = "BVH";
+    if (!PyArg_ParseTuple(args, "O|s", &rays, &name))
+        return NULL;
+
+    SearchStructure search;
+    if (!getSearchStructure(name, search)) {
+        PyErr_SetString(PyExc_ValueError, "Search structure must be 'BVH', 'Grid' or 'None'");
+        return NULL;
+    }
+
+    try {
+        Py::Sequence list(rays);
+        std::vector<std::pair<Base::Vector3f, Base::Vector3f> > rayList;
+        rayList.reserve(list.size());
+        for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+            Py::Tuple ray(*it);
+            Base::Vector3d pnt = Py::Vector(ray.getItem(0)).toVector();
+            Base::Vector3d dir = Py::Vector(ray.getItem(1)).toVector();
+            rayList.push_back(std::make_pair(Base::convertTo<Base::Vector3f>(pnt),
+                                             Base::convertTo<Base::Vector3f>(dir)));
+        }
+
+        const MeshCore::MeshKernel& kernel = getMeshObjectPtr()->getKernel();
+        MeshCore::MeshAlgorithm alg(kernel);
+        std::unique_ptr<MeshCore::MeshFacetGrid> grid;
+        std::unique_ptr<MeshCore::MeshFacetBVH> bvh;
+        if (search == SearchGrid)
+            grid.reset(new MeshCore::MeshFacetGrid(kernel));
+        else if (search == SearchBVH)
+            bvh.reset(new MeshCore::MeshFacetBVH(kernel));
+
+        Py::List result;
+        for (std::vector<std::pair<Base::Vector3f, Base::Vector3f> >::iterator it = rayList.begin(); it != rayList.end(); ++it) {
+            unsigned long index = 0;
+            Base::Vector3f res;
+            bool found;
+            if (grid.get())
+                found = alg.NearestFacetOnRay(it->first, it->second, *grid, res, index);
+            else if (bvh.get())
+                found = alg.NearestFacetOnRay(it->first, it->second, *bvh, res, index);
+            else
+                found = alg.NearestFacetOnRay(it->first, it->second, res, index);
+
+            if (found) {
+                Py::Tuple tuple(2);
+                tuple.setItem(0, Py::Long(index));
+                tuple.setItem(1, Py::Vector(res));
+                result.append(tuple);
+            }
+            else {
+                result.append(Py::None());
+            }
+        }
+
+        return Py::new_reference_to(result);
+    }
+    catch (const Py::Exception&) {
+        return 0;
+    }
+}
+
+PyObject* MeshPy::nearestFacetsToPoints(PyObject *args)
+{
+    PyObject* points;
+    const char* name = "BVH";
+    if (!PyArg_ParseTuple(args, "O|s", &points, &name))
+        return NULL;
+
+    SearchStructure search;
+    if (!getSearchStructure(name, search)) {
+        PyErr_SetString(PyExc_ValueError, "Search structure must be 'BVH', 'Grid' or 'None'");
+        return NULL;
+    }
+
+    try {
+        Py::Sequence list(points);
+        std::vector<Base::Vector3f> pointList;
+        pointList.reserve(list.size());
+        for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+            Base::Vector3d pnt = Py::Vector(*it).toVector();
+            pointList.push_back(Base::convertTo<Base::Vector3f>(pnt));
+        }
+
+        const MeshCore::MeshKernel& kernel = getMeshObjectPtr()->getKernel();
+        MeshCore::MeshAlgorithm alg(kernel);
+        std::unique_ptr<MeshCore::MeshFacetGrid> grid;
+        std::unique_ptr<MeshCore::MeshFacetBVH> bvh;
+        if (search == SearchGrid)
+            grid.reset(new MeshCore::MeshFacetGrid(kernel));
+        else if (search == SearchBVH)
+            bvh.reset(new MeshCore::MeshFacetBVH(kernel));
+
+        Py::List result;
+        for (std::vector<Base::Vector3f>::iterator it = pointList.begin(); it != pointList.end(); ++it) {
+            unsigned long index = 0;
+            Base::Vector3f res;
+            bool found;
+            if (grid.get())
+                found = alg.NearestPointFromPoint(*it, *grid, index, res);
+            else if (bvh.get())
+                found = alg.NearestPointFromPoint(*it, *bvh, index, res);
+            else
+                found = alg.NearestPointFromPoint(*it, index, res);
+
+            if (found) {
+                Py::Tuple tuple(2);
+                tuple.setItem(0, Py::Long(index));
+                tuple.setItem(1, Py::Vector(res));
+                result.append(tuple);
+            }
+            else {
+                result.append(Py::None());
+            }
+        }
+
+        return Py::new_reference_to(result);
+    }
+    catch (const Py::Exception&) {
+        return 0;
+    }
+}
+
 PyObject*  MeshPy::getPlanarSegments(PyObject *args)
 {
     float dev;
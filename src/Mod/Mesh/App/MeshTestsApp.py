@@ -1,7 +1,7 @@
 #   (c) Juergen Riegel (juergen.riegel@web.de) 2007      LGPL
 
 import FreeCAD, os, sys, unittest, Mesh
-import thread, time, tempfile, math
+import thread, time, tempfile, math, random, struct
 
 
 #---------------------------------------------------------------------------
@@ -120,6 +120,41 @@ class PivyTestCases(unittest.TestCase):
 		self.failUnless(pc.getTriangleCount() == 2)
 		#self.failUnless(pc.getPointCount() == 6)
 
+	def testFrameTime(self):
+		if not FreeCAD.GuiUp:
+			return
+		from pivy import coin; import FreeCADGui
+		hGrp = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Mod/Mesh")
+		useVBO = hGrp.GetBool("UseVBO", False)
+		mesh = Mesh.createSphere(10.0, 400)
+		viewport = coin.SbViewportRegion(400,400)
+		frames = 20
+		times = []
+		for vbo in [False, True]:
+			# the parameter is read when the view provider is attached
+			hGrp.SetBool("UseVBO", vbo)
+			feature = FreeCAD.ActiveDocument.addObject("Mesh::Feature","Mesh")
+			feature.Mesh = mesh
+			root = coin.SoSeparator()
+			cam = coin.SoPerspectiveCamera()
+			root.addChild(cam)
+			root.addChild(coin.SoDirectionalLight())
+			root.addChild(feature.ViewObject.RootNode)
+			cam.viewAll(root, viewport)
+			off = coin.SoOffscreenRenderer(viewport)
+			root.ref()
+			# the first frame fills the buffer objects
+			self.failUnless(off.render(root))
+			start = time.time()
+			for i in range(frames):
+				self.failUnless(off.render(root))
+			times.append((time.time() - start) / frames)
+			root.unref()
+			FreeCAD.ActiveDocument.removeObject(feature.Name)
+		hGrp.SetBool("UseVBO", useVBO)
+		FreeCAD.Console.PrintMessage("Frame time for %d facets: %.4fs (immediate mode) vs. %.4fs (buffer objects)\n"
+		                             % (mesh.CountFacets, times[0], times[1]))
+
 	def tearDown(self):
 		#closing doc
 		FreeCAD.closeDocument("MeshTest")
@@ -163,6 +198,275 @@ class LoadMeshInThreadsCases(unittest.TestCase):
         pass
 
 
+class LoadBinarySTLCases(unittest.TestCase):
+    def setUp(self):
+        self.param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Mod/Mesh")
+        self.fastImport = self.param.GetBool("FastImport", True)
+        self.fileName = tempfile.gettempdir() + os.sep + "binary.stl"
+
+    def loadMesh(self, fast):
+        self.param.SetBool("FastImport", fast)
+        start = time.time()
+        mesh = Mesh.Mesh(self.fileName)
+        return mesh, time.time() - start
+
+    def testCompareImport(self):
+        # a large synthetic mesh, compare the memory-mapped import with the stream-based one
+        Mesh.createSphere(10.0, 500).write(self.fileName)
+        fast, fastTime = self.loadMesh(True)
+        slow, slowTime = self.loadMesh(False)
+        FreeCAD.Console.PrintMessage("Load %d facets: %.3fs (fast) vs. %.3fs\n" % (slow.CountFacets, fastTime, slowTime))
+
+        self.failUnless(fast.CountPoints == slow.CountPoints)
+        self.failUnless(fast.CountFacets == slow.CountFacets)
+        self.failUnless(fast.Topology == slow.Topology)
+        self.failUnless(fast.isSolid())
+
+    def testNearCoincidentVertices(self):
+        # the corners of adjacent facets differ by less than the merge tolerance
+        rand = random.Random(4711)
+        size = 200
+        def corner(x, y):
+            return [1.0 + x * 0.01 + rand.uniform(-2e-7, 2e-7),
+                    1.0 + y * 0.01 + rand.uniform(-2e-7, 2e-7),
+                    1.0 + rand.uniform(-2e-7, 2e-7)]
+        data = [b"\0" * 80, struct.pack("<I", 2 * size * size)]
+        for x in range(size):
+            for y in range(size):
+                for facet in [[(x, y), (x + 1, y), (x + 1, y + 1)], [(x, y), (x + 1, y + 1), (x, y + 1)]]:
+                    values = [0.0, 0.0, 1.0]
+                    for i, j in facet:
+                        values += corner(i, j)
+                    data.append(struct.pack("<12fH", *(values + [0])))
+        stl = open(self.fileName, "wb")
+        stl.write(b"".join(data))
+        stl.close()
+
+        fast, fastTime = self.loadMesh(True)
+        slow, slowTime = self.loadMesh(False)
+        FreeCAD.Console.PrintMessage("Load %d near-coincident facets: %.3fs (fast) vs. %.3fs\n" % (slow.CountFacets, fastTime, slowTime))
+
+        self.failUnless(slow.CountPoints == (size + 1) * (size + 1))
+        self.failUnless(fast.CountPoints == slow.CountPoints)
+        self.failUnless(fast.CountFacets == slow.CountFacets)
+        self.failUnless(fast.Topology == slow.Topology)
+
+    def testCompareBinaryPLY(self):
+        # big-endian vertices of mixed types, compare the parallel decoding with the stream-based one
+        self.fileName = tempfile.gettempdir() + os.sep + "binary.ply"
+        mesh = Mesh.createSphere(10.0, 200)
+        points, facets = mesh.Topology
+        header = ["ply", "format binary_big_endian 1.0",
+                  "element vertex %d" % len(points),
+                  "property double x", "property float y", "property short id", "property double z",
+                  "property uchar red", "property uchar green", "property uchar blue",
+                  "element face %d" % len(facets),
+                  "property list uchar int vertex_indices", "end_header"]
+        data = ["\n".join(header) + "\n"]
+        for i, p in enumerate(points):
+            data.append(struct.pack(">dfhdBBB", p.x, p.y, i % 30000, p.z, 255, 128, 0))
+        for f in facets:
+            data.append(struct.pack(">Biii", 3, f[0], f[1], f[2]))
+        ply = open(self.fileName, "wb")
+        ply.write(b"".join(data))
+        ply.close()
+
+        fast, fastTime = self.loadMesh(True)
+        slow, slowTime = self.loadMesh(False)
+        FreeCAD.Console.PrintMessage("Load %d PLY facets: %.3fs (fast) vs. %.3fs\n" % (slow.CountFacets, fastTime, slowTime))
+
+        self.failUnless(fast.CountPoints == len(points))
+        self.failUnless(fast.Topology == slow.Topology)
+
+    def tearDown(self):
+        self.param.SetBool("FastImport", self.fastImport)
+        os.remove(self.fileName)
+
+
+class MeshGridCases(unittest.TestCase):
+    def testCrossSections(self):
+        # the facet grid is built for a large mesh and queried for each plane
+        mesh = Mesh.createSphere(10.0, 800)
+        planes = [(FreeCAD.Vector(0, 0, z * 0.5), FreeCAD.Vector(0, 0, 1)) for z in range(-19, 20)]
+        start = time.time()
+        sections = mesh.crossSections(planes)
+        FreeCAD.Console.PrintMessage("Cross-sections of %d facets: %.3fs\n" % (mesh.CountFacets, time.time() - start))
+
+        self.failUnless(len(sections) == len(planes))
+        for section in sections:
+            self.failUnless(len(section) == 1)
+
+
+class MeshBVHCases(unittest.TestCase):
+    def setUp(self):
+        # a very uneven facet density: a fine small sphere next to a coarse big one
+        self.mesh = Mesh.createSphere(10.0, 50)
+        small = Mesh.createSphere(0.2, 200)
+        small.translate(12.0, 0.0, 0.0)
+        self.mesh.addMesh(small)
+        rand = random.Random(4711)
+        def randomVector(size):
+            return FreeCAD.Vector(rand.uniform(-size, size), rand.uniform(-size, size), rand.uniform(-size, size))
+        self.points = [randomVector(15.0) for i in range(100)] + \
+                      [FreeCAD.Vector(12.0, 0.0, 0.0) + randomVector(0.5) for i in range(100)]
+        self.rays = [(p, FreeCAD.Vector(12.0, 0.0, 0.0) - p + randomVector(0.1)) for p in self.points]
+
+    def timeQuery(self, query, args, search):
+        start = time.time()
+        result = query(args, search)
+        return result, time.time() - start
+
+    def testNearestFacetOnRay(self):
+        bvh, bvhTime = self.timeQuery(self.mesh.nearestFacetsOnRays, self.rays, "BVH")
+        grid, gridTime = self.timeQuery(self.mesh.nearestFacetsOnRays, self.rays, "Grid")
+        all, allTime = self.timeQuery(self.mesh.nearestFacetsOnRays, self.rays, "None")
+        FreeCAD.Console.PrintMessage("%d rays on %d facets: %.3fs (BVH) vs. %.3fs (grid) vs. %.3fs (all facets)\n"
+                                     % (len(self.rays), self.mesh.CountFacets, bvhTime, gridTime, allTime))
+
+        # all rays point to the small sphere, most of them hit it
+        self.failUnless(len([r for r in all if r is not None]) > len(self.rays) // 2)
+        for (p, d), r1, r2 in zip(self.rays, bvh, all):
+            # the brute force search also finds facets behind the point
+            if r2 is not None and (r2[1] - p).dot(d) < 0:
+                continue
+            self.failUnless((r1 is None) == (r2 is None))
+            if r1 is not None:
+                self.failUnless(abs((r1[1] - p).Length - (r2[1] - p).Length) < 1e-4)
+
+    def testNearestFacetToPoint(self):
+        bvh, bvhTime = self.timeQuery(self.mesh.nearestFacetsToPoints, self.points, "BVH")
+        grid, gridTime = self.timeQuery(self.mesh.nearestFacetsToPoints, self.points, "Grid")
+        all, allTime = self.timeQuery(self.mesh.nearestFacetsToPoints, self.points, "None")
+        FreeCAD.Console.PrintMessage("%d nearest points on %d facets: %.3fs (BVH) vs. %.3fs (grid) vs. %.3fs (all facets)\n"
+                                     % (len(self.points), self.mesh.CountFacets, bvhTime, gridTime, allTime))
+
+        for p, r1, r2 in zip(self.points, bvh, all):
+            self.failUnless(r1 is not None and r2 is not None)
+            self.failUnless(abs((r1[1] - p).Length - (r2[1] - p).Length) < 1e-4)
+
+
+class MeshSelfIntersectionCases(unittest.TestCase):
+    def setUp(self):
+        # two overlapping spheres give many intersecting facet pairs spread over the grid
+        self.mesh = Mesh.createSphere(1.0, 60)
+        other = Mesh.createSphere(1.0, 60)
+        other.translate(0.5, 0.2, 0.1)
+        self.mesh.addMesh(other)
+
+    def testParallelAgainstSerial(self):
+        serial = [(i[0], i[1]) for i in self.mesh.getSelfIntersections(1)]
+        parallel = [(i[0], i[1]) for i in self.mesh.getSelfIntersections(4)]
+        self.failUnless(len(serial) > 0)
+        self.failUnless(len(set(parallel)) == len(parallel), "Duplicate facet pairs")
+        self.failUnless(all(i[0] < i[1] for i in parallel))
+        self.failUnless(sorted(serial) == sorted(parallel))
+        self.failUnless(self.mesh.hasSelfIntersections())
+
+    def testNoIntersections(self):
+        mesh = Mesh.createSphere(1.0, 60)
+        self.failUnless(len(mesh.getSelfIntersections(4)) == 0)
+        self.failIf(mesh.hasSelfIntersections())
+
+
+class MeshDecimationCases(unittest.TestCase):
+    def testDecimateSphere(self):
+        mesh = Mesh.createSphere(10.0, 100)
+        count = mesh.CountFacets
+        mesh.decimate(count // 4)
+        self.failUnless(mesh.CountFacets <= count // 4)
+        self.failUnless(mesh.isSolid())
+        self.failIf(mesh.hasNonManifolds())
+
+
+class MeshTransformCases(unittest.TestCase):
+    def testTransformLarge(self):
+        # a large mesh is transformed in blocks by several threads
+        mesh = Mesh.createSphere(10.0, 800)
+        mat = FreeCAD.Matrix()
+        mat.scale(2.0, 3.0, 4.0)
+        mat.rotateZ(0.5)
+        mat.move(FreeCAD.Vector(1, 2, 3))
+        points = mesh.Points
+        start = time.time()
+        mesh.transform(mat)
+        FreeCAD.Console.PrintMessage("Transform %d points: %.3fs\n" % (mesh.CountPoints, time.time() - start))
+        start = time.time()
+        box = mesh.BoundBox
+        FreeCAD.Console.PrintMessage("Bounding box of %d points: %.3fs\n" % (mesh.CountPoints, time.time() - start))
+
+        moved = [p.Vector for p in mesh.Points]
+        for i in range(0, len(points), 97):
+            self.failUnless((moved[i] - mat.multiply(points[i].Vector)).Length < 1e-4)
+        self.failUnless(math.fabs(box.XMin - min(v.x for v in moved)) < 1e-4)
+        self.failUnless(math.fabs(box.XMax - max(v.x for v in moved)) < 1e-4)
+        self.failUnless(math.fabs(box.YMin - min(v.y for v in moved)) < 1e-4)
+        self.failUnless(math.fabs(box.YMax - max(v.y for v in moved)) < 1e-4)
+        self.failUnless(math.fabs(box.ZMin - min(v.z for v in moved)) < 1e-4)
+        self.failUnless(math.fabs(box.ZMax - max(v.z for v in moved)) < 1e-4)
+
+
+class MeshUndoCases(unittest.TestCase):
+    def setUp(self):
+        self.doc = FreeCAD.newDocument("MeshUndoTest")
+        self.doc.UndoMode = 1
+
+    def testUndoEditedMesh(self):
+        # the undo stack shares the mesh with the property until it is modified
+        self.doc.openTransaction("Create")
+        feature = self.doc.addObject("Mesh::Feature", "Mesh")
+        feature.Mesh = Mesh.createSphere(10.0, 400)
+        self.doc.commitTransaction()
+        normal = feature.Mesh.Facets[0].Normal
+        mesh = feature.Mesh
+
+        self.doc.openTransaction("Flip")
+        start = time.time()
+        mesh.flipNormals()
+        self.doc.commitTransaction()
+        FreeCAD.Console.PrintMessage("Flip %d facets in a transaction: %.3fs\n" % (mesh.CountFacets, time.time() - start))
+        self.failUnless((feature.Mesh.Facets[0].Normal + normal).Length < 1e-6)
+        self.failUnless((mesh.Facets[0].Normal + normal).Length < 1e-6)
+        self.failUnless(self.doc.UndoRedoMemSize > 0)
+
+        self.doc.undo()
+        self.failUnless((feature.Mesh.Facets[0].Normal - normal).Length < 1e-6)
+        self.doc.redo()
+        self.failUnless((feature.Mesh.Facets[0].Normal + normal).Length < 1e-6)
+
+    def testUndoMovedPoints(self):
+        # the undo stack only keeps the moved points of the shared mesh
+        self.doc.openTransaction("Create")
+        feature = self.doc.addObject("Mesh::Feature", "Mesh")
+        feature.Mesh = Mesh.createSphere(10.0, 400)
+        self.doc.commitTransaction()
+        mesh = feature.Mesh
+        pnt0 = mesh.Points[0].Vector
+        pnt1 = mesh.Points[1].Vector
+        size = self.doc.UndoRedoMemSize
+
+        self.doc.openTransaction("Move 1")
+        mesh.setPoint(0, pnt0 + FreeCAD.Vector(1,0,0))
+        self.doc.commitTransaction()
+        self.doc.openTransaction("Move 2")
+        mesh.setPoint(0, pnt0 + FreeCAD.Vector(2,0,0))
+        mesh.setPoint(1, pnt1 + FreeCAD.Vector(2,0,0))
+        self.doc.commitTransaction()
+        self.failUnless(self.doc.UndoRedoMemSize - size < 1000)
+        self.failUnless(abs((feature.Mesh.Points[0].Vector - pnt0).Length - 2) < 1e-4)
+
+        self.doc.undo()
+        self.failUnless(abs((feature.Mesh.Points[0].Vector - pnt0).Length - 1) < 1e-4)
+        self.failUnless((feature.Mesh.Points[1].Vector - pnt1).Length < 1e-6)
+        self.doc.undo()
+        self.failUnless((feature.Mesh.Points[0].Vector - pnt0).Length < 1e-6)
+        self.doc.redo()
+        self.doc.redo()
+        self.failUnless(abs((feature.Mesh.Points[0].Vector - pnt0).Length - 2) < 1e-4)
+        self.failUnless(abs((feature.Mesh.Points[1].Vector - pnt1).Length - 2) < 1e-4)
+
+    def tearDown(self):
+        FreeCAD.closeDocument("MeshUndoTest")
+
 class PolynomialFitCases(unittest.TestCase):
     def setUp(self):
         pass
@@ -25,6 +25,7 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <vector>
 # ifdef FC_OS_MACOSX
 # include <OpenGL/gl.h>
 # include <OpenGL/glu.h>
@@ -34,13 +35,19 @@
 # endif
 # include <Inventor/actions/SoGLRenderAction.h>
 # include <Inventor/bundles/SoMaterialBundle.h>
+# include <Inventor/bundles/SoTextureCoordinateBundle.h>
+# include <Inventor/caches/SoNormalCache.h>
+# include <Inventor/elements/SoCacheElement.h>
 # include <Inventor/elements/SoCoordinateElement.h>
+# include <Inventor/elements/SoGLCacheContextElement.h>
 # include <Inventor/elements/SoGLCoordinateElement.h>
 # include <Inventor/elements/SoMaterialBindingElement.h>
+# include <Inventor/elements/SoNormalBindingElement.h>
 # include <Inventor/elements/SoProjectionMatrixElement.h>
 # include <Inventor/elements/SoViewingMatrixElement.h>
 #endif
 
+#include <Gui/GLBuffer.h>
 #include <Gui/SoFCInteractiveElement.h>
 #include <Gui/SoFCSelectionAction.h>
 #include "SoFCIndexedFaceSet.h"
@@ -55,12 +62,29 @@ void SoFCIndexedFaceSet::initClass()
     SO_NODE_INIT_CLASS(SoFCIndexedFaceSet, SoIndexedFaceSet, "IndexedFaceSet");
 }
 
-SoFCIndexedFaceSet::SoFCIndexedFaceSet() : renderTriangleLimit(100000), selectBuf(0)
+SoFCIndexedFaceSet::SoFCIndexedFaceSet()
+  : renderTriangleLimit(100000)
+  , useVBO(false)
+  , selectBuf(0)
+  , vertexBuffer(new Gui::OpenGLBuffer(GL_ARRAY_BUFFER))
+  , indexBuffer(new Gui::OpenGLBuffer(GL_ELEMENT_ARRAY_BUFFER))
+  , vboCoordId(0)
+  , vboNodeId(0)
+  , vboNormalCache(0)
+  , vboFailed(false)
 {
     SO_NODE_CONSTRUCTOR(SoFCIndexedFaceSet);
     setName(SoFCIndexedFaceSet::getClassTypeId().getName());
 }
 
+SoFCIndexedFaceSet::~SoFCIndexedFaceSet()
+{
+    delete vertexBuffer;
+    delete indexBuffer;
+    if (vboNormalCache)
+        vboNormalCache->unref();
+}
+
 /**
  * Either renders the complete mesh or only a subset of the points.
  */
@@ -77,7 +101,8 @@ void SoFCIndexedFaceSet::GLRender(SoGLRenderAction *action)
 
     unsigned int num = this->coordIndex.getNum()/4;
     if (mode == false || num <= this->renderTriangleLimit) {
-        inherited::GLRender(action);
+        if (!useVBO || !drawFacesVBO(action))
+            inherited::GLRender(action);
     }
     else {
         SoMaterialBindingElement::Binding matbind =
@@ -111,6 +136,193 @@ void SoFCIndexedFaceSet::GLRender(SoGLRenderAction *action)
     }
 }
 
+/**
+ * Renders all triangles from vertex buffer objects. The buffers are filled once and
+ * only rebuilt if this node, the coordinates or the normals have changed. Returns false
+ * if the mesh must be rendered by the base class, i.e. if buffer objects are not supported,
+ * the graphics card has not enough memory or there are textures or a material binding
+ * other than OVERALL.
+ */
+bool SoFCIndexedFaceSet::drawFacesVBO(SoGLRenderAction *action)
+{
+    SoState * state = action->getState();
+    // a buffer object cannot be part of a display list
+    if (SoCacheElement::anyOpen(state))
+        return false;
+    if (SoMaterialBindingElement::get(state) != SoMaterialBindingElement::OVERALL)
+        return false;
+    uint32_t context = action->getCacheContext();
+    if (!Gui::OpenGLBuffer::isVBOSupported(context))
+        return false;
+
+    SoMaterialBundle mb(action);
+    SoTextureCoordinateBundle tb(action, true, false);
+    if (tb.needCoordinates())
+        return false;
+    SbBool sendNormals = !mb.isColorOnly() || tb.isFunction();
+
+    const SoCoordinateElement * coords;
+    const SbVec3f * normals;
+    const int32_t * cindices;
+    int numindices;
+    const int32_t * nindices;
+    const int32_t * tindices;
+    const int32_t * mindices;
+    SbBool normalCacheUsed;
+
+    this->getVertexData(state, coords, normals, cindices,
+                        nindices, tindices, mindices, numindices,
+                        sendNormals, normalCacheUsed);
+
+    // only the normals generated by Coin are handled
+    if (sendNormals && !normalCacheUsed)
+        return false;
+    if (!sendNormals)
+        normals = 0;
+
+    // The normal cache is kept referenced so that a newly generated cache can never
+    // get the address of the one the buffers were built from
+    SoNormalCache * nc = normals ? this->getNormalCache() : 0;
+    if (coords->getNodeId() != vboCoordId || this->getNodeId() != vboNodeId ||
+        nc != vboNormalCache || (nc && !nc->isValid(state))) {
+        vertexBuffer->destroy();
+        indexBuffer->destroy();
+        vboCoordId = coords->getNodeId();
+        vboNodeId = this->getNodeId();
+        if (nc)
+            nc->ref();
+        if (vboNormalCache)
+            vboNormalCache->unref();
+        vboNormalCache = nc;
+        vboFailed = false;
+    }
+
+    if (vboFailed)
+        return false;
+
+    vertexBuffer->setCurrentContext(context);
+    indexBuffer->setCurrentContext(context);
+    if (!vertexBuffer->isCreated() || !indexBuffer->isCreated()) {
+        const SbVec3f * coords3d = coords->getArrayPtr3();
+        int numcoords = coords->getNum();
+        int numfaces = numindices/4;
+
+        // the normals are either indexed for each corner, one per point or one per face.
+        // The binding decides because the number of normals is ambiguous if there are
+        // as many points as faces.
+        bool perCorner = false, perPoint = false, perFace = false;
+        if (normals) {
+            switch (SoNormalBindingElement::get(state)) {
+            case SoNormalBindingElement::PER_FACE:
+            case SoNormalBindingElement::PER_FACE_INDEXED:
+                perFace = nc->getNum() == numfaces;
+                break;
+            case SoNormalBindingElement::PER_VERTEX:
+            case SoNormalBindingElement::PER_VERTEX_INDEXED:
+                if (nindices)
+                    perCorner = true;
+                else
+                    perPoint = nc->getNum() == numcoords;
+                break;
+            default:
+                break;
+            }
+            if (!perCorner && !perPoint && !perFace)
+                vboFailed = true;
+        }
+
+        // the mesh must only consist of triangles
+        for (int i=0; i<numfaces && !vboFailed; i++) {
+            if (cindices[4*i+3] >= 0)
+                vboFailed = true;
+        }
+        if (vboFailed || numindices % 4 != 0) {
+            vboFailed = true;
+            return false;
+        }
+
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        indices.reserve(3*numfaces);
+        if (!perCorner && !perFace) {
+            // share the vertices of adjacent triangles
+            vertices.reserve(6*numcoords);
+            for (int i=0; i<numcoords; i++) {
+                const SbVec3f& v = coords3d[i];
+                const SbVec3f n = perPoint ? normals[i] : SbVec3f(0,0,1);
+                vertices.push_back(v[0]); vertices.push_back(v[1]); vertices.push_back(v[2]);
+                vertices.push_back(n[0]); vertices.push_back(n[1]); vertices.push_back(n[2]);
+            }
+            for (int i=0; i<numfaces; i++) {
+                indices.push_back(cindices[4*i]);
+                indices.push_back(cindices[4*i+1]);
+                indices.push_back(cindices[4*i+2]);
+            }
+        }
+        else {
+            // a vertex is shared by all corners with the same point and normal
+            typedef std::pair<std::pair<int32_t, int32_t>, uint32_t> Corner;
+            std::vector<Corner> corners;
+            corners.reserve(3*numfaces);
+            for (int i=0; i<numfaces; i++) {
+                for (int j=0; j<3; j++) {
+                    int32_t n = perCorner ? nindices[4*i+j] : i;
+                    corners.push_back(Corner(std::make_pair(cindices[4*i+j], n), 3*i+j));
+                }
+            }
+            std::sort(corners.begin(), corners.end());
+
+            indices.resize(3*numfaces);
+            uint32_t vertex = 0;
+            for (std::vector<Corner>::iterator it = corners.begin(); it != corners.end(); ++it) {
+                if (it == corners.begin() || it->first != (it-1)->first) {
+                    const SbVec3f& v = coords3d[it->first.first];
+                    const SbVec3f& n = normals[it->first.second];
+                    vertices.push_back(v[0]); vertices.push_back(v[1]); vertices.push_back(v[2]);
+                    vertices.push_back(n[0]); vertices.push_back(n[1]); vertices.push_back(n[2]);
+                    vertex = static_cast<uint32_t>(vertices.size()/6 - 1);
+                }
+                indices[it->second] = vertex;
+            }
+        }
+
+        if (vertices.empty() || indices.empty() ||
+            !vertexBuffer->allocate(&vertices[0], vertices.size() * sizeof(float)) ||
+            !indexBuffer->allocate(&indices[0], indices.size() * sizeof(uint32_t))) {
+            vertexBuffer->destroy();
+            indexBuffer->destroy();
+            vboFailed = true;
+            return false;
+        }
+    }
+
+    mb.sendFirst(); // make sure we have the correct material
+
+    // interleaved position and normal
+    const GLsizei stride = 6 * sizeof(float);
+    vertexBuffer->bind();
+    indexBuffer->bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, 0);
+    if (normals) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(3 * sizeof(float)));
+    }
+
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexBuffer->size() / sizeof(uint32_t)),
+                   GL_UNSIGNED_INT, 0);
+
+    if (normals)
+        glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    indexBuffer->release();
+    vertexBuffer->release();
+
+    // the parent nodes must not put the buffer objects into a display list
+    SoGLCacheContextElement::shouldAutoCache(state, SoGLCacheContextElement::DONT_AUTO_CACHE);
+    return true;
+}
+
 void SoFCIndexedFaceSet::drawCoords(const SoGLCoordinateElement * const vertexlist,
                                     const int32_t *vertexindices,
                                     int numindices,
@@ -28,6 +28,9 @@
 
 class SoGLCoordinateElement;
 class SoTextureCoordinateBundle;
+class SoNormalCache;
+
+namespace Gui { class OpenGLBuffer; }
 
 typedef unsigned int GLuint;
 typedef int GLint;
@@ -40,6 +43,10 @@ namespace MeshGui {
  * \brief The SoFCIndexedFaceSet class is designed to optimize redrawing a mesh
  * during user interaction.
  *
+ * If the graphics card supports vertex buffer objects and \a useVBO is true the
+ * vertices and triangles are uploaded once and drawn from the buffers as long as
+ * the node and its coordinates don't change.
+ *
  * @author Werner Mayer
  */
 class MeshGuiExport SoFCIndexedFaceSet : public SoIndexedFaceSet {
@@ -52,10 +59,11 @@ public:
     SoFCIndexedFaceSet();
 
     unsigned int renderTriangleLimit;
+    bool useVBO;
 
 protected:
     // Force using the reference count mechanism.
-    virtual ~SoFCIndexedFaceSet() {};
+    virtual ~SoFCIndexedFaceSet();
     virtual void GLRender(SoGLRenderAction *action);
     void drawCoords(const SoGLCoordinateElement * const vertexlist,
                     const int32_t *vertexindices,
@@ -71,6 +79,7 @@ protected:
     void doAction(SoAction * action);
 
 private:
+    bool drawFacesVBO(SoGLRenderAction *action);
     void startSelection(SoAction * action);
     void stopSelection(SoAction * action);
     void renderSelectionGeometry(const SbVec3f *);
@@ -79,6 +88,13 @@ private:
     void renderVisibleFaces(const SbVec3f *);
 
     GLuint *selectBuf;
+    // vertex buffer with interleaved positions and normals and the triangle indices
+    Gui::OpenGLBuffer *vertexBuffer;
+    Gui::OpenGLBuffer *indexBuffer;
+    SbUniqueId vboCoordId;
+    SbUniqueId vboNodeId;
+    SoNormalCache *vboNormalCache;
+    bool vboFailed;
 };
 
 } // namespace MeshGui
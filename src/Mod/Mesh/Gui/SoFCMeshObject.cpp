@@ -25,6 +25,7 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <cmath>
 # ifdef FC_OS_WIN32
 # include <windows.h>
 # endif
@@ -42,16 +43,28 @@
 # include <Inventor/actions/SoPickAction.h>
 # include <Inventor/actions/SoWriteAction.h>
 # include <Inventor/details/SoFaceDetail.h>
+# include <Inventor/elements/SoCacheElement.h>
+# include <Inventor/elements/SoGLCacheContextElement.h>
+# include <Inventor/elements/SoModelMatrixElement.h>
+# include <Inventor/elements/SoViewportRegionElement.h>
+# include <Inventor/elements/SoViewVolumeElement.h>
 # include <Inventor/errors/SoReadError.h>
 # include <Inventor/misc/SoState.h>
+# include <QAtomicInt>
+# include <QFuture>
+# include <QtConcurrentRun>
+# include <boost/shared_ptr.hpp>
 #endif
 
 #include "SoFCMeshObject.h"
 #include <Base/Console.h>
 #include <Base/Exception.h>
+#include <Gui/GLBuffer.h>
 #include <Gui/SoFCInteractiveElement.h>
 #include <Gui/SoFCSelectionAction.h>
 #include <Mod/Mesh/App/Core/Algorithm.h>
+#include <Mod/Mesh/App/Core/BVH.h>
+#include <Mod/Mesh/App/Core/Decimation.h>
 #include <Mod/Mesh/App/Core/MeshIO.h>
 #include <Mod/Mesh/App/Core/MeshKernel.h>
 #include <Mod/Mesh/App/Core/Elements.h>
@@ -332,7 +345,7 @@ SO_NODE_SOURCE(SoFCMeshPickNode);
 /*!
   Constructor.
 */
-SoFCMeshPickNode::SoFCMeshPickNode(void) : meshGrid(0)
+SoFCMeshPickNode::SoFCMeshPickNode(void) : meshBVH(0)
 {
     SO_NODE_CONSTRUCTOR(SoFCMeshPickNode);
 
@@ -344,7 +357,7 @@ SoFCMeshPickNode::SoFCMeshPickNode(void) : meshGrid(0)
 */
 SoFCMeshPickNode::~SoFCMeshPickNode()
 {
-    delete meshGrid;
+    delete meshBVH;
 }
 
 // Doc from superclass.
@@ -357,13 +370,9 @@ void SoFCMeshPickNode::notify(SoNotList *list)
 {
     SoField *f = list->getLastField();
     if (f == &mesh) {
-        const Mesh::MeshObject* meshObject = mesh.getValue();
-        if (meshObject) {
-            MeshCore::MeshAlgorithm alg(meshObject->getKernel());
-            float fAvgLen = alg.GetAverageEdgeLength();
-            delete meshGrid;
-            meshGrid = new MeshCore::MeshFacetGrid(meshObject->getKernel(), 5.0f * fAvgLen);
-        }
+        // the hierarchy is rebuilt on the next pick only
+        delete meshBVH;
+        meshBVH = 0;
     }
 }
 
@@ -379,6 +388,10 @@ void SoFCMeshPickNode::pick(SoPickAction * action)
     raypick->setObjectSpace();
 
     const Mesh::MeshObject* meshObject = mesh.getValue();
+    if (!meshObject)
+        return;
+    if (!meshBVH)
+        meshBVH = new MeshCore::MeshFacetBVH(meshObject->getKernel());
     MeshCore::MeshAlgorithm alg(meshObject->getKernel());
 
     const SbLine& line = raypick->getLine();
@@ -387,7 +400,7 @@ void SoFCMeshPickNode::pick(SoPickAction * action)
     Base::Vector3f pt(pos[0],pos[1],pos[2]);
     Base::Vector3f dr(dir[0],dir[1],dir[2]);
     unsigned long index;
-    if (alg.NearestFacetOnRay(pt, dr, *meshGrid, pt, index)) {
+    if (alg.NearestFacetOnRay(pt, dr, *meshBVH, pt, index)) {
         SoPickedPoint* pp = raypick->addIntersection(SbVec3f(pt.x,pt.y,pt.z));
         if (pp) {
             SoFaceDetail* det = new SoFaceDetail();
@@ -581,6 +594,86 @@ inline SbVec3f sbvec3f(const Base::Vector3f& _v)
     return SbVec3f(_v.x, _v.y, _v.z); 
 }
 
+/**
+ * The LevelOfDetail class keeps decimated copies of a mesh that are rendered
+ * instead of the mesh while the user navigates. Each copy has a quarter of the
+ * facets of the previous one. They are computed in a worker thread, so the
+ * first frames after loading a mesh still show its points.
+ */
+class SoFCMeshObjectShape::LevelOfDetail
+{
+public:
+    struct Level {
+        boost::shared_ptr<MeshCore::MeshKernel> kernel;
+        // estimated distance to the original surface
+        float error;
+    };
+    struct Proxy {
+        Level level;
+        boost::shared_ptr<Gui::OpenGLBuffer> buffer;
+        bool failed;
+    };
+
+    LevelOfDetail() : meshId(0), pending(false)
+    {
+    }
+
+    /**
+     * Decimates \a kernel in place and returns a copy after each step until the
+     * mesh has not more than \a minSize facets. If \a cancel is set meanwhile an
+     * empty list is returned.
+     */
+    static std::vector<Level> createLevels(boost::shared_ptr<MeshCore::MeshKernel> kernel,
+                                           unsigned long minSize,
+                                           boost::shared_ptr<QAtomicInt> cancel)
+    {
+        std::vector<Level> levels;
+        float error = 0.0f;
+        unsigned long count = kernel->CountFacets();
+        while (count > minSize) {
+            MeshCore::MeshSimplify simplify(*kernel);
+            simplify.Simplify(count / 4, cancel.get());
+            if (cancel->fetchAndAddOrdered(0) != 0)
+                return std::vector<Level>();
+            unsigned long newCount = kernel->CountFacets();
+            // boundaries or degenerated regions block any further collapse
+            if (newCount > count - count / 10)
+                break;
+            error = std::max<float>(error, simplify.GetMaxError());
+            Level level;
+            level.kernel.reset(new MeshCore::MeshKernel(*kernel));
+            level.error = error;
+            levels.push_back(level);
+            count = newCount;
+        }
+        return levels;
+    }
+
+    /// Lets a running computation stop as soon as possible
+    void cancel()
+    {
+        if (cancelFlag)
+            cancelFlag->fetchAndStoreOrdered(1);
+    }
+
+    void releaseBuffers()
+    {
+        for (std::vector<Proxy>::iterator it = proxies.begin(); it != proxies.end(); ++it) {
+            it->buffer->destroy();
+            it->failed = false;
+        }
+    }
+
+    // ordered from fine to coarse
+    std::vector<Proxy> proxies;
+    QFuture< std::vector<Level> > future;
+    // shared with the running computation that may outlive the node
+    boost::shared_ptr<QAtomicInt> cancelFlag;
+    SbUniqueId meshId;
+    // the mesh has changed while a computation was running
+    bool pending;
+};
+
 SO_NODE_SOURCE(SoFCMeshObjectShape);
 
 void SoFCMeshObjectShape::initClass()
@@ -590,13 +683,29 @@ void SoFCMeshObjectShape::initClass()
 
 SoFCMeshObjectShape::SoFCMeshObjectShape()
     : renderTriangleLimit(100000)
+    , useVBO(false)
+    , useLevelOfDetail(true)
     , meshChanged(true)
     , selectBuf(0)
+    , vertexBuffer(new Gui::OpenGLBuffer(GL_ARRAY_BUFFER))
+    , vboMeshId(0)
+    , vboNodeId(0)
+    , vboCCW(true)
+    , vboFailed(false)
+    , lod(new LevelOfDetail)
 {
     SO_NODE_CONSTRUCTOR(SoFCMeshObjectShape);
     setName(SoFCMeshObjectShape::getClassTypeId().getName());
 }
 
+SoFCMeshObjectShape::~SoFCMeshObjectShape()
+{
+    delete vertexBuffer;
+    // a running decimation is not waited for, it works on its own copy
+    lod->cancel();
+    delete lod;
+}
+
 void SoFCMeshObjectShape::notify(SoNotList * node)
 {
     inherited::notify(node);
@@ -604,7 +713,8 @@ void SoFCMeshObjectShape::notify(SoNotList * node)
 }
 
 /**
- * Either renders the complete mesh or only a subset of the points.
+ * Either renders the complete mesh or, while navigating, a decimated copy of it or
+ * only a subset of the points.
  */
 void SoFCMeshObjectShape::GLRender(SoGLRenderAction *action)
 {
@@ -633,13 +743,28 @@ void SoFCMeshObjectShape::GLRender(SoGLRenderAction *action)
         if (SoShapeHintsElement::getVertexOrdering(state) == SoShapeHintsElement::CLOCKWISE) 
             ccw = false;
 
+        SbUniqueId meshId = SoFCMeshObjectElement::getInstance(state)->getNodeId();
+        if (meshId != vboMeshId || this->getNodeId() != vboNodeId || ccw != vboCCW) {
+            vertexBuffer->destroy();
+            lod->releaseBuffers();
+            vboMeshId = meshId;
+            vboNodeId = this->getNodeId();
+            vboCCW = ccw;
+            vboFailed = false;
+        }
+
+        if (useLevelOfDetail && mesh->countFacets() > this->renderTriangleLimit)
+            updateLevelOfDetail(state, mesh);
+
         if (mode == false || mesh->countFacets() <= this->renderTriangleLimit) {
+            const MeshCore::MeshKernel& kernel = mesh->getKernel();
             if (mbind != OVERALL)
-                drawFaces(mesh, &mb, mbind, needNormals, ccw);
-            else
-                drawFaces(mesh, 0, mbind, needNormals, ccw);
+                drawFaces(kernel, &mb, mbind, needNormals, ccw);
+            else if (!useVBO || !drawFacesVBO(action, kernel, vertexBuffer, vboFailed, needNormals, ccw))
+                drawFaces(kernel, 0, mbind, needNormals, ccw);
         }
-        else {
+        else if (mbind != OVERALL || !useLevelOfDetail ||
+                 !drawLevelOfDetail(action, mesh, needNormals, ccw)) {
             drawPoints(mesh, needNormals, ccw);
         }
 
@@ -648,6 +773,179 @@ void SoFCMeshObjectShape::GLRender(SoGLRenderAction *action)
     }
 }
 
+/**
+ * Renders the triangles of \a kernel from the vertex buffer object \a buffer. The
+ * buffer is filled once and the caller must destroy it if the mesh has changed. If
+ * the graphics card doesn't support buffer objects or has not enough memory false is
+ * returned and the caller must use drawFaces() instead. In the latter case \a failed
+ * is set to avoid further attempts.
+ */
+bool SoFCMeshObjectShape::drawFacesVBO(SoGLRenderAction *action, const MeshCore::MeshKernel& kernel,
+                                       Gui::OpenGLBuffer *buffer, bool& failed,
+                                       SbBool needNormals, SbBool ccw)
+{
+    SoState* state = action->getState();
+    // a buffer object cannot be part of a display list
+    if (SoCacheElement::anyOpen(state))
+        return false;
+    uint32_t context = action->getCacheContext();
+    if (!Gui::OpenGLBuffer::isVBOSupported(context))
+        return false;
+
+    if (failed)
+        return false;
+
+    buffer->setCurrentContext(context);
+    if (!buffer->isCreated()) {
+        const MeshCore::MeshPointArray & rPoints = kernel.GetPoints();
+        const MeshCore::MeshFacetArray & rFacets = kernel.GetFacets();
+        if (!buffer->allocate(0, rFacets.size() * 18 * sizeof(float))) {
+            failed = true;
+            return false;
+        }
+
+        // upload in blocks to keep the temporary memory small for huge meshes
+        const std::size_t blockSize = 18 * 65536;
+        std::vector<float> block;
+        block.reserve(blockSize);
+        std::size_t offset = 0;
+        float sign = ccw ? 1.0f : -1.0f;
+        for (MeshCore::MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+            const MeshCore::MeshPoint& v0 = rPoints[it->_aulPoints[0]];
+            const MeshCore::MeshPoint& v1 = rPoints[it->_aulPoints[1]];
+            const MeshCore::MeshPoint& v2 = rPoints[it->_aulPoints[2]];
+
+            // Calculate the normal n = (v1-v0)x(v2-v0)
+            float n[3];
+            n[0] = sign*((v1.y-v0.y)*(v2.z-v0.z)-(v1.z-v0.z)*(v2.y-v0.y));
+            n[1] = sign*((v1.z-v0.z)*(v2.x-v0.x)-(v1.x-v0.x)*(v2.z-v0.z));
+            n[2] = sign*((v1.x-v0.x)*(v2.y-v0.y)-(v1.y-v0.y)*(v2.x-v0.x));
+
+            const MeshCore::MeshPoint* v[3] = {&v0, &v1, &v2};
+            for (int i=0; i<3; i++) {
+                block.push_back(v[i]->x);
+                block.push_back(v[i]->y);
+                block.push_back(v[i]->z);
+                block.push_back(n[0]);
+                block.push_back(n[1]);
+                block.push_back(n[2]);
+            }
+
+            if (block.size() == blockSize) {
+                buffer->write(offset, &block[0], block.size() * sizeof(float));
+                offset += block.size() * sizeof(float);
+                block.clear();
+            }
+        }
+
+        if (!block.empty())
+            buffer->write(offset, &block[0], block.size() * sizeof(float));
+    }
+
+    // interleaved position and normal
+    const GLsizei stride = 6 * sizeof(float);
+    buffer->bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, 0);
+    if (needNormals) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(3 * sizeof(float)));
+    }
+
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(buffer->size() / stride));
+
+    if (needNormals)
+        glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    buffer->release();
+
+    // the parent nodes must not put the buffer object into a display list
+    SoGLCacheContextElement::shouldAutoCache(state, SoGLCacheContextElement::DONT_AUTO_CACHE);
+    return true;
+}
+
+/**
+ * Starts the computation of the decimated copies if the mesh has changed and takes
+ * over the result of a finished computation. There is at most one computation per
+ * node. If the mesh changes meanwhile the running computation is cancelled and the
+ * next one is started once it has stopped.
+ */
+void SoFCMeshObjectShape::updateLevelOfDetail(SoState *state, const Mesh::MeshObject * mesh)
+{
+    SbUniqueId meshId = SoFCMeshObjectElement::getInstance(state)->getNodeId();
+    if (meshId != lod->meshId) {
+        lod->proxies.clear();
+        lod->meshId = meshId;
+        lod->cancel();
+        lod->pending = true;
+    }
+
+    if (!lod->future.isFinished())
+        return;
+
+    if (lod->pending) {
+        lod->pending = false;
+        // the worker must not access the mesh as it can be modified meanwhile
+        boost::shared_ptr<MeshCore::MeshKernel> copy(new MeshCore::MeshKernel(mesh->getKernel()));
+        unsigned long minSize = this->renderTriangleLimit / 4;
+        lod->cancelFlag.reset(new QAtomicInt(0));
+        lod->future = QtConcurrent::run(&LevelOfDetail::createLevels, copy, minSize, lod->cancelFlag);
+    }
+    else if (!lod->future.isCanceled()) {
+        std::vector<LevelOfDetail::Level> levels = lod->future.result();
+        // a default constructed future is canceled
+        lod->future = QFuture< std::vector<LevelOfDetail::Level> >();
+        for (std::vector<LevelOfDetail::Level>::iterator it = levels.begin(); it != levels.end(); ++it) {
+            LevelOfDetail::Proxy proxy;
+            proxy.level = *it;
+            proxy.buffer.reset(new Gui::OpenGLBuffer(GL_ARRAY_BUFFER));
+            proxy.failed = false;
+            lod->proxies.push_back(proxy);
+        }
+    }
+}
+
+/**
+ * Renders the coarsest decimated copy whose error is not larger than two pixels at
+ * the center of the mesh. A copy with more triangles than renderTriangleLimit is
+ * never used. If no copy is available false is returned.
+ */
+bool SoFCMeshObjectShape::drawLevelOfDetail(SoGLRenderAction *action, const Mesh::MeshObject * mesh,
+                                            SbBool needNormals, SbBool ccw)
+{
+    if (lod->proxies.empty())
+        return false;
+
+    // size of a pixel in world coordinates at the center of the mesh
+    SoState* state = action->getState();
+    const SbMatrix& mat = SoModelMatrixElement::get(state);
+    const SbViewVolume& vv = SoViewVolumeElement::get(state);
+    const SbViewportRegion& vp = SoViewportRegionElement::get(state);
+    Base::BoundBox3f bbox = mesh->getKernel().GetBoundBox();
+    SbVec3f center(0.5f*(bbox.MinX+bbox.MaxX), 0.5f*(bbox.MinY+bbox.MaxY), 0.5f*(bbox.MinZ+bbox.MaxZ));
+    mat.multVecMatrix(center, center);
+    short height = std::max<short>(vp.getViewportSizePixels()[1], 1);
+    float pixel = vv.getWorldToScreenScale(center, 1.0f) / height;
+    // the errors are given in model coordinates
+    float scale = std::pow(std::fabs(mat.det3()), 1.0f/3.0f);
+
+    LevelOfDetail::Proxy* proxy = 0;
+    for (std::vector<LevelOfDetail::Proxy>::iterator it = lod->proxies.begin(); it != lod->proxies.end(); ++it) {
+        if (it->level.kernel->CountFacets() > this->renderTriangleLimit)
+            continue;
+        if (!proxy || it->level.error * scale <= 2.0f * pixel)
+            proxy = &(*it);
+    }
+
+    if (!proxy)
+        return false;
+
+    const MeshCore::MeshKernel& kernel = *proxy->level.kernel;
+    if (!useVBO || !drawFacesVBO(action, kernel, proxy->buffer.get(), proxy->failed, needNormals, ccw))
+        drawFaces(kernel, 0, OVERALL, needNormals, ccw);
+    return true;
+}
+
 /**
  * Translates current material binding into the internal Binding enum.
  */
@@ -685,11 +983,11 @@ SoFCMeshObjectShape::Binding SoFCMeshObjectShape::findMaterialBinding(SoState *
  * FIXME: Do it the same way as Coin did to have only one implementation which is controled by defines
  * FIXME: Implement using different values of transparency for each vertex or face
  */
-void SoFCMeshObjectShape::drawFaces(const Mesh::MeshObject * mesh, SoMaterialBundle* mb,
+void SoFCMeshObjectShape::drawFaces(const MeshCore::MeshKernel& kernel, SoMaterialBundle* mb,
                                     Binding bind, SbBool needNormals, SbBool ccw) const
 {
-    const MeshCore::MeshPointArray & rPoints = mesh->getKernel().GetPoints();
-    const MeshCore::MeshFacetArray & rFacets = mesh->getKernel().GetFacets();
+    const MeshCore::MeshPointArray & rPoints = kernel.GetPoints();
+    const MeshCore::MeshFacetArray & rFacets = kernel.GetFacets();
     bool perVertex = (mb && bind == PER_VERTEX_INDEXED);
     bool perFace = (mb && bind == PER_FACE_INDEXED);
 
@@ -38,7 +38,8 @@ typedef unsigned int GLuint;
 typedef int GLint;
 typedef float GLfloat;
 
-namespace MeshCore { class MeshFacetGrid; }
+namespace MeshCore { class MeshFacetBVH; }
+namespace Gui { class OpenGLBuffer; }
 
 namespace MeshGui {
 
@@ -93,7 +94,7 @@ protected:
     virtual ~SoFCMeshPickNode();
 
 private:
-    MeshCore::MeshFacetGrid* meshGrid;
+    MeshCore::MeshFacetBVH* meshBVH;
 };
 
 // -------------------------------------------------------
@@ -158,6 +159,10 @@ protected:
  * SoFCInteractiveElement to \a true if there is a user interation and set the status to
  * \a false if not. This can be done e.g. in the actualRedraw() method of the viewer.
  *
+ * If the graphics card supports vertex buffer objects and \a useVBO is true the complete
+ * mesh is uploaded once and drawn from the buffer as long as the mesh doesn't change.
+ * Otherwise, or if the mesh is colored per face or vertex, it is rendered in immediate mode.
+ *
  * @author Werner Mayer
  */
 class MeshGuiExport SoFCMeshObjectShape : public SoShape {
@@ -170,6 +175,9 @@ public:
     SoFCMeshObjectShape();
 
     unsigned int renderTriangleLimit;
+    bool useVBO;
+    /// Render decimated copies of a huge mesh while navigating
+    bool useLevelOfDetail;
 
 protected:
     virtual void doAction(SoAction * action);
@@ -194,13 +202,20 @@ private:
 
 private:
     // Force using the reference count mechanism.
-    virtual ~SoFCMeshObjectShape() {};
+    virtual ~SoFCMeshObjectShape();
     virtual void notify(SoNotList * list);
     Binding findMaterialBinding(SoState * const state) const;
     // Draw faces
-    void drawFaces(const Mesh::MeshObject *, SoMaterialBundle* mb, Binding bind, 
+    void drawFaces(const MeshCore::MeshKernel&, SoMaterialBundle* mb, Binding bind, 
                    SbBool needNormals, SbBool ccw) const;
+    bool drawFacesVBO(SoGLRenderAction *action, const MeshCore::MeshKernel&,
+                      Gui::OpenGLBuffer *buffer, bool& failed,
+                      SbBool needNormals, SbBool ccw);
     void drawPoints(const Mesh::MeshObject *, SbBool needNormals, SbBool ccw) const;
+    // Level of detail
+    void updateLevelOfDetail(SoState *state, const Mesh::MeshObject *);
+    bool drawLevelOfDetail(SoGLRenderAction *action, const Mesh::MeshObject *,
+                           SbBool needNormals, SbBool ccw);
     unsigned int countTriangles(SoAction * action) const;
 
     void startSelection(SoAction * action, const Mesh::MeshObject*);
@@ -212,6 +227,15 @@ private:
     GLuint *selectBuf;
     GLfloat modelview[16];
     GLfloat projection[16];
+    // vertex buffer with position and normal of the three corners of each facet
+    Gui::OpenGLBuffer *vertexBuffer;
+    SbUniqueId vboMeshId;
+    SbUniqueId vboNodeId;
+    SbBool vboCCW;
+    bool vboFailed;
+    // decimated copies of the mesh
+    class LevelOfDetail;
+    LevelOfDetail *lod;
 };
 
 class MeshGuiExport SoFCMeshSegmentShape : public SoShape {
@@ -1977,6 +1977,7 @@ void ViewProviderIndexedFaceSet::attach(App::DocumentObject *pcFeat)
     Base::Reference<ParameterGrp> hGrp = Gui::WindowParameter::getDefaultParameter()->GetGroup("Mod/Mesh");
     int size = hGrp->GetInt("RenderTriangleLimit", -1);
     if (size > 0) static_cast<SoFCIndexedFaceSet*>(pcMeshFaces)->renderTriangleLimit = (unsigned int)(pow(10.0f,size));
+    static_cast<SoFCIndexedFaceSet*>(pcMeshFaces)->useVBO = hGrp->GetBool("UseVBO", false);
 }
 
 void ViewProviderIndexedFaceSet::updateData(const App::Property* prop)
@@ -2064,6 +2065,8 @@ void ViewProviderMeshObject::attach(App::DocumentObject *pcFeat)
     Base::Reference<ParameterGrp> hGrp = Gui::WindowParameter::getDefaultParameter()->GetGroup("Mod/Mesh");
     int size = hGrp->GetInt("RenderTriangleLimit", -1);
     if (size > 0) pcMeshShape->renderTriangleLimit = (unsigned int)(pow(10.0f,size));
+    pcMeshShape->useVBO = hGrp->GetBool("UseVBO", false);
+    pcMeshShape->useLevelOfDetail = hGrp->GetBool("UseLevelOfDetail", true);
 }
 
 void ViewProviderMeshObject::updateData(const App::Property* prop)
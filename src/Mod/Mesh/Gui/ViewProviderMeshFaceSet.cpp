@@ -124,6 +124,11 @@ void ViewProviderMeshFaceSet::attach(App::DocumentObject *pcFeat)
         pcMeshShape->renderTriangleLimit = (unsigned int)(pow(10.0f,size));
         static_cast<SoFCIndexedFaceSet*>(pcMeshFaces)->renderTriangleLimit = (unsigned int)(pow(10.0f,size));
     }
+
+    bool vbo = hGrp->GetBool("UseVBO", false);
+    pcMeshShape->useVBO = vbo;
+    static_cast<SoFCIndexedFaceSet*>(pcMeshFaces)->useVBO = vbo;
+    pcMeshShape->useLevelOfDetail = hGrp->GetBool("UseLevelOfDetail", true);
 }
 
 void ViewProviderMeshFaceSet::updateData(const App::Property* prop)
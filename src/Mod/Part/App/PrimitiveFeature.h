@@ -45,6 +45,10 @@ public:
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
     PyObject* getPyObject();
+    /// the shape only depends on the own properties and the attachment support
+    virtual bool canRecomputeInParallel(void) const {
+        return true;
+    }
     //@}
 
 protected:
@@ -67,19 +67,79 @@
 
 using namespace Part;
 
+namespace Part {
+/*!
+ Stream buffer that reads the first bytes of a BRep file in advance to
+ determine its format, and then passes them on before the rest of the file.
+ */
+class BRepHeaderStreambuf : public std::streambuf
+{
+public:
+    BRepHeaderStreambuf(std::streambuf* buf)
+      : buf(buf), header(256)
+    {
+        std::streamsize size = buf->sgetn(&header[0], static_cast<std::streamsize>(header.size()));
+        header.resize(size > 0 ? static_cast<std::size_t>(size) : 0);
+        if (!header.empty())
+            setg(&header[0], &header[0], &header[0] + header.size());
+    }
+    bool isEmpty() const
+    {
+        return header.empty();
+    }
+    bool isBinary() const
+    {
+        // BinTools_ShapeSet writes 'Open CASCADE Topology V1 (c)'
+        return contains("Open CASCADE Topology");
+    }
+    bool isAscii() const
+    {
+        // BRepTools_ShapeSet writes 'CASCADE Topology V1, (c) Matra-Datavision'
+        return !isBinary() && contains("CASCADE Topology");
+    }
+
+protected:
+    virtual int_type underflow()
+    {
+        std::streamsize size = buf->sgetn(buffer, sizeof(buffer));
+        if (size <= 0)
+            return traits_type::eof();
+        setg(buffer, buffer, buffer + size);
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    bool contains(const char* text) const
+    {
+        std::string str(header.begin(), header.end());
+        return str.find(text) != std::string::npos;
+    }
+
+private:
+    std::streambuf* buf;
+    std::vector<char> header;
+    char buffer[4096];
+};
+}
+
 TYPESYSTEM_SOURCE(Part::PropertyPartShape , App::PropertyComplexGeoData);
 
 PropertyPartShape::PropertyPartShape()
+  : _LazyFile(0)
 {
 }
 
 PropertyPartShape::~PropertyPartShape()
 {
+    delete _LazyFile;
 }
 
 void PropertyPartShape::setValue(const TopoShape& sh)
 {
     aboutToSetValue();
+    // the shape is replaced, so there is no need to read in the old one
+    delete _LazyFile;
+    _LazyFile = 0;
     _Shape = sh;
     hasSetValue();
 }
@@ -87,27 +147,33 @@ void PropertyPartShape::setValue(const TopoShape& sh)
 void PropertyPartShape::setValue(const TopoDS_Shape& sh)
 {
     aboutToSetValue();
+    delete _LazyFile;
+    _LazyFile = 0;
     _Shape.setShape(sh);
     hasSetValue();
 }
 
 const TopoDS_Shape& PropertyPartShape::getValue(void)const 
 {
+    restoreLazyFile();
     return _Shape.getShape();
 }
 
 const TopoShape& PropertyPartShape::getShape() const
 {
+    restoreLazyFile();
     return this->_Shape;
 }
 
 const Data::ComplexGeoData* PropertyPartShape::getComplexData() const
 {
+    restoreLazyFile();
     return &(this->_Shape);
 }
 
 Base::BoundBox3d PropertyPartShape::getBoundingBox() const
 {
+    restoreLazyFile();
     Base::BoundBox3d box;
     if (_Shape.getShape().IsNull())
         return box;
@@ -134,6 +200,7 @@ Base::BoundBox3d PropertyPartShape::getBoundingBox() const
 
 void PropertyPartShape::transformGeometry(const Base::Matrix4D &rclTrf)
 {
+    restoreLazyFile();
     aboutToSetValue();
     _Shape.transformGeometry(rclTrf);
     hasSetValue();
@@ -141,6 +208,7 @@ void PropertyPartShape::transformGeometry(const Base::Matrix4D &rclTrf)
 
 PyObject *PropertyPartShape::getPyObject(void)
 {
+    restoreLazyFile();
     Base::PyObjectBase* prop;
     const TopoDS_Shape& sh = _Shape.getShape();
     if (sh.IsNull()) {
@@ -200,6 +268,7 @@ void PropertyPartShape::setPyObject(PyObject *value)
 
 App::Property *PropertyPartShape::Copy(void) const
 {
+    restoreLazyFile();
     PropertyPartShape *prop = new PropertyPartShape();
     prop->_Shape = this->_Shape;
     if (!_Shape.getShape().IsNull()) {
@@ -212,8 +281,12 @@ App::Property *PropertyPartShape::Copy(void) const
 
 void PropertyPartShape::Paste(const App::Property &from)
 {
+    const PropertyPartShape& prop = dynamic_cast<const PropertyPartShape&>(from);
+    prop.restoreLazyFile();
     aboutToSetValue();
-    _Shape = dynamic_cast<const PropertyPartShape&>(from)._Shape;
+    delete _LazyFile;
+    _LazyFile = 0;
+    _Shape = prop._Shape;
     hasSetValue();
 }
 
@@ -266,135 +339,96 @@ void PropertyPartShape::Restore(Base::XMLReader &reader)
 
 void PropertyPartShape::SaveDocFile (Base::Writer &writer) const
 {
+    restoreLazyFile();
     // If the shape is empty we simply store nothing. The file size will be 0 which
     // can be checked when reading in the data.
     if (_Shape.getShape().IsNull())
         return;
     // NOTE: Cleaning the triangulation may cause problems on some algorithms like BOP
     // Before writing to the project we clean all triangulation data to save memory
-    BRepBuilderAPI_Copy copy(_Shape.getShape());
-    const TopoDS_Shape& myShape = copy.Shape();
-    BRepTools::Clean(myShape); // remove triangulation
+    // unless the tessellation is requested to be kept. In this case the triangulation
+    // is stored together with the faces it belongs to, including the deflection it was
+    // created with, so that the view provider can reuse it when the file is opened.
+    TopoDS_Shape myShape = _Shape.getShape();
+    if (!writer.getMode("Tessellation")) {
+        BRepBuilderAPI_Copy copy(myShape);
+        myShape = copy.Shape();
+        BRepTools::Clean(myShape); // remove triangulation
+    }
 
+    // the shape is streamed directly into the archive
     if (writer.getMode("BinaryBrep")) {
         TopoShape shape;
         shape.setShape(myShape);
         shape.exportBinary(writer.Stream());
     }
     else {
-        bool direct = App::GetApplication().GetParameterGroupByPath
-            ("User parameter:BaseApp/Preferences/Mod/Part/General")->GetBool("DirectAccess", true);
-        if (!direct) {
-            // create a temporary file and copy the content to the zip stream
-            // once the tmp. filename is known use always the same because otherwise
-            // we may run into some problems on the Linux platform
-            static Base::FileInfo fi(App::Application::getTempFileName());
-
-            if (!BRepTools::Write(myShape,(const Standard_CString)fi.filePath().c_str())) {
-                // Note: Do NOT throw an exception here because if the tmp. file could
-                // not be created we should not abort.
-                // We only print an error message but continue writing the next files to the
-                // stream...
-                App::PropertyContainer* father = this->getContainer();
-                if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
-                    App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
-                    Base::Console().Error("Shape of '%s' cannot be written to BRep file '%s'\n", 
-                        obj->Label.getValue(),fi.filePath().c_str());
-                }
-                else {
-                    Base::Console().Error("Cannot save BRep file '%s'\n", fi.filePath().c_str());
-                }
-
-                std::stringstream ss;
-                ss << "Cannot save BRep file '" << fi.filePath() << "'";
-                writer.addError(ss.str());
-            }
-
-            Base::ifstream file(fi, std::ios::in | std::ios::binary);
-            if (file) {
-                //unsigned long ulSize = 0; 
-                std::streambuf* buf = file.rdbuf();
-                //if (buf) {
-                //    unsigned long ulCurr;
-                //    ulCurr = buf->pubseekoff(0, std::ios::cur, std::ios::in);
-                //    ulSize = buf->pubseekoff(0, std::ios::end, std::ios::in);
-                //    buf->pubseekoff(ulCurr, std::ios::beg, std::ios::in);
-                //}
-
-                // read in the ASCII file and write back to the stream
-                //std::strstreambuf sbuf(ulSize);
-                //file >> &sbuf;
-                //writer.Stream() << &sbuf;
-                writer.Stream() << buf;
-            }
-
-            file.close();
-            // remove temp file
-            fi.deleteFile();
-        }
-        else {
-            BRepTools::Write(myShape, writer.Stream());
-        }
+        BRepTools::Write(myShape, writer.Stream());
     }
 }
 
 void PropertyPartShape::RestoreDocFile(Base::Reader &reader)
 {
-    Base::FileInfo brep(reader.getFileName());
-    if (brep.hasExtension("bin")) {
+    TopoDS_Shape shape;
+    readShape(reader, shape);
+    setValue(shape);
+}
+
+bool PropertyPartShape::RestoreDocFileLazy(Base::LazyFile* file)
+{
+    delete _LazyFile;
+    _LazyFile = file;
+    return true;
+}
+
+void PropertyPartShape::restoreLazyFile() const
+{
+    // The shape is read in as if it had been restored together with the
+    // document, so no change is notified
+    Base::LazyFile::restoreOnce(_LazyFile, [this](Base::Reader& reader) {
+        TopoDS_Shape shape;
+        readShape(reader, shape);
+        const_cast<TopoShape&>(_Shape).setShape(shape);
+    });
+}
+
+void PropertyPartShape::readShape(Base::Reader &reader, TopoDS_Shape& result) const
+{
+    // The format is detected from the file content, so that it doesn't matter
+    // whether the shape was written in binary or ASCII format
+    BRepHeaderStreambuf buf(reader.rdbuf());
+    if (buf.isEmpty()) {
+        // an empty file means the stored shape was already empty
+        return;
+    }
+
+    std::istream str(&buf);
+    bool binary = buf.isBinary();
+    if (!binary && !buf.isAscii()) {
+        // unknown header, rely on the file name
+        Base::FileInfo brep(reader.getFileName());
+        binary = brep.hasExtension("bin");
+    }
+
+    if (binary) {
         TopoShape shape;
-        shape.importBinary(reader);
-        setValue(shape);
+        shape.importBinary(str);
+        result = shape.getShape();
     }
     else {
-        bool direct = App::GetApplication().GetParameterGroupByPath
-            ("User parameter:BaseApp/Preferences/Mod/Part/General")->GetBool("DirectAccess", true);
-        if (!direct) {
-            BRep_Builder builder;
-            // create a temporary file and copy the content from the zip stream
-            Base::FileInfo fi(App::Application::getTempFileName());
-
-            // read in the ASCII file and write back to the file stream
-            Base::ofstream file(fi, std::ios::out | std::ios::binary);
-            unsigned long ulSize = 0; 
-            if (reader) {
-                std::streambuf* buf = file.rdbuf();
-                reader >> buf;
-                file.flush();
-                ulSize = buf->pubseekoff(0, std::ios::cur, std::ios::in);
-            }
-            file.close();
-
-            // Read the shape from the temp file, if the file is empty the stored shape was already empty.
-            // If it's still empty after reading the (non-empty) file there must occurred an error.
-            TopoDS_Shape shape;
-            if (ulSize > 0) {
-                if (!BRepTools::Read(shape, (const Standard_CString)fi.filePath().c_str(), builder)) {
-                    // Note: Do NOT throw an exception here because if the tmp. created file could
-                    // not be read it's NOT an indication for an invalid input stream 'reader'.
-                    // We only print an error message but continue reading the next files from the
-                    // stream...
-                    App::PropertyContainer* father = this->getContainer();
-                    if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
-                        App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
-                        Base::Console().Error("BRep file '%s' with shape of '%s' seems to be empty\n", 
-                            fi.filePath().c_str(),obj->Label.getValue());
-                    }
-                    else {
-                        Base::Console().Warning("Loaded BRep file '%s' seems to be empty\n", fi.filePath().c_str());
-                    }
-                }
-            }
-
-            // delete the temp file
-            fi.deleteFile();
-            setValue(shape);
+        BRep_Builder builder;
+        BRepTools::Read(result, str, builder);
+    }
+
+    if (result.IsNull()) {
+        App::PropertyContainer* father = this->getContainer();
+        if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
+            App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
+            Base::Console().Error("BRep file '%s' with shape of '%s' seems to be empty\n",
+                reader.getFileName().c_str(),obj->Label.getValue());
         }
         else {
-            BRep_Builder builder;
-            TopoDS_Shape shape;
-            BRepTools::Read(shape, reader, builder);
-            setValue(shape);
+            Base::Console().Warning("Loaded BRep file '%s' seems to be empty\n", reader.getFileName().c_str());
         }
     }
 }
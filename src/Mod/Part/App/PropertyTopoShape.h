@@ -31,6 +31,10 @@
 #include <map>
 #include <vector>
 
+namespace Base {
+class LazyFile;
+}
+
 namespace Part
 {
 
@@ -82,6 +86,10 @@ public:
 
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
+    bool RestoreDocFileLazy(Base::LazyFile* file);
+    void restoreLazyFile() const;
+    bool hasLazyFile() const
+    { return _LazyFile != 0; }
 
     App::Property *Copy(void) const;
     void Paste(const App::Property &from);
@@ -91,8 +99,13 @@ public:
     /// Get valid paths for this property; used by auto completer
     virtual void getPaths(std::vector<App::ObjectIdentifier> & paths) const;
 
+private:
+    void readShape(Base::Reader &reader, TopoDS_Shape& shape) const;
+
 private:
     TopoShape _Shape;
+    /// file with the shape if it isn't read in yet
+    mutable Base::LazyFile* _LazyFile;
 };
 
 struct PartExport ShapeHistory {
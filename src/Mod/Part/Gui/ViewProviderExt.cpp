@@ -94,6 +94,8 @@
 # include <Inventor/nodes/SoLightModel.h>
 # include <QAction>
 # include <QMenu>
+# include <QtConcurrentMap>
+# include <boost/bind.hpp>
 #endif
 
 /// Here the FreeCAD includes sorted by Base,App,Gui......
@@ -125,6 +127,16 @@ using namespace PartGui;
 
 PROPERTY_SOURCE(PartGui::ViewProviderPartExt, Gui::ViewProviderGeometryObject)
 
+/// The triangulation of a face and the position of its nodes and triangles in the Inventor arrays
+struct ViewProviderPartExt::FaceTriangulation
+{
+    TopoDS_Face face;
+    TopLoc_Location loc;
+    Handle(Poly_Triangulation) mesh;
+    int nodeOffset;
+    int triaOffset;
+};
+
 
 void ViewProviderPartExt::GetNormals(const TopoDS_Face&  theFace,
              const Handle(Poly_Triangulation)& aPolyTri,
@@ -214,6 +226,112 @@ void ViewProviderPartExt::GetNormals(const TopoDS_Face&  theFace,
     }
 }
 
+bool ViewProviderPartExt::isMeshed(const TopoDS_Shape& shape, Standard_Real deflection)
+{
+    // The triangulation may have been restored from the project file. It's reused if it
+    // isn't coarser than requested, allowing a small tolerance for the stored value.
+    bool meshed = false;
+    TopExp_Explorer xp;
+    for (xp.Init(shape, TopAbs_FACE); xp.More(); xp.Next()) {
+        TopLoc_Location loc;
+        Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(TopoDS::Face(xp.Current()), loc);
+        if (mesh.IsNull() || mesh->Deflection() > deflection * (1.0 + 1e-6))
+            return false;
+        meshed = true;
+    }
+
+    // free edges need their own polygon
+    for (xp.Init(shape, TopAbs_EDGE, TopAbs_FACE); xp.More(); xp.Next()) {
+        TopLoc_Location loc;
+        if (BRep_Tool::Polygon3D(TopoDS::Edge(xp.Current()), loc).IsNull())
+            return false;
+    }
+
+    return meshed;
+}
+
+void ViewProviderPartExt::fillTriangulation(SbVec3f* verts, SbVec3f* norms, int32_t* index,
+                                            const FaceTriangulation* data)
+{
+    const TopoDS_Face &actFace = data->face;
+    const Handle(Poly_Triangulation) &mesh = data->mesh;
+    int faceNodeOffset = data->nodeOffset;
+    int faceTriaOffset = data->triaOffset;
+
+    // getting the transformation of the shape/face
+    gp_Trsf myTransf;
+    Standard_Boolean identity = true;
+    if (!data->loc.IsIdentity()) {
+        identity = false;
+        myTransf = data->loc.Transformation();
+    }
+
+    // getting size of node and triangle array of this face
+    int nbNodesInFace = mesh->NbNodes();
+    int nbTriInFace   = mesh->NbTriangles();
+    // check orientation
+    TopAbs_Orientation orient = actFace.Orientation();
+
+    // preset the normal vector with null vector
+    for (int i=0;i < nbNodesInFace;i++)
+        norms[faceNodeOffset+i]= SbVec3f(0.0,0.0,0.0);
+
+    // cycling through the poly mesh
+    const Poly_Array1OfTriangle& Triangles = mesh->Triangles();
+    const TColgp_Array1OfPnt& Nodes = mesh->Nodes();
+    TColgp_Array1OfDir Normals (Nodes.Lower(), Nodes.Upper());
+    GetNormals(actFace, mesh, Normals);
+
+    for (int g=1;g<=nbTriInFace;g++) {
+        // Get the triangle
+        Standard_Integer N1,N2,N3;
+        Triangles(g).Get(N1,N2,N3);
+
+        // change orientation of the triangle if the face is reversed
+        if ( orient != TopAbs_FORWARD ) {
+            Standard_Integer tmp = N1;
+            N1 = N2;
+            N2 = tmp;
+        }
+
+        // get the 3 points of this triangle
+        gp_Pnt V1(Nodes(N1)), V2(Nodes(N2)), V3(Nodes(N3));
+
+        // get the 3 normals of this triangle
+        gp_Dir NV1(Normals(N1)), NV2(Normals(N2)), NV3(Normals(N3));
+
+        // transform the vertices and normals to the place of the face
+        if(!identity) {
+            V1.Transform(myTransf);
+            V2.Transform(myTransf);
+            V3.Transform(myTransf);
+            NV1.Transform(myTransf);
+            NV2.Transform(myTransf);
+            NV3.Transform(myTransf);
+        }
+
+        // add the normals for all points of this triangle
+        norms[faceNodeOffset+N1-1] += SbVec3f(NV1.X(),NV1.Y(),NV1.Z());
+        norms[faceNodeOffset+N2-1] += SbVec3f(NV2.X(),NV2.Y(),NV2.Z());
+        norms[faceNodeOffset+N3-1] += SbVec3f(NV3.X(),NV3.Y(),NV3.Z());
+
+        // set the vertices
+        verts[faceNodeOffset+N1-1].setValue((float)(V1.X()),(float)(V1.Y()),(float)(V1.Z()));
+        verts[faceNodeOffset+N2-1].setValue((float)(V2.X()),(float)(V2.Y()),(float)(V2.Z()));
+        verts[faceNodeOffset+N3-1].setValue((float)(V3.X()),(float)(V3.Y()),(float)(V3.Z()));
+
+        // set the index vector with the 3 point indexes and the end delimiter
+        index[faceTriaOffset*4+4*(g-1)]   = faceNodeOffset+N1-1;
+        index[faceTriaOffset*4+4*(g-1)+1] = faceNodeOffset+N2-1;
+        index[faceTriaOffset*4+4*(g-1)+2] = faceNodeOffset+N3-1;
+        index[faceTriaOffset*4+4*(g-1)+3] = SO_END_FACE_INDEX;
+    }
+
+    // normalize all normals of this face
+    for (int i=0;i < nbNodesInFace;i++)
+        norms[faceNodeOffset+i].normalize();
+}
+
 //**************************************************************************
 // Construction/Destruction
 
@@ -897,14 +1015,16 @@ void ViewProviderPartExt::updateVisual(const TopoDS_Shape& inputShape)
         Standard_Real deflection = ((xMax-xMin)+(yMax-yMin)+(zMax-zMin))/300.0 *
             Deviation.getValue();
 
-        // create or use the mesh on the data structure
+        // create or use the mesh on the data structure, the faces are meshed in parallel
+        if (!isMeshed(cShape, deflection)) {
 #if OCC_VERSION_HEX >= 0x060600
-        Standard_Real AngDeflectionRads = AngularDeflection.getValue() / 180.0 * M_PI;
-        BRepMesh_IncrementalMesh(cShape,deflection,Standard_False,
-                AngDeflectionRads,Standard_True);
+            Standard_Real AngDeflectionRads = AngularDeflection.getValue() / 180.0 * M_PI;
+            BRepMesh_IncrementalMesh(cShape,deflection,Standard_False,
+                    AngDeflectionRads,Standard_True);
 #else
-        BRepMesh_IncrementalMesh(cShape,deflection);
+            BRepMesh_IncrementalMesh(cShape,deflection);
 #endif
+        }
         // We must reset the location here because the transformation data
         // are set in the placement property
         TopLoc_Location aLoc;
@@ -913,13 +1033,20 @@ void ViewProviderPartExt::updateVisual(const TopoDS_Shape& inputShape)
         // count triangles and nodes in the mesh
         TopTools_IndexedMapOfShape faceMap;
         TopExp::MapShapes(cShape, TopAbs_FACE, faceMap);
+        std::vector<FaceTriangulation> faces(faceMap.Extent());
+        std::map<Poly_Triangulation*, int> meshUsage;
         for (int i=1; i <= faceMap.Extent(); i++) {
-            Handle (Poly_Triangulation) mesh = BRep_Tool::Triangulation(TopoDS::Face(faceMap(i)), aLoc);
+            FaceTriangulation& data = faces[i-1];
+            data.face = TopoDS::Face(faceMap(i));
+            data.mesh = BRep_Tool::Triangulation(data.face, data.loc);
+            data.nodeOffset = numNodes;
+            data.triaOffset = numTriangles;
             // Note: we must also count empty faces
-            if (!mesh.IsNull()) {
-                numTriangles += mesh->NbTriangles();
-                numNodes     += mesh->NbNodes();
-                numNorms     += mesh->NbNodes();
+            if (!data.mesh.IsNull()) {
+                numTriangles += data.mesh->NbTriangles();
+                numNodes     += data.mesh->NbNodes();
+                numNorms     += data.mesh->NbNodes();
+                meshUsage[data.mesh.operator->()]++;
             }
 
             TopExp_Explorer xp;
@@ -978,16 +1105,33 @@ void ViewProviderPartExt::updateVisual(const TopoDS_Shape& inputShape)
         int32_t* index = faceset ->coordIndex  .startEditing();
         int32_t* parts = faceset ->partIndex   .startEditing();
 
-        // preset the normal vector with null vector
-        for (int i=0;i < numNorms;i++)
-            norms[i]= SbVec3f(0.0,0.0,0.0);
+        // fill in the triangles of the faces, each face has its own range in the arrays
+        std::vector<const FaceTriangulation*> parallelFaces, serialFaces;
+        for (std::vector<FaceTriangulation>::const_iterator it = faces.begin(); it != faces.end(); ++it) {
+            if (it->mesh.IsNull())
+                continue;
+#if OCC_VERSION_HEX >= 0x070000
+            // Since OCC 7.0 the evaluation of surfaces is thread-safe. Faces sharing their
+            // triangulation are handled serially because GetNormals() may modify it.
+            if (meshUsage[it->mesh.operator->()] == 1) {
+                parallelFaces.push_back(&(*it));
+                continue;
+            }
+#endif
+            serialFaces.push_back(&(*it));
+        }
 
-        int ii = 0,faceNodeOffset=0,faceTriaOffset=0;
+        QtConcurrent::blockingMap(parallelFaces, boost::bind(&ViewProviderPartExt::fillTriangulation,
+                                                             this, verts, norms, index, _1));
+        for (std::vector<const FaceTriangulation*>::iterator it = serialFaces.begin(); it != serialFaces.end(); ++it)
+            fillTriangulation(verts, norms, index, *it);
+
+        int ii = 0,faceNodeOffset=0;
         for (int i=1; i <= faceMap.Extent(); i++, ii++) {
-            TopLoc_Location aLoc;
-            const TopoDS_Face &actFace = TopoDS::Face(faceMap(i));
-            // get the mesh of the shape
-            Handle (Poly_Triangulation) mesh = BRep_Tool::Triangulation(actFace,aLoc);
+            const FaceTriangulation& data = faces[i-1];
+            const TopoDS_Face &actFace = data.face;
+            const TopLoc_Location &aLoc = data.loc;
+            const Handle(Poly_Triangulation) &mesh = data.mesh;
             if (mesh.IsNull()) continue;
 
             // getting the transformation of the shape/face
@@ -1001,60 +1145,7 @@ void ViewProviderPartExt::updateVisual(const TopoDS_Shape& inputShape)
             // getting size of node and triangle array of this face
             int nbNodesInFace = mesh->NbNodes();
             int nbTriInFace   = mesh->NbTriangles();
-            // check orientation
-            TopAbs_Orientation orient = actFace.Orientation();
-
-
-            // cycling through the poly mesh
-            const Poly_Array1OfTriangle& Triangles = mesh->Triangles();
             const TColgp_Array1OfPnt& Nodes = mesh->Nodes();
-            TColgp_Array1OfDir Normals (Nodes.Lower(), Nodes.Upper());
-            GetNormals(actFace, mesh, Normals);
-            
-            for (int g=1;g<=nbTriInFace;g++) {
-                // Get the triangle
-                Standard_Integer N1,N2,N3;
-                Triangles(g).Get(N1,N2,N3);
-
-                // change orientation of the triangle if the face is reversed
-                if ( orient != TopAbs_FORWARD ) {
-                    Standard_Integer tmp = N1;
-                    N1 = N2;
-                    N2 = tmp;
-                }
-
-                // get the 3 points of this triangle
-                gp_Pnt V1(Nodes(N1)), V2(Nodes(N2)), V3(Nodes(N3));
-
-                // get the 3 normals of this triangle
-                gp_Dir NV1(Normals(N1)), NV2(Normals(N2)), NV3(Normals(N3));                
-
-                // transform the vertices and normals to the place of the face
-                if(!identity) {
-                    V1.Transform(myTransf);
-                    V2.Transform(myTransf);
-                    V3.Transform(myTransf);
-                    NV1.Transform(myTransf);
-                    NV2.Transform(myTransf);
-                    NV3.Transform(myTransf);
-                }
-
-                // add the normals for all points of this triangle
-                norms[faceNodeOffset+N1-1] += SbVec3f(NV1.X(),NV1.Y(),NV1.Z());
-                norms[faceNodeOffset+N2-1] += SbVec3f(NV2.X(),NV2.Y(),NV2.Z());
-                norms[faceNodeOffset+N3-1] += SbVec3f(NV3.X(),NV3.Y(),NV3.Z());
-
-                // set the vertices
-                verts[faceNodeOffset+N1-1].setValue((float)(V1.X()),(float)(V1.Y()),(float)(V1.Z()));
-                verts[faceNodeOffset+N2-1].setValue((float)(V2.X()),(float)(V2.Y()),(float)(V2.Z()));
-                verts[faceNodeOffset+N3-1].setValue((float)(V3.X()),(float)(V3.Y()),(float)(V3.Z()));
-
-                // set the index vector with the 3 point indexes and the end delimiter
-                index[faceTriaOffset*4+4*(g-1)]   = faceNodeOffset+N1-1;
-                index[faceTriaOffset*4+4*(g-1)+1] = faceNodeOffset+N2-1;
-                index[faceTriaOffset*4+4*(g-1)+2] = faceNodeOffset+N3-1;
-                index[faceTriaOffset*4+4*(g-1)+3] = SO_END_FACE_INDEX;
-            }
 
             parts[ii] = nbTriInFace; // new part
 
@@ -1100,7 +1191,6 @@ void ViewProviderPartExt::updateVisual(const TopoDS_Shape& inputShape)
             
             // counting up the per Face offsets
             faceNodeOffset += nbNodesInFace;
-            faceTriaOffset += nbTriInFace;
         }
 
         // handling of the free edges
@@ -1145,10 +1235,6 @@ void ViewProviderPartExt::updateVisual(const TopoDS_Shape& inputShape)
             verts[faceNodeOffset+i].setValue((float)(pnt.X()),(float)(pnt.Y()),(float)(pnt.Z()));
         }
 
-        // normalize all normals 
-        for (int i = 0; i< numNorms ;i++)
-            norms[i].normalize();
-        
         std::vector<int32_t> lineSetCoords;
         for (std::map<int, std::vector<int32_t> >::iterator it = lineSetMap.begin(); it != lineSetMap.end(); ++it) {
             lineSetCoords.insert(lineSetCoords.end(), it->second.begin(), it->second.end());
@@ -143,6 +143,12 @@ protected:
     void updateVisual(const TopoDS_Shape &);
     void GetNormals(const TopoDS_Face&  theFace, const Handle(Poly_Triangulation)& aPolyTri,
                     TColgp_Array1OfDir& theNormals);
+    struct FaceTriangulation;
+    /// Fills in the nodes, normals and triangles of a face, can be called from several threads
+    void fillTriangulation(SbVec3f* verts, SbVec3f* norms, int32_t* index,
+                           const FaceTriangulation* face);
+    /// Checks whether all faces are already meshed at least as fine as the given deflection
+    static bool isMeshed(const TopoDS_Shape&, Standard_Real deflection);
 
     // nodes for the data representation
     SoMaterialBinding * pcShapeBind;
@@ -19,7 +19,7 @@
 #   USA                                                                   *
 #**************************************************************************
 
-import FreeCAD, os, sys, unittest, Part
+import FreeCAD, os, sys, unittest, tempfile, Part
 App = FreeCAD
 
 #---------------------------------------------------------------------------
@@ -40,3 +40,56 @@ class PartTestCases(unittest.TestCase):
 		#closing doc
 		FreeCAD.closeDocument("PartTest")
 		#print ("omit clos document for debuging")
+
+class PartSaveRestoreCases(unittest.TestCase):
+	def setUp(self):
+		self.Doc = FreeCAD.newDocument("PartSaveRestoreTest")
+		self.FileName = os.path.join(tempfile.gettempdir(), "PartSaveRestoreTest.FCStd")
+
+	def testBinaryBrep(self):
+		# a larger shape saved in binary and in ASCII format
+		import time
+		boxes = []
+		for i in range(20):
+			for j in range(20):
+				boxes.append(Part.makeBox(1, 1, 1 + (i + j) % 5, App.Vector(2 * i, 2 * j, 0)))
+		shape = Part.makeCompound(boxes)
+		self.Doc.addObject("Part::Feature","Shape").Shape = shape
+		param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+		binary = param.GetBool("SaveBinaryBrep", True)
+		try:
+			for mode in [True, False]:
+				param.SetBool("SaveBinaryBrep", mode)
+				t = time.time()
+				self.Doc.saveAs(self.FileName)
+				save = time.time() - t
+				t = time.time()
+				self.Doc.restore()
+				load = time.time() - t
+				FreeCAD.Console.PrintLog("Binary BRep %s: size %d bytes, save %f s, load %f s\n" % (mode, os.path.getsize(self.FileName), save, load))
+				self.failUnless(abs(self.Doc.Shape.Shape.Volume - shape.Volume) < 1e-6)
+				self.failUnless(len(self.Doc.Shape.Shape.Faces) == len(shape.Faces))
+		finally:
+			param.SetBool("SaveBinaryBrep", binary)
+
+	def testTessellation(self):
+		# the triangulation of a shape is only kept in the file on request
+		shape = Part.makeSphere(5)
+		self.Doc.addObject("Part::Feature","Shape").Shape = shape
+		param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+		tessellation = param.GetBool("SaveTessellation", False)
+		try:
+			sizes = []
+			for mode in [False, True]:
+				param.SetBool("SaveTessellation", mode)
+				self.Doc.Shape.Shape.tessellate(0.01)
+				self.Doc.saveAs(self.FileName)
+				sizes.append(os.path.getsize(self.FileName))
+				self.Doc.restore()
+				self.failUnless(abs(self.Doc.Shape.Shape.Volume - shape.Volume) < 1e-6)
+			self.failUnless(sizes[1] > sizes[0])
+		finally:
+			param.SetBool("SaveTessellation", tessellation)
+
+	def tearDown(self):
+		FreeCAD.closeDocument("PartSaveRestoreTest")
@@ -0,0 +1,338 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cstring>
+# include <fstream>
+#endif
+
+#include <QFile>
+#include <QFileInfo>
+
+#include <Base/Exception.h>
+#include <Base/FileInfo.h>
+#include <Base/Sequencer.h>
+#include <Base/Stream.h>
+
+#include "PointPages.h"
+
+using namespace Points;
+
+namespace {
+
+const char pageMagic[8] = { 'F', 'C', 'P', 'O', 'I', 'N', 'T', 'S' };
+const uint32_t pageVersion = 1;
+
+// the points are sorted in blocks of this size
+const std::size_t blockSize = 1024 * 1024;
+
+/**
+ * Computes the octree bucket of a point. The bucket index is the Morton code of
+ * the cell, i.e. the bits of the cell position are interleaved.
+ */
+class BucketIndex
+{
+public:
+    BucketIndex(const Base::BoundBox3f& box, uint32_t depth)
+      : depth(depth), cells(1u << depth), min(box.MinX, box.MinY, box.MinZ)
+    {
+        float len[3] = { box.LengthX(), box.LengthY(), box.LengthZ() };
+        for (int i = 0; i < 3; i++)
+            scale[i] = len[i] > 0.0f ? static_cast<float>(cells) / len[i] : 0.0f;
+    }
+    uint32_t operator()(const Base::Vector3f& pnt) const
+    {
+        uint32_t x = cell(pnt.x - min.x, scale[0]);
+        uint32_t y = cell(pnt.y - min.y, scale[1]);
+        uint32_t z = cell(pnt.z - min.z, scale[2]);
+        uint32_t code = 0;
+        for (int i = static_cast<int>(depth) - 1; i >= 0; i--) {
+            code = (code << 3) | (((x >> i) & 1) << 2) | (((y >> i) & 1) << 1) | ((z >> i) & 1);
+        }
+        return code;
+    }
+
+private:
+    uint32_t cell(float dist, float s) const
+    {
+        // points outside the box like NaN values go to the first or last cell
+        float pos = dist * s;
+        if (!(pos > 0.0f))
+            return 0;
+        return std::min<uint32_t>(static_cast<uint32_t>(pos), cells - 1);
+    }
+
+    uint32_t depth;
+    uint32_t cells;
+    Base::Vector3f min;
+    float scale[3];
+};
+
+/**
+ * Reads the temporary file of the builder block by block.
+ */
+class BlockReader
+{
+public:
+    BlockReader(const std::string& filename)
+      : file(Base::FileInfo(filename), std::ios::in | std::ios::binary)
+    {
+    }
+    bool next(std::vector<Base::Vector3f>& block)
+    {
+        block.resize(blockSize);
+        file.read(reinterpret_cast<char*>(&block[0]), blockSize * sizeof(Base::Vector3f));
+        block.resize(static_cast<std::size_t>(file.gcount()) / sizeof(Base::Vector3f));
+        return !block.empty();
+    }
+
+private:
+    Base::ifstream file;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+
+PointPages::PointPages()
+  : file(0), points(0), numPoints(0)
+{
+}
+
+PointPages::~PointPages()
+{
+    if (file) {
+        if (points)
+            file->unmap(reinterpret_cast<uchar*>(const_cast<Base::Vector3f*>(points)));
+        delete file;
+    }
+}
+
+std::size_t PointPages::dataOffset(std::size_t numPages)
+{
+    return sizeof(Header) + numPages * sizeof(Page);
+}
+
+boost::shared_ptr<PointPages> PointPages::open(const std::string& filename)
+{
+    boost::shared_ptr<PointPages> pages(new PointPages());
+    // the file name is kept absolute as the kernel may be saved in another directory
+    QFileInfo fi(QString::fromUtf8(filename.c_str()));
+    pages->fileName = fi.absoluteFilePath().toUtf8().constData();
+    pages->file = new QFile(QString::fromUtf8(filename.c_str()));
+    if (!pages->file->open(QIODevice::ReadOnly))
+        throw Base::FileException("Cannot open point pages", filename.c_str());
+
+    Header header;
+    if (pages->file->read(reinterpret_cast<char*>(&header), sizeof(Header)) != sizeof(Header) ||
+        std::memcmp(header.magic, pageMagic, sizeof(pageMagic)) != 0 ||
+        header.version != pageVersion)
+        throw Base::FileException("Invalid point pages", filename.c_str());
+
+    std::size_t numPages = static_cast<std::size_t>(header.numPages);
+    pages->pages.resize(numPages);
+    qint64 tableSize = static_cast<qint64>(numPages * sizeof(Page));
+    if (numPages > 0 && pages->file->read(reinterpret_cast<char*>(&pages->pages[0]), tableSize) != tableSize)
+        throw Base::FileException("Invalid point pages", filename.c_str());
+
+    pages->numPoints = static_cast<std::size_t>(header.numPoints);
+    pages->boundBox = Base::BoundBox3f(header.box[0], header.box[1], header.box[2],
+                                       header.box[3], header.box[4], header.box[5]);
+
+    qint64 dataSize = static_cast<qint64>(pages->numPoints * sizeof(Base::Vector3f));
+    qint64 offset = static_cast<qint64>(dataOffset(numPages));
+    if (pages->file->size() < offset + dataSize)
+        throw Base::FileException("Truncated point pages", filename.c_str());
+    if (dataSize > 0) {
+        pages->points = reinterpret_cast<const Base::Vector3f*>(pages->file->map(offset, dataSize));
+        if (!pages->points)
+            throw Base::FileException("Cannot map point pages", filename.c_str());
+    }
+
+    return pages;
+}
+
+Base::BoundBox3f PointPages::getPageBoundBox(std::size_t page) const
+{
+    const float* box = pages[page].box;
+    return Base::BoundBox3f(box[0], box[1], box[2], box[3], box[4], box[5]);
+}
+
+std::size_t PointPages::findPage(std::size_t index) const
+{
+    // the last page whose first point is not behind index
+    std::size_t lo = 0, hi = pages.size();
+    while (hi - lo > 1) {
+        std::size_t mid = (lo + hi) / 2;
+        if (pages[mid].first <= index)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void PointPages::findPages(const Base::BoundBox3f& box, std::vector<std::size_t>& result) const
+{
+    for (std::size_t i = 0; i < pages.size(); i++) {
+        if (getPageBoundBox(i).Intersect(box))
+            result.push_back(i);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+PointPagesBuilder::PointPagesBuilder(const std::string& filename)
+  : fileName(filename), tempName(filename + ".tmp"), temp(0), numPoints(0)
+{
+    temp = new Base::ofstream(Base::FileInfo(tempName), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!*temp) {
+        delete temp;
+        temp = 0;
+        throw Base::FileException("Cannot create temporary file", tempName.c_str());
+    }
+}
+
+PointPagesBuilder::~PointPagesBuilder()
+{
+    delete temp;
+    Base::FileInfo(tempName).deleteFile();
+}
+
+void PointPagesBuilder::add(const Base::Vector3f* points, std::size_t count)
+{
+    if (!temp)
+        throw Base::RuntimeError("Point pages are already built");
+
+    temp->write(reinterpret_cast<const char*>(points), count * sizeof(Base::Vector3f));
+    if (!*temp)
+        throw Base::FileException("Cannot write temporary file", tempName.c_str());
+
+    for (std::size_t i = 0; i < count; i++)
+        boundBox.Add(points[i]);
+    numPoints += count;
+}
+
+boost::shared_ptr<PointPages> PointPagesBuilder::build(std::size_t pageSize)
+{
+    if (!temp)
+        throw Base::RuntimeError("Point pages are already built");
+    temp->flush();
+    delete temp;
+    temp = 0;
+
+    if (pageSize == 0)
+        pageSize = 1;
+
+    // an octree bucket should have about the size of a page
+    uint32_t depth = 0;
+    while (depth < 7 && numPoints / (std::size_t(1) << (3 * depth)) > pageSize)
+        depth++;
+    BucketIndex bucketIndex(boundBox, depth);
+    std::size_t numBlocks = (numPoints + blockSize - 1) / blockSize;
+    Base::SequencerLauncher seq("Sorting points into pages...", 2 * numBlocks);
+
+    // count the points of each bucket
+    std::vector<uint64_t> offsets(std::size_t(1) << (3 * depth), 0);
+    std::vector<Base::Vector3f> block;
+    BlockReader counting(tempName);
+    while (counting.next(block)) {
+        for (std::vector<Base::Vector3f>::iterator it = block.begin(); it != block.end(); ++it)
+            offsets[bucketIndex(*it)]++;
+        seq.next(true);
+    }
+
+    // split the buckets into pages
+    std::vector<PointPages::Page> pages;
+    uint64_t first = 0;
+    for (std::size_t code = 0; code < offsets.size(); code++) {
+        uint64_t size = offsets[code];
+        offsets[code] = first;
+        for (uint64_t i = 0; i < size; i += pageSize) {
+            PointPages::Page page;
+            page.first = first + i;
+            page.count = static_cast<uint32_t>(std::min<uint64_t>(pageSize, size - i));
+            page.code = static_cast<uint32_t>(code);
+            pages.push_back(page);
+        }
+        first += size;
+    }
+
+    QFile out(QString::fromUtf8(fileName.c_str()));
+    if (!out.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        throw Base::FileException("Cannot create point pages", fileName.c_str());
+    qint64 offset = static_cast<qint64>(PointPages::dataOffset(pages.size()));
+    qint64 dataSize = static_cast<qint64>(numPoints * sizeof(Base::Vector3f));
+    if (!out.resize(offset + dataSize))
+        throw Base::FileException("Cannot write point pages", fileName.c_str());
+
+    if (dataSize > 0) {
+        Base::Vector3f* data = reinterpret_cast<Base::Vector3f*>(out.map(offset, dataSize));
+        if (!data)
+            throw Base::FileException("Cannot map point pages", fileName.c_str());
+
+        // move the points to their buckets
+        BlockReader sorting(tempName);
+        while (sorting.next(block)) {
+            for (std::vector<Base::Vector3f>::iterator it = block.begin(); it != block.end(); ++it)
+                data[offsets[bucketIndex(*it)]++] = *it;
+            seq.next(true);
+        }
+
+        for (std::vector<PointPages::Page>::iterator it = pages.begin(); it != pages.end(); ++it) {
+            Base::BoundBox3f box;
+            const Base::Vector3f* pnt = data + it->first;
+            for (uint32_t i = 0; i < it->count; i++)
+                box.Add(pnt[i]);
+            it->box[0] = box.MinX; it->box[1] = box.MinY; it->box[2] = box.MinZ;
+            it->box[3] = box.MaxX; it->box[4] = box.MaxY; it->box[5] = box.MaxZ;
+        }
+
+        out.unmap(reinterpret_cast<uchar*>(data));
+    }
+
+    PointPages::Header header;
+    std::memcpy(header.magic, pageMagic, sizeof(pageMagic));
+    header.version = pageVersion;
+    header.depth = depth;
+    header.numPoints = numPoints;
+    header.numPages = pages.size();
+    header.box[0] = boundBox.MinX; header.box[1] = boundBox.MinY; header.box[2] = boundBox.MinZ;
+    header.box[3] = boundBox.MaxX; header.box[4] = boundBox.MaxY; header.box[5] = boundBox.MaxZ;
+
+    out.seek(0);
+    bool ok = out.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header);
+    if (ok && !pages.empty()) {
+        qint64 tableSize = static_cast<qint64>(pages.size() * sizeof(PointPages::Page));
+        ok = out.write(reinterpret_cast<const char*>(&pages[0]), tableSize) == tableSize;
+    }
+    out.close();
+    if (!ok)
+        throw Base::FileException("Cannot write point pages", fileName.c_str());
+
+    Base::FileInfo(tempName).deleteFile();
+    return PointPages::open(fileName);
+}
@@ -0,0 +1,174 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef POINTS_POINTPAGES_H
+#define POINTS_POINTPAGES_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <Base/BoundBox.h>
+#include <Base/Vector3D.h>
+
+class QFile;
+
+namespace Points
+{
+
+/**
+ * The PointPages class gives access to a point cloud that is stored in a page
+ * file on disk instead of in memory.
+ *
+ * The points of the file are sorted into the buckets of an octree over their
+ * bounding box. The buckets are stored in Morton order, so the points of an
+ * octree node at any level form one contiguous range. A bucket with too many
+ * points is split into several pages. For each page the file keeps the index of
+ * its first point and its bounding box, so spatial queries only need the small
+ * page table that is kept in memory.
+ *
+ * The point data is memory-mapped, so the operating system loads the pages on
+ * demand when they are accessed and can drop them again if memory gets low.
+ * The file is read-only; a PointKernel that uses it loads the points into
+ * memory before they are modified.
+ * @see PointPagesBuilder
+ */
+class PointsExport PointPages
+{
+public:
+    /// Opens the page file \a filename, throws a Base::FileException on failure
+    static boost::shared_ptr<PointPages> open(const std::string& filename);
+    ~PointPages();
+
+    /// Returns the absolute path of the page file
+    const std::string& getFileName() const
+    { return fileName; }
+    /// Returns the number of points
+    std::size_t size() const
+    { return numPoints; }
+    /// Returns the bounding box of all points
+    const Base::BoundBox3f& getBoundBox() const
+    { return boundBox; }
+    /// Returns the memory needed for the page table
+    std::size_t getMemSize() const
+    { return pages.size() * sizeof(Page); }
+
+    /// Returns all points, the pointer is valid as long as this object exists
+    const Base::Vector3f* data() const
+    { return points; }
+    const Base::Vector3f& getPoint(std::size_t index) const
+    { return points[index]; }
+
+    /** @name Pages */
+    //@{
+    std::size_t countPages() const
+    { return pages.size(); }
+    /// Returns the index of the first point of page \a page
+    std::size_t getPageOffset(std::size_t page) const
+    { return pages[page].first; }
+    /// Returns the number of points of page \a page
+    std::size_t getPageSize(std::size_t page) const
+    { return pages[page].count; }
+    Base::BoundBox3f getPageBoundBox(std::size_t page) const;
+    /// Returns the page that contains the point with index \a index
+    std::size_t findPage(std::size_t index) const;
+    /// Appends the pages whose bounding box intersects with \a box to \a result
+    void findPages(const Base::BoundBox3f& box, std::vector<std::size_t>& result) const;
+    //@}
+
+private:
+    PointPages();
+    PointPages(const PointPages&);
+    PointPages& operator=(const PointPages&);
+
+    friend class PointPagesBuilder;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t depth;
+        uint64_t numPoints;
+        uint64_t numPages;
+        float box[6];
+    };
+    struct Page
+    {
+        uint64_t first;
+        uint32_t count;
+        uint32_t code;
+        float box[6];
+    };
+
+    static std::size_t dataOffset(std::size_t numPages);
+
+    std::string fileName;
+    QFile* file;
+    const Base::Vector3f* points;
+    std::size_t numPoints;
+    Base::BoundBox3f boundBox;
+    std::vector<Page> pages;
+};
+
+/**
+ * The PointPagesBuilder class writes a page file for PointPages. The points can
+ * be added in blocks; they are written to a temporary file first, so the whole
+ * point cloud never needs to be in memory. The page file is written by build().
+ */
+class PointsExport PointPagesBuilder
+{
+public:
+    /// The page file is written to \a filename
+    PointPagesBuilder(const std::string& filename);
+    ~PointPagesBuilder();
+
+    void add(const Base::Vector3f* points, std::size_t count);
+    void add(const std::vector<Base::Vector3f>& points)
+    { if (!points.empty()) add(&points[0], points.size()); }
+    /// Returns the number of added points
+    std::size_t size() const
+    { return numPoints; }
+    /**
+     * Sorts the points into octree buckets of at most \a pageSize points and
+     * writes the page file. Throws a Base::FileException on failure.
+     */
+    boost::shared_ptr<PointPages> build(std::size_t pageSize = 65536);
+
+private:
+    PointPagesBuilder(const PointPagesBuilder&);
+    PointPagesBuilder& operator=(const PointPagesBuilder&);
+
+    std::string fileName;
+    std::string tempName;
+    std::ostream* temp;
+    std::size_t numPoints;
+    Base::BoundBox3f boundBox;
+};
+
+} // namespace Points
+
+
+#endif // POINTS_POINTPAGES_H
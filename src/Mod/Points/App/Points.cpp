@@ -29,10 +29,12 @@
 
 #include <boost/math/special_functions/fpclassify.hpp>
 
+#include <Base/Console.h>
 #include <Base/Exception.h>
 #include <Base/Matrix.h>
 #include <Base/Persistence.h>
 #include <Base/Stream.h>
+#include <Base/VectorArray.h>
 #include <Base/Writer.h>
 
 #include "Points.h"
@@ -73,15 +75,26 @@ Data::Segment* PointKernel::getSubElement(const char* /*Type*/, unsigned long /*
 void PointKernel::transformGeometry(const Base::Matrix4D &rclMat)
 {
     std::vector<value_type>& kernel = getBasicPoints();
-    for (std::vector<value_type>::iterator it = kernel.begin(); it != kernel.end(); ++it)
-        *it = rclMat * (*it);
+    if (!kernel.empty())
+        Base::VectorArray::Transform(rclMat, &kernel[0], kernel.size());
 }
 
 Base::BoundBox3d PointKernel::getBoundBox(void)const
 {
     Base::BoundBox3d bnd;
-    for (const_point_iterator it = begin(); it != end(); ++it)
-        bnd.Add(*it);
+    if (_Pages) {
+        // the page table is enough, there is no need to touch the points
+        for (std::size_t i = 0; i < _Pages->countPages(); i++) {
+            Base::BoundBox3f box = _Pages->getPageBoundBox(i);
+            if (box.IsValid()) {
+                bnd.Add(Base::BoundBox3d(box.MinX, box.MinY, box.MinZ,
+                                         box.MaxX, box.MaxY, box.MaxZ).Transformed(_Mtrx));
+            }
+        }
+        return bnd;
+    }
+    if (size() > 0)
+        bnd = Base::VectorArray::GetBoundBox(_Mtrx, data(), size());
     return bnd;
 }
 
@@ -91,14 +104,50 @@ void PointKernel::operator = (const PointKernel& Kernel)
         // copy the mesh structure
         setTransform(Kernel._Mtrx);
         this->_Points = Kernel._Points;
+        // the page file is read-only and can be shared
+        this->_Pages = Kernel._Pages;
+        this->_MissingPages = Kernel._MissingPages;
     }
 }
 
 unsigned int PointKernel::getMemSize (void) const
 {
+    if (_Pages)
+        return _Pages->getMemSize();
     return _Points.size() * sizeof(value_type);
 }
 
+const std::vector<PointKernel::value_type>& PointKernel::getBasicPoints() const
+{
+    if (_Pages)
+        throw Base::RuntimeError("The points are stored in a page file and must be loaded first");
+    return _Points;
+}
+
+void PointKernel::setPages(const boost::shared_ptr<PointPages>& pages)
+{
+    _Points.clear();
+    _MissingPages.clear();
+    _Pages = pages;
+}
+
+void PointKernel::loadPages()
+{
+    if (_Pages) {
+        const value_type* pts = _Pages->data();
+        _Points.assign(pts, pts + _Pages->size());
+    }
+    // after a modification the points don't belong to a page file any more
+    detachPages();
+}
+
+std::string PointKernel::getPageFile() const
+{
+    if (_Pages)
+        return _Pages->getFileName();
+    return _MissingPages;
+}
+
 PointKernel::size_type PointKernel::countValid(void) const
 {
     size_type num = 0;
@@ -129,21 +178,34 @@ std::vector<PointKernel::value_type> PointKernel::getValidPoints() const
 
 void PointKernel::Save (Base::Writer &writer) const
 {
-    if (!writer.isForceXML()) {
+    std::string pages = getPageFile();
+    if (!pages.empty()) {
+        savePages(writer, pages);
+    }
+    else if (!writer.isForceXML()) {
         writer.Stream() << writer.ind()
             << "<Points file=\"" << writer.addFile(writer.ObjectName.c_str(), this) << "\" " 
             << "mtrx=\"" << _Mtrx.toString() << "\"/>" << std::endl;
     }
 }
 
+void PointKernel::savePages(Base::Writer &writer, const std::string& file) const
+{
+    // the page file is referenced instead of copying it into the project file
+    writer.Stream() << writer.ind()
+        << "<Points pages=\"" << App::Property::encodeAttribute(file) << "\" "
+        << "mtrx=\"" << _Mtrx.toString() << "\"/>" << std::endl;
+}
+
 void PointKernel::SaveDocFile (Base::Writer &writer) const
 {
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)size();
     str << uCt;
     // store the data without transforming it
-    for (std::vector<value_type>::const_iterator it = _Points.begin(); it != _Points.end(); ++it) {
-        str << it->x << it->y << it->z;
+    const value_type* pts = data();
+    for (std::size_t i = 0; i < size(); i++) {
+        str << pts[i].x << pts[i].y << pts[i].z;
     }
 }
 
@@ -152,11 +214,16 @@ void PointKernel::Restore(Base::XMLReader &reader)
     clear();
 
     reader.readElement("Points");
-    std::string file (reader.getAttribute("file") );
+    if (reader.hasAttribute("pages")) {
+        restorePages(reader.getAttribute("pages"));
+    }
+    else {
+        std::string file (reader.getAttribute("file") );
 
-    if (!file.empty()) {
-        // initate a file read
-        reader.addFile(file.c_str(),this);
+        if (!file.empty()) {
+            // initate a file read
+            reader.addFile(file.c_str(),this);
+        }
     }
     if (reader.DocumentSchema > 3) {
         std::string Matrix (reader.getAttribute("mtrx") );
@@ -164,11 +231,25 @@ void PointKernel::Restore(Base::XMLReader &reader)
     }
 }
 
+void PointKernel::restorePages(const std::string& file)
+{
+    try {
+        setPages(PointPages::open(file));
+    }
+    catch (const Base::Exception& e) {
+        // keep the rest of the document and the reference to the page file
+        clear();
+        _MissingPages = file;
+        Base::Console().Error("Cannot restore point pages: %s\n", e.what());
+    }
+}
+
 void PointKernel::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
     uint32_t uCt = 0;
     str >> uCt;
+    detachPages();
     _Points.resize(uCt);
     for (unsigned long i=0; i < uCt; i++) {
         float x, y, z;
@@ -191,8 +272,9 @@ void PointKernel::load(const char* file)
 void PointKernel::save(std::ostream& out) const
 {
     out << "# ASCII" << std::endl;
-    for (std::vector<value_type>::const_iterator it = _Points.begin(); it != _Points.end(); ++it) {
-        out << it->x << " " << it->y << " " << it->z << std::endl;
+    const value_type* pts = data();
+    for (std::size_t i = 0; i < size(); i++) {
+        out << pts[i].x << " " << pts[i].y << " " << pts[i].z << std::endl;
     }
 }
 
@@ -200,7 +282,7 @@ void PointKernel::getPoints(std::vector<Base::Vector3d> &Points,
                             std::vector<Base::Vector3d> &/*Normals*/,
                             float /*Accuracy*/, uint16_t /*flags*/) const
 {
-    unsigned long ctpoints = _Points.size();
+    unsigned long ctpoints = size();
     Points.reserve(ctpoints);
     for (unsigned long i=0; i<ctpoints; i++) {
         Points.push_back(this->getPoint(i));
@@ -210,10 +292,10 @@ void PointKernel::getPoints(std::vector<Base::Vector3d> &Points,
 // ----------------------------------------------------------------------------
 
 PointKernel::const_point_iterator::const_point_iterator
-(const PointKernel* kernel, std::vector<kernel_type>::const_iterator index)
+(const PointKernel* kernel, iter_type index)
   : _kernel(kernel), _p_it(index)
 {
-    if(_p_it != kernel->_Points.end())
+    if(_p_it != kernel->data() + kernel->size())
     {
         value_type vertd(_p_it->x, _p_it->y, _p_it->z);
         this->_point = _kernel->_Mtrx * vertd;
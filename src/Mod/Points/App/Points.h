@@ -35,11 +35,14 @@
 #include <App/PropertyStandard.h>
 #include <App/PropertyGeo.h>
 
+#include "PointPages.h"
+
 namespace Points
 {
 
 
 /** Point kernel
+ * The points are either kept in memory or in a page file on disk, see setPages().
  */
 class PointsExport PointKernel : public Data::ComplexGeoData
 {
@@ -78,14 +81,44 @@ public:
 
     inline void setTransform(const Base::Matrix4D& rclTrf){_Mtrx = rclTrf;}
     inline Base::Matrix4D getTransform(void) const{return _Mtrx;}
+    /// If the points are stored in a page file they are loaded into memory first
     std::vector<value_type>& getBasicPoints()
-    { return this->_Points; }
-    const std::vector<value_type>& getBasicPoints() const
-    { return this->_Points; }
+    { loadPages(); return this->_Points; }
+    /** The points must be in memory, a paged kernel is not loaded from a const
+     * context but throws a Base::RuntimeError. Use data() or the iterators that
+     * work in both cases.
+     */
+    const std::vector<value_type>& getBasicPoints() const;
     void setBasicPoints(const std::vector<value_type>& pts)
-    { this->_Points = pts; }
+    { detachPages(); this->_Points = pts; }
     void swap(std::vector<value_type>& pts)
-    { this->_Points.swap(pts); }
+    { detachPages(); this->_Points.swap(pts); }
+    /// Returns the untransformed points of memory or of the page file
+    const value_type* data() const
+    { return _Pages ? _Pages->data() : (_Points.empty() ? 0 : &_Points[0]); }
+
+    /** @name Paged storage */
+    //@{
+    /** Uses the page file \a pages as storage of the points instead of memory.
+     * The points are only read from the file when they are accessed.
+     */
+    void setPages(const boost::shared_ptr<PointPages>& pages);
+    const boost::shared_ptr<PointPages>& getPages() const
+    { return this->_Pages; }
+    bool isPaged() const
+    { return this->_Pages.get() != 0; }
+    /// Loads the points of the page file into memory and detaches the kernel from it
+    void loadPages();
+    /** Opens the page file of a project. If this fails an error is reported and
+     * the kernel is empty but keeps \a file as reference, so that saving the
+     * project again doesn't lose it.
+     */
+    void restorePages(const std::string& file);
+    /// Returns the page file of the points or the reference to a missing one
+    std::string getPageFile() const;
+    /// Writes the reference to the page file as \a file, e.g. relative to the project
+    void savePages(Base::Writer &writer, const std::string& file) const;
+    //@}
 
     virtual void getPoints(std::vector<Base::Vector3d> &Points,
         std::vector<Base::Vector3d> &Normals,
@@ -108,33 +141,42 @@ public:
     //@}
 
 private:
+    void detachPages()
+    { this->_Pages.reset(); this->_MissingPages.clear(); }
+
     Base::Matrix4D _Mtrx;
     std::vector<value_type> _Points;
+    boost::shared_ptr<PointPages> _Pages;
+    // the page file of a project that couldn't be opened
+    std::string _MissingPages;
 
 public:
     /// number of points stored 
-    size_type size(void) const {return this->_Points.size();}
+    size_type size(void) const {return _Pages ? _Pages->size() : this->_Points.size();}
     size_type countValid(void) const;
     std::vector<value_type> getValidPoints() const;
-    void resize(size_type n){_Points.resize(n);}
-    void reserve(size_type n){_Points.reserve(n);}
+    void resize(size_type n){loadPages(); _Points.resize(n);}
+    void reserve(size_type n){loadPages(); _Points.reserve(n);}
     inline void erase(size_type first, size_type last) {
+        loadPages();
         _Points.erase(_Points.begin()+first,_Points.begin()+last);
     }
 
-    void clear(void){_Points.clear();}
+    void clear(void){detachPages(); _Points.clear();}
 
 
     /// get the points
     inline const Base::Vector3d getPoint(const int idx) const {
-        return transformToOutside(_Points[idx]);
+        return transformToOutside(_Pages ? _Pages->getPoint(idx) : _Points[idx]);
     }
     /// set the points
     inline void setPoint(const int idx,const Base::Vector3d& point) {
+        loadPages();
         _Points[idx] = transformToInside(point);
     }
     /// insert the points
     inline void push_back(const Base::Vector3d& point) {
+        loadPages();
         _Points.push_back(transformToInside(point));
     }
 
@@ -143,13 +185,13 @@ public:
     public:
         typedef PointKernel::value_type kernel_type;
         typedef Base::Vector3d value_type;
-        typedef std::vector<kernel_type>::const_iterator iter_type;
-        typedef iter_type::difference_type difference_type;
-        typedef iter_type::iterator_category iterator_category;
+        typedef const kernel_type* iter_type;
+        typedef PointKernel::difference_type difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
         typedef const value_type* pointer;
         typedef const value_type& reference;
 
-        const_point_iterator(const PointKernel*, std::vector<kernel_type>::const_iterator index);
+        const_point_iterator(const PointKernel*, iter_type index);
         const_point_iterator(const const_point_iterator& pi);
         //~const_point_iterator();
 
@@ -171,7 +213,7 @@ public:
         void dereference();
         const PointKernel* _kernel;
         value_type _point;
-        std::vector<kernel_type>::const_iterator _p_it;
+        iter_type _p_it;
     };
 
     typedef const_point_iterator const_iterator;
@@ -180,9 +222,9 @@ public:
     /** @name Iterator */
     //@{
     const_point_iterator begin() const
-    { return const_point_iterator(this, _Points.begin()); }
+    { return const_point_iterator(this, data()); }
     const_point_iterator end() const
-    { return const_point_iterator(this, _Points.end()); }
+    { return const_point_iterator(this, data() + size()); }
     const_reverse_iterator rbegin() const
     { return const_reverse_iterator(end()); }
     const_reverse_iterator rend() const
@@ -26,6 +26,9 @@
 #ifdef FC_OS_LINUX
 # include <unistd.h>
 #endif
+# include <algorithm>
+# include <cstring>
+# include <limits>
 # include <sstream>
 #endif
 
@@ -45,11 +48,757 @@
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
 
-#include <boost/regex.hpp>
+#include <QByteArray>
+#include <QFile>
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
 #include <boost/math/special_functions/fpclassify.hpp>
 
 using namespace Points;
 
+namespace {
+
+/**
+ * Maps a file into memory. If this is not possible the file is read into a buffer.
+ */
+class MappedFile
+{
+public:
+    MappedFile(const std::string& filename)
+      : file(QString::fromUtf8(filename.c_str())), data(0), size(0)
+    {
+        if (file.open(QIODevice::ReadOnly)) {
+            qint64 length = file.size();
+            if (length > 0) {
+                data = reinterpret_cast<const char*>(file.map(0, length));
+                if (data) {
+                    size = static_cast<std::size_t>(length);
+                }
+                else {
+                    buffer = file.readAll();
+                    data = buffer.constData();
+                    size = static_cast<std::size_t>(buffer.size());
+                }
+            }
+        }
+    }
+    bool isOpen() const
+    {
+        return file.isOpen();
+    }
+    const char* begin() const
+    {
+        return data;
+    }
+    const char* end() const
+    {
+        return data + size;
+    }
+    std::size_t length() const
+    {
+        return size;
+    }
+
+private:
+    QFile file;
+    QByteArray buffer;
+    const char* data;
+    std::size_t size;
+};
+
+// ----------------------------------------------------------------------------
+
+inline bool isDigit(char c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+inline bool isSeparator(char c)
+{
+    return (c == ' ' || c == '\t' || c == ',' || c == ';');
+}
+
+inline bool isEndOfLine(char c)
+{
+    return (c == '\n' || c == '\r');
+}
+
+inline double powerOfTen(int exp)
+{
+    // the powers up to 1e22 are exactly representable
+    static const double table[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if (exp <= 22)
+        return table[exp];
+    return std::pow(10.0, exp);
+}
+
+/**
+ * Scans a decimal number like std::strtod() does but without locale and with
+ * a slightly lower precision than a double, which is good enough for points
+ * stored with single precision. "nan" in any case is read as NaN, as scanners
+ * write it for invalid points. Returns the position after the number or null
+ * if there is no number. \a integer is set if it has no fraction or exponent.
+ */
+const char* scanNumber(const char* p, const char* end, double& value, bool& integer)
+{
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    if (end - p >= 3 && (p[0] == 'n' || p[0] == 'N') && (p[1] == 'a' || p[1] == 'A') &&
+                        (p[2] == 'n' || p[2] == 'N')) {
+        p += 3;
+        if (p != end && !isSeparator(*p) && !isEndOfLine(*p))
+            return 0;
+        value = std::numeric_limits<double>::quiet_NaN();
+        integer = false;
+        return p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    integer = true;
+
+    for (; p != end && isDigit(*p); ++p) {
+        anyDigit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa > 0)
+                digits++;
+        }
+        else {
+            exponent++;
+        }
+    }
+
+    if (p != end && *p == '.') {
+        integer = false;
+        for (++p; p != end && isDigit(*p); ++p) {
+            anyDigit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa > 0)
+                    digits++;
+                exponent--;
+            }
+        }
+    }
+
+    if (!anyDigit)
+        return 0;
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negexp = false;
+        if (q != end && (*q == '-' || *q == '+')) {
+            negexp = (*q == '-');
+            ++q;
+        }
+        if (q != end && isDigit(*q)) {
+            int exp = 0;
+            for (; q != end && isDigit(*q); ++q) {
+                if (exp < 10000)
+                    exp = exp * 10 + (*q - '0');
+            }
+            exponent += negexp ? -exp : exp;
+            integer = false;
+            p = q;
+        }
+    }
+
+    // the number must be followed by a separator
+    if (p != end && !isSeparator(*p) && !isEndOfLine(*p))
+        return 0;
+
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0)
+        result /= powerOfTen(-exponent);
+    else if (exponent > 0)
+        result *= powerOfTen(exponent);
+    value = negative ? -result : result;
+    return p;
+}
+
+/**
+ * Scans the numbers of the line at \a p and stores the first \a maxValues of them.
+ * Returns the number of values or -1 if the line contains anything else. At return
+ * \a p points to the start of the next line.
+ */
+int scanLine(const char*& p, const char* end, double* values, bool* integer, int maxValues)
+{
+    int count = 0;
+    bool valid = true;
+    while (p != end) {
+        while (p != end && isSeparator(*p))
+            ++p;
+        if (p == end || isEndOfLine(*p))
+            break;
+
+        double value;
+        bool isInteger;
+        const char* next = scanNumber(p, end, value, isInteger);
+        if (!next) {
+            valid = false;
+            while (p != end && !isEndOfLine(*p))
+                ++p;
+            break;
+        }
+
+        if (count < maxValues) {
+            values[count] = value;
+            integer[count] = isInteger;
+        }
+        count++;
+        p = next;
+    }
+
+    // skip the line end
+    while (p != end && *p != '\n')
+        ++p;
+    if (p != end)
+        ++p;
+
+    return valid ? count : -1;
+}
+
+/**
+ * The columns of an ASCII point file after the coordinates. Depending on the
+ * number of columns these can be the intensity and triples of color or normal
+ * values. A triple of integers is taken as 8-bit color.
+ */
+struct AsciiLayout
+{
+    int columns;
+    int intensity;
+    int color;
+    int normal;
+
+    AsciiLayout() : columns(3), intensity(-1), color(-1), normal(-1)
+    {
+    }
+    void setup(int count, const bool* integer)
+    {
+        columns = count;
+        int extra = count - 3;
+        int triple = 3;
+        if (extra == 1 || extra == 4 || extra == 7) {
+            intensity = 3;
+            triple = 4;
+            extra--;
+        }
+        if (extra != 3 && extra != 6)
+            return;
+        for (int i = triple; i < triple + extra; i += 3) {
+            bool isColor = integer[i] && integer[i+1] && integer[i+2];
+            if (isColor && color < 0)
+                color = i;
+            else if (!isColor && normal < 0)
+                normal = i;
+        }
+    }
+};
+
+/**
+ * A part of an ASCII file that is read by one thread. Each line is stored at
+ * the index of its line in the chunk, afterwards the points are moved together.
+ */
+struct AsciiChunk
+{
+    const char* begin;
+    const char* end;
+    unsigned long offset;
+    unsigned long lines;
+    unsigned long count;
+};
+
+struct AsciiOutput
+{
+    const AsciiLayout* layout;
+    Base::Vector3f* points;
+    float* intensity;
+    App::Color* colors;
+    Base::Vector3f* normals;
+};
+
+void countLines(AsciiChunk* chunk)
+{
+    chunk->lines = static_cast<unsigned long>(std::count(chunk->begin, chunk->end, '\n')) + 1;
+}
+
+void readAsciiChunk(AsciiChunk* chunk, const AsciiOutput* out)
+{
+    const AsciiLayout& layout = *out->layout;
+    double values[16];
+    bool integer[16];
+    unsigned long index = chunk->offset;
+    const char* p = chunk->begin;
+    while (p != chunk->end) {
+        int count = scanLine(p, chunk->end, values, integer, 16);
+        if (count != layout.columns)
+            continue;
+
+        out->points[index].Set(static_cast<float>(values[0]),
+                               static_cast<float>(values[1]),
+                               static_cast<float>(values[2]));
+        if (out->intensity && layout.intensity >= 0) {
+            out->intensity[index] = static_cast<float>(values[layout.intensity]);
+        }
+        if (out->colors && layout.color >= 0) {
+            const double* rgb = values + layout.color;
+            out->colors[index].set(static_cast<float>(rgb[0]) / 255.0f,
+                                   static_cast<float>(rgb[1]) / 255.0f,
+                                   static_cast<float>(rgb[2]) / 255.0f);
+        }
+        if (out->normals && layout.normal >= 0) {
+            const double* n = values + layout.normal;
+            out->normals[index].Set(static_cast<float>(n[0]),
+                                    static_cast<float>(n[1]),
+                                    static_cast<float>(n[2]));
+        }
+        index++;
+    }
+    chunk->count = index - chunk->offset;
+}
+
+template <typename T>
+void compactChunks(std::vector<T>& data, const std::vector<AsciiChunk>& chunks)
+{
+    if (data.empty())
+        return;
+    unsigned long count = 0;
+    for (std::vector<AsciiChunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        typename std::vector<T>::iterator first = data.begin() + it->offset;
+        std::copy(first, first + it->count, data.begin() + count);
+        count += it->count;
+    }
+    data.resize(count);
+}
+
+/**
+ * The first line with at least three numbers defines the columns of an ASCII file.
+ */
+AsciiLayout findAsciiLayout(const MappedFile& file)
+{
+    AsciiLayout layout;
+    const char* p = file.begin();
+    while (p != file.end()) {
+        double values[16];
+        bool integer[16];
+        int count = scanLine(p, file.end(), values, integer, 16);
+        if (count >= 3 && count <= 16) {
+            layout.setup(count, integer);
+            break;
+        }
+    }
+    return layout;
+}
+
+/**
+ * Splits an ASCII file into chunks at line ends.
+ */
+std::vector<AsciiChunk> splitAsciiChunks(const MappedFile& file)
+{
+    const std::size_t chunkSize = 4 * 1024 * 1024;
+    std::vector<AsciiChunk> chunks;
+    const char* begin = file.begin();
+    while (begin != file.end()) {
+        const char* end = file.end();
+        if (static_cast<std::size_t>(end - begin) > chunkSize) {
+            end = std::find(begin + chunkSize, file.end(), '\n');
+            if (end != file.end())
+                ++end;
+        }
+        AsciiChunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        chunk.offset = 0;
+        chunk.lines = 0;
+        chunk.count = 0;
+        chunks.push_back(chunk);
+        begin = end;
+    }
+    return chunks;
+}
+
+/**
+ * Parses the chunks in parallel. The properties are only read if the
+ * corresponding vector is given.
+ */
+void readAsciiChunks(std::vector<AsciiChunk>& chunks, const AsciiLayout& layout,
+                     std::vector<Base::Vector3f>& points, std::vector<float>* intensity,
+                     std::vector<App::Color>* colors, std::vector<Base::Vector3f>* normals,
+                     Base::SequencerLauncher& seq)
+{
+    QList< QFuture<void> > futures;
+    for (std::vector<AsciiChunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+        futures << QtConcurrent::run(countLines, &(*it));
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+        it->waitForFinished();
+    futures.clear();
+
+    unsigned long lines = 0;
+    for (std::vector<AsciiChunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        it->offset = lines;
+        lines += it->lines;
+    }
+
+    points.resize(lines);
+    AsciiOutput out;
+    out.layout = &layout;
+    out.points = lines > 0 ? &points[0] : 0;
+    out.intensity = 0;
+    out.colors = 0;
+    out.normals = 0;
+    if (intensity && layout.intensity >= 0) {
+        intensity->resize(lines);
+        out.intensity = lines > 0 ? &(*intensity)[0] : 0;
+    }
+    if (colors && layout.color >= 0) {
+        colors->resize(lines);
+        out.colors = lines > 0 ? &(*colors)[0] : 0;
+    }
+    if (normals && layout.normal >= 0) {
+        normals->resize(lines);
+        out.normals = lines > 0 ? &(*normals)[0] : 0;
+    }
+
+    for (std::vector<AsciiChunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+        futures << QtConcurrent::run(readAsciiChunk, &(*it), &out);
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it) {
+        it->waitForFinished();
+        seq.next();
+    }
+
+    compactChunks(points, chunks);
+    if (intensity)
+        compactChunks(*intensity, chunks);
+    if (colors)
+        compactChunks(*colors, chunks);
+    if (normals)
+        compactChunks(*normals, chunks);
+}
+
+/**
+ * Reads an ASCII file with one point per line. Lines that don't have the same
+ * number of columns as the first point are skipped, like comments or headers.
+ * Points with NaN coordinates are kept, fromValid() of the Python API removes them.
+ * The file is split into chunks that are parsed in parallel. The properties
+ * are only read if the corresponding vector is given.
+ */
+void readAsciiPoints(const std::string& filename, std::vector<Base::Vector3f>& points,
+                     std::vector<float>* intensity, std::vector<App::Color>* colors,
+                     std::vector<Base::Vector3f>* normals)
+{
+    MappedFile file(filename);
+    if (!file.isOpen())
+        throw Base::FileException("File to load not existing or not readable", filename.c_str());
+
+    AsciiLayout layout = findAsciiLayout(file);
+    std::vector<AsciiChunk> chunks = splitAsciiChunks(file);
+    Base::SequencerLauncher seq("Loading points...", chunks.size());
+    readAsciiChunks(chunks, layout, points, intensity, colors, normals, seq);
+}
+
+/**
+ * Reads the points of an ASCII file into a page file. Only a few chunks are
+ * parsed at once, so the file can be larger than the memory.
+ */
+void readAsciiPages(const std::string& filename, PointPagesBuilder& builder)
+{
+    MappedFile file(filename);
+    if (!file.isOpen())
+        throw Base::FileException("File to load not existing or not readable", filename.c_str());
+
+    AsciiLayout layout = findAsciiLayout(file);
+    std::vector<AsciiChunk> chunks = splitAsciiChunks(file);
+    std::size_t group = static_cast<std::size_t>(std::max(1, QThread::idealThreadCount())) * 4;
+    Base::SequencerLauncher seq("Loading points...", chunks.size());
+    std::vector<Base::Vector3f> points;
+    for (std::size_t i = 0; i < chunks.size(); i += group) {
+        std::vector<AsciiChunk> part(chunks.begin() + i, chunks.begin() + std::min(i + group, chunks.size()));
+        readAsciiChunks(part, layout, points, 0, 0, 0, seq);
+        builder.add(points);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+#ifdef HAVE_PCL_IO
+/**
+ * Describes where a value of a point record of a binary file is stored.
+ */
+struct BinaryField
+{
+    enum Type {
+        None, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+    };
+
+    Type type;
+    std::size_t offset;
+
+    BinaryField() : type(None), offset(0)
+    {
+    }
+    bool isValid() const
+    {
+        return type != None;
+    }
+    bool isInteger() const
+    {
+        return type != Float32 && type != Float64;
+    }
+    static Type fromName(const std::string& name)
+    {
+        if (name == "char" || name == "int8")
+            return Int8;
+        if (name == "uchar" || name == "uint8")
+            return UInt8;
+        if (name == "short" || name == "int16")
+            return Int16;
+        if (name == "ushort" || name == "uint16")
+            return UInt16;
+        if (name == "int" || name == "int32")
+            return Int32;
+        if (name == "uint" || name == "uint32")
+            return UInt32;
+        if (name == "float" || name == "float32")
+            return Float32;
+        if (name == "double" || name == "float64")
+            return Float64;
+        return None;
+    }
+    static std::size_t sizeOf(Type type)
+    {
+        switch (type) {
+        case Int8:
+        case UInt8:
+            return 1;
+        case Int16:
+        case UInt16:
+            return 2;
+        case Int32:
+        case UInt32:
+        case Float32:
+            return 4;
+        case Float64:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+    /// Reads the value of a record, the file and the machine must be little-endian
+    double read(const char* record) const
+    {
+        const char* p = record + offset;
+        switch (type) {
+        case Int8:
+            return static_cast<double>(*reinterpret_cast<const int8_t*>(p));
+        case UInt8:
+            return static_cast<double>(*reinterpret_cast<const uint8_t*>(p));
+        case Int16: {
+            int16_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        case UInt16: {
+            uint16_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        case Int32: {
+            int32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        case UInt32: {
+            uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        case Float32: {
+            float v; std::memcpy(&v, p, sizeof(v)); return v; }
+        case Float64: {
+            double v; std::memcpy(&v, p, sizeof(v)); return v; }
+        default:
+            return 0.0;
+        }
+    }
+};
+
+/**
+ * The layout of the point records of a binary PLY or PCD file.
+ */
+struct BinaryLayout
+{
+    std::size_t stride;
+    BinaryField x, y, z;
+    BinaryField nx, ny, nz;
+    BinaryField red, green, blue;
+    BinaryField rgb; // red, green and blue packed into four bytes
+    BinaryField intensity;
+
+    BinaryLayout() : stride(0)
+    {
+    }
+    void addField(const std::string& name, BinaryField::Type type, std::size_t offset)
+    {
+        BinaryField field;
+        field.type = type;
+        field.offset = offset;
+        if (name == "x")
+            x = field;
+        else if (name == "y")
+            y = field;
+        else if (name == "z")
+            z = field;
+        else if (name == "nx" || name == "normal_x")
+            nx = field;
+        else if (name == "ny" || name == "normal_y")
+            ny = field;
+        else if (name == "nz" || name == "normal_z")
+            nz = field;
+        else if (name == "red" || name == "r")
+            red = field;
+        else if (name == "green" || name == "g")
+            green = field;
+        else if (name == "blue" || name == "b")
+            blue = field;
+        else if ((name == "rgb" || name == "rgba") && BinaryField::sizeOf(type) == 4)
+            rgb = field;
+        else if (name == "intensity")
+            intensity = field;
+    }
+    bool hasPoints() const
+    {
+        return x.isValid() && y.isValid() && z.isValid();
+    }
+    bool hasNormals() const
+    {
+        return nx.isValid() && ny.isValid() && nz.isValid();
+    }
+    bool hasColors() const
+    {
+        return (red.isValid() && green.isValid() && blue.isValid()) || rgb.isValid();
+    }
+    bool hasIntensity() const
+    {
+        return intensity.isValid();
+    }
+};
+
+struct BinaryOutput
+{
+    const BinaryLayout* layout;
+    const char* data;
+    Base::Vector3f* points;
+    float* intensity;
+    App::Color* colors;
+    Base::Vector3f* normals;
+};
+
+void readBinaryRecords(const BinaryOutput* out, unsigned long begin, unsigned long end)
+{
+    const BinaryLayout& layout = *out->layout;
+    float colorScale = layout.red.isInteger() ? 1.0f / 255.0f : 1.0f;
+    for (unsigned long i = begin; i < end; i++) {
+        const char* record = out->data + i * layout.stride;
+        out->points[i].Set(static_cast<float>(layout.x.read(record)),
+                           static_cast<float>(layout.y.read(record)),
+                           static_cast<float>(layout.z.read(record)));
+        if (out->intensity) {
+            out->intensity[i] = static_cast<float>(layout.intensity.read(record));
+        }
+        if (out->normals) {
+            out->normals[i].Set(static_cast<float>(layout.nx.read(record)),
+                                static_cast<float>(layout.ny.read(record)),
+                                static_cast<float>(layout.nz.read(record)));
+        }
+        if (out->colors) {
+            if (layout.rgb.isValid()) {
+                uint32_t packed;
+                std::memcpy(&packed, record + layout.rgb.offset, sizeof(packed));
+                out->colors[i].set(((packed >> 16) & 0xff) / 255.0f,
+                                   ((packed >> 8) & 0xff) / 255.0f,
+                                   (packed & 0xff) / 255.0f);
+            }
+            else {
+                out->colors[i].set(static_cast<float>(layout.red.read(record)) * colorScale,
+                                   static_cast<float>(layout.green.read(record)) * colorScale,
+                                   static_cast<float>(layout.blue.read(record)) * colorScale);
+            }
+        }
+    }
+}
+
+/**
+ * Reads \a count records from \a data in parallel blocks into the kernel and the
+ * properties that the layout provides.
+ */
+void readBinaryPoints(const char* data, unsigned long count, const BinaryLayout& layout,
+                      PointKernel& points, std::vector<float>& intensity,
+                      std::vector<App::Color>& colors, std::vector<Base::Vector3f>& normals)
+{
+    std::vector<Base::Vector3f> pts(count);
+    if (layout.hasIntensity())
+        intensity.resize(count);
+    if (layout.hasColors())
+        colors.resize(count);
+    if (layout.hasNormals())
+        normals.resize(count);
+
+    BinaryOutput out;
+    out.layout = &layout;
+    out.data = data;
+    out.points = count > 0 ? &pts[0] : 0;
+    out.intensity = intensity.empty() ? 0 : &intensity[0];
+    out.colors = colors.empty() ? 0 : &colors[0];
+    out.normals = normals.empty() ? 0 : &normals[0];
+
+    unsigned long threads = std::max(1, QThread::idealThreadCount());
+    if (count < 100000)
+        threads = 1;
+    QList< QFuture<void> > futures;
+    for (unsigned long i = 0; i < threads; i++) {
+        unsigned long begin = (static_cast<uint64_t>(count) * i) / threads;
+        unsigned long end = (static_cast<uint64_t>(count) * (i + 1)) / threads;
+        futures << QtConcurrent::run(readBinaryRecords, &out, begin, end);
+    }
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+        it->waitForFinished();
+
+    points.swap(pts);
+}
+
+bool isLittleEndian()
+{
+    uint16_t value = 1;
+    unsigned char byte;
+    std::memcpy(&byte, &value, 1);
+    return byte == 1;
+}
+
+/**
+ * Reads the next line of a file header and splits it into words.
+ */
+bool readHeaderLine(const char*& p, const char* end, std::vector<std::string>& words)
+{
+    words.clear();
+    if (p == end)
+        return false;
+    const char* eol = std::find(p, end, '\n');
+    std::string line(p, eol);
+    p = (eol == end) ? end : eol + 1;
+    std::istringstream str(line);
+    std::string word;
+    while (str >> word)
+        words.push_back(word);
+    return true;
+}
+#endif
+
+}
+
+// ----------------------------------------------------------------------------
+
+
 void PointsAlgos::Load(PointKernel &points, const char *FileName)
 {
     Base::FileInfo File(FileName);
@@ -66,57 +815,31 @@ void PointsAlgos::Load(PointKernel &points, const char *FileName)
 
 void PointsAlgos::LoadAscii(PointKernel &points, const char *FileName)
 {
-    boost::regex rx("^\\s*([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$");
-    //boost::regex rx("(\\b[0-9]+\\.([0-9]+\\b)?|\\.[0-9]+\\b)");
-    //boost::regex rx("^\\s*(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s*$");
-    boost::cmatch what;
-
-    Base::Vector3d pt;
-    int LineCnt=0;
-    std::string line;
-    Base::FileInfo fi(FileName);
-
-    Base::ifstream tmp_str(fi, std::ios::in);
-
-    // estimating size
-    while (std::getline(tmp_str,line))
-        LineCnt++;
-
-    // resize the PointKernel
-    points.resize(LineCnt);
-
-    Base::SequencerLauncher seq( "Loading points...", LineCnt );
-
-    // again to the beginning
-    Base::ifstream file(fi, std::ios::in);
-    LineCnt = 0;
+    std::vector<Base::Vector3f> pts;
 
     try {
-        // read file
-        while (std::getline(file, line)) {
-            if (boost::regex_match(line.c_str(), what, rx)) {
-                pt.x = std::atof(what[1].first);
-                pt.y = std::atof(what[4].first);
-                pt.z = std::atof(what[7].first);
-
-                points.setPoint(LineCnt,pt);
-                seq.next();
-                LineCnt++;
-            }
-        }
+        readAsciiPoints(FileName, pts, 0, 0, 0);
     }
     catch (...) {
         points.clear();
         throw Base::Exception("Reading in points failed.");
     }
 
-    // now remove the last points from the kernel
-    // Note: first we allocate memory corresponding to the number of lines (points and comments)
-    //       and read in the file twice. But then the size of the kernel is too high
-    if (LineCnt < (int)points.size())
-        points.erase(LineCnt, points.size());
+    if (points.getTransform() == Base::Matrix4D()) {
+        points.swap(pts);
+    }
+    else {
+        points.resize(pts.size());
+        for (std::size_t i = 0; i < pts.size(); i++)
+            points.setPoint(i, Base::Vector3d(pts[i].x, pts[i].y, pts[i].z));
+    }
+}
+
+void PointsAlgos::LoadPaged(PointKernel &points, const char *FileName, const char *PageFile)
+{
+    PointPagesBuilder builder(PageFile);
+    readAsciiPages(FileName, builder);
+    points.setPages(builder.build());
 }
 
 // ----------------------------------------------------------------------------
@@ -205,7 +928,11 @@ AscReader::~AscReader()
 
 void AscReader::read(const std::string& filename)
 {
-    points.load(filename.c_str());
+    clear();
+
+    std::vector<Base::Vector3f> pts;
+    readAsciiPoints(filename, pts, &intensity, &colors, &normals);
+    points.swap(pts);
 }
 
 // ----------------------------------------------------------------------------
@@ -223,6 +950,10 @@ void PlyReader::read(const std::string& filename)
 {
     clear();
 
+    // binary little-endian files are read directly, all others with PCL
+    if (readBinary(filename))
+        return;
+
     // pcl test
     pcl::PCLPointCloud2 cloud2;
     Eigen::Vector4f origin;
@@ -323,6 +1054,71 @@ void PlyReader::read(const std::string& filename)
 
 // ----------------------------------------------------------------------------
 
+bool PlyReader::readBinary(const std::string& filename)
+{
+    if (!isLittleEndian())
+        return false;
+
+    MappedFile file(filename);
+    if (!file.isOpen() || file.length() == 0)
+        return false;
+
+    const char* p = file.begin();
+    const char* end = file.end();
+    std::vector<std::string> words;
+    if (!readHeaderLine(p, end, words) || words.size() != 1 || words[0] != "ply")
+        return false;
+
+    BinaryLayout layout;
+    unsigned long count = 0;
+    int elements = 0;
+    bool vertex = false;
+    bool binary = false;
+    bool header = false;
+    while (readHeaderLine(p, end, words)) {
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+            continue;
+        if (words[0] == "end_header") {
+            header = true;
+            break;
+        }
+        if (words[0] == "format") {
+            binary = (words.size() > 1 && words[1] == "binary_little_endian");
+        }
+        else if (words[0] == "element") {
+            // only handle files where the vertices come first
+            if (elements++ > 0) {
+                vertex = false;
+            }
+            else if (words.size() == 3 && words[1] == "vertex") {
+                vertex = true;
+                count = std::strtoul(words[2].c_str(), 0, 10);
+            }
+            else {
+                return false;
+            }
+        }
+        else if (words[0] == "property" && vertex) {
+            // list properties have a variable size
+            if (words.size() != 3)
+                return false;
+            BinaryField::Type type = BinaryField::fromName(words[1]);
+            if (type == BinaryField::None)
+                return false;
+            layout.addField(words[2], type, layout.stride);
+            layout.stride += BinaryField::sizeOf(type);
+        }
+    }
+
+    if (!header || !binary || !layout.hasPoints())
+        return false;
+    if (static_cast<std::size_t>(end - p) / layout.stride < count)
+        return false;
+
+    readBinaryPoints(p, count, layout, points, intensity, colors, normals);
+    return true;
+}
+
 PcdReader::PcdReader()
 {
 }
@@ -335,6 +1131,10 @@ void PcdReader::read(const std::string& filename)
 {
     clear();
 
+    // uncompressed binary files are read directly, all others with PCL
+    if (readBinary(filename))
+        return;
+
     // pcl test
     pcl::PCLPointCloud2 cloud2;
     Eigen::Vector4f origin;
@@ -436,6 +1236,103 @@ void PcdReader::read(const std::string& filename)
     }
 }
 
+bool PcdReader::readBinary(const std::string& filename)
+{
+    if (!isLittleEndian())
+        return false;
+
+    MappedFile file(filename);
+    if (!file.isOpen() || file.length() == 0)
+        return false;
+
+    const char* p = file.begin();
+    const char* end = file.end();
+    std::vector<std::string> words;
+    std::vector<std::string> fields;
+    std::vector<std::size_t> sizes;
+    std::vector<char> types;
+    std::vector<std::size_t> counts;
+    unsigned long count = 0;
+    int w = 0, h = 0;
+    bool binary = false;
+    while (readHeaderLine(p, end, words)) {
+        if (words.empty() || words[0][0] == '#')
+            continue;
+        if (words[0] == "FIELDS") {
+            fields.assign(words.begin() + 1, words.end());
+        }
+        else if (words[0] == "SIZE") {
+            for (std::size_t i = 1; i < words.size(); i++)
+                sizes.push_back(std::strtoul(words[i].c_str(), 0, 10));
+        }
+        else if (words[0] == "TYPE") {
+            for (std::size_t i = 1; i < words.size(); i++)
+                types.push_back(words[i][0]);
+        }
+        else if (words[0] == "COUNT") {
+            for (std::size_t i = 1; i < words.size(); i++)
+                counts.push_back(std::strtoul(words[i].c_str(), 0, 10));
+        }
+        else if (words[0] == "WIDTH" && words.size() > 1) {
+            w = std::atoi(words[1].c_str());
+        }
+        else if (words[0] == "HEIGHT" && words.size() > 1) {
+            h = std::atoi(words[1].c_str());
+        }
+        else if (words[0] == "POINTS" && words.size() > 1) {
+            count = std::strtoul(words[1].c_str(), 0, 10);
+        }
+        else if (words[0] == "DATA") {
+            // the data section starts after this line
+            binary = (words.size() > 1 && words[1] == "binary");
+            break;
+        }
+    }
+
+    if (!binary || fields.empty() || sizes.size() != fields.size() || types.size() != fields.size())
+        return false;
+    if (counts.empty())
+        counts.resize(fields.size(), 1);
+    if (counts.size() != fields.size())
+        return false;
+
+    BinaryLayout layout;
+    for (std::size_t i = 0; i < fields.size(); i++) {
+        BinaryField::Type type = BinaryField::None;
+        switch (types[i]) {
+        case 'F':
+            type = sizes[i] == 4 ? BinaryField::Float32 : sizes[i] == 8 ? BinaryField::Float64 : BinaryField::None;
+            break;
+        case 'U':
+            type = sizes[i] == 1 ? BinaryField::UInt8 : sizes[i] == 2 ? BinaryField::UInt16 :
+                   sizes[i] == 4 ? BinaryField::UInt32 : BinaryField::None;
+            break;
+        case 'I':
+            type = sizes[i] == 1 ? BinaryField::Int8 : sizes[i] == 2 ? BinaryField::Int16 :
+                   sizes[i] == 4 ? BinaryField::Int32 : BinaryField::None;
+            break;
+        default:
+            break;
+        }
+        // fields with several values like histograms are skipped
+        if (counts[i] == 1 && type != BinaryField::None)
+            layout.addField(fields[i], type, layout.stride);
+        layout.stride += sizes[i] * counts[i];
+    }
+
+    if (!layout.hasPoints() || layout.stride == 0)
+        return false;
+    if (count == 0)
+        count = static_cast<unsigned long>(w) * static_cast<unsigned long>(h);
+    if (static_cast<std::size_t>(end - p) / layout.stride < count)
+        return false;
+
+    readBinaryPoints(p, count, layout, points, intensity, colors, normals);
+    width = w;
+    height = h;
+    return true;
+}
+
 #endif
 
 // ----------------------------------------------------------------------------
@@ -511,8 +1408,8 @@ void PlyWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZRGBNormal> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const Base::Vector3f& n = normals[index];
@@ -538,8 +1435,8 @@ void PlyWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZINormal> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const Base::Vector3f& n = normals[index];
@@ -562,8 +1459,8 @@ void PlyWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZRGBA> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const App::Color& c = colors[index];
@@ -585,8 +1482,8 @@ void PlyWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZI> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             if (!boost::math::isnan(p.x) && !boost::math::isnan(p.y) && !boost::math::isnan(p.z)) {
@@ -605,8 +1502,8 @@ void PlyWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointNormal> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const Base::Vector3f& n = normals[index];
@@ -657,8 +1554,8 @@ void PcdWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZRGBNormal> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const Base::Vector3f& n = normals[index];
@@ -685,8 +1582,8 @@ void PcdWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZINormal> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const Base::Vector3f& n = normals[index];
@@ -710,8 +1607,8 @@ void PcdWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZRGBA> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const App::Color& c = colors[index];
@@ -734,8 +1631,8 @@ void PcdWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointXYZI> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             pcl::PointXYZI pi;
@@ -755,8 +1652,8 @@ void PcdWriter::write(const std::string& filename)
         pcl::PointCloud<pcl::PointNormal> cloud_out;
         cloud_out.reserve(points.size());
 
-        const std::vector<Base::Vector3f>& pts = points.getBasicPoints();
-        std::size_t num_points = pts.size();
+        const Base::Vector3f* pts = points.data();
+        std::size_t num_points = points.size();
         for (std::size_t index=0; index<num_points; index++) {
             const Base::Vector3f& p = pts[index];
             const Base::Vector3f& n = normals[index];
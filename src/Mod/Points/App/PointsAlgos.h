@@ -41,6 +41,11 @@ public:
     /** Load a point cloud
      */
     static void LoadAscii(PointKernel&, const char *FileName);
+    /** Sort the points of an ASCII file into the page file \a PageFile and use
+     * it as storage of the point cloud. The file is read in parts, so it can be
+     * larger than the memory.
+     */
+    static void LoadPaged(PointKernel&, const char *FileName, const char *PageFile);
 };
 
 class Reader
@@ -86,6 +91,9 @@ public:
     PlyReader();
     ~PlyReader();
     void read(const std::string& filename);
+
+private:
+    bool readBinary(const std::string& filename);
 };
 
 class PcdReader : public Reader
@@ -94,6 +102,9 @@ public:
     PcdReader();
     ~PcdReader();
     void read(const std::string& filename);
+
+private:
+    bool readBinary(const std::string& filename);
 };
 #endif
 
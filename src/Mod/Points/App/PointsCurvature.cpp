@@ -0,0 +1,331 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cfloat>
+# include <cmath>
+#endif
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <Eigen/Eigenvalues>
+#include <Eigen/QR>
+
+#include <Base/Sequencer.h>
+
+#include "PointsCurvature.h"
+#include "PointsKdTree.h"
+
+using namespace Points;
+
+namespace {
+
+/**
+ * The CurvatureEstimation class processes the points of a kd-tree in chunks of
+ * the tree order. The threads take the chunks one after another and write the
+ * results of each point to its index, so no locking is needed.
+ */
+class CurvatureEstimation
+{
+public:
+    CurvatureEstimation(const PointsKdTree& tree, unsigned long k, float radius,
+                        const Base::Vector3f& view, std::vector<Base::Vector3f>& normals,
+                        std::vector<CurvatureInfo>* curvature)
+      : _tree(tree), _k(k), _radius(radius), _view(view)
+      , _normals(normals), _curvature(curvature)
+      , _nextChunk(0), _countDone(0), _ulCountReported(0)
+    {
+        _ulCountChunks = (tree.CountEntries() + ChunkSize - 1) / ChunkSize;
+    }
+    unsigned long CountChunks() const
+    {
+        return _ulCountChunks;
+    }
+    /// Processes all points with \a threads threads, the progress is reported to \a seq
+    void Run(int threads, Base::SequencerLauncher& seq)
+    {
+        if (threads < 2 || _ulCountChunks < 2) {
+            ProcessChunks(&seq);
+            return;
+        }
+
+        QList< QFuture<void> > futures;
+        for (int i = 1; i < threads; i++) {
+            Base::SequencerLauncher* progress = 0;
+            futures << QtConcurrent::run(this, &CurvatureEstimation::ProcessChunks, progress);
+        }
+
+        try {
+            // the calling thread takes part and reports the progress of all threads
+            ProcessChunks(&seq);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+                it->waitForFinished();
+            ReportProgress(seq);
+        }
+        catch (...) {
+            // the user has aborted, stop the other threads before the data is destroyed
+            _nextChunk.fetchAndStoreOrdered((int)_ulCountChunks);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it) {
+                try {
+                    it->waitForFinished();
+                }
+                catch (...) {
+                }
+            }
+            throw;
+        }
+    }
+
+private:
+    void ProcessChunks(Base::SequencerLauncher* seq)
+    {
+        std::vector<unsigned long> entries;
+        std::vector<float> dist;
+        for (;;) {
+            unsigned long ulChunk = (unsigned long)_nextChunk.fetchAndAddOrdered(1);
+            if (ulChunk >= _ulCountChunks)
+                break;
+            unsigned long ulBegin = ulChunk * ChunkSize;
+            unsigned long ulEnd = std::min<unsigned long>(ulBegin + ChunkSize, _tree.CountEntries());
+            for (unsigned long i = ulBegin; i < ulEnd; i++) {
+                Base::Vector3f pnt = _tree.GetPoint(i);
+                if (_radius > 0.0f)
+                    _tree.FindEntriesInRadius(pnt, _radius, entries, dist);
+                else
+                    _tree.FindNearestEntries(pnt, _k, entries, dist);
+                ProcessPoint(i, pnt, entries);
+            }
+
+            _countDone.fetchAndAddOrdered(1);
+            if (seq)
+                ReportProgress(*seq);
+        }
+    }
+    void ProcessPoint(unsigned long entry, const Base::Vector3f& pnt,
+                      const std::vector<unsigned long>& entries)
+    {
+        // the results are initialized as invalid
+        if (entries.size() < 3)
+            return;
+
+        // the direction of least variance of the neighbours is the normal
+        Eigen::Vector3d center(Eigen::Vector3d::Zero());
+        for (std::vector<unsigned long>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            Base::Vector3f p = _tree.GetPoint(*it);
+            center += Eigen::Vector3d(p.x, p.y, p.z);
+        }
+        center /= (double)entries.size();
+        Eigen::Matrix3d covMat(Eigen::Matrix3d::Zero());
+        for (std::vector<unsigned long>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            Base::Vector3f p = _tree.GetPoint(*it);
+            Eigen::Vector3d d = Eigen::Vector3d(p.x, p.y, p.z) - center;
+            covMat += d * d.transpose();
+        }
+
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig;
+        eig.computeDirect(covMat);
+        Eigen::Vector3d w = eig.eigenvectors().col(0);
+        Eigen::Vector3d u = eig.eigenvectors().col(2);
+        Eigen::Vector3d view(_view.x - pnt.x, _view.y - pnt.y, _view.z - pnt.z);
+        if (w.dot(view) < 0.0)
+            w = -w;
+        Eigen::Vector3d v = w.cross(u);
+
+        unsigned long index = _tree.GetIndex(entry);
+        _normals[index].Set((float)w[0], (float)w[1], (float)w[2]);
+        if (_curvature)
+            EstimateCurvature(pnt, entries, u, v, w, (*_curvature)[index]);
+    }
+    /**
+     * Fits the quadric z = a*x^2 + b*x*y + c*y^2 + d*x + e*y + f to the neighbours in
+     * the frame (u,v,w) at \a pnt and computes the principal curvatures at its origin.
+     */
+    void EstimateCurvature(const Base::Vector3f& pnt, const std::vector<unsigned long>& entries,
+                           const Eigen::Vector3d& u, const Eigen::Vector3d& v, const Eigen::Vector3d& w,
+                           CurvatureInfo& info) const
+    {
+        if (entries.size() < 6)
+            return;
+
+        // scale the coordinates to about 1 for a well-conditioned system
+        std::vector<Eigen::Vector3d> local;
+        local.reserve(entries.size());
+        double sqrLength = 0.0;
+        Eigen::Vector3d origin(pnt.x, pnt.y, pnt.z);
+        for (std::vector<unsigned long>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            Base::Vector3f p = _tree.GetPoint(*it);
+            Eigen::Vector3d d = Eigen::Vector3d(p.x, p.y, p.z) - origin;
+            local.push_back(Eigen::Vector3d(d.dot(u), d.dot(v), d.dot(w)));
+            sqrLength += d.squaredNorm();
+        }
+        if (sqrLength <= 0.0)
+            return;
+        double scale = 1.0 / std::sqrt(sqrLength / local.size());
+
+        Eigen::Matrix<double, 6, 6> ata(Eigen::Matrix<double, 6, 6>::Zero());
+        Eigen::Matrix<double, 6, 1> atb(Eigen::Matrix<double, 6, 1>::Zero());
+        for (std::vector<Eigen::Vector3d>::iterator it = local.begin(); it != local.end(); ++it) {
+            double x = (*it)[0] * scale;
+            double y = (*it)[1] * scale;
+            double z = (*it)[2] * scale;
+            Eigen::Matrix<double, 6, 1> row;
+            row << x * x, x * y, y * y, x, y, 1.0;
+            ata += row * row.transpose();
+            atb += row * z;
+        }
+
+        Eigen::ColPivHouseholderQR< Eigen::Matrix<double, 6, 6> > qr(ata);
+        if (qr.rank() < 6)
+            return;
+        Eigen::Matrix<double, 6, 1> coeff = qr.solve(atb);
+
+        // the quadratic coefficients scale with the coordinates, the linear ones do not
+        double fxx = 2.0 * coeff[0] * scale;
+        double fxy = coeff[1] * scale;
+        double fyy = 2.0 * coeff[2] * scale;
+        double fx = coeff[3];
+        double fy = coeff[4];
+
+        // first and second fundamental form of the height field at the origin
+        double E = 1.0 + fx * fx;
+        double F = fx * fy;
+        double G = 1.0 + fy * fy;
+        double W = std::sqrt(1.0 + fx * fx + fy * fy);
+        double L = fxx / W;
+        double M = fxy / W;
+        double N = fyy / W;
+
+        double det = E * G - F * F;
+        double H = (E * N - 2.0 * F * M + G * L) / (2.0 * det);
+        double K = (L * N - M * M) / det;
+        double disc = std::sqrt(std::max(0.0, H * H - K));
+        double k1 = H + disc;
+        double k2 = H - disc;
+        if (!(std::fabs(k1) < FLT_MAX) || !(std::fabs(k2) < FLT_MAX))
+            return;
+
+        Eigen::Vector3d xu = u + fx * w;
+        Eigen::Vector3d xv = v + fy * w;
+        Eigen::Vector3d dir1 = PrincipalDirection(k1, E, F, G, L, M, N, xu, xv);
+        Eigen::Vector3d dir2 = w.cross(dir1);
+
+        info.fMaxCurvature = (float)k1;
+        info.fMinCurvature = (float)k2;
+        info.cMaxCurvDir.Set((float)dir1[0], (float)dir1[1], (float)dir1[2]);
+        info.cMinCurvDir.Set((float)dir2[0], (float)dir2[1], (float)dir2[2]);
+    }
+    /// Returns the direction of the curvature \a k on the surface spanned by \a xu and \a xv
+    static Eigen::Vector3d PrincipalDirection(double k, double E, double F, double G,
+                                              double L, double M, double N,
+                                              const Eigen::Vector3d& xu, const Eigen::Vector3d& xv)
+    {
+        // solve (II - k*I) * (a,b) = 0 with the larger row
+        double r1a = L - k * E, r1b = M - k * F;
+        double r2a = M - k * F, r2b = N - k * G;
+        double a, b;
+        if (r1a * r1a + r1b * r1b >= r2a * r2a + r2b * r2b) {
+            a = -r1b;
+            b = r1a;
+        }
+        else {
+            a = -r2b;
+            b = r2a;
+        }
+
+        Eigen::Vector3d dir = a * xu + b * xv;
+        double len = dir.norm();
+        if (len < 1e-12) // umbilic point, each direction is a principal direction
+            return xu.normalized();
+        return dir / len;
+    }
+    void ReportProgress(Base::SequencerLauncher& seq)
+    {
+        unsigned long ulDone = (unsigned long)_countDone.fetchAndAddOrdered(0);
+        for (; _ulCountReported < ulDone; _ulCountReported++)
+            seq.next(true);
+    }
+
+    static const unsigned long ChunkSize = 4096;
+
+    const PointsKdTree& _tree;
+    unsigned long _k;
+    float _radius;
+    Base::Vector3f _view;
+    std::vector<Base::Vector3f>& _normals;
+    std::vector<CurvatureInfo>* _curvature;
+    unsigned long _ulCountChunks;
+    QAtomicInt _nextChunk;
+    QAtomicInt _countDone;
+    unsigned long _ulCountReported;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+
+PointsCurvature::PointsCurvature(const PointsKdTree& tree)
+  : myTree(tree), myKSearch(20), myRadius(0.0f), myViewPoint(0.0f, 0.0f, 0.0f)
+{
+}
+
+PointsCurvature::~PointsCurvature()
+{
+}
+
+void PointsCurvature::ComputeNormals(std::vector<Base::Vector3f>& normals) const
+{
+    Compute(normals, 0);
+}
+
+void PointsCurvature::ComputeCurvature(std::vector<Base::Vector3f>& normals,
+                                       std::vector<CurvatureInfo>& curvature) const
+{
+    Compute(normals, &curvature);
+}
+
+void PointsCurvature::Compute(std::vector<Base::Vector3f>& normals,
+                              std::vector<CurvatureInfo>* curvature) const
+{
+    // points that are not in the tree keep a null normal and no curvature
+    normals.clear();
+    normals.resize(myTree.CountPoints(), Base::Vector3f(0.0f, 0.0f, 0.0f));
+    if (curvature) {
+        CurvatureInfo info;
+        info.fMaxCurvature = FLT_MAX;
+        info.fMinCurvature = FLT_MAX;
+        curvature->clear();
+        curvature->resize(myTree.CountPoints(), info);
+    }
+
+    CurvatureEstimation estimate(myTree, myKSearch, myRadius, myViewPoint, normals, curvature);
+    Base::SequencerLauncher seq(curvature ? "Curvature estimation" : "Normal estimation",
+                                estimate.CountChunks());
+    estimate.Run(QThread::idealThreadCount(), seq);
+}
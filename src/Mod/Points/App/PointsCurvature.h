@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef POINTS_CURVATURE_H
+#define POINTS_CURVATURE_H
+
+#include <vector>
+
+#include <Base/Vector3D.h>
+
+namespace Points
+{
+class PointsKdTree;
+
+/** Curvature information of a point, FLT_MAX if it could not be estimated. */
+struct PointsExport CurvatureInfo
+{
+    float fMaxCurvature, fMinCurvature;
+    Base::Vector3f cMaxCurvDir, cMinCurvDir;
+};
+
+/**
+ * The PointsCurvature class estimates the normals and principal curvatures of a
+ * point cloud from the neighbours of each point.
+ *
+ * The normal is the direction of least variance of the neighbours and is turned
+ * towards the view point. For the curvature a quadric is fitted to the neighbours
+ * in the frame of the normal; the curvature is positive where the surface bends
+ * towards the normal.
+ *
+ * The points are processed by several threads in the order of the kd-tree, so
+ * neighbouring points are handled together and their neighbours are likely to be
+ * in the cache already.
+ */
+class PointsExport PointsCurvature
+{
+public:
+    /// The neighbours are searched in \a tree which must exist as long as this object
+    PointsCurvature(const PointsKdTree& tree);
+    ~PointsCurvature();
+
+    /// Sets the number of nearest neighbours to use, 20 by default
+    void SetKSearch(unsigned long k)
+    { myKSearch = k; }
+    unsigned long GetKSearch() const
+    { return myKSearch; }
+    /// If \a radius is greater than zero all neighbours within this distance are used instead
+    void SetSearchRadius(float radius)
+    { myRadius = radius; }
+    float GetSearchRadius() const
+    { return myRadius; }
+    /// Sets the point the normals are turned to, the origin by default
+    void SetViewPoint(const Base::Vector3f& view)
+    { myViewPoint = view; }
+    const Base::Vector3f& GetViewPoint() const
+    { return myViewPoint; }
+
+    /**
+     * Estimates the normal of each point. Points with NaN coordinates or too few
+     * neighbours get a null vector.
+     */
+    void ComputeNormals(std::vector<Base::Vector3f>& normals) const;
+    /**
+     * Estimates the normal and the principal curvatures of each point.
+     */
+    void ComputeCurvature(std::vector<Base::Vector3f>& normals,
+                          std::vector<CurvatureInfo>& curvature) const;
+
+private:
+    void Compute(std::vector<Base::Vector3f>& normals,
+                 std::vector<CurvatureInfo>* curvature) const;
+
+private:
+    const PointsKdTree& myTree;
+    unsigned long myKSearch;
+    float myRadius;
+    Base::Vector3f myViewPoint;
+};
+
+} // namespace Points
+
+
+#endif // POINTS_CURVATURE_H
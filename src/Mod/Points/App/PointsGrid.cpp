@@ -25,12 +25,18 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <climits>
 #endif
 
 
 
 #include "PointsGrid.h"
 
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
 using namespace Points;
 
 PointsGrid::PointsGrid (const PointKernel &rclM)
@@ -95,7 +101,8 @@ void PointsGrid::Attach (const PointKernel &rclM)
 
 void PointsGrid::Clear (void)
 {
-  _aulGrid.clear();
+  std::vector<unsigned long>().swap(_aulOffsets);
+  std::vector<unsigned long>().swap(_aulIndices);
   _pclPoints = NULL;  
 }
 
@@ -126,8 +133,6 @@ void PointsGrid::InitGrid (void)
 {
   assert(_pclPoints != NULL);
 
-  unsigned long i, j;
-
   // Grid Laengen berechnen wenn nicht initialisiert
   //
   if ((_ulCtGridsX == 0) || (_ulCtGridsY == 0) || (_ulCtGridsZ == 0))
@@ -163,14 +168,8 @@ void PointsGrid::InitGrid (void)
   }
 
   // Daten-Struktur anlegen
-  _aulGrid.clear();
-  _aulGrid.resize(_ulCtGridsX);
-  for (i = 0; i < _ulCtGridsX; i++)
-  {
-    _aulGrid[i].resize(_ulCtGridsY);
-    for (j = 0; j < _ulCtGridsY; j++)
-      _aulGrid[i][j].resize(_ulCtGridsZ);
-  }
+  _aulOffsets.assign(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
+  _aulIndices.clear();
 }
 
 unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::vector<unsigned long> &raulElements, bool bDelDoubles) const
@@ -189,7 +188,7 @@ unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::vector<uns
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -223,7 +222,7 @@ unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::vector<uns
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
         if (Base::DistanceP2(GetBoundBox(i, j, k).GetCenter(), rclOrg) < fMinDistP2)
-          raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+          GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -254,7 +253,7 @@ unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::set<unsign
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(_aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -455,9 +454,9 @@ void PointsGrid::CalculateGridLength (int iCtGridPerAxis)
   }
 }
 
-void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<unsigned long> &raclInd) const
+void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::vector<unsigned long> &raulInd) const
 {
-  raclInd.clear();
+  raulInd.clear();
   Base::BoundBox3d  clBB = GetBoundBox();
 
   if (clBB.IsInBox(rclPt) == true)
@@ -466,9 +465,9 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
     Position(rclPt, ulX, ulY, ulZ);
     //int nX = ulX, nY = ulY, nZ = ulZ;
     unsigned long ulLevel = 0;
-    while (raclInd.size() == 0)
-      GetHull(ulX, ulY, ulZ, ulLevel++, raclInd);
-    GetHull(ulX, ulY, ulZ, ulLevel, raclInd);
+    while (raulInd.size() == 0)
+      GetHull(ulX, ulY, ulZ, ulLevel++, raulInd);
+    GetHull(ulX, ulY, ulZ, ulLevel, raulInd);
   }
   else
   { // Punkt ausserhalb
@@ -478,12 +477,12 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::RIGHT:
       {
         int nX = 0;
-        while (raclInd.size() == 0)
+        while (raulInd.size() == 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raulInd);
           }
           nX++;
         }
@@ -492,26 +491,26 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::LEFT:
       {
         int nX = _ulCtGridsX - 1;
-        while (raclInd.size() == 0)
+        while (raulInd.size() == 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raulInd);
           }
-          nX++;
+          nX--;
         }
         break;
       }
       case Base::BoundBox3d::TOP:
       {
         int nY = 0;
-        while (raclInd.size() == 0)
+        while (raulInd.size() == 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raulInd);
           }
           nY++;
         }
@@ -520,12 +519,12 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::BOTTOM:
       {
         int nY = _ulCtGridsY - 1;
-        while (raclInd.size() == 0)
+        while (raulInd.size() == 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raulInd);
           }
           nY--;
         }
@@ -534,12 +533,12 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::BACK:
       {
         int nZ = 0;
-        while (raclInd.size() == 0)
+        while (raulInd.size() == 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raulInd);
           }
           nZ++;
         }
@@ -548,12 +547,12 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::FRONT:
       {
         int nZ = _ulCtGridsZ - 1;
-        while (raclInd.size() == 0)
+        while (raulInd.size() == 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raulInd);
           }
           nZ--;
         }
@@ -564,6 +563,18 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
         break;
     }
   }
+
+  // the same grid may be visited twice
+  std::sort(raulInd.begin(), raulInd.end());
+  raulInd.erase(std::unique(raulInd.begin(), raulInd.end()), raulInd.end());
+}
+
+void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<unsigned long> &raclInd) const
+{
+  std::vector<unsigned long> aulInd;
+  SearchNearestFromPoint(rclPt, aulInd);
+  raclInd.clear();
+  raclInd.insert(aulInd.begin(), aulInd.end());
 }
 
 void PointsGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
@@ -616,25 +627,70 @@ void PointsGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ul
   }
 }
 
-unsigned long PointsGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
-                                     std::set<unsigned long> &raclInd) const
+void PointsGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
+                        unsigned long ulDistance, std::vector<unsigned long> &raulInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  if (rclSet.size() > 0)
+  int nX1 = std::max<int>(0, int(ulX) - int(ulDistance));
+  int nY1 = std::max<int>(0, int(ulY) - int(ulDistance));
+  int nZ1 = std::max<int>(0, int(ulZ) - int(ulDistance));
+  int nX2 = std::min<int>(int(_ulCtGridsX) - 1, int(ulX) + int(ulDistance));
+  int nY2 = std::min<int>(int(_ulCtGridsY) - 1, int(ulY) + int(ulDistance));
+  int nZ2 = std::min<int>(int(_ulCtGridsZ) - 1, int(ulZ) + int(ulDistance));
+
+  int i, j;
+
+  // top plane
+  for (i = nX1; i <= nX2; i++)
+  {
+    for (j = nY1; j <= nY2; j++)
+      GetElements(i, j, nZ1, raulInd);
+  }
+  // bottom plane
+  for (i = nX1; i <= nX2; i++)
+  {
+    for (j = nY1; j <= nY2; j++)
+      GetElements(i, j, nZ2, raulInd);
+  }
+  // left plane
+  for (i = nY1; i <= nY2; i++)
+  {
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(nX1, i, j, raulInd);
+  }
+  // right plane
+  for (i = nY1; i <= nY2; i++)
   {
-    raclInd.insert(rclSet.begin(), rclSet.end());
-    return rclSet.size();
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(nX2, i, j, raulInd);
+  }
+  // front plane
+  for (i = (nX1+1); i <= (nX2-1); i++)
+  {
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(i, nY1, j, raulInd);
   }
+  // back plane
+  for (i = (nX1+1); i <= (nX2-1); i++)
+  {
+    for (j = (nZ1+1); j <= (nZ2-1); j++)
+      GetElements(i, nY2, j, raulInd);
+  }
+}
 
-  return 0;
+unsigned long PointsGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
+                                     std::set<unsigned long> &raclInd) const
+{
+  unsigned long ulCell = CellIndex(ulX, ulY, ulZ);
+  raclInd.insert(_aulIndices.begin() + _aulOffsets[ulCell], _aulIndices.begin() + _aulOffsets[ulCell + 1]);
+  return _aulOffsets[ulCell + 1] - _aulOffsets[ulCell];
 }
 
-void PointsGrid::AddPoint (const Base::Vector3d &rclPt, unsigned long ulPtIndex, float /*fEpsilon*/)
+unsigned long PointsGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
+                                     std::vector<unsigned long> &raulInd) const
 {
-  unsigned long ulX, ulY, ulZ;
-  Pos(Base::Vector3d(rclPt.x, rclPt.y, rclPt.z), ulX, ulY, ulZ);
-  if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
-    _aulGrid[ulX][ulY][ulZ].insert(ulPtIndex);
+  unsigned long ulCell = CellIndex(ulX, ulY, ulZ);
+  raulInd.insert(raulInd.end(), _aulIndices.begin() + _aulOffsets[ulCell], _aulIndices.begin() + _aulOffsets[ulCell + 1]);
+  return _aulOffsets[ulCell + 1] - _aulOffsets[ulCell];
 }
 
 void PointsGrid::Validate (const PointKernel &rclPoints)
@@ -683,12 +739,93 @@ void PointsGrid::RebuildGrid (void)
 
   InitGrid();
  
-  // Daten-Struktur fuellen
+  // Daten-Struktur fuellen, the points are sorted into their grid elements by a counting sort.
+  // For large point clouds the points are split into blocks handled by several threads. Each
+  // block gets its own range in each grid element, in block order, so that the points of a
+  // grid element are sorted.
+  unsigned long ulBlocks = std::min<unsigned long>(QThread::idealThreadCount(), _ulCtElements / 100000 + 1);
+  ulBlocks = std::max<unsigned long>(ulBlocks, 1);
+  unsigned long ulCtCells = _aulOffsets.size() - 1;
+  std::vector<unsigned long> aulCells(_ulCtElements);
+  std::vector<std::vector<unsigned long> > aulCounts(ulBlocks);
+  if (ulBlocks > 1)
+  {
+    QList< QFuture<void> > futures;
+    for (unsigned long i = 0; i < ulBlocks; i++)
+    {
+      futures << QtConcurrent::run(this, &PointsGrid::CountPoints, i * _ulCtElements / ulBlocks,
+                                   (i + 1) * _ulCtElements / ulBlocks, &aulCells, &aulCounts[i]);
+    }
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+      it->waitForFinished();
+  }
+  else
+  {
+    CountPoints(0, _ulCtElements, &aulCells, &aulCounts[0]);
+  }
 
-  unsigned long i = 0;
-  for (PointKernel::const_iterator it = _pclPoints->begin(); it != _pclPoints->end(); ++it )
+  // the counts become the positions where the blocks start to write into the grid elements
+  unsigned long ulPos = 0;
+  for (unsigned long ulCell = 0; ulCell < ulCtCells; ulCell++)
+  {
+    _aulOffsets[ulCell] = ulPos;
+    for (unsigned long i = 0; i < ulBlocks; i++)
+    {
+      unsigned long ulCount = aulCounts[i][ulCell];
+      aulCounts[i][ulCell] = ulPos;
+      ulPos += ulCount;
+    }
+  }
+  _aulOffsets[ulCtCells] = ulPos;
+
+  _aulIndices.resize(ulPos);
+  if (ulBlocks > 1)
+  {
+    QList< QFuture<void> > futures;
+    for (unsigned long i = 0; i < ulBlocks; i++)
+    {
+      futures << QtConcurrent::run(this, &PointsGrid::SortPoints, i * _ulCtElements / ulBlocks,
+                                   (i + 1) * _ulCtElements / ulBlocks, &aulCells, &aulCounts[i]);
+    }
+    for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+      it->waitForFinished();
+  }
+  else
+  {
+    SortPoints(0, _ulCtElements, &aulCells, &aulCounts[0]);
+  }
+}
+
+void PointsGrid::CountPoints (unsigned long ulBegin, unsigned long ulEnd, std::vector<unsigned long> *paulCells,
+                              std::vector<unsigned long> *paulCounts) const
+{
+  paulCounts->resize(_aulOffsets.size() - 1, 0);
+  PointKernel::const_iterator it = _pclPoints->begin() + ulBegin;
+  for (unsigned long i = ulBegin; i < ulEnd; i++, ++it)
+  {
+    unsigned long ulX, ulY, ulZ;
+    Pos(*it, ulX, ulY, ulZ);
+    if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
+    {
+      unsigned long ulCell = CellIndex(ulX, ulY, ulZ);
+      (*paulCells)[i] = ulCell;
+      (*paulCounts)[ulCell]++;
+    }
+    else
+    {
+      (*paulCells)[i] = ULONG_MAX;
+    }
+  }
+}
+
+void PointsGrid::SortPoints (unsigned long ulBegin, unsigned long ulEnd, const std::vector<unsigned long> *paulCells,
+                             std::vector<unsigned long> *paulNext)
+{
+  for (unsigned long i = ulBegin; i < ulEnd; i++)
   {
-    AddPoint(*it, i++);
+    unsigned long ulCell = (*paulCells)[i];
+    if (ulCell != ULONG_MAX)
+      _aulIndices[(*paulNext)[ulCell]++] = i;
   }
 }
 
@@ -751,7 +888,7 @@ bool PointsGridIterator::InitOnRay (const Base::Vector3d &rclPt, const Base::Vec
   if ((_rclGrid.GetBoundBox().IsInBox(rclPt)) == true)
   {  // Voxel bestimmen, indem der Startpunkt liegt
     _rclGrid.Position(rclPt, _ulX, _ulY, _ulZ);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
     _bValidRay = true;
   }
   else
@@ -764,7 +901,7 @@ bool PointsGridIterator::InitOnRay (const Base::Vector3d &rclPt, const Base::Vec
       else
         _rclGrid.Position(cP1, _ulX, _ulY, _ulZ);
 
-      raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+      _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
       _bValidRay = true;
     }
   }
@@ -815,7 +952,7 @@ bool PointsGridIterator::NextOnRay (std::vector<unsigned long> &raulElements)
   if ((_bValidRay == true) && (_rclGrid.CheckPos(_ulX, _ulY, _ulZ) == true))
   {
     GridElement pos(_ulX, _ulY, _ulZ); _cSearchPositions.insert(pos);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end()); 
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements); 
   }
   else
     _bValidRay = false;  // Strahl ausgetreten
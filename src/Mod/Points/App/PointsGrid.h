@@ -25,6 +25,7 @@
 #define POINTS_GRID_H
 
 #include <set>
+#include <vector>
 
 #include "Points.h"
 #include <Base/Vector3D.h>
@@ -87,6 +88,8 @@ public:
                                 const Base::Vector3d &rclOrg, double fMaxDist, bool bDelDoubles = true) const;
   /** Searches for the nearest grids that contain elements from a point, the result are grid indices. */
   void SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<unsigned long> &rclInd) const;
+  /** Does the same as the method above but fills a sorted vector. */
+  void SearchNearestFromPoint (const Base::Vector3d &rclPt, std::vector<unsigned long> &raulInd) const;
   //@}
 
   /** Returns the lengths of the grid elements in x,y and z direction. */
@@ -105,7 +108,10 @@ public:
   //@}
   /** Returns the number of elements in a given grid. */
   unsigned long GetCtElements(unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
-  { return _aulGrid[ulX][ulY][ulZ].size(); }
+  { unsigned long ulCell = CellIndex(ulX, ulY, ulZ); return _aulOffsets[ulCell + 1] - _aulOffsets[ulCell]; }
+  /** Returns the number of bytes used to store the grid elements. */
+  unsigned long GetMemoryUsage() const
+  { return (_aulOffsets.capacity() + _aulIndices.capacity()) * sizeof(unsigned long); }
   /** Finds all points that lie in the same grid as the point \a rclPoint. */
   unsigned long FindElements(const Base::Vector3d &rclPoint, std::set<unsigned long>& aulElements) const;
   /** Validates the grid structure and rebuilds it if needed. */
@@ -119,8 +125,13 @@ public:
   virtual void Position (const Base::Vector3d &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
   /** Returns the indices of the elements in the given grid. */
   unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::set<unsigned long> &raclInd) const;
+  /** Appends the indices of the elements in the given grid to \a raulInd. */
+  unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::vector<unsigned long> &raulInd) const;
 
 protected:
+  /** Returns the index of a grid element in the internal structure, the position is not checked. */
+  unsigned long CellIndex (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+  { return (ulZ * _ulCtGridsY + ulY) * _ulCtGridsX + ulX; }
   /** Checks if this is a valid grid position. */
   inline bool CheckPos (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const;
   /** Initializes the size of the internal structure. */
@@ -133,14 +144,25 @@ protected:
   virtual void CalculateGridLength (int    iCtGridPerAxis);
   /** Rebuilds the grid structure. */
   virtual void RebuildGrid (void);
+  /** Sets the grid elements of the points [ulBegin, ulEnd) and counts the points of each grid element. */
+  void CountPoints (unsigned long ulBegin, unsigned long ulEnd, std::vector<unsigned long> *paulCells,
+                    std::vector<unsigned long> *paulCounts) const;
+  /** Writes the points [ulBegin, ulEnd) into their grid elements, starting at the given positions. */
+  void SortPoints (unsigned long ulBegin, unsigned long ulEnd, const std::vector<unsigned long> *paulCells,
+                   std::vector<unsigned long> *paulNext);
   /** Returns the number of stored elements. */
   unsigned long HasElements (void) const
   { return _pclPoints->size(); }
   /** Get the indices of all elements lying in the grids around a given grid with distance \a ulDistance. */
   void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::set<unsigned long> &raclInd) const;
+  /** Does the same as the method above but appends the indices to \a raulInd. */
+  void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::vector<unsigned long> &raulInd) const;
 
 protected:
-  std::vector<std::vector<std::vector<std::set<unsigned long> > > >  _aulGrid;   /**< Grid data structure. */
+  /** Grid data structure: the point indices sorted by grid element and for each grid element the offset of its
+   * first index. As each point lies in one grid element only the structure is built by a counting sort. */
+  std::vector<unsigned long> _aulOffsets;
+  std::vector<unsigned long> _aulIndices;
   const PointKernel* _pclPoints;  /**< The point kernel. */
   unsigned long     _ulCtElements;/**< Number of grid elements for validation issues. */
   unsigned long     _ulCtGridsX;  /**< Number of grid elements in z. */
@@ -160,9 +182,6 @@ protected:
 public:
 
 protected:
-  /** Adds a new point element to the grid structure. \a rclPt is the geometric point and \a ulPtIndex 
-   * the corresponding index in the point kernel. */
-  void AddPoint (const Base::Vector3d &rclPt, unsigned long ulPtIndex, float fEpsilon = 0.0f);
   /** Returns the grid numbers to the given point \a rclPoint. */
   void Pos(const Base::Vector3d &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
 };
@@ -182,7 +201,7 @@ public:
   /** Returns indices of the elements in the current grid. */
   void GetElements (std::vector<unsigned long> &raulElements) const
   {
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
   }
   /** @name Iteration */
   //@{
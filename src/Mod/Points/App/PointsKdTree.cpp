@@ -0,0 +1,482 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cfloat>
+# include <climits>
+#endif
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QList>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include <Base/Exception.h>
+
+#include "PointsKdTree.h"
+#include "Points.h"
+
+using namespace Points;
+
+namespace {
+
+inline float coordinate(float x, float y, float z, int axis)
+{
+    return axis == 0 ? x : (axis == 1 ? y : z);
+}
+
+inline bool isValid(const Base::Vector3f& pnt)
+{
+    return !boost::math::isnan(pnt.x) && !boost::math::isnan(pnt.y) && !boost::math::isnan(pnt.z);
+}
+
+/**
+ * Answers a list of nearest neighbour queries. The queries are split into chunks
+ * that the threads take one after another.
+ */
+class NearestQuery
+{
+public:
+    NearestQuery(const PointsKdTree& tree, const std::vector<Base::Vector3f>& points,
+                 unsigned long k, std::vector<unsigned long>& indices)
+      : tree(tree), points(points), k(k), indices(indices), nextChunk(0)
+    {
+    }
+    void Run(int threads)
+    {
+        int chunks = (int)((points.size() + ChunkSize - 1) / ChunkSize);
+        threads = std::min(threads, chunks);
+        if (threads < 2) {
+            QueryChunks(0);
+            return;
+        }
+
+        QList< QFuture<void> > futures;
+        for (int i = 1; i < threads; i++)
+            futures << QtConcurrent::run(this, &NearestQuery::QueryChunks, i);
+
+        try {
+            QueryChunks(0);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+                it->waitForFinished();
+        }
+        catch (...) {
+            // stop the other threads before the result is destroyed
+            nextChunk.fetchAndStoreOrdered(chunks);
+            for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it) {
+                try {
+                    it->waitForFinished();
+                }
+                catch (...) {
+                }
+            }
+            throw;
+        }
+    }
+
+private:
+    void QueryChunks(int)
+    {
+        std::vector<unsigned long> found;
+        std::vector<float> dist;
+        for (;;) {
+            unsigned long begin = (unsigned long)nextChunk.fetchAndAddOrdered(1) * ChunkSize;
+            if (begin >= points.size())
+                break;
+            unsigned long end = std::min<unsigned long>(begin + ChunkSize, points.size());
+            for (unsigned long i = begin; i < end; i++) {
+                unsigned long count = tree.FindNearest(points[i], k, found, dist);
+                std::copy(found.begin(), found.begin() + count, indices.begin() + i * k);
+            }
+        }
+    }
+
+    static const unsigned long ChunkSize = 1024;
+
+    const PointsKdTree& tree;
+    const std::vector<Base::Vector3f>& points;
+    unsigned long k;
+    std::vector<unsigned long>& indices;
+    QAtomicInt nextChunk;
+};
+
+}
+
+/**
+ * Keeps the k nearest points found so far, sorted by their distance.
+ */
+class PointsKdTree::Heap
+{
+public:
+    Heap(unsigned long k, std::vector<unsigned long>& indices, std::vector<float>& dist)
+      : k(k), count(0), indices(indices), dist(dist)
+    {
+        indices.resize(k);
+        dist.resize(k);
+    }
+    unsigned long Count() const
+    {
+        return count;
+    }
+    /// Returns the distance a point must fall below to be added
+    float Worst() const
+    {
+        return count < k ? FLT_MAX : dist[k - 1];
+    }
+    void Push(unsigned long index, float sqrDist)
+    {
+        unsigned long pos = count < k ? count++ : k - 1;
+        while (pos > 0 && dist[pos - 1] > sqrDist) {
+            dist[pos] = dist[pos - 1];
+            indices[pos] = indices[pos - 1];
+            pos--;
+        }
+        dist[pos] = sqrDist;
+        indices[pos] = index;
+    }
+
+private:
+    unsigned long k;
+    unsigned long count;
+    std::vector<unsigned long>& indices;
+    std::vector<float>& dist;
+};
+
+// ----------------------------------------------------------------------------
+
+PointsKdTree::PointsKdTree(const PointKernel& kernel)
+  : _ulCountPoints(kernel.size())
+{
+    if (_ulCountPoints > UINT32_MAX)
+        throw Base::ValueError("Too many points for the kd-tree");
+
+    _aclEntries.reserve(_ulCountPoints);
+    uint32_t index = 0;
+    for (PointKernel::const_iterator it = kernel.begin(); it != kernel.end(); ++it, ++index) {
+        Base::Vector3f pnt((float)it->x, (float)it->y, (float)it->z);
+        if (isValid(pnt)) {
+            Entry e = { pnt.x, pnt.y, pnt.z, index };
+            _aclEntries.push_back(e);
+        }
+    }
+
+    Build();
+}
+
+PointsKdTree::PointsKdTree(const std::vector<Base::Vector3f>& points)
+  : _ulCountPoints(points.size())
+{
+    if (_ulCountPoints > UINT32_MAX)
+        throw Base::ValueError("Too many points for the kd-tree");
+
+    _aclEntries.reserve(_ulCountPoints);
+    for (std::size_t i = 0; i < points.size(); i++) {
+        const Base::Vector3f& pnt = points[i];
+        if (isValid(pnt)) {
+            Entry e = { pnt.x, pnt.y, pnt.z, (uint32_t)i };
+            _aclEntries.push_back(e);
+        }
+    }
+
+    Build();
+}
+
+PointsKdTree::~PointsKdTree()
+{
+}
+
+unsigned long PointsKdTree::GetMemoryUsage() const
+{
+    return _aclEntries.capacity() * sizeof(Entry) + _aclNodes.capacity() * sizeof(Node);
+}
+
+unsigned long PointsKdTree::CountNodes(unsigned long count) const
+{
+    // the right half of a node is never smaller than the left half, so the
+    // rightmost path of the tree is the longest one
+    unsigned long levels = 0;
+    while (count > LeafSize) {
+        count -= count / 2;
+        levels++;
+    }
+
+    // the nodes are numbered from 1, the children of node n are 2n and 2n+1
+    return 1ul << levels;
+}
+
+void PointsKdTree::Build()
+{
+    _aclNodes.resize(CountNodes(_aclEntries.size()));
+    if (_aclEntries.empty())
+        return;
+
+    Range root;
+    root.node = 1;
+    root.begin = 0;
+    root.end = _aclEntries.size();
+    for (std::vector<Entry>::const_iterator it = _aclEntries.begin(); it != _aclEntries.end(); ++it)
+        root.box.Add(Base::Vector3f(it->x, it->y, it->z));
+
+    // split the upper levels until there are enough subtrees for all threads
+    int threads = std::max(1, QThread::idealThreadCount());
+    std::vector<Range> ranges(1, root);
+    while (threads > 1 && ranges.size() < (std::size_t)threads * 4) {
+        std::vector<Range> next;
+        for (std::vector<Range>::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+            if (it->end - it->begin > LeafSize) {
+                Range left, right;
+                Split(*it, left, right);
+                next.push_back(left);
+                next.push_back(right);
+            }
+        }
+        if (next.empty())
+            return;
+        ranges.swap(next);
+    }
+
+    QList< QFuture<void> > futures;
+    for (std::vector<Range>::const_iterator it = ranges.begin() + 1; it != ranges.end(); ++it)
+        futures << QtConcurrent::run(this, &PointsKdTree::BuildSubtree, *it);
+
+    try {
+        BuildSubtree(ranges.front());
+        for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it)
+            it->waitForFinished();
+    }
+    catch (...) {
+        // the other subtrees still work on the entries
+        for (QList< QFuture<void> >::iterator it = futures.begin(); it != futures.end(); ++it) {
+            try {
+                it->waitForFinished();
+            }
+            catch (...) {
+            }
+        }
+        throw;
+    }
+}
+
+void PointsKdTree::BuildSubtree(Range range)
+{
+    if (range.end - range.begin <= LeafSize)
+        return;
+
+    Range left, right;
+    Split(range, left, right);
+    BuildSubtree(left);
+    BuildSubtree(right);
+}
+
+namespace {
+struct CoordinateLess
+{
+    CoordinateLess(int axis) : axis(axis) {}
+    template <class T>
+    bool operator()(const T& a, const T& b) const
+    {
+        return coordinate(a.x, a.y, a.z, axis) < coordinate(b.x, b.y, b.z, axis);
+    }
+    int axis;
+};
+}
+
+void PointsKdTree::Split(const Range& range, Range& left, Range& right)
+{
+    // split at the median of the longest side
+    const Base::BoundBox3f& box = range.box;
+    int axis = 0;
+    float length = box.LengthX();
+    if (box.LengthY() > length) {
+        axis = 1;
+        length = box.LengthY();
+    }
+    if (box.LengthZ() > length) {
+        axis = 2;
+    }
+
+    unsigned long mid = range.begin + (range.end - range.begin) / 2;
+    std::vector<Entry>::iterator first = _aclEntries.begin();
+    std::nth_element(first + range.begin, first + mid, first + range.end, CoordinateLess(axis));
+
+    const Entry& median = _aclEntries[mid];
+    Node& node = _aclNodes[range.node];
+    node.axis = axis;
+    node.split = coordinate(median.x, median.y, median.z, axis);
+
+    left.node = 2 * range.node;
+    left.begin = range.begin;
+    left.end = mid;
+    left.box = box;
+    right.node = 2 * range.node + 1;
+    right.begin = mid;
+    right.end = range.end;
+    right.box = box;
+    switch (axis) {
+    case 0:
+        left.box.MaxX = right.box.MinX = node.split;
+        break;
+    case 1:
+        left.box.MaxY = right.box.MinY = node.split;
+        break;
+    default:
+        left.box.MaxZ = right.box.MinZ = node.split;
+        break;
+    }
+}
+
+unsigned long PointsKdTree::FindNearest(const Base::Vector3f& rclPt, unsigned long k,
+                                        std::vector<unsigned long>& raulIndices,
+                                        std::vector<float>& rafSqrDist) const
+{
+    unsigned long count = FindNearestEntries(rclPt, k, raulIndices, rafSqrDist);
+    for (std::vector<unsigned long>::iterator it = raulIndices.begin(); it != raulIndices.end(); ++it)
+        *it = _aclEntries[*it].index;
+    return count;
+}
+
+unsigned long PointsKdTree::FindNearestEntries(const Base::Vector3f& rclPt, unsigned long k,
+                                               std::vector<unsigned long>& raulEntries,
+                                               std::vector<float>& rafSqrDist) const
+{
+    unsigned long count = 0;
+    if (k > 0 && !_aclEntries.empty()) {
+        Heap heap(k, raulEntries, rafSqrDist);
+        float offset[3] = { 0.0f, 0.0f, 0.0f };
+        SearchNearest(1, 0, _aclEntries.size(), rclPt, 0.0f, offset, heap);
+        count = heap.Count();
+    }
+
+    raulEntries.resize(count);
+    rafSqrDist.resize(count);
+    return count;
+}
+
+void PointsKdTree::SearchNearest(unsigned long node, unsigned long begin, unsigned long end,
+                                 const Base::Vector3f& rclPt, float fSqrDist, float offset[3],
+                                 Heap& heap) const
+{
+    if (end - begin <= LeafSize) {
+        for (unsigned long i = begin; i < end; i++) {
+            const Entry& e = _aclEntries[i];
+            float dx = e.x - rclPt.x;
+            float dy = e.y - rclPt.y;
+            float dz = e.z - rclPt.z;
+            float dist = dx * dx + dy * dy + dz * dz;
+            if (dist < heap.Worst())
+                heap.Push(i, dist);
+        }
+        return;
+    }
+
+    // search the side of the point first, the other side only if it may contain a closer point
+    unsigned long mid = begin + (end - begin) / 2;
+    const Node& n = _aclNodes[node];
+    float diff = coordinate(rclPt.x, rclPt.y, rclPt.z, n.axis) - n.split;
+    unsigned long nearNode = diff < 0.0f ? 2 * node : 2 * node + 1;
+    if (diff < 0.0f)
+        SearchNearest(nearNode, begin, mid, rclPt, fSqrDist, offset, heap);
+    else
+        SearchNearest(nearNode, mid, end, rclPt, fSqrDist, offset, heap);
+
+    // fSqrDist is the squared distance to the box of the far side, where offset holds
+    // the distance to the box along each axis
+    float oldOffset = offset[n.axis];
+    float farDist = fSqrDist - oldOffset * oldOffset + diff * diff;
+    if (farDist < heap.Worst()) {
+        offset[n.axis] = diff;
+        if (diff < 0.0f)
+            SearchNearest(2 * node + 1, mid, end, rclPt, farDist, offset, heap);
+        else
+            SearchNearest(2 * node, begin, mid, rclPt, farDist, offset, heap);
+        offset[n.axis] = oldOffset;
+    }
+}
+
+unsigned long PointsKdTree::FindInRadius(const Base::Vector3f& rclPt, float fRadius,
+                                         std::vector<unsigned long>& raulIndices,
+                                         std::vector<float>& rafSqrDist) const
+{
+    unsigned long count = FindEntriesInRadius(rclPt, fRadius, raulIndices, rafSqrDist);
+    for (std::vector<unsigned long>::iterator it = raulIndices.begin(); it != raulIndices.end(); ++it)
+        *it = _aclEntries[*it].index;
+    return count;
+}
+
+unsigned long PointsKdTree::FindEntriesInRadius(const Base::Vector3f& rclPt, float fRadius,
+                                                std::vector<unsigned long>& raulEntries,
+                                                std::vector<float>& rafSqrDist) const
+{
+    raulEntries.clear();
+    rafSqrDist.clear();
+    if (!_aclEntries.empty())
+        SearchRadius(1, 0, _aclEntries.size(), rclPt, fRadius * fRadius, raulEntries, rafSqrDist);
+    return raulEntries.size();
+}
+
+void PointsKdTree::SearchRadius(unsigned long node, unsigned long begin, unsigned long end,
+                                const Base::Vector3f& rclPt, float fSqrRadius,
+                                std::vector<unsigned long>& raulIndices,
+                                std::vector<float>& rafSqrDist) const
+{
+    if (end - begin <= LeafSize) {
+        for (unsigned long i = begin; i < end; i++) {
+            const Entry& e = _aclEntries[i];
+            float dx = e.x - rclPt.x;
+            float dy = e.y - rclPt.y;
+            float dz = e.z - rclPt.z;
+            float dist = dx * dx + dy * dy + dz * dz;
+            if (dist <= fSqrRadius) {
+                raulIndices.push_back(i);
+                rafSqrDist.push_back(dist);
+            }
+        }
+        return;
+    }
+
+    unsigned long mid = begin + (end - begin) / 2;
+    const Node& n = _aclNodes[node];
+    float diff = coordinate(rclPt.x, rclPt.y, rclPt.z, n.axis) - n.split;
+    if (diff < 0.0f || diff * diff <= fSqrRadius)
+        SearchRadius(2 * node, begin, mid, rclPt, fSqrRadius, raulIndices, rafSqrDist);
+    if (diff >= 0.0f || diff * diff <= fSqrRadius)
+        SearchRadius(2 * node + 1, mid, end, rclPt, fSqrRadius, raulIndices, rafSqrDist);
+}
+
+void PointsKdTree::FindNearest(const std::vector<Base::Vector3f>& rclPts, unsigned long k,
+                               std::vector<unsigned long>& raulIndices) const
+{
+    raulIndices.clear();
+    raulIndices.resize(rclPts.size() * k, ULONG_MAX);
+    if (k == 0 || rclPts.empty())
+        return;
+
+    NearestQuery query(*this, rclPts, k, raulIndices);
+    query.Run(QThread::idealThreadCount());
+}
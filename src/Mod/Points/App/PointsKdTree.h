@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   Copyright (c) 2017 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef POINTS_KDTREE_H
+#define POINTS_KDTREE_H
+
+#include <vector>
+#include <stdint.h>
+
+#include <Base/BoundBox.h>
+#include <Base/Vector3D.h>
+
+namespace Points
+{
+class PointKernel;
+
+/**
+ * The PointsKdTree class is a balanced kd-tree over the points of a point cloud
+ * to search for the nearest neighbours of a point.
+ *
+ * Each inner node splits its points at the median along the longest side of its
+ * box, so the tree needs no pointers: the nodes are numbered like a binary heap
+ * and only the split values and axes are stored. The points are copied in the
+ * order of the leaves, so the points of a subtree are contiguous in memory. Points
+ * with NaN coordinates are not added to the tree.
+ *
+ * The upper levels of the tree are split by the calling thread, the subtrees
+ * below are built by several threads. After the tree is built all queries are
+ * read-only and can be used by several threads at the same time.
+ */
+class PointsExport PointsKdTree
+{
+public:
+    /// Builds the tree for the points of \a kernel
+    PointsKdTree(const PointKernel& kernel);
+    /// Builds the tree for \a points
+    PointsKdTree(const std::vector<Base::Vector3f>& points);
+    ~PointsKdTree();
+
+    /// Returns the number of points the tree was built for, including skipped points
+    unsigned long CountPoints() const
+    { return _ulCountPoints; }
+    /// Returns the number of points in the tree
+    unsigned long CountEntries() const
+    { return _aclEntries.size(); }
+    /// Returns the point with the index \a ulIndex of the tree order
+    Base::Vector3f GetPoint(unsigned long ulIndex) const
+    { const Entry& e = _aclEntries[ulIndex]; return Base::Vector3f(e.x, e.y, e.z); }
+    /// Returns the point cloud index of the point with the index \a ulIndex of the tree order
+    unsigned long GetIndex(unsigned long ulIndex) const
+    { return _aclEntries[ulIndex].index; }
+    /** Returns the number of bytes used by the tree. */
+    unsigned long GetMemoryUsage() const;
+
+    /** @name Search */
+    //@{
+    /**
+     * Searches for the \a k nearest points to \a rclPt. The point cloud indices of the points
+     * are written to \a raulIndices and their squared distances to \a rafSqrDist, both sorted by
+     * the distance. Returns the number of found points which is less than \a k only if the
+     * tree has less points.
+     */
+    unsigned long FindNearest(const Base::Vector3f& rclPt, unsigned long k,
+                              std::vector<unsigned long>& raulIndices,
+                              std::vector<float>& rafSqrDist) const;
+    /**
+     * Searches for all points within the distance \a fRadius to \a rclPt. The point cloud
+     * indices are written to \a raulIndices and their squared distances to \a rafSqrDist in no
+     * particular order. Returns the number of found points.
+     */
+    unsigned long FindInRadius(const Base::Vector3f& rclPt, float fRadius,
+                               std::vector<unsigned long>& raulIndices,
+                               std::vector<float>& rafSqrDist) const;
+    /**
+     * Searches for the \a k nearest points to each of the points \a rclPts with several threads.
+     * \a raulIndices gets \a k entries for each point; if the tree has less than \a k points the
+     * remaining entries are ULONG_MAX.
+     */
+    void FindNearest(const std::vector<Base::Vector3f>& rclPts, unsigned long k,
+                     std::vector<unsigned long>& raulIndices) const;
+    /**
+     * Does the same as FindNearest() but returns the indices of the tree order, which can
+     * be passed to GetPoint() and GetIndex().
+     */
+    unsigned long FindNearestEntries(const Base::Vector3f& rclPt, unsigned long k,
+                                     std::vector<unsigned long>& raulEntries,
+                                     std::vector<float>& rafSqrDist) const;
+    /**
+     * Does the same as FindInRadius() but returns the indices of the tree order, which can
+     * be passed to GetPoint() and GetIndex().
+     */
+    unsigned long FindEntriesInRadius(const Base::Vector3f& rclPt, float fRadius,
+                                      std::vector<unsigned long>& raulEntries,
+                                      std::vector<float>& rafSqrDist) const;
+    //@}
+
+private:
+    PointsKdTree(const PointsKdTree&);
+    PointsKdTree& operator=(const PointsKdTree&);
+
+    struct Entry
+    {
+        float x, y, z;
+        uint32_t index;
+    };
+    struct Node
+    {
+        float split;
+        int axis;
+    };
+    struct Range
+    {
+        unsigned long node, begin, end;
+        Base::BoundBox3f box;
+    };
+    class Heap;
+
+    void Build();
+    void Split(const Range& range, Range& left, Range& right);
+    void BuildSubtree(Range range);
+    unsigned long CountNodes(unsigned long count) const;
+    void SearchNearest(unsigned long node, unsigned long begin, unsigned long end,
+                       const Base::Vector3f& rclPt, float fSqrDist, float offset[3],
+                       Heap& heap) const;
+    void SearchRadius(unsigned long node, unsigned long begin, unsigned long end,
+                      const Base::Vector3f& rclPt, float fSqrRadius,
+                      std::vector<unsigned long>& raulIndices,
+                      std::vector<float>& rafSqrDist) const;
+
+    static const unsigned long LeafSize = 16;
+
+    std::vector<Entry> _aclEntries;
+    std::vector<Node> _aclNodes;
+    unsigned long _ulCountPoints;
+};
+
+} // namespace Points
+
+
+#endif // POINTS_KDTREE_H
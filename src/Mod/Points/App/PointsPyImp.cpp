@@ -24,10 +24,13 @@
 #include "PreCompiled.h"
 
 #include "Mod/Points/App/Points.h"
+#include "Mod/Points/App/PointsAlgos.h"
+#include "Mod/Points/App/PointsKdTree.h"
 #include <Base/Builder3D.h>
 #include <Base/VectorPy.h>
 #include <Base/GeometryPyCXX.h>
 #include <boost/math/special_functions/fpclassify.hpp>
+#include <climits>
 
 // inclusion of the generated files (generated out of PointsPy.xml)
 #include "PointsPy.h"
@@ -115,6 +118,39 @@ PyObject* PointsPy::write(PyObject * args)
     Py_Return; 
 }
 
+PyObject* PointsPy::readPages(PyObject * args)
+{
+    const char* Name;
+    const char* Source=0;
+    if (!PyArg_ParseTuple(args, "s|s",&Name,&Source))
+        return NULL;
+
+    PY_TRY {
+        if (Source)
+            PointsAlgos::LoadPaged(*getPointKernelPtr(), Source, Name);
+        else
+            getPointKernelPtr()->setPages(PointPages::open(Name));
+    } PY_CATCH;
+
+    Py_Return;
+}
+
+PyObject* PointsPy::writePages(PyObject * args)
+{
+    const char* Name;
+    if (!PyArg_ParseTuple(args, "s",&Name))
+        return NULL;
+
+    PY_TRY {
+        const PointKernel* kernel = getPointKernelPtr();
+        PointPagesBuilder builder(Name);
+        builder.add(kernel->data(), kernel->size());
+        builder.build();
+    } PY_CATCH;
+
+    Py_Return;
+}
+
 PyObject* PointsPy::writeInventor(PyObject * args)
 {
     if (!PyArg_ParseTuple(args, ""))
@@ -217,6 +253,64 @@ PyObject* PointsPy::fromValid(PyObject * args)
     }
 }
 
+PyObject* PointsPy::nearestPoints(PyObject * args)
+{
+    PyObject *obj;
+    int k = 1;
+    if (!PyArg_ParseTuple(args, "O|i", &obj, &k))
+        return 0;
+    if (k < 1) {
+        PyErr_SetString(PyExc_ValueError, "k must be positive");
+        return 0;
+    }
+
+    PY_TRY {
+        std::vector<Base::Vector3f> pts;
+        Py::Sequence list(obj);
+        pts.reserve(list.size());
+        for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+            Base::Vector3d pnt = Py::Vector(*it).toVector();
+            pts.push_back(Base::Vector3f((float)pnt.x, (float)pnt.y, (float)pnt.z));
+        }
+
+        PointsKdTree tree(*getPointKernelPtr());
+        std::vector<unsigned long> indices;
+        tree.FindNearest(pts, k, indices);
+
+        Py::List result;
+        for (std::size_t i = 0; i < pts.size(); i++) {
+            Py::List nearest;
+            for (std::size_t j = i * k; j < (i + 1) * k && indices[j] != ULONG_MAX; j++)
+                nearest.append(Py::Long(indices[j]));
+            result.append(nearest);
+        }
+        return Py::new_reference_to(result);
+    } PY_CATCH;
+}
+
+PyObject* PointsPy::pointsInRadius(PyObject * args)
+{
+    PyObject *obj;
+    double radius;
+    if (!PyArg_ParseTuple(args, "O!d", &(Base::VectorPy::Type), &obj, &radius))
+        return 0;
+
+    PY_TRY {
+        Base::Vector3d pnt = *static_cast<Base::VectorPy*>(obj)->getVectorPtr();
+        PointsKdTree tree(*getPointKernelPtr());
+        std::vector<unsigned long> indices;
+        std::vector<float> dist;
+        tree.FindInRadius(Base::Vector3f((float)pnt.x, (float)pnt.y, (float)pnt.z),
+                          (float)radius, indices, dist);
+        std::sort(indices.begin(), indices.end());
+
+        Py::List result;
+        for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it)
+            result.append(Py::Long(*it));
+        return Py::new_reference_to(result);
+    } PY_CATCH;
+}
+
 Py::Int PointsPy::getCountPoints(void) const
 {
     return Py::Int((long)getPointKernelPtr()->size());
@@ -0,0 +1,392 @@
+#***************************************************************************
+#*                                                                         *
+#*   This file is part of the FreeCAD CAx development system.              *
+#*                                                                         *
+#*   This program is free software; you can redistribute it and/or modify  *
+#*   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#*   as published by the Free Software Foundation; either version 2 of     *
+#*   the License, or (at your option) any later version.                   *
+#*   for detail see the LICENCE text file.                                 *
+#*                                                                         *
+#*   FreeCAD is distributed in the hope that it will be useful,            *
+#*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#*   GNU Library General Public License for more details.                  *
+#*                                                                         *
+#*   You should have received a copy of the GNU Library General Public     *
+#*   License along with FreeCAD; if not, write to the Free Software        *
+#*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#*   USA                                                                   *
+#*                                                                         *
+#***************************************************************************
+
+import FreeCAD, os, unittest, Points
+import tempfile, time, math, random, struct, shutil
+
+
+#---------------------------------------------------------------------------
+# define the functions to test the FreeCAD points module
+#---------------------------------------------------------------------------
+
+
+def writeFile(path, text, mode="w"):
+    f = open(path, mode)
+    f.write(text)
+    f.close()
+    return path
+
+
+class PointsAsciiCases(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.doc = FreeCAD.newDocument("PointsTest")
+
+    def tearDown(self):
+        FreeCAD.closeDocument("PointsTest")
+        shutil.rmtree(self.dir)
+
+    def testCommentsAndHeaders(self):
+        name = writeFile(os.path.join(self.dir, "comments.asc"),
+                         "# scanned points 1 2 3\n"
+                         "X Y Z\n"
+                         "4\n"
+                         "1.0 2.0 3.0\n"
+                         "4 5 6\n"
+                         "; 7 8 9\n"
+                         "\n"
+                         "-1.5e2\t2.5E-1 +3e+0\r\n"
+                         "7.5,8.5,9.5\n"
+                         "1 2 x\n"
+                         "1 2 3 4\n"
+                         ".5 -.25 1.\n")
+        pts = Points.Points()
+        pts.read(name)
+        expected = [(1.0, 2.0, 3.0), (4.0, 5.0, 6.0), (-150.0, 0.25, 3.0),
+                    (7.5, 8.5, 9.5), (0.5, -0.25, 1.0)]
+        self.failUnless(pts.CountPoints == len(expected))
+        for p, e in zip(pts.Points, expected):
+            self.failUnless((p - FreeCAD.Vector(e)).Length < 1e-6)
+
+    def testNaN(self):
+        name = writeFile(os.path.join(self.dir, "nan.asc"),
+                         "1 2 3\n"
+                         "nan nan nan\n"
+                         "NaN 1 -nan\n"
+                         "nanx 1 2\n"
+                         "4 5 6\n")
+        pts = Points.Points()
+        pts.read(name)
+        self.failUnless(pts.CountPoints == 4)
+        self.failUnless(math.isnan(pts.Points[1].x))
+        self.failUnless(math.isnan(pts.Points[2].x))
+        self.failUnless(pts.Points[2].y == 1.0)
+        self.failUnless(math.isnan(pts.Points[2].z))
+        self.failUnless(pts.fromValid().CountPoints == 2)
+
+    def testMixedColumns(self):
+        name = writeFile(os.path.join(self.dir, "mixed.asc"),
+                         "// x y z intensity r g b nx ny nz\n"
+                         "0 0 0 0.5 255 0 0 0.0 0.0 1.0\n"
+                         "1 0 0 0.25 0 255 0 1.0 0.0 0.0\n"
+                         "2 0 0\n"
+                         "2 0 0 1e-1 0 0 255 0.0 1.0 0.0\n")
+        Points.insert(name, "PointsTest")
+        fea = self.doc.Objects[-1]
+        self.failUnless(fea.Points.CountPoints == 3)
+        self.failUnless([round(i, 6) for i in fea.Intensity] == [0.5, 0.25, 0.1])
+        self.failUnless([c[0:3] for c in fea.Color] == [(1.0, 0.0, 0.0), (0.0, 1.0, 0.0), (0.0, 0.0, 1.0)])
+        self.failUnless(fea.Normal == [FreeCAD.Vector(0, 0, 1), FreeCAD.Vector(1, 0, 0), FreeCAD.Vector(0, 1, 0)])
+
+    def testIntensityOnly(self):
+        name = writeFile(os.path.join(self.dir, "intensity.asc"),
+                         "0 0 0 12\n"
+                         "1 2 3 24\n")
+        Points.insert(name, "PointsTest")
+        fea = self.doc.Objects[-1]
+        self.failUnless(fea.Points.CountPoints == 2)
+        self.failUnless(list(fea.Intensity) == [12.0, 24.0])
+        self.failIf(hasattr(fea, "Color"))
+        self.failIf(hasattr(fea, "Normal"))
+
+    def testThroughput(self):
+        rand = random.Random(4711)
+        count = 200000
+        lines = ["%.6f %.6f %.6f\n" % (rand.uniform(-1e3, 1e3), rand.uniform(-1e3, 1e3), rand.uniform(-1e3, 1e3))
+                 for i in range(count)]
+        name = writeFile(os.path.join(self.dir, "large.asc"), "".join(lines))
+        pts = Points.Points()
+        start = time.time()
+        pts.read(name)
+        seconds = time.time() - start
+        self.failUnless(pts.CountPoints == count)
+        FreeCAD.Console.PrintMessage("Read %d ASCII points in %.3fs (%.0f points/s)\n"
+                                     % (count, seconds, count / max(seconds, 1e-6)))
+
+
+class PointsPlyCases(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.doc = FreeCAD.newDocument("PointsTest")
+
+    def tearDown(self):
+        FreeCAD.closeDocument("PointsTest")
+        shutil.rmtree(self.dir)
+
+    def insert(self, name):
+        try:
+            Points.insert(name, "PointsTest")
+        except RuntimeError:
+            # PLY files are only supported if built with PCL
+            return None
+        return self.doc.Objects[-1]
+
+    def testBinaryRoundTrip(self):
+        rand = random.Random(4711)
+        count = 1000
+        points = [FreeCAD.Vector(rand.uniform(-10, 10), rand.uniform(-10, 10), rand.uniform(-10, 10))
+                  for i in range(count)]
+        normals = [FreeCAD.Vector(rand.uniform(-1, 1), rand.uniform(-1, 1), 1).normalize() for i in range(count)]
+        colors = [(rand.randint(0, 255), rand.randint(0, 255), rand.randint(0, 255)) for i in range(count)]
+
+        header = ("ply\n"
+                  "format binary_little_endian 1.0\n"
+                  "comment written by PointsTestsApp\n"
+                  "element vertex %d\n"
+                  "property float x\n"
+                  "property float y\n"
+                  "property float z\n"
+                  "property float nx\n"
+                  "property float ny\n"
+                  "property float nz\n"
+                  "property uchar red\n"
+                  "property uchar green\n"
+                  "property uchar blue\n"
+                  "end_header\n" % count)
+        data = [struct.pack("<6f3B", p.x, p.y, p.z, n.x, n.y, n.z, c[0], c[1], c[2])
+                for p, n, c in zip(points, normals, colors)]
+        name = writeFile(os.path.join(self.dir, "binary.ply"), header.encode("ascii") + b"".join(data), "wb")
+
+        fea = self.insert(name)
+        if fea is None:
+            return
+        self.failUnless(fea.Points.CountPoints == count)
+        for p, q in zip(points, fea.Points.Points):
+            self.failUnless((p - q).Length < 1e-5)
+        for n, m in zip(normals, fea.Normal):
+            self.failUnless((n - m).Length < 1e-5)
+        for c, d in zip(colors, fea.Color):
+            self.failUnless(all(abs(c[i] / 255.0 - d[i]) < 1e-5 for i in range(3)))
+
+        # write the points back and read them once more
+        copy = os.path.join(self.dir, "copy.ply")
+        Points.export([fea], copy)
+        other = self.insert(copy)
+        self.failUnless(other.Points.CountPoints == count)
+        for p, q in zip(fea.Points.Points, other.Points.Points):
+            self.failUnless((p - q).Length < 1e-4)
+        self.failUnless(fea.Points.BoundBox.isInside(other.Points.BoundBox.Center))
+
+
+class PointsPagesCases(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        rand = random.Random(4711)
+        # a sparse and a dense region, so that some octree buckets need several pages
+        vectors = [FreeCAD.Vector(rand.uniform(-100, 100), rand.uniform(-100, 100), rand.uniform(-10, 10))
+                   for i in range(50000)]
+        vectors += [FreeCAD.Vector(rand.gauss(5, 0.1), rand.gauss(5, 0.1), rand.gauss(5, 0.1))
+                    for i in range(100000)]
+        self.points = Points.Points(vectors)
+
+    def tearDown(self):
+        shutil.rmtree(self.dir)
+
+    def compare(self, paged, points):
+        self.failUnless(paged.CountPoints == points.CountPoints)
+        # the page file stores the points in octree order
+        self.failUnless(sorted((p.x, p.y, p.z) for p in paged.Points) ==
+                        sorted((p.x, p.y, p.z) for p in points.Points))
+        box1 = paged.BoundBox
+        box2 = points.BoundBox
+        for a, b in zip([box1.XMin, box1.YMin, box1.ZMin, box1.XMax, box1.YMax, box1.ZMax],
+                        [box2.XMin, box2.YMin, box2.ZMin, box2.XMax, box2.YMax, box2.ZMax]):
+            self.failUnless(abs(a - b) < 1e-4)
+
+    def testWriteAndReadPages(self):
+        name = os.path.join(self.dir, "points.pages")
+        self.points.writePages(name)
+        paged = Points.Points()
+        paged.readPages(name)
+        self.compare(paged, self.points)
+
+        # writing the pages of a paged kernel gives the same points
+        other = os.path.join(self.dir, "copy.pages")
+        paged.writePages(other)
+        copy = Points.Points()
+        copy.readPages(other)
+        self.compare(copy, self.points)
+
+    def testPagesFromAscii(self):
+        source = os.path.join(self.dir, "points.asc")
+        self.points.write(source)
+        points = Points.Points()
+        points.read(source)
+        paged = Points.Points()
+        paged.readPages(os.path.join(self.dir, "points.pages"), source)
+        self.compare(paged, points)
+
+    def testProjectRoundTrip(self):
+        name = os.path.join(self.dir, "points.pages")
+        self.points.writePages(name)
+        paged = Points.Points()
+        paged.readPages(name)
+
+        doc = FreeCAD.newDocument("PointsPages")
+        fea = doc.addObject("Points::Feature", "Cloud")
+        fea.Points = paged
+        doc.saveAs(os.path.join(self.dir, "project.FCStd"))
+        FreeCAD.closeDocument(doc.Name)
+
+        # the page file is referenced relative to the project, so both can be moved together
+        moved = os.path.join(self.dir, "moved")
+        os.mkdir(moved)
+        shutil.move(os.path.join(self.dir, "project.FCStd"), moved)
+        shutil.move(name, moved)
+        project = os.path.join(moved, "project.FCStd")
+        doc = FreeCAD.openDocument(project)
+        self.compare(doc.Cloud.Points, self.points)
+        FreeCAD.closeDocument(doc.Name)
+
+        # a missing page file stays referenced when the project is saved again
+        name = os.path.join(moved, "points.pages")
+        os.rename(name, name + ".bak")
+        doc = FreeCAD.openDocument(project)
+        self.failUnless(doc.Cloud.Points.CountPoints == 0)
+        doc.save()
+        FreeCAD.closeDocument(doc.Name)
+        os.rename(name + ".bak", name)
+        doc = FreeCAD.openDocument(project)
+        self.compare(doc.Cloud.Points, self.points)
+        FreeCAD.closeDocument(doc.Name)
+
+
+class PointsKdTreeCases(unittest.TestCase):
+    def setUp(self):
+        rand = random.Random(4711)
+        vectors = [FreeCAD.Vector(rand.uniform(-10, 10), rand.uniform(-10, 10), rand.uniform(-10, 10))
+                   for i in range(5000)]
+        # duplicates and points with NaN coordinates
+        vectors += vectors[0:100]
+        nan = float("nan")
+        vectors += [FreeCAD.Vector(nan, 0, 0), FreeCAD.Vector(nan, nan, nan)] * 10
+        rand.shuffle(vectors)
+        self.points = Points.Points(vectors)
+        self.valid = [(i, p) for i, p in enumerate(self.points.Points)
+                      if not (math.isnan(p.x) or math.isnan(p.y) or math.isnan(p.z))]
+        self.queries = [FreeCAD.Vector(rand.uniform(-12, 12), rand.uniform(-12, 12), rand.uniform(-12, 12))
+                        for i in range(200)]
+
+    def bruteForce(self, query, k):
+        dist = sorted((p - query).Length for i, p in self.valid)
+        return dist[0:k]
+
+    def testNearestPoints(self):
+        k = 8
+        points = self.points.Points
+        result = self.points.nearestPoints(self.queries, k)
+        self.failUnless(len(result) == len(self.queries))
+        for query, nearest in zip(self.queries, result):
+            self.failUnless(len(nearest) == k)
+            # with equal distances the indices may differ, so compare the distances
+            dist = [(points[i] - query).Length for i in nearest]
+            for a, b in zip(dist, self.bruteForce(query, k)):
+                self.failUnless(abs(a - b) < 1e-4)
+
+    def testNearestOfOwnPoints(self):
+        points = self.points.Points
+        queries = [p for i, p in self.valid[0:500]]
+        result = self.points.nearestPoints(queries)
+        for query, nearest in zip(queries, result):
+            self.failUnless((points[nearest[0]] - query).Length == 0.0)
+
+    def testLessPointsThanK(self):
+        result = self.points.nearestPoints(self.queries[0:3], len(self.valid) + 10)
+        for nearest in result:
+            self.failUnless(sorted(nearest) == [i for i, p in self.valid])
+
+    def testPointsInRadius(self):
+        radius = 2.0
+        indices = set(i for i, p in self.valid)
+        for query in self.queries[0:50]:
+            found = set(self.points.pointsInRadius(query, radius))
+            for i, p in self.valid:
+                dist = (p - query).Length
+                # skip the points where float and double precision disagree
+                if abs(dist - radius) < 1e-4:
+                    continue
+                self.failUnless((i in found) == (dist < radius))
+            self.failUnless(found.issubset(indices))
+
+
+class PointsCurvatureCases(unittest.TestCase):
+    def setUp(self):
+        try:
+            import ReverseEngineering
+            self.reen = ReverseEngineering
+        except ImportError:
+            self.reen = None
+
+    def testSphere(self):
+        if self.reen is None:
+            return
+        # Fibonacci sphere around the origin
+        radius = 10.0
+        count = 5000
+        vectors = []
+        for i in range(count):
+            z = 1.0 - (2.0 * i + 1.0) / count
+            r = math.sqrt(1.0 - z * z)
+            phi = i * math.pi * (3.0 - math.sqrt(5.0))
+            vectors.append(FreeCAD.Vector(radius * r * math.cos(phi), radius * r * math.sin(phi), radius * z))
+        points = Points.Points(vectors)
+
+        normals = self.reen.normalEstimation(points, KSearch=20)
+        self.failUnless(len(normals) == count)
+        result = self.reen.curvatureEstimation(points, KSearch=20)
+        self.failUnless(len(result) == count)
+        for p, n, c in zip(points.Points, normals, result):
+            # the normals are turned towards the view point in the origin
+            self.failUnless(n.dot(p) < 0.0)
+            self.failUnless(abs(n.dot(p) / p.Length) > 0.99)
+            self.failUnless((c[0] - n).Length < 1e-5)
+            self.failUnless(abs(abs(c[1]) - 1.0 / radius) < 0.01)
+            self.failUnless(abs(abs(c[2]) - 1.0 / radius) < 0.01)
+
+    def testCylinder(self):
+        if self.reen is None:
+            return
+        radius = 5.0
+        vectors = []
+        for i in range(120):
+            phi = 2.0 * math.pi * i / 120
+            for j in range(61):
+                vectors.append(FreeCAD.Vector(radius * math.cos(phi), radius * math.sin(phi), -15.0 + 0.5 * j))
+        points = Points.Points(vectors)
+
+        result = self.reen.curvatureEstimation(points, KSearch=20)
+        self.failUnless(len(result) == len(vectors))
+        axis = FreeCAD.Vector(0, 0, 1)
+        for p, c in zip(vectors, result):
+            # the neighbourhood is one-sided at the rims
+            if abs(p.z) > 12.0:
+                continue
+            normal, kmax, kmin, dmax, dmin = c
+            radial = FreeCAD.Vector(p.x, p.y, 0)
+            self.failUnless(normal.dot(radial) < 0.0)
+            self.failUnless(abs(normal.dot(radial) / radial.Length) > 0.99)
+            if abs(kmax) < abs(kmin):
+                kmax, kmin, dmax, dmin = kmin, kmax, dmin, dmax
+            self.failUnless(abs(abs(kmax) - 1.0 / radius) < 0.01)
+            self.failUnless(abs(kmin) < 0.01)
+            self.failUnless(abs(dmin.dot(axis)) > 0.99)
+            self.failUnless(abs(dmax.dot(axis)) < 0.1)
@@ -31,53 +31,80 @@
 
 #include <Base/Exception.h>
 #include <Base/Matrix.h>
+#include <Base/Reader.h>
 #include <Base/Stream.h>
 #include <Base/Writer.h>
+#include <App/Document.h>
+#include <App/DocumentObject.h>
+
+#include <QDir>
+#include <QFileInfo>
 
 #include "PropertyPointKernel.h"
 #include "PointsPy.h"
 
 using namespace Points;
 
+namespace {
+
+/// Returns the directory of the project file the property belongs to or an empty string
+QString projectDir(const App::Property* prop)
+{
+    App::DocumentObject* obj = dynamic_cast<App::DocumentObject*>(prop->getContainer());
+    if (obj && obj->getDocument()) {
+        const char* file = obj->getDocument()->FileName.getValue();
+        if (file && file[0] != '\0')
+            return QFileInfo(QString::fromUtf8(file)).absolutePath();
+    }
+    return QString();
+}
+
+}
+
 TYPESYSTEM_SOURCE(Points::PropertyPointKernel , App::PropertyComplexGeoData);
 
 PropertyPointKernel::PropertyPointKernel()
-    : _cPoints(new PointKernel())
+    : _cPoints(new PointKernel()), _LazyFile(0)
 {
 
 }
 
 PropertyPointKernel::~PropertyPointKernel()
 {
+    delete _LazyFile;
 }
 
 void PropertyPointKernel::setValue(const PointKernel& m)
 {
     aboutToSetValue();
+    // the points are replaced, so there is no need to read in the old ones
+    delete _LazyFile;
+    _LazyFile = 0;
     *_cPoints = m;
     hasSetValue();
 }
 
 const PointKernel& PropertyPointKernel::getValue(void) const 
 {
+    restoreLazyFile();
     return *_cPoints;
 }
 
 const Data::ComplexGeoData* PropertyPointKernel::getComplexData() const
 {
+    restoreLazyFile();
     return _cPoints;
 }
 
 Base::BoundBox3d PropertyPointKernel::getBoundingBox() const
 {
-    Base::BoundBox3d box;
-    for (PointKernel::const_iterator it = _cPoints->begin(); it != _cPoints->end(); ++it)
-        box.Add(*it);
-    return box;
+    restoreLazyFile();
+    return _cPoints->getBoundBox();
 }
 
 PyObject *PropertyPointKernel::getPyObject(void)
 {
+    restoreLazyFile();
     PointsPy* points = new PointsPy(&*_cPoints);
     points->setConst(); // set immutable
     return points;
@@ -98,17 +125,40 @@ void PropertyPointKernel::setPyObject(PyObject *value)
 
 void PropertyPointKernel::Save (Base::Writer &writer) const
 {
-    _cPoints->Save(writer);
+    // the point kernel writes its own file
+    restoreLazyFile();
+    std::string pages = _cPoints->getPageFile();
+    QString dir = projectDir(this);
+    if (!pages.empty() && !dir.isEmpty()) {
+        // refer to the page file relative to the project, so both can be moved together
+        QString file = QDir(dir).relativeFilePath(QString::fromUtf8(pages.c_str()));
+        _cPoints->savePages(writer, file.toUtf8().constData());
+    }
+    else {
+        _cPoints->Save(writer);
+    }
 }
 
 void PropertyPointKernel::Restore(Base::XMLReader &reader)
 {
     reader.readElement("Points");
-    std::string file (reader.getAttribute("file") );
+    if (reader.hasAttribute("pages")) {
+        // the points stay in their page file
+        QString file = QString::fromUtf8(reader.getAttribute("pages"));
+        QString dir = projectDir(this);
+        if (QFileInfo(file).isRelative() && !dir.isEmpty())
+            file = QDir::cleanPath(QDir(dir).absoluteFilePath(file));
+        aboutToSetValue();
+        _cPoints->restorePages(file.toUtf8().constData());
+        hasSetValue();
+    }
+    else {
+        std::string file (reader.getAttribute("file") );
 
-    if (!file.empty()) {
-        // initate a file read
-        reader.addFile(file.c_str(),this);
+        if (!file.empty()) {
+            // initate a file read
+            reader.addFile(file.c_str(),this);
+        }
     }
     if(reader.DocumentSchema > 3)
     {
@@ -135,8 +185,26 @@ void PropertyPointKernel::RestoreDocFile(Base::Reader &reader)
     hasSetValue();
 }
 
+bool PropertyPointKernel::RestoreDocFileLazy(Base::LazyFile* file)
+{
+    delete _LazyFile;
+    _LazyFile = file;
+    return true;
+}
+
+void PropertyPointKernel::restoreLazyFile() const
+{
+    // The points are read in as if they had been restored together with
+    // the document, so no change is notified
+    PointKernel* points = _cPoints;
+    Base::LazyFile::restoreOnce(_LazyFile, [points](Base::Reader& reader) {
+        points->RestoreDocFile(reader);
+    });
+}
+
 App::Property *PropertyPointKernel::Copy(void) const 
 {
+    restoreLazyFile();
     PropertyPointKernel* prop = new PropertyPointKernel();
     (*prop->_cPoints) = (*this->_cPoints);
     return prop;
@@ -144,19 +212,23 @@ App::Property *PropertyPointKernel::Copy(void) const
 
 void PropertyPointKernel::Paste(const App::Property &from)
 {
-    aboutToSetValue();
     const PropertyPointKernel& prop = dynamic_cast<const PropertyPointKernel&>(from);
+    prop.restoreLazyFile();
+    aboutToSetValue();
+    delete _LazyFile;
+    _LazyFile = 0;
     *(this->_cPoints) = *(prop._cPoints);
     hasSetValue();
 }
 
 unsigned int PropertyPointKernel::getMemSize (void) const
 {
-    return sizeof(Base::Vector3f) * this->_cPoints->size();
+    return this->_cPoints->getMemSize();
 }
 
 PointKernel* PropertyPointKernel::startEditing()
 {
+    restoreLazyFile();
     aboutToSetValue();
     return static_cast<PointKernel*>(_cPoints);
 }
@@ -168,6 +240,7 @@ void PropertyPointKernel::finishEditing()
 
 void PropertyPointKernel::removeIndices( const std::vector<unsigned long>& uIndices )
 {
+    restoreLazyFile();
     // We need a sorted array
     std::vector<unsigned long> uSortedInds = uIndices;
     std::sort(uSortedInds.begin(), uSortedInds.end());
@@ -196,6 +269,7 @@ void PropertyPointKernel::removeIndices( const std::vector<unsigned long>& uIndi
 
 void PropertyPointKernel::transformGeometry(const Base::Matrix4D &rclMat)
 {
+    restoreLazyFile();
     aboutToSetValue();
     _cPoints->transformGeometry(rclMat);
     hasSetValue();
@@ -26,6 +26,10 @@
 
 #include "Points.h"
 
+namespace Base {
+class LazyFile;
+}
+
 namespace Points
 {
 
@@ -75,6 +79,10 @@ public:
     void Restore(Base::XMLReader &reader);
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
+    bool RestoreDocFileLazy(Base::LazyFile* file);
+    void restoreLazyFile() const;
+    bool hasLazyFile() const
+    { return _LazyFile != 0; }
     //@}
 
     /** @name Modification */
@@ -88,6 +96,8 @@ public:
 
 private:
     Base::Reference<PointKernel> _cPoints;
+    /// file with the points if they aren't read in yet
+    mutable Base::LazyFile* _LazyFile;
 };
 
 } // namespace Points
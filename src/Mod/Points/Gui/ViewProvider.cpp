@@ -24,6 +24,11 @@
 #include "PreCompiled.h"
 
 #ifndef _PreComp_
+# include <Inventor/actions/SoGLRenderAction.h>
+# include <Inventor/elements/SoModelMatrixElement.h>
+# include <Inventor/elements/SoViewportRegionElement.h>
+# include <Inventor/elements/SoViewVolumeElement.h>
+# include <Inventor/nodes/SoCallback.h>
 # include <Inventor/nodes/SoCamera.h>
 # include <Inventor/nodes/SoCoordinate3.h>
 # include <Inventor/nodes/SoDrawStyle.h>
@@ -34,6 +39,7 @@
 # include <Inventor/nodes/SoNormal.h>
 # include <Inventor/errors/SoDebugError.h>
 # include <Inventor/events/SoMouseButtonEvent.h>
+# include <Inventor/sensors/SoOneShotSensor.h>
 #endif
 
 #include <boost/math/special_functions/fpclassify.hpp>
@@ -54,6 +60,7 @@
 #include <Gui/Window.h>
 
 #include <Gui/View3DInventorViewer.h>
+#include <Mod/Points/App/PointPages.h>
 #include <Mod/Points/App/PointsFeature.h>
 
 #include "ViewProvider.h"
@@ -63,6 +70,166 @@
 using namespace PointsGui;
 using namespace Points;
 
+namespace PointsGui {
+
+/**
+ * The PagedPointsLoader class shows a point cloud that is stored in a page file.
+ * Only the pages inside the view volume are loaded into the coordinate node, and
+ * pages that appear small on the screen are thinned out. At most \a budget points
+ * are shown at once.
+ *
+ * The pages are selected during rendering. If the selection has changed the new
+ * points are loaded by a sensor after the frame, which triggers a redraw.
+ */
+class PagedPointsLoader
+{
+public:
+    // a page and the stride used to thin it out
+    typedef std::vector< std::pair<std::size_t, std::size_t> > PageList;
+
+    PagedPointsLoader(SoCoordinate3* coords, SoPointSet* points)
+      : coords(coords), points(points), budget(5000000)
+    {
+        callback = new SoCallback();
+        callback->ref();
+        callback->setCallback(renderCB, this);
+        sensor = new SoOneShotSensor(loadCB, this);
+
+        Base::Reference<ParameterGrp> hGrp = Gui::WindowParameter::getDefaultParameter()->GetGroup("Mod/Points");
+        long value = hGrp->GetInt("PagedPointBudget", static_cast<long>(budget));
+        if (value > 0)
+            budget = static_cast<std::size_t>(value);
+    }
+    ~PagedPointsLoader()
+    {
+        delete sensor;
+        callback->unref();
+    }
+    SoNode* getNode() const
+    {
+        return callback;
+    }
+    bool isActive() const
+    {
+        return pages.get() != 0;
+    }
+    /// Shows an overview of all pages until the first frame is rendered
+    void setPages(const boost::shared_ptr<Points::PointPages>& p)
+    {
+        sensor->unschedule();
+        pages = p;
+        loaded.clear();
+        wanted.clear();
+        if (pages) {
+            std::size_t stride = strideFor(pages->size(), budget);
+            for (std::size_t i = 0; i < pages->countPages(); i++)
+                wanted.push_back(std::make_pair(i, stride));
+            loadPages();
+        }
+    }
+    static void fillPoints(const Points::PointPages& pages, const PageList& list,
+                           SoCoordinate3* coords, SoPointSet* points)
+    {
+        std::size_t total = 0;
+        for (PageList::const_iterator it = list.begin(); it != list.end(); ++it)
+            total += (pages.getPageSize(it->first) + it->second - 1) / it->second;
+
+        coords->point.setNum(total);
+        SbVec3f* vec = coords->point.startEditing();
+        std::size_t idx = 0;
+        for (PageList::const_iterator it = list.begin(); it != list.end(); ++it) {
+            const Base::Vector3f* pnt = pages.data() + pages.getPageOffset(it->first);
+            std::size_t size = pages.getPageSize(it->first);
+            for (std::size_t i = 0; i < size; i += it->second)
+                vec[idx++].setValue(pnt[i].x, pnt[i].y, pnt[i].z);
+        }
+        coords->point.finishEditing();
+        points->numPoints = total;
+    }
+    /// Returns the power of two stride that takes at most \a max of \a size points
+    static std::size_t strideFor(std::size_t size, std::size_t max)
+    {
+        std::size_t stride = 1;
+        while (max > 0 && size / stride > max)
+            stride *= 2;
+        return stride;
+    }
+
+private:
+    static void renderCB(void * data, SoAction * action)
+    {
+        if (action->isOfType(SoGLRenderAction::getClassTypeId()))
+            static_cast<PagedPointsLoader*>(data)->selectPages(action->getState());
+    }
+    static void loadCB(void * data, SoSensor *)
+    {
+        static_cast<PagedPointsLoader*>(data)->loadPages();
+    }
+    void selectPages(SoState* state)
+    {
+        if (!pages)
+            return;
+
+        // the page boxes are given in the coordinate system of the points
+        SbViewVolume vv = SoViewVolumeElement::get(state);
+        vv.transform(SoModelMatrixElement::get(state).inverse());
+        const SbViewportRegion& vp = SoViewportRegionElement::get(state);
+        float pixels = static_cast<float>(std::max(vp.getViewportSizePixels()[0],
+                                                   vp.getViewportSizePixels()[1]));
+
+        // a page needs about one point per pixel of its projection
+        PageList visible;
+        std::vector<std::size_t> needed;
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < pages->countPages(); i++) {
+            Base::BoundBox3f box = pages->getPageBoundBox(i);
+            SbBox3f sbox(box.MinX, box.MinY, box.MinZ, box.MaxX, box.MaxY, box.MaxZ);
+            if (!vv.intersect(sbox))
+                continue;
+            SbVec3f center = sbox.getCenter();
+            float diag = box.CalcDiagonalLength();
+            float scale = vv.getWorldToScreenScale(center, 1.0f);
+            float size = scale > 0.0f ? pixels * diag / scale : pixels;
+            std::size_t need = static_cast<std::size_t>(size * size) + 1;
+            need = std::min(need, pages->getPageSize(i));
+            visible.push_back(std::make_pair(i, std::size_t(1)));
+            needed.push_back(need);
+            total += need;
+        }
+
+        // thin out all pages equally if the budget is exceeded
+        double ratio = total > budget ? double(budget) / double(total) : 1.0;
+        for (std::size_t i = 0; i < visible.size(); i++) {
+            std::size_t need = std::max<std::size_t>(1, static_cast<std::size_t>(needed[i] * ratio));
+            visible[i].second = strideFor(pages->getPageSize(visible[i].first), need);
+        }
+
+        if (visible != loaded && visible != wanted) {
+            wanted.swap(visible);
+            sensor->schedule();
+        }
+    }
+    void loadPages()
+    {
+        if (!pages)
+            return;
+        fillPoints(*pages, wanted, coords, points);
+        loaded = wanted;
+    }
+
+private:
+    SoCallback* callback;
+    SoOneShotSensor* sensor;
+    SoCoordinate3* coords;
+    SoPointSet* points;
+    std::size_t budget;
+    boost::shared_ptr<Points::PointPages> pages;
+    PageList loaded;
+    PageList wanted;
+};
+
+}
+
 
 PROPERTY_SOURCE_ABSTRACT(PointsGui::ViewProviderPoints, Gui::ViewProviderGeometryObject)
 
@@ -331,10 +498,12 @@ ViewProviderScattered::ViewProviderScattered()
 {
     pcPoints = new SoPointSet();
     pcPoints->ref();
+    pcPagedPoints = new PagedPointsLoader(pcPointsCoord, pcPoints);
 }
 
 ViewProviderScattered::~ViewProviderScattered()
 {
+    delete pcPagedPoints;
     pcPoints->unref();
 }
 
@@ -348,6 +517,7 @@ void ViewProviderScattered::attach(App::DocumentObject* pcObj)
     pcHighlight->subElementName = "Main";
 
     // Hilight for selection
+    pcHighlight->addChild(pcPagedPoints->getNode());
     pcHighlight->addChild(pcPointsCoord);
     pcHighlight->addChild(pcPoints);
 
@@ -388,8 +558,13 @@ void ViewProviderScattered::updateData(const App::Property* prop)
 {
     ViewProviderPoints::updateData(prop);
     if (prop->getTypeId() == Points::PropertyPointKernel::getClassTypeId()) {
-        ViewProviderPointsBuilder builder;
-        builder.createPoints(prop, pcPointsCoord, pcPoints);
+        // paged points are loaded depending on the view
+        const Points::PointKernel& kernel = static_cast<const Points::PropertyPointKernel*>(prop)->getValue();
+        pcPagedPoints->setPages(kernel.getPages());
+        if (!pcPagedPoints->isActive()) {
+            ViewProviderPointsBuilder builder;
+            builder.createPoints(prop, pcPointsCoord, pcPoints);
+        }
 
         // The number of points might have changed, so force also a resize of the Inventor internals
         setActiveMode();
@@ -648,13 +823,24 @@ void ViewProviderPointsBuilder::createPoints(const App::Property* prop, SoCoordi
     const Points::PropertyPointKernel* prop_points = static_cast<const Points::PropertyPointKernel*>(prop);
     const Points::PointKernel& cPts = prop_points->getValue();
 
+    // for paged points show an overview instead of loading all of them
+    if (cPts.isPaged()) {
+        const Points::PointPages& pages = *cPts.getPages();
+        std::size_t stride = PagedPointsLoader::strideFor(pages.size(), 1000000);
+        PagedPointsLoader::PageList list;
+        for (std::size_t i = 0; i < pages.countPages(); i++)
+            list.push_back(std::make_pair(i, stride));
+        PagedPointsLoader::fillPoints(pages, list, coords, points);
+        return;
+    }
+
     coords->point.setNum(cPts.size());
     SbVec3f* vec = coords->point.startEditing();
 
     // get all points
     std::size_t idx=0;
-    const std::vector<Points::PointKernel::value_type>& kernel = cPts.getBasicPoints();
-    for (std::vector<Points::PointKernel::value_type>::const_iterator it = kernel.begin(); it != kernel.end(); ++it, idx++) {
+    const Points::PointKernel::value_type* kernel = cPts.data();
+    for (const Points::PointKernel::value_type* it = kernel; it != kernel + cPts.size(); ++it, idx++) {
         vec[idx].setValue(it->x, it->y, it->z);
     }
 
@@ -674,8 +860,8 @@ void ViewProviderPointsBuilder::createPoints(const App::Property* prop, SoCoordi
     std::size_t idx=0;
     std::vector<int32_t> indices;
     indices.reserve(cPts.size());
-    const std::vector<Points::PointKernel::value_type>& kernel = cPts.getBasicPoints();
-    for (std::vector<Points::PointKernel::value_type>::const_iterator it = kernel.begin(); it != kernel.end(); ++it, idx++) {
+    const Points::PointKernel::value_type* kernel = cPts.data();
+    for (const Points::PointKernel::value_type* it = kernel; it != kernel + cPts.size(); ++it, idx++) {
         vec[idx].setValue(it->x, it->y, it->z);
         // valid point?
         if (!(boost::math::isnan(it->x) || boost::math::isnan(it->y) || boost::math::isnan(it->z))) {
@@ -55,6 +55,8 @@ namespace Points {
 
 namespace PointsGui {
 
+class PagedPointsLoader;
+
 class ViewProviderPointsBuilder : public Gui::ViewProviderBuilder
 {
 public:
@@ -138,6 +140,7 @@ protected:
 
 protected:
     SoPointSet          * pcPoints;
+    PagedPointsLoader   * pcPagedPoints;
 };
 
 /**
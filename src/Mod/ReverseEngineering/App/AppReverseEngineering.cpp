@@ -39,6 +39,7 @@
 #include <Mod/Part/App/BSplineSurfacePy.h>
 #include <Mod/Mesh/App/Mesh.h>
 #include <Mod/Mesh/App/MeshPy.h>
+#include <Mod/Points/App/PointsCurvature.h>
 #include <Mod/Points/App/PointsPy.h>
 
 #include "ApproxSurface.h"
@@ -113,10 +114,14 @@ public:
         add_keyword_method("filterVoxelGrid",&Module::filterVoxelGrid,
             "filterVoxelGrid(dim)."
         );
+#endif
         add_keyword_method("normalEstimation",&Module::normalEstimation,
-            "normalEstimation(Points)."
+            "normalEstimation(Points,[KSearch=20,SearchRadius=0])."
+        );
+        add_keyword_method("curvatureEstimation",&Module::curvatureEstimation,
+            "curvatureEstimation(Points,[KSearch=20,SearchRadius=0])\n"
+            "Returns a list of (Normal,MaxCurvature,MinCurvature,MaxCurvDir,MinCurvDir) for each point."
         );
-#endif
 #if defined(HAVE_PCL_SEGMENTATION)
         add_keyword_method("regionGrowingSegmentation",&Module::regionGrowingSegmentation,
             "regionGrowingSegmentation()."
@@ -194,8 +199,8 @@ private:
             std::vector<Base::Vector3f> pts;
             if (PyObject_TypeCheck(o, &(Points::PointsPy::Type))) {
                 Points::PointsPy* pPoints = static_cast<Points::PointsPy*>(o);
-                Points::PointKernel* points = pPoints->getPointKernelPtr();
-                pts = points->getBasicPoints();
+                const Points::PointKernel* points = pPoints->getPointKernelPtr();
+                pts.assign(points->data(), points->data() + points->size());
             }
             else {
                 Py::Sequence l(o);
@@ -546,9 +551,9 @@ Mesh.show(m)
                                         &boundarySmoothness, &boundaryWeight))
             throw Py::Exception();
 
-        Points::PointKernel* points = static_cast<Points::PointsPy*>(pts)->getPointKernelPtr();
+        const Points::PointKernel* points = static_cast<Points::PointsPy*>(pts)->getPointKernelPtr();
 
-        BSplineFitting fit(points->getBasicPoints());
+        BSplineFitting fit(std::vector<Base::Vector3f>(points->data(), points->data() + points->size()));
         fit.setOrder(degree+1);
         fit.setRefinement(refinement);
         fit.setIterations(iterations);
@@ -609,7 +614,6 @@ Mesh.show(m)
         return Py::asObject(new Points::PointsPy(points_sample));
     }
 #endif
-#if defined(HAVE_PCL_FILTERS)
     Py::Object normalEstimation(const Py::Tuple& args, const Py::Dict& kwds)
     {
         PyObject *pts;
@@ -637,7 +641,41 @@ Mesh.show(m)
 
         return list;
     }
-#endif
+    Py::Object curvatureEstimation(const Py::Tuple& args, const Py::Dict& kwds)
+    {
+        PyObject *pts;
+        int ksearch=0;
+        double searchRadius=0;
+
+        static char* kwds_curvature[] = {"Points", "KSearch", "SearchRadius", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args.ptr(), kwds.ptr(), "O!|id", kwds_curvature,
+                                        &(Points::PointsPy::Type), &pts,
+                                        &ksearch, &searchRadius))
+            throw Py::Exception();
+
+        Points::PointKernel* points = static_cast<Points::PointsPy*>(pts)->getPointKernelPtr();
+
+        std::vector<Base::Vector3f> normals;
+        std::vector<Points::CurvatureInfo> curvature;
+        NormalEstimation estimate(*points);
+        estimate.setKSearch(ksearch);
+        estimate.setSearchRadius(searchRadius);
+        estimate.perform(normals, curvature);
+
+        Py::List list;
+        for (std::size_t i = 0; i < normals.size(); i++) {
+            const Points::CurvatureInfo& info = curvature[i];
+            Py::Tuple tuple(5);
+            tuple.setItem(0, Py::Vector(normals[i]));
+            tuple.setItem(1, Py::Float(info.fMaxCurvature));
+            tuple.setItem(2, Py::Float(info.fMinCurvature));
+            tuple.setItem(3, Py::Vector(info.cMaxCurvDir));
+            tuple.setItem(4, Py::Vector(info.cMinCurvDir));
+            list.append(tuple);
+        }
+
+        return list;
+    }
 #if defined(HAVE_PCL_SEGMENTATION)
     Py::Object regionGrowingSegmentation(const Py::Tuple& args, const Py::Dict& kwds)
     {
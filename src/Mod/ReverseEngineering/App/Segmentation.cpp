@@ -25,6 +25,8 @@
 
 #include "Segmentation.h"
 #include <Mod/Points/App/Points.h>
+#include <Mod/Points/App/PointsCurvature.h>
+#include <Mod/Points/App/PointsKdTree.h>
 #include <Base/Exception.h>
 
 #if defined(HAVE_PCL_FILTERS)
@@ -159,50 +161,47 @@ void Segmentation::perform(int ksearch)
 
 // ----------------------------------------------------------------------------
 
-#if defined (HAVE_PCL_FILTERS)
 NormalEstimation::NormalEstimation(const Points::PointKernel& pts)
   : myPoints(pts)
   , kSearch(0)
   , searchRadius(0)
+  , viewPoint(0.0f, 0.0f, 0.0f)
 {
 }
 
 void NormalEstimation::perform(std::vector<Base::Vector3d>& normals)
 {
-    // Copy the points
-    pcl::PointCloud<PointXYZ>::Ptr cloud (new pcl::PointCloud<PointXYZ>);
-    cloud->reserve(myPoints.size());
-    for (Points::PointKernel::const_iterator it = myPoints.begin(); it != myPoints.end(); ++it) {
-        cloud->push_back(pcl::PointXYZ(it->x, it->y, it->z));
-    }
-
-    cloud->width = int (cloud->points.size ());
-    cloud->height = 1;
+    std::vector<Base::Vector3f> estimated;
+    perform(estimated);
 
-    // Build a passthrough filter to remove spurious NaNs
-    pcl::PointCloud<PointXYZ>::Ptr cloud_filtered (new pcl::PointCloud<PointXYZ>);
-    pcl::PassThrough<PointXYZ> pass;
-    pass.setInputCloud (cloud);
-    pass.setFilterFieldName ("z");
-    pass.setFilterLimits (0, 1.5);
-    pass.filter (*cloud_filtered);
+    normals.reserve(estimated.size());
+    for (std::vector<Base::Vector3f>::iterator it = estimated.begin(); it != estimated.end(); ++it) {
+        normals.push_back(Base::convertTo<Base::Vector3d>(*it));
+    }
+}
 
-    // Estimate point normals
-    pcl::PointCloud<pcl::Normal>::Ptr cloud_normals (new pcl::PointCloud<pcl::Normal>);
-    pcl::search::KdTree<PointXYZ>::Ptr tree (new pcl::search::KdTree<PointXYZ> ());
-    pcl::NormalEstimation<PointXYZ, pcl::Normal> ne;
-    ne.setSearchMethod (tree);
-    ne.setInputCloud (cloud_filtered);
+void NormalEstimation::perform(std::vector<Base::Vector3f>& normals)
+{
+    // points with NaN coordinates get a null normal
+    Points::PointsKdTree tree(myPoints);
+    Points::PointsCurvature estimate(tree);
     if (kSearch > 0)
-        ne.setKSearch (kSearch);
+        estimate.SetKSearch(kSearch);
     if (searchRadius > 0)
-        ne.setRadiusSearch (searchRadius);
-    ne.compute (*cloud_normals);
-
-    normals.reserve(cloud_normals->size());
-    for (pcl::PointCloud<pcl::Normal>::const_iterator it = cloud_normals->begin(); it != cloud_normals->end(); ++it) {
-        normals.push_back(Base::Vector3d(it->normal_x, it->normal_y, it->normal_z));
-    }
+        estimate.SetSearchRadius(static_cast<float>(searchRadius));
+    estimate.SetViewPoint(viewPoint);
+    estimate.ComputeNormals(normals);
 }
 
-#endif // HAVE_PCL_FILTERS
+void NormalEstimation::perform(std::vector<Base::Vector3f>& normals,
+                               std::vector<Points::CurvatureInfo>& curvature)
+{
+    Points::PointsKdTree tree(myPoints);
+    Points::PointsCurvature estimate(tree);
+    if (kSearch > 0)
+        estimate.SetKSearch(kSearch);
+    if (searchRadius > 0)
+        estimate.SetSearchRadius(static_cast<float>(searchRadius));
+    estimate.SetViewPoint(viewPoint);
+    estimate.ComputeCurvature(normals, curvature);
+}
@@ -28,7 +28,7 @@
 #include <vector>
 #include <list>
 
-namespace Points {class PointKernel;}
+namespace Points {class PointKernel; struct CurvatureInfo;}
 
 namespace Reen {
 
@@ -66,15 +66,29 @@ public:
         searchRadius = radius;
     }
 
+    /** \brief Set the view point the normals are turned to.
+      * \param[in] view the view point, the default is the origin
+      */
+    inline void
+    setViewPoint (const Base::Vector3f& view) { viewPoint = view; }
+
     /** \brief Perform the normal estimation.
       * \param[out] the estimated normals
       */
     void perform(std::vector<Base::Vector3d>& normals);
+    void perform(std::vector<Base::Vector3f>& normals);
+    /** \brief Perform the normal and curvature estimation.
+      * \param[out] the estimated normals
+      * \param[out] the estimated principal curvatures
+      */
+    void perform(std::vector<Base::Vector3f>& normals,
+                 std::vector<Points::CurvatureInfo>& curvature);
 
 private:
     const Points::PointKernel& myPoints;
     int kSearch;
     double searchRadius;
+    Base::Vector3f viewPoint;
 };
 
 } // namespace Reen
@@ -24,6 +24,7 @@
 #include "PreCompiled.h"
 
 #include "SurfaceTriangulation.h"
+#include "Segmentation.h"
 #include <Mod/Points/App/Points.h>
 #include <Mod/Mesh/App/Mesh.h>
 #include <Mod/Mesh/App/Core/Algorithm.h>
@@ -60,6 +61,18 @@ using namespace pcl::io;
 using namespace std;
 using namespace Reen;
 
+namespace {
+// Estimates the normals like pcl::NormalEstimation with its default settings
+// did, i.e. the normals are turned towards the origin
+void estimateNormals(const Points::PointKernel& points, int ksearch, std::vector<Base::Vector3f>& normals)
+{
+    Reen::NormalEstimation estimate(points);
+    estimate.setKSearch(ksearch);
+    estimate.setViewPoint(Base::Vector3f(0.0f, 0.0f, 0.0f));
+    estimate.perform(normals);
+}
+}
+
 // See
 // http://www.ics.uci.edu/~gopi/PAPERS/Euro00.pdf
 // http://www.ics.uci.edu/~gopi/PAPERS/CGMV.pdf
@@ -73,61 +86,10 @@ SurfaceTriangulation::SurfaceTriangulation(const Points::PointKernel& pts, Mesh:
 
 void SurfaceTriangulation::perform(int ksearch)
 {
-    PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
-    PointCloud<PointNormal>::Ptr cloud_with_normals (new PointCloud<PointNormal>);
-    search::KdTree<PointXYZ>::Ptr tree;
-    search::KdTree<PointNormal>::Ptr tree2;
-
-    cloud->reserve(myPoints.size());
-    for (Points::PointKernel::const_iterator it = myPoints.begin(); it != myPoints.end(); ++it) {
-        if (!boost::math::isnan(it->x) && !boost::math::isnan(it->y) && !boost::math::isnan(it->z))
-            cloud->push_back(PointXYZ(it->x, it->y, it->z));
-    }
-
-    // Create search tree
-    tree.reset (new search::KdTree<PointXYZ> (false));
-    tree->setInputCloud (cloud);
-
-    // Normal estimation
-    NormalEstimation<PointXYZ, Normal> n;
-    PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
-    n.setInputCloud (cloud);
-    //n.setIndices (indices[B);
-    n.setSearchMethod (tree);
-    n.setKSearch (ksearch);
-    n.compute (*normals);
-
-    // Concatenate XYZ and normal information
-    pcl::concatenateFields (*cloud, *normals, *cloud_with_normals);
-
-    // Create search tree
-    tree2.reset (new search::KdTree<PointNormal>);
-    tree2->setInputCloud (cloud_with_normals);
-
-    // Init objects
-    GreedyProjectionTriangulation<PointNormal> gp3;
-
-    // Set parameters
-    gp3.setInputCloud (cloud_with_normals);
-    gp3.setSearchMethod (tree2);
-    gp3.setSearchRadius (searchRadius);
-    gp3.setMu (mu);
-    gp3.setMaximumNearestNeighbors (100);
-    gp3.setMaximumSurfaceAngle(M_PI/4); // 45 degrees
-    gp3.setMinimumAngle(M_PI/18); // 10 degrees
-    gp3.setMaximumAngle(2*M_PI/3); // 120 degrees
-    gp3.setNormalConsistency(false);
-    gp3.setConsistentVertexOrdering(true);
-
-    // Reconstruct
-    PolygonMesh mesh;
-    gp3.reconstruct (mesh);
-
-    MeshConversion::convert(mesh, myMesh);
-
-    // Additional vertex information
-    //std::vector<int> parts = gp3.getPartIDs();
-    //std::vector<int> states = gp3.getPointStates();
+    std::vector<Base::Vector3f> normals;
+    estimateNormals(myPoints, ksearch, normals);
+    // the estimated normals are not consistently oriented
+    triangulate(normals, false);
 }
 
 void SurfaceTriangulation::perform(const std::vector<Base::Vector3f>& normals)
@@ -135,12 +97,17 @@ void SurfaceTriangulation::perform(const std::vector<Base::Vector3f>& normals)
     if (myPoints.size() != normals.size())
         throw Base::RuntimeError("Number of points doesn't match with number of normals");
 
+    triangulate(normals, true);
+}
+
+void SurfaceTriangulation::triangulate(const std::vector<Base::Vector3f>& normals, bool normalConsistency)
+{
     PointCloud<PointNormal>::Ptr cloud_with_normals (new PointCloud<PointNormal>);
     search::KdTree<PointNormal>::Ptr tree;
 
     cloud_with_normals->reserve(myPoints.size());
     std::size_t num_points = myPoints.size();
-    const std::vector<Base::Vector3f>& points = myPoints.getBasicPoints();
+    const Base::Vector3f* points = myPoints.data();
     for (std::size_t index=0; index<num_points; index++) {
         const Base::Vector3f& p = points[index];
         const Base::Vector3f& n = normals[index];
@@ -172,7 +139,7 @@ void SurfaceTriangulation::perform(const std::vector<Base::Vector3f>& normals)
     gp3.setMaximumSurfaceAngle(M_PI/4); // 45 degrees
     gp3.setMinimumAngle(M_PI/18); // 10 degrees
     gp3.setMaximumAngle(2*M_PI/3); // 120 degrees
-    gp3.setNormalConsistency(true);
+    gp3.setNormalConsistency(normalConsistency);
     gp3.setConsistentVertexOrdering(true);
 
     // Reconstruct
@@ -201,55 +168,9 @@ PoissonReconstruction::PoissonReconstruction(const Points::PointKernel& pts, Mes
 
 void PoissonReconstruction::perform(int ksearch)
 {
-    PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
-    PointCloud<PointNormal>::Ptr cloud_with_normals (new PointCloud<PointNormal>);
-    search::KdTree<PointXYZ>::Ptr tree;
-    search::KdTree<PointNormal>::Ptr tree2;
-
-    cloud->reserve(myPoints.size());
-    for (Points::PointKernel::const_iterator it = myPoints.begin(); it != myPoints.end(); ++it) {
-        if (!boost::math::isnan(it->x) && !boost::math::isnan(it->y) && !boost::math::isnan(it->z))
-            cloud->push_back(PointXYZ(it->x, it->y, it->z));
-    }
-
-    // Create search tree
-    tree.reset (new search::KdTree<PointXYZ> (false));
-    tree->setInputCloud (cloud);
-
-    // Normal estimation
-    NormalEstimation<PointXYZ, Normal> n;
-    PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
-    n.setInputCloud (cloud);
-    //n.setIndices (indices[B);
-    n.setSearchMethod (tree);
-    n.setKSearch (ksearch);
-    n.compute (*normals);
-
-    // Concatenate XYZ and normal information
-    pcl::concatenateFields (*cloud, *normals, *cloud_with_normals);
-
-    // Create search tree
-    tree2.reset (new search::KdTree<PointNormal>);
-    tree2->setInputCloud (cloud_with_normals);
-
-    // Init objects
-    Poisson<PointNormal> poisson;
-
-    // Set parameters
-    poisson.setInputCloud (cloud_with_normals);
-    poisson.setSearchMethod (tree2);
-    if (depth >= 1)
-        poisson.setDepth(depth);
-    if (solverDivide >= 1)
-        poisson.setSolverDivide(solverDivide);
-    if (samplesPerNode >= 1.0f)
-        poisson.setSamplesPerNode(samplesPerNode);
-
-    // Reconstruct
-    PolygonMesh mesh;
-    poisson.reconstruct (mesh);
-
-    MeshConversion::convert(mesh, myMesh);
+    std::vector<Base::Vector3f> normals;
+    estimateNormals(myPoints, ksearch, normals);
+    perform(normals);
 }
 
 void PoissonReconstruction::perform(const std::vector<Base::Vector3f>& normals)
@@ -262,7 +183,7 @@ void PoissonReconstruction::perform(const std::vector<Base::Vector3f>& normals)
 
     cloud_with_normals->reserve(myPoints.size());
     std::size_t num_points = myPoints.size();
-    const std::vector<Base::Vector3f>& points = myPoints.getBasicPoints();
+    const Base::Vector3f* points = myPoints.data();
     for (std::size_t index=0; index<num_points; index++) {
         const Base::Vector3f& p = points[index];
         const Base::Vector3f& n = normals[index];
@@ -312,53 +233,9 @@ GridReconstruction::GridReconstruction(const Points::PointKernel& pts, Mesh::Mes
 
 void GridReconstruction::perform(int ksearch)
 {
-    PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
-    PointCloud<PointNormal>::Ptr cloud_with_normals (new PointCloud<PointNormal>);
-    search::KdTree<PointXYZ>::Ptr tree;
-    search::KdTree<PointNormal>::Ptr tree2;
-
-    cloud->reserve(myPoints.size());
-    for (Points::PointKernel::const_iterator it = myPoints.begin(); it != myPoints.end(); ++it) {
-        if (!boost::math::isnan(it->x) && !boost::math::isnan(it->y) && !boost::math::isnan(it->z))
-            cloud->push_back(PointXYZ(it->x, it->y, it->z));
-    }
-
-    // Create search tree
-    tree.reset (new search::KdTree<PointXYZ> (false));
-    tree->setInputCloud (cloud);
-
-    // Normal estimation
-    NormalEstimation<PointXYZ, Normal> n;
-    PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
-    n.setInputCloud (cloud);
-    //n.setIndices (indices[B);
-    n.setSearchMethod (tree);
-    n.setKSearch (ksearch);
-    n.compute (*normals);
-
-    // Concatenate XYZ and normal information
-    pcl::concatenateFields (*cloud, *normals, *cloud_with_normals);
-
-    // Create search tree
-    tree2.reset (new search::KdTree<PointNormal>);
-    tree2->setInputCloud (cloud_with_normals);
-
-    // Init objects
-    GridProjection<PointNormal> grid;
-
-    // Set parameters
-    grid.setResolution(0.005); 
-    grid.setPaddingSize(3); 
-    grid.setNearestNeighborNum(100); 
-    grid.setMaxBinarySearchLevel(10);
-    grid.setInputCloud (cloud_with_normals);
-    grid.setSearchMethod (tree2);
-
-    // Reconstruct
-    PolygonMesh mesh;
-    grid.reconstruct (mesh);
-
-    MeshConversion::convert(mesh, myMesh);
+    std::vector<Base::Vector3f> normals;
+    estimateNormals(myPoints, ksearch, normals);
+    perform(normals);
 }
 
 void GridReconstruction::perform(const std::vector<Base::Vector3f>& normals)
@@ -371,7 +248,7 @@ void GridReconstruction::perform(const std::vector<Base::Vector3f>& normals)
 
     cloud_with_normals->reserve(myPoints.size());
     std::size_t num_points = myPoints.size();
-    const std::vector<Base::Vector3f>& points = myPoints.getBasicPoints();
+    const Base::Vector3f* points = myPoints.data();
     for (std::size_t index=0; index<num_points; index++) {
         const Base::Vector3f& p = points[index];
         const Base::Vector3f& n = normals[index];
@@ -430,7 +307,7 @@ void ImageTriangulation::perform()
     cloud_organized->height = height;
     cloud_organized->points.resize (cloud_organized->width * cloud_organized->height);
 
-    const std::vector<Base::Vector3f>& points = myPoints.getBasicPoints();
+    const Base::Vector3f* points = myPoints.data();
 
     int npoints = 0;
     for (size_t i = 0; i < cloud_organized->height; i++) {
@@ -498,54 +375,9 @@ Reen::MarchingCubesRBF::MarchingCubesRBF(const Points::PointKernel& pts, Mesh::M
 
 void Reen::MarchingCubesRBF::perform(int ksearch)
 {
-    PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
-    PointCloud<PointNormal>::Ptr cloud_with_normals (new PointCloud<PointNormal>);
-    search::KdTree<PointXYZ>::Ptr tree;
-    search::KdTree<PointNormal>::Ptr tree2;
-
-    cloud->reserve(myPoints.size());
-    for (Points::PointKernel::const_iterator it = myPoints.begin(); it != myPoints.end(); ++it) {
-        if (!boost::math::isnan(it->x) && !boost::math::isnan(it->y) && !boost::math::isnan(it->z))
-            cloud->push_back(PointXYZ(it->x, it->y, it->z));
-    }
-
-    // Create search tree
-    tree.reset (new search::KdTree<PointXYZ> (false));
-    tree->setInputCloud (cloud);
-
-    // Normal estimation
-    NormalEstimation<PointXYZ, Normal> n;
-    PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
-    n.setInputCloud (cloud);
-    //n.setIndices (indices[B);
-    n.setSearchMethod (tree);
-    n.setKSearch (ksearch);
-    n.compute (*normals);
-
-    // Concatenate XYZ and normal information
-    pcl::concatenateFields (*cloud, *normals, *cloud_with_normals);
-
-    // Create search tree
-    tree2.reset (new search::KdTree<PointNormal>);
-    tree2->setInputCloud (cloud_with_normals);
-
-    // Init objects
-    pcl::MarchingCubesRBF<PointNormal> rbf;
-
-    // Set parameters
-    rbf.setIsoLevel (0);
-    rbf.setGridResolution (60, 60, 60);
-    rbf.setPercentageExtendGrid (0.1f);
-    rbf.setOffSurfaceDisplacement (0.02f);
-
-    rbf.setInputCloud (cloud_with_normals);
-    rbf.setSearchMethod (tree2);
-
-    // Reconstruct
-    PolygonMesh mesh;
-    rbf.reconstruct (mesh);
-
-    MeshConversion::convert(mesh, myMesh);
+    std::vector<Base::Vector3f> normals;
+    estimateNormals(myPoints, ksearch, normals);
+    perform(normals);
 }
 
 void Reen::MarchingCubesRBF::perform(const std::vector<Base::Vector3f>& normals)
@@ -558,7 +390,7 @@ void Reen::MarchingCubesRBF::perform(const std::vector<Base::Vector3f>& normals)
 
     cloud_with_normals->reserve(myPoints.size());
     std::size_t num_points = myPoints.size();
-    const std::vector<Base::Vector3f>& points = myPoints.getBasicPoints();
+    const Base::Vector3f* points = myPoints.data();
     for (std::size_t index=0; index<num_points; index++) {
         const Base::Vector3f& p = points[index];
         const Base::Vector3f& n = normals[index];
@@ -608,53 +440,9 @@ Reen::MarchingCubesHoppe::MarchingCubesHoppe(const Points::PointKernel& pts, Mes
 
 void Reen::MarchingCubesHoppe::perform(int ksearch)
 {
-    PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
-    PointCloud<PointNormal>::Ptr cloud_with_normals (new PointCloud<PointNormal>);
-    search::KdTree<PointXYZ>::Ptr tree;
-    search::KdTree<PointNormal>::Ptr tree2;
-
-    cloud->reserve(myPoints.size());
-    for (Points::PointKernel::const_iterator it = myPoints.begin(); it != myPoints.end(); ++it) {
-        if (!boost::math::isnan(it->x) && !boost::math::isnan(it->y) && !boost::math::isnan(it->z))
-            cloud->push_back(PointXYZ(it->x, it->y, it->z));
-    }
-
-    // Create search tree
-    tree.reset (new search::KdTree<PointXYZ> (false));
-    tree->setInputCloud (cloud);
-
-    // Normal estimation
-    NormalEstimation<PointXYZ, Normal> n;
-    PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
-    n.setInputCloud (cloud);
-    //n.setIndices (indices[B);
-    n.setSearchMethod (tree);
-    n.setKSearch (ksearch);
-    n.compute (*normals);
-
-    // Concatenate XYZ and normal information
-    pcl::concatenateFields (*cloud, *normals, *cloud_with_normals);
-
-    // Create search tree
-    tree2.reset (new search::KdTree<PointNormal>);
-    tree2->setInputCloud (cloud_with_normals);
-
-    // Init objects
-    pcl::MarchingCubesHoppe<PointNormal> hoppe;
-
-    // Set parameters
-    hoppe.setIsoLevel (0);
-    hoppe.setGridResolution (60, 60, 60);
-    hoppe.setPercentageExtendGrid (0.1f);
-
-    hoppe.setInputCloud (cloud_with_normals);
-    hoppe.setSearchMethod (tree2);
-
-    // Reconstruct
-    PolygonMesh mesh;
-    hoppe.reconstruct (mesh);
-
-    MeshConversion::convert(mesh, myMesh);
+    std::vector<Base::Vector3f> normals;
+    estimateNormals(myPoints, ksearch, normals);
+    perform(normals);
 }
 
 void Reen::MarchingCubesHoppe::perform(const std::vector<Base::Vector3f>& normals)
@@ -667,7 +455,7 @@ void Reen::MarchingCubesHoppe::perform(const std::vector<Base::Vector3f>& normal
 
     cloud_with_normals->reserve(myPoints.size());
     std::size_t num_points = myPoints.size();
-    const std::vector<Base::Vector3f>& points = myPoints.getBasicPoints();
+    const Base::Vector3f* points = myPoints.data();
     for (std::size_t index=0; index<num_points; index++) {
         const Base::Vector3f& p = points[index];
         const Base::Vector3f& n = normals[index];
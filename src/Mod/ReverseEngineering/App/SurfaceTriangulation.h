@@ -66,6 +66,9 @@ public:
     inline void 
     setSearchRadius (double radius) { this->searchRadius = radius; }
 
+private:
+    void triangulate(const std::vector<Base::Vector3f>& normals, bool normalConsistency);
+
 private:
     const Points::PointKernel& myPoints;
     Mesh::MeshObject& myMesh;
@@ -1422,10 +1422,28 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
         return Success;
 
     Eigen::VectorXd e(csize), e_new(csize); // vector of all function errors (every constraint is one function)
-    Eigen::MatrixXd J(csize, xsize);        // Jacobi of the subsystem
-    Eigen::MatrixXd A(xsize, xsize);
+    Eigen::MatrixXd J;                      // Jacobi of the subsystem
+    Eigen::MatrixXd A;
     Eigen::VectorXd x(xsize), h(xsize), x_new(xsize), g(xsize), diag_A(xsize);
 
+    bool sparse = false;
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+    // for large subsystems J and J^T J are sparse as each constraint only
+    // depends on a handful of parameters
+    Eigen::SparseMatrix<double> SJ, SA, SAmu;
+    Eigen::SparseMatrix<double> SI(xsize, xsize);
+    Eigen::SimplicialLDLT< Eigen::SparseMatrix<double> > ldlt;
+    if (xsize >= SparseMinSize) {
+        sparse = true;
+        SI.setIdentity();
+    }
+    else
+#endif
+    {
+        J.resize(csize, xsize);
+        A.resize(xsize, xsize);
+    }
+
     subsys->redirectParams();
 
     subsys->getParams(x);
@@ -1471,14 +1489,26 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
         }
 
         // J^T J, J^T e
-        subsys->calcJacobi(J);;
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+        if (sparse) {
+            subsys->calcJacobi(SJ);
+
+            SA = SJ.transpose()*SJ;
+            g = SJ.transpose()*e;
+            diag_A = SA.diagonal();
+        }
+        else
+#endif
+        {
+            subsys->calcJacobi(J);
 
-        A = J.transpose()*J;
-        g = J.transpose()*e;
+            A = J.transpose()*J;
+            g = J.transpose()*e;
+            diag_A = A.diagonal(); // save diagonal entries so that augmentation can be later canceled
+        }
 
         // Compute ||J^T e||_inf
         double g_inf = g.lpNorm<Eigen::Infinity>();
-        diag_A = A.diagonal(); // save diagonal entries so that augmentation can be later canceled
 
         // check for convergence
         if (g_inf <= eps1) {
@@ -1494,13 +1524,33 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
         // determine increment using adaptive damping
         int k=0;
         while (k < 50) {
-            // augment normal equations A = A+uI
-            for (int i=0; i < xsize; ++i)
-                A(i,i) += mu;
-
-            //solve augmented functions A*h=-g
-            h = A.fullPivLu().solve(g);
-            double rel_error = (A*h - g).norm() / g.norm();
+            double rel_error;
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+            if (sparse) {
+                // augment normal equations A = A+uI
+                SAmu = SA + mu*SI;
+
+                //solve augmented functions A*h=-g, the pattern does not change with mu
+                if (k == 0)
+                    ldlt.analyzePattern(SAmu);
+                ldlt.factorize(SAmu);
+                if (ldlt.info() == Eigen::Success)
+                    h = ldlt.solve(g);
+                else
+                    h = Eigen::MatrixXd(SAmu).fullPivLu().solve(g);
+                rel_error = (SAmu*h - g).norm() / g.norm();
+            }
+            else
+#endif
+            {
+                // augment normal equations A = A+uI
+                for (int i=0; i < xsize; ++i)
+                    A(i,i) += mu;
+
+                //solve augmented functions A*h=-g
+                h = A.fullPivLu().solve(g);
+                rel_error = (A*h - g).norm() / g.norm();
+            }
 
             // check if solving works
             if (rel_error < 1e-5) {
@@ -1547,8 +1597,10 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
 
             mu*=nu;
             nu*=2.0;
-            for (int i=0; i < xsize; ++i) // restore diagonal J^T J entries
-                A(i,i) = diag_A(i);
+            if (!sparse) {
+                for (int i=0; i < xsize; ++i) // restore diagonal J^T J entries
+                    A(i,i) = diag_A(i);
+            }
 
             k++;
         }
@@ -1579,12 +1631,75 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
 }
 
 
-int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
+// get the gauss-newton step
+// http://forum.freecadweb.org/viewtopic.php?f=10&t=12769&start=50#p106220
+// https://forum.kde.org/viewtopic.php?f=74&t=129439#p346104
+static void gaussNewtonStep(const Eigen::MatrixXd &Jx, const Eigen::VectorXd &fx,
+                            DogLegGaussStep method, Eigen::VectorXd &h_gn)
 {
-#ifdef _GCS_EXTRACT_SOLVER_SUBSYSTEM_
-    extractSubsystem(subsys, isRedundantsolving);
+    switch (method){
+        case FullPivLU:
+            h_gn = Jx.fullPivLu().solve(-fx);
+            break;
+        case LeastNormFullPivLU:
+            h_gn = Jx.adjoint()*(Jx*Jx.adjoint()).fullPivLu().solve(-fx);
+            break;
+        case LeastNormLdlt:
+            h_gn = Jx.adjoint()*(Jx*Jx.adjoint()).ldlt().solve(-fx);
+            break;
+    }
+}
+
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+static void gaussNewtonStep(const Eigen::SparseMatrix<double> &Jx, const Eigen::VectorXd &fx,
+                            DogLegGaussStep method, Eigen::VectorXd &h_gn)
+{
+    bool ok = false;
+    if (method == FullPivLU) {
+        // Only a regular square system has a unique solution that is the same as the
+        // one of the dense FullPivLU. For other systems FullPivLU picks a particular
+        // solution, which determines how a dragged sketch moves, so they are left to it.
+        if (Jx.rows() == Jx.cols()) {
+            Eigen::SparseLU< Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > lu;
+            lu.analyzePattern(Jx);
+            lu.factorize(Jx);
+            if (lu.info() == Eigen::Success) {
+                h_gn = lu.solve(-fx);
+                ok = (lu.info() == Eigen::Success);
+            }
+        }
+    }
+    else {
+        // least norm solution
+        Eigen::SparseMatrix<double> JJt = Jx*Jx.transpose();
+        Eigen::VectorXd y;
+        if (method == LeastNormLdlt) {
+            Eigen::SimplicialLDLT< Eigen::SparseMatrix<double> > ldlt(JJt);
+            if (ldlt.info() == Eigen::Success)
+                y = ldlt.solve(-fx);
+            ok = (ldlt.info() == Eigen::Success);
+        }
+        else {
+            Eigen::SparseLU< Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > lu;
+            lu.analyzePattern(JJt);
+            lu.factorize(JJt);
+            if (lu.info() == Eigen::Success)
+                y = lu.solve(-fx);
+            ok = (lu.info() == Eigen::Success);
+        }
+        if (ok)
+            h_gn = Jx.transpose()*y;
+    }
+
+    // singular and non-square FullPivLU systems are left to the dense decompositions
+    if (!ok || !h_gn.allFinite())
+        gaussNewtonStep(Eigen::MatrixXd(Jx), fx, method, h_gn);
+}
 #endif
 
+template <typename Matrix>
+int System::solve_DL(SubSystem* subsys, bool isRedundantsolving, Matrix &Jx, Matrix &Jx_new)
+{
     double tolg=(isRedundantsolving?DL_tolgRedundant:DL_tolg);
     double tolx=(isRedundantsolving?DL_tolxRedundant:DL_tolx);
     double tolf=(isRedundantsolving?DL_tolfRedundant:DL_tolf);
@@ -1616,7 +1731,6 @@ int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
 
     Eigen::VectorXd x(xsize), x_new(xsize);
     Eigen::VectorXd fx(csize), fx_new(csize);
-    Eigen::MatrixXd Jx(csize, xsize), Jx_new(csize, xsize);
     Eigen::VectorXd g(xsize), h_sd(xsize), h_gn(xsize), h_dl(xsize);
 
     subsys->redirectParams();
@@ -1658,19 +1772,7 @@ int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
             h_sd  = alpha*g;
 
             // get the gauss-newton step
-            // http://forum.freecadweb.org/viewtopic.php?f=10&t=12769&start=50#p106220
-            // https://forum.kde.org/viewtopic.php?f=74&t=129439#p346104
-            switch (dogLegGaussStep){
-                case FullPivLU:
-                    h_gn = Jx.fullPivLu().solve(-fx);
-                    break;
-                case LeastNormFullPivLU:
-                    h_gn = Jx.adjoint()*(Jx*Jx.adjoint()).fullPivLu().solve(-fx);
-                    break;
-                case LeastNormLdlt:
-                    h_gn = Jx.adjoint()*(Jx*Jx.adjoint()).ldlt().solve(-fx);
-                    break;
-            }
+            gaussNewtonStep(Jx, fx, dogLegGaussStep, h_gn);
 
             double rel_error = (Jx*h_gn + fx).norm() / fx.norm();
             if (rel_error > 1e15)
@@ -1786,6 +1888,23 @@ int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
     return (stop == 1) ? Success : Failed;
 }
 
+int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
+{
+#ifdef _GCS_EXTRACT_SOLVER_SUBSYSTEM_
+    extractSubsystem(subsys, isRedundantsolving);
+#endif
+
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+    if (subsys->pSize() >= SparseMinSize) {
+        Eigen::SparseMatrix<double> Jx, Jx_new;
+        return solve_DL(subsys, isRedundantsolving, Jx, Jx_new);
+    }
+#endif
+
+    Eigen::MatrixXd Jx, Jx_new;
+    return solve_DL(subsys, isRedundantsolving, Jx, Jx_new);
+}
+
 #ifdef _GCS_EXTRACT_SOLVER_SUBSYSTEM_
 void System::extractSubsystem(SubSystem *subsys, bool isRedundantsolving)
 {
@@ -3530,14 +3649,43 @@ int System::diagnose(Algorithm alg)
     redundant.clear();
     conflictingTags.clear();
     redundantTags.clear();
-    Eigen::MatrixXd J(clist.size(), plist.size());
+
+#ifndef EIGEN_SPARSEQR_COMPATIBLE
+    if(qrAlgorithm==EigenSparseQR){
+        Base::Console().Warning("SparseQR not supported by you current version of Eigen. It requires Eigen 3.2.2 or higher. Falling back to Dense QR\n");
+        qrAlgorithm=EigenDenseQR;
+    }
+#endif
+
+    // the dense Jacobian is only created for the dense QR decomposition
+    Eigen::MatrixXd J;
+    if(qrAlgorithm==EigenDenseQR)
+        J.setZero(clist.size(), plist.size());
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+    std::vector< Eigen::Triplet<double> > triplets;
+#endif
+
     int count=0;
     for (std::vector<Constraint *>::iterator constr=clist.begin(); constr != clist.end(); ++constr) {
         (*constr)->revertParams();
         if ((*constr)->getTag() >= 0) {
             count++;
-            for (int j=0; j < int(plist.size()); j++)
-                J(count-1,j) = (*constr)->grad(plist[j]);
+            // only the parameters of a constraint have a non-zero derivative
+            VEC_pD &cparams = c2p[*constr];
+            SET_pD constr_params(cparams.begin(), cparams.end());
+            for (SET_pD::const_iterator param=constr_params.begin();
+                 param != constr_params.end(); ++param) {
+                MAP_pD_I::const_iterator it = pIndex.find(*param);
+                if (it == pIndex.end())
+                    continue;
+                double value = (*constr)->grad(*param);
+                if(qrAlgorithm==EigenDenseQR)
+                    J(count-1,it->second) = value;
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+                else if (value != 0.)
+                    triplets.push_back(Eigen::Triplet<double>(count-1,it->second,value));
+#endif
+            }
         }
     }
 
@@ -3545,19 +3693,12 @@ int System::diagnose(Algorithm alg)
     Eigen::SparseMatrix<double> SJ;
 
     if(qrAlgorithm==EigenSparseQR){
-        // this creation is not optimized (done using triplets)
-        // however the time this takes is negligible compared to the
-        // time the QR decomposition itself takes
-        SJ = J.sparseView();
+        SJ.resize(clist.size(), plist.size());
+        SJ.setFromTriplets(triplets.begin(), triplets.end());
         SJ.makeCompressed();
     }
 
     Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > SqrJT;
-#else
-    if(qrAlgorithm==EigenSparseQR){
-        Base::Console().Warning("SparseQR not supported by you current version of Eigen. It requires Eigen 3.2.2 or higher. Falling back to Dense QR\n");
-        qrAlgorithm=EigenDenseQR;
-    }
 #endif
 
 #ifdef _GCS_DEBUG
@@ -3625,7 +3766,7 @@ int System::diagnose(Algorithm alg)
         std::stringstream stream;
         stream  << (qrAlgorithm==EigenSparseQR?"EigenSparseQR":(qrAlgorithm==EigenDenseQR?"DenseQR":""));
 
-        if (J.rows() > 0) {
+        if (!clist.empty()) {
             stream
 #ifdef EIGEN_SPARSEQR_COMPATIBLE
                     << ", Threads: " << Eigen::nbThreads()
@@ -3653,7 +3794,7 @@ int System::diagnose(Algorithm alg)
         Base::Console().Log(tmp.c_str());
     }
 
-    if (J.rows() > 0) {
+    if (!clist.empty()) {
 #ifdef _GCS_DEBUG_SOLVER_JACOBIAN_QR_DECOMPOSITION_TRIANGULAR_MATRIX
         // Debug code starts
         std::stringstream stream;
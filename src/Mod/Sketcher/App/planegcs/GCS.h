@@ -35,6 +35,13 @@ namespace GCS
     #define XconvergenceRough 1e-8
     #define smallF            1e-20
 
+    ///////////////////////////////////////
+    // LM and DogLeg Solver parameters
+    ///////////////////////////////////////
+    // subsystems with at least this number of parameters are solved with
+    // sparse matrices, smaller ones are faster with the dense decompositions
+    #define SparseMinSize     100
+
     ///////////////////////////////////////
     // Solver
     ///////////////////////////////////////
@@ -103,6 +110,8 @@ namespace GCS
         int solve_BFGS(SubSystem *subsys, bool isFine=true, bool isRedundantsolving=false);
         int solve_LM(SubSystem *subsys, bool isRedundantsolving=false);
         int solve_DL(SubSystem *subsys, bool isRedundantsolving=false);
+        template <typename Matrix>
+        int solve_DL(SubSystem *subsys, bool isRedundantsolving, Matrix &Jx, Matrix &Jx_new);
 
         #ifdef _GCS_EXTRACT_SOLVER_SUBSYSTEM_
         void extractSubsystem(SubSystem *subsys, bool isRedundantsolving);
@@ -258,15 +258,39 @@ void SubSystem::calcJacobi()
 }
 */
 
-void SubSystem::calcJacobi(VEC_pD &params, Eigen::MatrixXd &jacobi)
+void SubSystem::jacobiColumns(VEC_pD &params, std::vector<VEC_I> &columns)
 {
-    jacobi.setZero(csize, params.size());
+    // several parameters may be reduced to the same entry of pvals
+    columns.clear();
+    columns.resize(psize);
     for (int j=0; j < int(params.size()); j++) {
         MAP_pD_pD::const_iterator
           pmapfind = pmap.find(params[j]);
         if (pmapfind != pmap.end())
-            for (int i=0; i < csize; i++)
-                jacobi(i,j) = clist[i]->grad(pmapfind->second);
+            columns[pmapfind->second - &pvals[0]].push_back(j);
+    }
+}
+
+void SubSystem::calcJacobi(VEC_pD &params, Eigen::MatrixXd &jacobi)
+{
+    jacobi.setZero(csize, params.size());
+    if (psize == 0)
+        return;
+
+    // only the parameters of a constraint have a non-zero derivative
+    std::vector<VEC_I> columns;
+    jacobiColumns(params, columns);
+    for (int i=0; i < csize; i++) {
+        VEC_pD &constr_params = c2p[clist[i]];
+        for (VEC_pD::const_iterator p=constr_params.begin();
+             p != constr_params.end(); ++p) {
+            VEC_I &cols = columns[*p - &pvals[0]];
+            if (cols.empty())
+                continue;
+            double value = clist[i]->grad(*p);
+            for (VEC_I::const_iterator j=cols.begin(); j != cols.end(); ++j)
+                jacobi(i,*j) = value;
+        }
     }
 }
 
@@ -275,6 +299,40 @@ void SubSystem::calcJacobi(Eigen::MatrixXd &jacobi)
     calcJacobi(plist, jacobi);
 }
 
+void SubSystem::calcJacobi(VEC_pD &params, Eigen::SparseMatrix<double> &jacobi)
+{
+    jacobi.resize(csize, params.size());
+    if (psize == 0)
+        return;
+
+    std::vector<VEC_I> columns;
+    jacobiColumns(params, columns);
+
+    std::vector< Eigen::Triplet<double> > triplets;
+    for (int i=0; i < csize; i++) {
+        // the parameters of a constraint are unique, see initialize()
+        VEC_pD &constr_params = c2p[clist[i]];
+        for (VEC_pD::const_iterator p=constr_params.begin();
+             p != constr_params.end(); ++p) {
+            VEC_I &cols = columns[*p - &pvals[0]];
+            if (cols.empty())
+                continue;
+            double value = clist[i]->grad(*p);
+            if (value == 0.)
+                continue;
+            for (VEC_I::const_iterator j=cols.begin(); j != cols.end(); ++j)
+                triplets.push_back(Eigen::Triplet<double>(i,*j,value));
+        }
+    }
+    jacobi.setFromTriplets(triplets.begin(), triplets.end());
+    jacobi.makeCompressed();
+}
+
+void SubSystem::calcJacobi(Eigen::SparseMatrix<double> &jacobi)
+{
+    calcJacobi(plist, jacobi);
+}
+
 void SubSystem::calcGrad(VEC_pD &params, Eigen::VectorXd &grad)
 {
     assert(grad.size() == int(params.size()));
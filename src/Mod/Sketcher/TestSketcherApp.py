@@ -20,7 +20,7 @@
 #**************************************************************************
 
 
-import FreeCAD, os, sys, unittest, Part, Sketcher
+import FreeCAD, os, sys, unittest, Part, Sketcher, time
 App = FreeCAD
 
 def CreateBoxSketchSet(SketchFeature):
@@ -41,6 +41,25 @@ def CreateBoxSketchSet(SketchFeature):
 	SketchFeature.addConstraint(Sketcher.Constraint('Distance',1,81.370787)) 
 	SketchFeature.addConstraint(Sketcher.Constraint('Distance',0,187.573036)) 
 
+def CreateZigZagSketchSet(SketchFeature, constraintCount):
+	# a synthetic profile of horizontal and vertical segments with three constraints per segment
+	segments = constraintCount // 3
+	geometries = []
+	constraints = []
+	for i in range(segments):
+		start = App.Vector(10.0*((i+1)//2) + 0.3*(i%3), 10.0*(i//2) + 0.2*(i%5), 0)
+		end = App.Vector(10.0*((i+2)//2) + 0.2*(i%5), 10.0*((i+1)//2) + 0.3*(i%3), 0)
+		geometries.append(Part.LineSegment(start, end))
+		if i > 0:
+			constraints.append(Sketcher.Constraint('Coincident',i-1,2,i,1))
+		if i % 2 == 0:
+			constraints.append(Sketcher.Constraint('Horizontal',i))
+		else:
+			constraints.append(Sketcher.Constraint('Vertical',i))
+		constraints.append(Sketcher.Constraint('Distance',i,10.0))
+	SketchFeature.addGeometry(geometries)
+	SketchFeature.addConstraint(constraints)
+
 def CreateSlotPlateSet(SketchFeature):
 	SketchFeature.addGeometry(Part.LineSegment(App.Vector(60.029362,-30.279360,0),App.Vector(-120.376335,-30.279360,0)))
 	SketchFeature.addConstraint(Sketcher.Constraint('Horizontal',0)) 
@@ -113,6 +132,17 @@ class SketcherSolverTestCases(unittest.TestCase):
 		CreateSlotPlateInnerSet(self.Slot)
 		self.Doc.recompute()
 		self.failUnless(len(self.Slot.Shape.Edges) == 9)
+
+	def testSolverBenchmark(self):
+		# large sketches are solved with sparse matrices
+		for count in (100, 1000, 5000):
+			sketch = self.Doc.addObject('Sketcher::SketchObject','SketchZigZag')
+			start = time.time()
+			CreateZigZagSketchSet(sketch, count)
+			self.Doc.recompute()
+			FreeCAD.Console.PrintMessage("Sketch with %d constraints solved in %.3fs\n" % (len(sketch.Constraints), time.time() - start))
+			self.failUnless(sketch.solve() == 0)
+			self.failUnless(len(sketch.Shape.Edges) == count // 3)
 	
 	
 	def tearDown(self):
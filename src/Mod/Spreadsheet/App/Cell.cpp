@@ -32,6 +32,7 @@
 #include <Base/Quantity.h>
 #include <Base/Writer.h>
 #include <App/Expression.h>
+#include <App/CompiledExpression.h>
 #include "Sheet.h"
 #include <iomanip>
 
@@ -84,6 +85,7 @@ Cell::Cell(const CellAddress &_address, PropertySheet *_owner)
     , owner(_owner)
     , used(0)
     , expression(0)
+    , compiledExpression(0)
     , alignment(ALIGNMENT_HIMPLIED | ALIGNMENT_LEFT | ALIGNMENT_VIMPLIED | ALIGNMENT_VCENTER)
     , style()
     , foregroundColor(0, 0, 0, 1)
@@ -103,6 +105,7 @@ Cell::Cell(PropertySheet *_owner, const Cell &other)
     , owner(_owner)
     , used(other.used)
     , expression(other.expression ? other.expression->copy() : 0)
+    , compiledExpression(0)
     , alignment(other.alignment)
     , style(other.style)
     , foregroundColor(other.foregroundColor)
@@ -146,6 +149,7 @@ Cell::~Cell()
 {
     if (expression)
         delete expression;
+    delete compiledExpression;
 }
 
 /**
@@ -163,6 +167,8 @@ void Cell::setExpression(App::Expression *expr)
     if (expression)
         delete expression;
     expression = expr;
+    delete compiledExpression;
+    compiledExpression = 0;
     setUsed(EXPRESSION_SET, expression != 0);
 
     /* Update dependencies */
@@ -181,6 +187,25 @@ const App::Expression *Cell::getExpression() const
     return expression;
 }
 
+/**
+  * Get the compiled form of the expression tree, or 0 if the cell has no expression.
+  * It is compiled on first use and again after the expression was modified.
+  *
+  */
+
+const App::CompiledExpression *Cell::getCompiledExpression() const
+{
+    if (!expression)
+        return 0;
+
+    if (!compiledExpression || !compiledExpression->isUpToDate()) {
+        delete compiledExpression;
+        compiledExpression = 0;
+        compiledExpression = new App::CompiledExpression(expression);
+    }
+    return compiledExpression;
+}
+
 /**
   * Get string content.
   *
@@ -222,7 +247,7 @@ void Cell::setContent(const char * value)
     if (value != 0) {
         if (*value == '=') {
             try {
-                expr = App::ExpressionParser::parse(owner->sheet(), value + 1);
+                expr = App::ExpressionParser::parseCached(owner->sheet(), value + 1);
             }
             catch (Base::Exception & e) {
                 expr = new App::StringExpression(owner->sheet(), value);
@@ -239,7 +264,7 @@ void Cell::setContent(const char * value)
                 expr = new App::NumberExpression(owner->sheet(), Quantity(float_value));
             else {
                 try {
-                    expr = ExpressionParser::parse(owner->sheet(), value);
+                    expr = ExpressionParser::parseCached(owner->sheet(), value);
                     if (expr)
                         delete expr->eval();
                 }
@@ -37,6 +37,7 @@ class Writer;
 }
 
 namespace App {
+class CompiledExpression;
 class Expression;
 class ExpressionVisitor;
 }
@@ -61,6 +62,8 @@ public:
 
     const App::Expression * getExpression() const;
 
+    const App::CompiledExpression * getCompiledExpression() const;
+
     bool getStringContent(std::string & s) const;
 
     void setContent(const char * value);
@@ -179,6 +182,7 @@ private:
 
     int used;
     App::Expression * expression;
+    mutable App::CompiledExpression * compiledExpression;
     int alignment;
     std::set<std::string> style;
     App::Color foregroundColor;
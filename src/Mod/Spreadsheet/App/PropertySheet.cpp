@@ -81,6 +81,28 @@ private:
     std::set<App::DocumentObject*> & docDeps;
 };
 
+/*
+ * Returns true and the address in \a address if \a name is the name of a cell.
+ */
+static bool cellAddressFromName(const std::string & name, CellAddress & address)
+{
+    static const boost::regex e("\\${0,1}([A-Z]{1,2})\\${0,1}([0-9]{1,5})");
+    boost::cmatch cm;
+
+    if (boost::regex_match(name.c_str(), cm, e)) {
+        const boost::sub_match<const char *> colstr = cm[1];
+        const boost::sub_match<const char *> rowstr = cm[2];
+
+        int row = App::validRow(rowstr.str());
+        int col = App::validColumn(colstr.str());
+        if (row >= 0 && col >= 0) {
+            address = CellAddress(row, col);
+            return true;
+        }
+    }
+    return false;
+}
+
 }
 
 TYPESYSTEM_SOURCE(Spreadsheet::PropertySheet , App::Property);
@@ -103,6 +125,8 @@ void PropertySheet::clear()
 
     propertyNameToCellMap.clear();
     documentObjectToCellMap.clear();
+    cellToDependantCellMap.clear();
+    cellToDependencyCellMap.clear();
     docDeps.clear();
     aliasProp.clear();
     revAliasProp.clear();
@@ -215,6 +239,8 @@ PropertySheet::PropertySheet(const PropertySheet &other)
     , cellToPropertyNameMap(other.cellToPropertyNameMap)
     , documentObjectToCellMap(other.documentObjectToCellMap)
     , cellToDocumentObjectMap(other.cellToDocumentObjectMap)
+    , cellToDependantCellMap(other.cellToDependantCellMap)
+    , cellToDependencyCellMap(other.cellToDependencyCellMap)
     , docDeps(other.docDeps)
     , documentObjectName(other.documentObjectName)
     , documentName(other.documentName)
@@ -953,6 +979,8 @@ void PropertySheet::addDependencies(CellAddress key)
         // Also an alias?
         if (docObj == owner) {
             std::map<std::string, CellAddress>::const_iterator j = revAliasProp.find(i->getPropertyName());
+            CellAddress address;
+            bool isCell = false;
 
             if (j != revAliasProp.end()) {
                 propName = docObjName + "." + j->second.toString();
@@ -960,6 +988,17 @@ void PropertySheet::addDependencies(CellAddress key)
                 // Insert into maps
                 propertyNameToCellMap[propName].insert(key);
                 cellToPropertyNameMap[key].insert(propName);
+
+                address = j->second;
+                isCell = true;
+            }
+            else
+                isCell = cellAddressFromName(i->getPropertyName(), address);
+
+            // Insert into cell graph
+            if (isCell) {
+                cellToDependantCellMap[address].insert(key);
+                cellToDependencyCellMap[key].insert(address);
             }
         }
 
@@ -1021,6 +1060,29 @@ void PropertySheet::removeDependencies(CellAddress key)
 
         cellToDocumentObjectMap.erase(i2);
     }
+
+    /* Remove from cell graph */
+
+    std::map<CellAddress, std::set< CellAddress > >::iterator i3 = cellToDependencyCellMap.find(key);
+
+    if (i3 != cellToDependencyCellMap.end()) {
+        std::set< CellAddress >::const_iterator j = i3->second.begin();
+
+        while (j != i3->second.end()) {
+            std::map<CellAddress, std::set< CellAddress > >::iterator k = cellToDependantCellMap.find(*j);
+
+            assert(k != cellToDependantCellMap.end());
+
+            k->second.erase(key);
+
+            if (k->second.size() == 0)
+                cellToDependantCellMap.erase(k);
+
+            ++j;
+        }
+
+        cellToDependencyCellMap.erase(i3);
+    }
 }
 
 /**
@@ -1195,6 +1257,22 @@ const std::set<std::string> &PropertySheet::getDeps(CellAddress pos) const
         return empty;
 }
 
+/**
+  * Get the cells of this sheet that depend on the cell at \a pos.
+  *
+  */
+
+const std::set<CellAddress> &PropertySheet::getCellDependants(CellAddress pos) const
+{
+    static std::set<CellAddress> empty;
+    std::map<CellAddress, std::set< CellAddress > >::const_iterator i = cellToDependantCellMap.find(pos);
+
+    if (i != cellToDependantCellMap.end())
+        return i->second;
+    else
+        return empty;
+}
+
 void PropertySheet::recomputeDependencies(CellAddress key)
 {
     AtomicPropertyChange signaller(*this);
@@ -29,8 +29,8 @@
 #include <boost/range/adaptor/map.hpp>
 #include <boost/range/algorithm/copy.hpp>
 #include <boost/assign.hpp>
-#include <boost/graph/topological_sort.hpp>
 #include <App/Application.h>
+#include <App/CompiledExpression.h>
 #include <App/Document.h>
 #include <App/DynamicProperty.h>
 #include <App/FeaturePythonPyImp.h>
@@ -57,19 +57,6 @@ using namespace Spreadsheet;
 
 PROPERTY_SOURCE(Spreadsheet::Sheet, App::DocumentObject)
 
-typedef boost::adjacency_list <
-boost::vecS,           // class OutEdgeListS  : a Sequence or an AssociativeContainer
-boost::vecS,           // class VertexListS   : a Sequence or a RandomAccessContainer
-boost::directedS,      // class DirectedS     : This is a directed graph
-boost::no_property,    // class VertexProperty:
-boost::no_property,    // class EdgeProperty:
-boost::no_property,    // class GraphProperty:
-boost::listS           // class EdgeListS:
-> DependencyList;
-typedef boost::graph_traits<DependencyList> Traits;
-typedef Traits::vertex_descriptor Vertex;
-typedef Traits::edge_descriptor Edge;
-
 /**
   * Construct a new Sheet object.
   */
@@ -77,6 +64,7 @@ typedef Traits::edge_descriptor Edge;
 Sheet::Sheet()
     : DocumentObject()
     , props(this)
+    , compiledExpressions(true)
     , cells(this)
 {
     ADD_PROPERTY_TYPE(docDeps, (0), "Spreadsheet", (PropertyType)(Prop_Transient|Prop_ReadOnly|Prop_Hidden), "Dependencies");
@@ -618,7 +606,10 @@ void Sheet::updateProperty(CellAddress key)
         const Expression * input = cell->getExpression();
 
         if (input) {
-            output = input->eval();
+            if (compiledExpressions)
+                output = cell->getCompiledExpression()->eval().toExpression(this);
+            else
+                output = input->eval();
         }
         else {
             std::string s;
@@ -731,6 +722,8 @@ DocumentObjectExecReturn *Sheet::execute(void)
     // Remove all aliases first
     removeAliases();
 
+    compiledExpressions = CompiledExpression::isEnabled();
+
     // Get dirty cells that we have to recompute
     std::set<CellAddress> dirtyCells = cells.getDirty();
 
@@ -740,78 +733,69 @@ DocumentObjectExecReturn *Sheet::execute(void)
          dirtyCells.insert(*i);
     }
 
-    // Push dirty cells onto queue
-    for (std::set<CellAddress>::const_iterator i = dirtyCells.begin(); i != dirtyCells.end(); ++i) {
-        // Create queue and a graph structure to compute order of evaluation
-        std::deque<CellAddress> workQueue;
-        DependencyList graph;
-        std::map<CellAddress, Vertex> VertexList;
-        std::map<Vertex, CellAddress> VertexIndexList;
+    // Collect the dirty cells and all cells depending on them
+    std::set<CellAddress> affectedCells;
+    std::deque<CellAddress> workQueue(dirtyCells.begin(), dirtyCells.end());
 
-        workQueue.push_back(*i);
+    while (workQueue.size() > 0) {
+        CellAddress currPos = workQueue.front();
+        workQueue.pop_front();
 
-        while (workQueue.size() > 0) {
-            CellAddress currPos = workQueue.front();
-            std::set<CellAddress> s;
+        if (affectedCells.insert(currPos).second) {
+            const std::set<CellAddress> & s = cells.getCellDependants(currPos);
+            workQueue.insert(workQueue.end(), s.begin(), s.end());
+        }
+    }
 
-            // Get other cells that depends on the current cell (currPos)
-            providesTo(currPos, s);
-            workQueue.pop_front();
+    // Count for each cell the number of collected cells it depends on
+    std::map<CellAddress, int> pendingDeps;
+    for (std::set<CellAddress>::const_iterator i = affectedCells.begin(); i != affectedCells.end(); ++i)
+        pendingDeps.insert(std::make_pair(*i, 0));
 
-            // Insert into map of CellPos -> Index, if it doesn't exist already
-            if (VertexList.find(currPos) == VertexList.end()) {
-                VertexList[currPos] = add_vertex(graph);
-                VertexIndexList[VertexList[currPos]] = currPos;
-            }
+    for (std::set<CellAddress>::const_iterator i = affectedCells.begin(); i != affectedCells.end(); ++i) {
+        const std::set<CellAddress> & s = cells.getCellDependants(*i);
+        for (std::set<CellAddress>::const_iterator j = s.begin(); j != s.end(); ++j)
+            pendingDeps[*j]++;
+    }
 
-            // Process cells that depend on the current cell
-            std::set<CellAddress>::const_iterator i = s.begin();
-            while (i != s.end()) {
-                // Insert into map of CellPos -> Index, if it doesn't exist already
-                if (VertexList.find(*i) == VertexList.end()) {
-                    VertexList[*i] = add_vertex(graph);
-                    VertexIndexList[VertexList[*i]] = *i;
-                    workQueue.push_back(*i);
-                }
-                // Add edge to graph to signal dependency
-                add_edge(VertexList[currPos], VertexList[*i], graph);
-                ++i;
-            }
-        }
+    // Recompute cells in topological order; a cell is ready when all cells it
+    // depends on are recomputed, so each cell is recomputed only once
+    std::deque<CellAddress> readyCells;
+    for (std::map<CellAddress, int>::const_iterator i = pendingDeps.begin(); i != pendingDeps.end(); ++i) {
+        if (i->second == 0)
+            readyCells.push_back(i->first);
+    }
 
-        // Compute cells
-        std::list<Vertex> make_order;
+    while (readyCells.size() > 0) {
+        CellAddress currPos = readyCells.front();
+        readyCells.pop_front();
 
-        // Sort graph topologically to find evaluation order
-        try {
-            boost::topological_sort(graph, std::front_inserter(make_order));
+        recomputeCell(currPos);
 
-            // Recompute cells
-            std::list<Vertex>::const_iterator i = make_order.begin();
-            while (i != make_order.end()) {
-                recomputeCell(VertexIndexList[*i]);
-                ++i;
-            }
+        const std::set<CellAddress> & s = cells.getCellDependants(currPos);
+        for (std::set<CellAddress>::const_iterator j = s.begin(); j != s.end(); ++j) {
+            std::map<CellAddress, int>::iterator k = pendingDeps.find(*j);
+
+            if (k != pendingDeps.end() && --k->second == 0)
+                readyCells.push_back(*j);
         }
-        catch (std::exception) {
-            // Cycle detected; flag all with errors
+    }
 
-            std::map<CellAddress, Vertex>::const_iterator i = VertexList.begin();
-            while (i != VertexList.end()) {
-                Cell * cell = cells.getValue(i->first);
+    // The remaining cells are part of a cycle or depend on one; flag all with errors
+    for (std::map<CellAddress, int>::const_iterator i = pendingDeps.begin(); i != pendingDeps.end(); ++i) {
+        if (i->second > 0) {
+            Cell * cell = cells.getValue(i->first);
 
-                // Mark as erronous
-                cellErrors.insert(i->first);
+            // Mark as erronous
+            cellErrors.insert(i->first);
 
-                if (cell)
-                    cell->setException("Circular dependency.");
-                updateProperty(i->first);
-                updateAlias(i->first);
+            if (cell)
+                cell->setException("Circular dependency.");
 
-                ++i;
-            }
+            // The cells of the cycle can't be evaluated, show the error instead
+            setStringProperty(i->first, "ERR: Circular dependency.");
+            updateAlias(i->first);
         }
-
     }
 
     // Signal update of column widths
@@ -1258,10 +1242,7 @@ void Sheet::providesTo(CellAddress address, std::set<std::string> & result) cons
 
 void Sheet::providesTo(CellAddress address, std::set<CellAddress> & result) const
 {
-    const char * docName = getDocument()->Label.getValue();
-    const char * docObjName = getNameInDocument();
-    std::string fullName = std::string(docName) + "#" + std::string(docObjName) + "." + address.toString();
-    result = cells.getDeps(fullName);
+    result = cells.getCellDependants(address);
 }
 
 void Sheet::onDocumentRestored()
@@ -277,6 +277,9 @@ protected:
     /* Set of cells with errors */
     std::set<App::CellAddress> cellErrors;
 
+    /* Evaluate cells with compiled expressions */
+    bool compiledExpressions;
+
     /* Properties */
 
     /* Cell data */
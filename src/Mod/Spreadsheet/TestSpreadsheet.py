@@ -10,6 +10,7 @@ import FreeCAD
 import Part
 import Sketcher
 import tempfile
+import time
 from FreeCAD import Base
 from Units import Unit,Quantity
 
@@ -764,6 +765,91 @@ class SpreadsheetCases(unittest.TestCase):
         # Close second document
         FreeCAD.closeDocument(doc2.Name)
 
+    def testRecomputeLargeSheet(self):
+        """ Recompute a generated sheet with a shared lookup column """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        rows = 2000
+        sheet.set('A1', '2')
+        for i in range(1, rows + 1):
+            sheet.set('B%d' % i, '=A1 * %d' % i)
+            sheet.set('C%d' % i, '=B%d + A1' % i)
+            sheet.set('D%d' % i, '=C%d + B%d' % (i, i))
+        start = time.time()
+        self.doc.recompute()
+        FreeCAD.Console.PrintMessage("Recompute %d cells: %.3fs\n" % (3 * rows + 1, time.time() - start))
+        sheet.set('A1', '3')
+        start = time.time()
+        self.doc.recompute()
+        FreeCAD.Console.PrintMessage("Recompute %d cells after edit: %.3fs\n" % (3 * rows + 1, time.time() - start))
+        for i in range(1, rows + 1, 97):
+            self.assertEqual(sheet.get('B%d' % i), 3 * i)
+            self.assertEqual(sheet.get('C%d' % i), 3 * i + 3)
+            self.assertEqual(sheet.get('D%d' % i), 6 * i + 3)
+
+    def testCompiledExpressions(self):
+        """ Compiled expressions give the same results as the tree walker """
+        param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Expression")
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        formulas = ['=A1 * 2 + 1', '=A1 mm * 3 - 1 cm', '=sin(A1 * 30) + cos(A1 deg)', '=A1 > 2 ? A1 ^ 2 : -A1',
+                    '=mod(A1 * 7; 4) + sqrt(A1 * A1)', '=sum(A1:A3) / 2', '=A1 mm + 1', '=A1 ? A3 : 1', '=atan2(A1; 2) + pow(A1 mm; 2) / 1 mm^2']
+        rows = 500
+        sheet.set('A1', '2')
+        sheet.set('A2', '4')
+        sheet.set('A3', 'text')
+        for i in range(1, rows + 1):
+            sheet.set('B%d' % i, formulas[i % len(formulas)])
+        results = {}
+        try:
+            for compiled in (False, True):
+                param.SetBool("CompileExpressions", compiled)
+                sheet.set('A1', '3')
+                self.doc.recompute()
+                sheet.set('A1', '2')
+                start = time.time()
+                self.doc.recompute()
+                FreeCAD.Console.PrintMessage("Evaluate %d cells %s: %.3fs\n" % (rows, "compiled" if compiled else "as trees", time.time() - start))
+                results[compiled] = [sheet.get('B%d' % i) for i in range(1, len(formulas) + 1)]
+        finally:
+            param.RemBool("CompileExpressions")
+        self.assertEqual(results[True], results[False])
+
+    def testRestoreRepeatedFormulas(self):
+        """ Formulas shared by several sheets refer to their own sheet after restoring """
+        rows = 1000
+        for name, value in (('Sheet1', '2'), ('Sheet2', '5')):
+            sheet = self.doc.addObject('Spreadsheet::Sheet', name)
+            sheet.set('A1', value)
+            for i in range(1, rows + 1):
+                sheet.set('B%d' % i, '=A1 * 2 + 1')
+                sheet.set('C%d' % i, '=B%d > 6 ? B%d : -1' % (i % 10 + 1, i % 10 + 1))
+        self.doc.saveAs(self.TempPath + os.sep + 'formulas.fcstd')
+        FreeCAD.closeDocument(self.doc.Name)
+        start = time.time()
+        self.doc = FreeCAD.openDocument(self.TempPath + os.sep + 'formulas.fcstd')
+        FreeCAD.Console.PrintMessage("Restore %d formulas: %.3fs\n" % (4 * rows, time.time() - start))
+        self.doc.recompute()
+        sheet1 = self.doc.getObject('Sheet1')
+        sheet2 = self.doc.getObject('Sheet2')
+        self.assertEqual(sheet1.getContents('B1'), '=A1 * 2 + 1')
+        self.assertEqual(sheet1.get('B%d' % rows), 5)
+        self.assertEqual(sheet2.get('B%d' % rows), 11)
+        self.assertEqual(sheet1.get('C1'), -1)
+        self.assertEqual(sheet2.get('C1'), 11)
+
+    def testCircularDependency(self):
+        """ Cells in a cycle and cells depending on them fail, other cells are computed """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('A1', '=B1 + 1')
+        sheet.set('B1', '=A1 + 1')
+        sheet.set('C1', '=A1')
+        sheet.set('D1', '5')
+        sheet.set('E1', '=D1 * 2')
+        self.doc.recompute()
+        self.assertTrue(sheet.get('A1').startswith('ERR: Circular dependency'))
+        self.assertTrue(sheet.get('B1').startswith('ERR: Circular dependency'))
+        self.assertTrue(sheet.get('C1').startswith('ERR: Circular dependency'))
+        self.assertEqual(sheet.get('E1'), 10)
+
     def tearDown(self):
         #closing doc
         FreeCAD.closeDocument(self.doc.Name)
@@ -408,6 +408,110 @@ class DocumentSaveRestoreCases(unittest.TestCase):
     self.failUnless(len(Doc.Objects) == 1)
     FreeCAD.closeDocument("RestoreTests")
 
+  def testSaveThreads(self):
+    # save a larger document with a varying number of compression threads
+    import time
+    Doc = FreeCAD.newDocument("SaveThreadsTests")
+    for i in range(20):
+      obj = Doc.addObject("App::FeatureTest","Test")
+      obj.FloatList = [j * 0.5 for j in range(20000 * (i % 4 + 1))]
+      obj.VectorList = [(j, -j, 0.25 * j) for j in range(10000)]
+    try:
+      import Points
+      pts = Points.Points()
+      pts.addPoints([(i, 2 * i, 3 * i) for i in range(100000)])
+      Doc.addObject("Points::Feature", "Points").Points = pts
+    except ImportError:
+      pass
+    FileName = self.TempPath + os.sep + "SaveThreadsTests.FCStd"
+    param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+    threads = param.GetInt("SaveThreads", 0)
+    compression = param.GetInt("CompressionLevel", 3)
+    try:
+      for level in [0, 6]:
+        param.SetInt("CompressionLevel", level)
+        for count in [1, 2, 4, 0]:
+          param.SetInt("SaveThreads", count)
+          t = time.time()
+          Doc.saveAs(FileName)
+          FreeCAD.Console.PrintLog("Saving with level %d and %d threads took %f s\n" % (level, count, time.time() - t))
+          Doc.restore()
+          self.failUnless(len(Doc.Objects) >= 20)
+          self.failUnless(len(Doc.Test003.FloatList) == 80000)
+          self.failUnless(Doc.Test003.FloatList[-1] == 39999.5)
+          self.failUnless(len(Doc.Test019.VectorList) == 10000)
+    finally:
+      param.SetInt("SaveThreads", threads)
+      param.SetInt("CompressionLevel", compression)
+      FreeCAD.closeDocument("SaveThreadsTests")
+
+  def testLazyLoading(self):
+    try:
+      import Part
+    except ImportError:
+      return
+    Doc = FreeCAD.newDocument("LazyLoadingTests")
+    for i in range(5):
+      Doc.addObject("Part::Feature","Shape").Shape = Part.makeBox(1, 2, i + 1)
+    FileName = self.TempPath + os.sep + "LazyLoadingTests.FCStd"
+    Doc.saveAs(FileName)
+    param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+    lazy = param.GetBool("LazyLoading", False)
+    try:
+      param.SetBool("LazyLoading", True)
+      Doc.restore()
+      self.failUnless(len(Doc.Objects) == 5)
+      self.failUnless(abs(Doc.Shape002.Shape.Volume - 6.0) < 1e-6)
+      # overwrite the file while most shapes are not read in yet
+      Doc.save()
+      Doc.restore()
+      for i in range(5):
+        self.failUnless(abs(Doc.Objects[i].Shape.Volume - 2.0 * (i + 1)) < 1e-6)
+    finally:
+      param.SetBool("LazyLoading", lazy)
+      FreeCAD.closeDocument("LazyLoadingTests")
+
+  def testLazyLoadingView(self):
+    if not FreeCAD.GuiUp:
+      return
+    try:
+      import Part, Mesh
+    except ImportError:
+      return
+    import FreeCADGui, re
+
+    def hasCoordinates(vp):
+      # the scene graph must contain at least one non-empty coordinate node
+      for points in re.findall(r"point\s*\[([^\]]*)\]", vp.toString()):
+        if re.search(r"\d", points):
+          return True
+      return False
+
+    Doc = FreeCAD.newDocument("LazyLoadingViewTests")
+    Doc.addObject("Part::Feature","Shape").Shape = Part.makeBox(1, 2, 3)
+    Doc.addObject("Mesh::Feature","Mesh").Mesh = Mesh.createBox(1, 2, 3)
+    Doc.addObject("Part::Feature","Hidden").Shape = Part.makeCylinder(1, 2)
+    FreeCADGui.getDocument(Doc.Name).getObject("Hidden").hide()
+    FileName = self.TempPath + os.sep + "LazyLoadingViewTests.FCStd"
+    Doc.saveAs(FileName)
+    FreeCAD.closeDocument("LazyLoadingViewTests")
+
+    param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+    lazy = param.GetBool("LazyLoading", False)
+    try:
+      param.SetBool("LazyLoading", True)
+      Doc = FreeCAD.open(FileName)
+      GuiDoc = FreeCADGui.getDocument(Doc.Name)
+      self.failUnless(hasCoordinates(GuiDoc.getObject("Shape")))
+      self.failUnless(hasCoordinates(GuiDoc.getObject("Mesh")))
+      # hidden objects are drawn when they are shown for the first time
+      self.failIf(GuiDoc.getObject("Hidden").isVisible())
+      GuiDoc.getObject("Hidden").show()
+      self.failUnless(hasCoordinates(GuiDoc.getObject("Hidden")))
+    finally:
+      param.SetBool("LazyLoading", lazy)
+      FreeCAD.closeDocument(Doc.Name)
+
   def testActiveDocument(self):
     # open 2nd doc
     Second = FreeCAD.newDocument("Active")
@@ -469,9 +573,79 @@ class DocumentRecomputeCases(unittest.TestCase):
 
   def testDescent(self):
     # testing the up and downstream stuff
-    FreeCAD.Console.PrintLog("def testDescent(self):Testcase not implemented\n")
     self.L1.Link = self.L2
     self.L2.Link = self.L3
+    self.failUnless(self.L3.InList == [self.L2])
+    self.failUnless(self.L2.InList == [self.L1])
+    self.failUnless(self.L1.InList == [])
+    self.failUnless(len(self.L3.InListRecursive) == 2)
+    self.failUnless(self.L1 in self.L3.InListRecursive)
+    self.L1.Link = self.L3
+    self.failUnless(self.L2.InList == [])
+    self.failUnless(len(self.L3.InList) == 2)
+    self.Doc.removeObject(self.L1.Name)
+    self.failUnless(self.L3.InList == [self.L2])
+
+  def testManyObjects(self):
+    # a shared base object and a long chain of objects on top of it
+    import time
+    base = self.L3
+    objs = [self.L2]
+    for i in range(1000):
+      obj = self.Doc.addObject("App::FeatureTest","Chain")
+      obj.Link = objs[-1]
+      obj.LinkList = [base]
+      objs.append(obj)
+    self.failUnless(len(base.InList) == 1000)
+    self.failUnless(len(self.L2.InListRecursive) == 1000)
+    seqDic = {}
+    for i, obj in enumerate(self.Doc.ToplogicalSortedObjects):
+      seqDic[obj] = i
+    for i in range(1, len(objs)):
+      self.failUnless(seqDic[objs[i]] < seqDic[objs[i-1]])
+    t = time.time()
+    self.failUnless(self.Doc.recompute() == 1000)
+    FreeCAD.Console.PrintLog("Recompute of %d objects took %f s\n" % (len(objs), time.time() - t))
+    objs[1].touch()
+    self.failUnless(self.Doc.recompute() == 1000)
+    objs[-1].touch()
+    self.failUnless(self.Doc.recompute() == 1)
+
+  def testParallelRecompute(self):
+    param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+    param.SetBool("ParallelRecompute", True)
+    doc = FreeCAD.newDocument("ParallelRecomputeTests")
+    param.SetBool("ParallelRecompute", False)
+    # independent chains sharing one base object
+    base = doc.addObject("App::FeatureTest","Base")
+    chains = []
+    for i in range(8):
+      prev = base
+      chain = []
+      for j in range(10):
+        obj = doc.addObject("App::FeatureTest","Chain")
+        obj.Link = prev
+        chain.append(obj)
+        prev = obj
+      chains.append(chain)
+    self.failUnless(doc.recompute() == 80)
+    base.touch()
+    self.failUnless(doc.recompute() == 81)
+    for chain in chains:
+      self.failUnless([o.ExecCount for o in chain] == [2] * 10)
+    # a failing object is marked invalid like in a serial recompute
+    chains[0][0].ExceptionType = 2
+    self.failUnless(doc.recompute() == 10)
+    self.failUnless("Invalid" in chains[0][0].State)
+    self.failUnless("Invalid" not in chains[1][0].State)
+    # objects with expressions are recomputed in this thread after the workers
+    chains[0][0].ExceptionType = 0
+    chains[1][3].setExpression('Integer', 'Base.Integer + 1')
+    base.touch()
+    self.failUnless(doc.recompute() == 81)
+    self.failUnless(chains[1][3].Integer == 4712)
+    self.failUnless("Invalid" not in chains[0][0].State)
+    FreeCAD.closeDocument("ParallelRecomputeTests")
 
 
   def tearDown(self):
@@ -0,0 +1,121 @@
+# Selection test module
+
+#***************************************************************************
+#*                                                                         *
+#*   This file is part of the FreeCAD CAx development system.              *
+#*                                                                         *
+#*   This program is free software; you can redistribute it and/or modify  *
+#*   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#*   as published by the Free Software Foundation; either version 2 of     *
+#*   the License, or (at your option) any later version.                   *
+#*   for detail see the LICENCE text file.                                 *
+#*                                                                         *
+#*   FreeCAD is distributed in the hope that it will be useful,            *
+#*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#*   GNU Library General Public License for more details.                  *
+#*                                                                         *
+#*   You should have received a copy of the GNU Library General Public     *
+#*   License along with FreeCAD; if not, write to the Free Software        *
+#*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#*   USA                                                                   *
+#*                                                                         *
+#***************************************************************************/
+
+import FreeCAD, FreeCADGui, unittest
+
+class SelectionRecorder:
+    def __init__(self):
+        self.messages = []
+    def addSelection(self, doc, obj, sub, pnt):
+        self.messages.append(("add", obj, sub))
+    def removeSelection(self, doc, obj, sub):
+        self.messages.append(("rmv", obj, sub))
+    def setSelection(self, doc):
+        self.messages.append(("set", doc))
+    def clearSelection(self, doc):
+        self.messages.append(("clr", doc))
+
+class SelectionCases(unittest.TestCase):
+    def setUp(self):
+        self.doc = FreeCAD.newDocument("SelectionTest")
+        self.box = self.doc.addObject("Part::Box", "Box")
+        self.cyl = self.doc.addObject("Part::Cylinder", "Cylinder")
+        self.doc.recompute()
+        FreeCADGui.Selection.clearSelection()
+        self.recorder = SelectionRecorder()
+        FreeCADGui.Selection.addObserver(self.recorder)
+
+    def tearDown(self):
+        FreeCADGui.Selection.removeObserver(self.recorder)
+        FreeCADGui.Selection.clearSelection()
+        FreeCAD.closeDocument("SelectionTest")
+
+    def subNames(self, obj):
+        for sel in FreeCADGui.Selection.getSelectionEx("SelectionTest"):
+            if sel.ObjectName == obj.Name:
+                return list(sel.SubElementNames)
+        return []
+
+    def testAddSelectionList(self):
+        faces = ["Face%d" % i for i in range(1, 4)]
+        FreeCADGui.Selection.addSelection(self.box, faces)
+        for face in faces:
+            self.failUnless(FreeCADGui.Selection.isSelected(self.box, face))
+        self.failUnless(self.subNames(self.box) == faces)
+        # the observers get one message per item
+        self.failUnless(self.recorder.messages == [("add", "Box", face) for face in faces])
+
+    def testAddSelections(self):
+        faces = ["Face%d" % i for i in range(1, 7)]
+        FreeCADGui.Selection.addSelections(self.box, faces)
+        for face in faces:
+            self.failUnless(FreeCADGui.Selection.isSelected(self.box, face))
+        self.failUnless(FreeCADGui.Selection.isSelected(self.box))
+        self.failIf(FreeCADGui.Selection.isSelected(self.box, "Edge1"))
+        self.failIf(FreeCADGui.Selection.isSelected(self.cyl))
+        self.failUnless(self.subNames(self.box) == faces)
+        # the observers get one message for all items
+        self.failUnless(self.recorder.messages == [("set", "SelectionTest")])
+
+        # items that are already selected are skipped
+        FreeCADGui.Selection.addSelections(self.box, ["Face1", "Edge1", "Edge1"])
+        self.failUnless(self.subNames(self.box) == faces + ["Edge1"])
+
+        # nothing is sent if all items are already selected
+        del self.recorder.messages[:]
+        FreeCADGui.Selection.addSelections(self.box, ["Face2", "Edge1"])
+        self.failUnless(self.recorder.messages == [])
+
+    def testRemoveSelection(self):
+        FreeCADGui.Selection.addSelection(self.box, ["Face1", "Face2", "Face3"])
+        FreeCADGui.Selection.addSelection(self.cyl, ["Face1"])
+        del self.recorder.messages[:]
+
+        FreeCADGui.Selection.removeSelection(self.box, "Face2")
+        self.failIf(FreeCADGui.Selection.isSelected(self.box, "Face2"))
+        self.failUnless(FreeCADGui.Selection.isSelected(self.box, "Face1"))
+        self.failUnless(FreeCADGui.Selection.isSelected(self.box, "Face3"))
+        self.failUnless(self.subNames(self.box) == ["Face1", "Face3"])
+        self.failUnless(self.recorder.messages == [("rmv", "Box", "Face2")])
+
+        # removing an item that is not selected does nothing
+        del self.recorder.messages[:]
+        FreeCADGui.Selection.removeSelection(self.box, "Face2")
+        self.failUnless(self.recorder.messages == [])
+
+        # without a sub-element all items of the object are removed
+        FreeCADGui.Selection.removeSelection(self.box)
+        self.failIf(FreeCADGui.Selection.isSelected(self.box))
+        self.failUnless(FreeCADGui.Selection.isSelected(self.cyl, "Face1"))
+        self.failUnless(len(FreeCADGui.Selection.getSelectionEx("SelectionTest")) == 1)
+
+    def testSelectAfterRemove(self):
+        FreeCADGui.Selection.addSelection(self.box, ["Face1", "Face2"])
+        FreeCADGui.Selection.removeSelection(self.box, "Face1")
+        FreeCADGui.Selection.addSelection(self.box, ["Face1"])
+        self.failUnless(FreeCADGui.Selection.isSelected(self.box, "Face1"))
+        self.failUnless(sorted(self.subNames(self.box)) == ["Face1", "Face2"])
+        FreeCADGui.Selection.clearSelection("SelectionTest")
+        self.failIf(FreeCADGui.Selection.isSelected(self.box))
+        self.failIf(FreeCADGui.Selection.isSelected(self.box, "Face2"))
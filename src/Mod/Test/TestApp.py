@@ -63,11 +63,14 @@ def All():
     # Base system gui test
     if (FreeCAD.GuiUp == 1):
         tests += [ "Workbench",
-                   "Menu" ]
+                   "Menu",
+                   "SelectionTests" ]
 
     # add the module tests
     tests += [ "TestFem",
                "MeshTestsApp",
+               "PointsTestsApp",
+               "InspectionTestsApp",
                "TestSketcherApp",
                "TestPartApp",
                "TestPartDesignApp",
@@ -47,6 +47,8 @@ class TestCmd:
         QtUnitGui.addTest("Document")
         QtUnitGui.addTest("UnicodeTests")
         QtUnitGui.addTest("MeshTestsApp")
+        QtUnitGui.addTest("PointsTestsApp")
+        QtUnitGui.addTest("InspectionTestsApp")
         QtUnitGui.addTest("TestFem")
         QtUnitGui.addTest("TestSketcherApp")
         QtUnitGui.addTest("TestPartApp")
@@ -61,6 +63,7 @@ class TestCmd:
         QtUnitGui.addTest("Menu")
         QtUnitGui.addTest("Menu.MenuDeleteCases")
         QtUnitGui.addTest("Menu.MenuCreateCases")
+        QtUnitGui.addTest("SelectionTests")
 
     def GetResources(self):
         return {'MenuText': 'Self-test...', 'ToolTip': 'Runs a self-test to check if the application works properly'}
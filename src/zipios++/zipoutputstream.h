@@ -10,6 +10,9 @@
 #include "ziphead.h"
 #include "zipoutputstreambuf.h"
 
+/** Defined if ZipOutputStream::putRawEntry() is available. */
+#define ZIPIOS_HAVE_PUT_RAW_ENTRY 1
+
 namespace zipios {
 
 /** \anchor ZipOutputStream_anchor
@@ -54,6 +57,13 @@ public:
   */
   void putNextEntry(const std::string& entryName);
 
+  /** Writes a complete entry whose data has already been compressed.
+      \see ZipOutputStreambuf::putRawEntry()
+  */
+  void putRawEntry( const ZipCDirEntry &entry, StorageMethod method,
+                    const char *data, uint32 compressed_size,
+                    uint32 size, uint32 crc ) ;
+
   /** Sets the global comment for the Zip archive. */
   void setComment( const std::string& comment ) ;
 
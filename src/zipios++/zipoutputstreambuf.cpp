@@ -18,6 +18,18 @@ using std::endl ;
 using std::min ;
 using std::vector ;
 
+// Returns the current date and time in MS-DOS format
+static int currentDosTime() {
+  // Mark Donszelmann: added current date and time
+  time_t ltime;
+  time( &ltime );
+  struct tm *now;
+  now = localtime( &ltime );
+  int dosTime = (now->tm_year - 80) << 25 | (now->tm_mon + 1) << 21 | now->tm_mday << 16 |
+              now->tm_hour << 11 | now->tm_min << 5 | now->tm_sec >> 1;
+  return dosTime;
+}
+
 ZipOutputStreambuf::ZipOutputStreambuf( streambuf *outbuf, bool del_outbuf ) 
   : DeflateOutputStreambuf( outbuf, false, del_outbuf ),
     _open_entry( false    ),
@@ -81,6 +93,31 @@ void ZipOutputStreambuf::putNextEntry( const ZipCDirEntry &entry ) {
 }
 
 
+void ZipOutputStreambuf::putRawEntry( const ZipCDirEntry &entry, StorageMethod method,
+                                      const char *data, uint32 compressed_size,
+                                      uint32 size, uint32 crc ) {
+  if ( _open_entry )
+    closeEntry() ;
+
+  _entries.push_back( entry ) ;
+  ZipCDirEntry &ent = _entries.back() ;
+
+  ostream os( _outbuf ) ;
+
+  // All header fields are known in advance, so the local header
+  // doesn't need to be rewritten afterwards
+  ent.setLocalHeaderOffset( os.tellp() ) ;
+  ent.setMethod( method ) ;
+  ent.setSize( size ) ;
+  ent.setCrc( crc ) ;
+  ent.setCompressedSize( compressed_size ) ;
+  ent.setTime( currentDosTime() ) ;
+
+  os << static_cast< ZipLocalEntry >( ent ) ;
+  os.write( data, compressed_size ) ;
+}
+
+
 void ZipOutputStreambuf::setComment( const string &comment ) {
   _zip_comment = comment ;
 }
@@ -146,14 +183,7 @@ void ZipOutputStreambuf::updateEntryHeaderInfo() {
   entry.setCompressedSize( curr_pos - entry.getLocalHeaderOffset() 
 			   - entry.getLocalHeaderSize() ) ;
 
-  // Mark Donszelmann: added current date and time
-  time_t ltime;
-  time( &ltime );
-  struct tm *now;
-  now = localtime( &ltime );
-  int dosTime = (now->tm_year - 80) << 25 | (now->tm_mon + 1) << 21 | now->tm_mday << 16 |
-              now->tm_hour << 11 | now->tm_min << 5 | now->tm_sec >> 1;
-  entry.setTime(dosTime);
+  entry.setTime( currentDosTime() ) ;
 
   // write ZipLocalEntry header to header position
   os.seekp( entry.getLocalHeaderOffset() ) ;
@@ -49,6 +49,20 @@ public:
       entry. */
   void putNextEntry( const ZipCDirEntry &entry ) ;
 
+  /** Writes a complete entry whose data has already been compressed
+      by the caller (raw deflate stream without zlib header if method
+      is DEFLATED, the plain data if method is STORED). The current
+      entry is closed first.
+      @param entry the entry to add.
+      @param method the storage method that was used for data.
+      @param data the (compressed) entry data.
+      @param compressed_size the number of bytes in data.
+      @param size the uncompressed size of the entry.
+      @param crc the CRC32 of the uncompressed data. */
+  void putRawEntry( const ZipCDirEntry &entry, StorageMethod method,
+                    const char *data, uint32 compressed_size,
+                    uint32 size, uint32 crc ) ;
+
   /** Sets the global comment for the Zip archive. */
   void setComment( const string &comment ) ;
 